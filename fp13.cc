@@ -15,23 +15,90 @@
 // 		Manuel Schiller <schiller@physi.uni-heidelberg.de>
 //
 // usage: fp13.exe [-n nEvents] [-i inputDataFile] [-o rootOutputFile]
+// 		[-s skipNrEvents] [-p nReadThreads] [-j nThreads] [-q] [-v]
+// 		[-x] [-e eventNr] [-f] [-u refreshInterval] [-l nLayers]
+// 		[-S name:minDelay:mergeWindow[:variant]]... [-c candidateFile]
+// 		[-k skimFile] [-b flagIndexFile]
+// 		[-w window[:deadTime[:coincidence[:triggerMask]]]]
+// 		[inputDataFile...]
 //
 // werden Eingabe- oder Ausgabefile auf der Kommandozeile nicht
 // angegeben, so verwendet das Programm "fp13.txt" standardmaessig als
 // Eingabefile und "fp13.root" als Ausgabefile
+//
+// mehrere Eingabedateien (mehrmals -i oder nach den Optionen, -i auch mit
+// Platzhaltern wie 'run*.txt') sind Laeufe einer Messperiode: sie werden
+// mit -j Threads gleichzeitig analysiert, die Histogramme jedes Laufs
+// stehen in einem eigenen Verzeichnis der Ausgabedatei, die Summe aller
+// Laeufe wie gewohnt direkt darin (s. fp13RunSet.h)
+//
+// mit gzip oder zstd komprimierte Eingabedateien werden beim Lesen
+// entpackt (s. fp13Compressed.h); mit -p werden zstd-Dateien aus
+// mehreren Frames parallel entpackt
+//
+// mit -x wird nur der Ereignisindex zur Eingabedatei erstellt (s.
+// fp13Index.h), mit -e nur das Ereignis eventNr ausgegeben
+//
+// mit -f wird die Eingabedatei verfolgt, waehrend sie waechst; die
+// Ausgabedatei wird alle refreshInterval Sekunden aktualisiert, beendet
+// wird mit Ctrl-C (s. fp13FollowInput.h)
+//
+// mit -l wird ein Detektor mit nLayers Lagen analysiert (6, 8, 12, 16
+// oder 32, s. fp13BasicAnalysis in fp13Analysis.h), Standard sind die 6
+// Lagen des Detektors im Praktikum
+//
+// jedes -S fuegt eine Konfiguration fuer systematische Studien hinzu, die
+// im selben Durchgang analysiert wird; ihre Histogramme stehen im
+// Verzeichnis name der Ausgabedatei (s. fp13Scan.h)
+//
+// mit -c werden alle gefundenen Zerfaelle und Nachpulse zusaetzlich
+// ungebinnt als Tabelle nach candidateFile geschrieben (s.
+// fp13Candidates.h)
+//
+// mit -k werden alle Ereignisse, in denen nach Zerfaellen und Nachpulsen
+// gesucht wird, im Binaerformat nach skimFile geschrieben, die Anzahl
+// aller gelesenen Ereignisse nach skimFile.sum (s. fp13Skim.h)
+//
+// mit -b werden eventFlags und lastMuonLayer aller analysierten
+// Ereignisse als Bitmap-Index nach flagIndexFile geschrieben; Ereignisse
+// daraus auswaehlen kann man mit fp13query (s. fp13FlagIndex.h)
+//
+// mit -w ist die Eingabedatei ein fortlaufender Strom einzelner Hits
+// (Zeitpunkt und Lage), aus dem die Ereignisse mit einem Trigger auf die
+// obersten Lagen, einem Auslesefenster von window ns und einer Totzeit
+// gebildet werden (s. fp13HitStream.h); -f, -S, -x, -e und -b gehen
+// damit nicht
 ////////////////////////////////////////////////////////////////////////
 
 // C++ header files
 #include <iostream>
 #include <string>
 #include <sstream>
-// C header files (fuer getopt)
+#include <iomanip>
+#include <vector>
+// C header files (fuer getopt, signal und glob)
 #include <unistd.h>
+#include <csignal>
+#include <glob.h>
 
 // C++ header fuer logstream, die Programmeldungen netter machen
 #include "logstream.h"
 // C++ header file fuer das Analyseobjekt
 #include "fp13Analysis.h"
+// C++ header file fuer mehrere Konfigurationen in einem Durchgang
+#include "fp13Scan.h"
+// C++ header file fuer den Ereignisindex
+#include "fp13Index.h"
+// C++ header file fuer das Verfolgen der Eingabedatei
+#include "fp13FollowInput.h"
+// C++ header file fuer den Skim
+#include "fp13Skim.h"
+// C++ header file fuer den Flag-Index
+#include "fp13FlagIndex.h"
+// C++ header file fuer die Ereignisbildung aus einem Hitstrom
+#include "fp13HitStream.h"
+// C++ header file fuer die Analyse vieler Laeufe
+#include "fp13RunSet.h"
 
 using namespace std;
 using namespace logstreams;
@@ -41,13 +108,22 @@ static const unsigned long defMaxNoOfEvents = (unsigned long) -1;
 static const unsigned long defFirstEvent = 0;
 static const char *defInputDataFileName = "fp13.txt";
 static const char *defRootOutputFileName = "fp13.root";
+static const unsigned defNoOfReadThreads = 1;
+static const unsigned defNoOfThreads = 1;
+static const unsigned defRefreshInterval = 60;
+static const int defNoOfLayers = 6;
 
 // kleine Prozedur zum Ausgeben eines Hilfetextes
 void help(char *myname)
 {
 	cout << endl << "usage:\t" << myname << " [-n maxNoOfEvents] " <<
 		"[-i inputDataFileName] " << "[-o rootOutputFileName] " <<
-		"[-s skipNrEvents] [-q] [-v]" << endl << endl <<
+		"[-s skipNrEvents] [-p nReadThreads] [-j nThreads] " <<
+		"[-q] [-v] [-x] [-e eventNr] [-f] [-u refreshInterval] " <<
+		"[-l nLayers] [-S name:minDelay:mergeWindow[:variant]]... " <<
+		"[-c candidateFile] [-k skimFile] [-b flagIndexFile] " <<
+		"[-w window[:deadTime[:coincidence[:triggerMask]]]] " <<
+		"[inputDataFileName...]" << endl << endl <<
 		"\tIf not specified on the command line, input is read "
 		"from " << defInputDataFileName << "," << endl <<
 		"\tand output is written to " << defRootOutputFileName <<
@@ -55,11 +131,292 @@ void help(char *myname)
 		defMaxNoOfEvents << " events are processed." << endl <<
 		"\tIf \"-\" is given as name of the input file, input " <<
 		"data" << endl << "\tis read from stdin." << endl <<
+		"\tSeveral input files (-i given more than once, with "
+		"wildcards like" << endl << "\t'run*.txt', or after the "
+		"options) are analyzed as runs, nThreads" << endl <<
+		"\tat a time; each run gets its own directory in the "
+		"output file, and" << endl << "\tthe sum of all runs is "
+		"written to the top level as usual. -n" << endl <<
+		"\tapplies to each run." << endl <<
+		"\tWith -p, text input files are parsed by nReadThreads "
+		"threads in" << endl << "\tparallel (default: " <<
+		defNoOfReadThreads << ")." << endl <<
+		"\tWith -j, events are analyzed by nThreads threads "
+		"(default: " << defNoOfThreads << ")." << endl <<
+		"\tWith -x, only the event index used by -s is built "
+		"(" << fp13EventIndex::indexFileName("file") << ")." <<
+		endl << "\tWith -e, only event eventNr (counted from 0) is "
+		"printed." << endl <<
+		"\tWith -f, the input file is followed while it grows; "
+		"the output" << endl << "\tfile is refreshed every "
+		"refreshInterval seconds (default: " <<
+		defRefreshInterval << ")," << endl << "\tand a "
+		"checkpoint is kept to continue after a restart. Stop "
+		"with Ctrl-C." << endl <<
+		"\tWith -l, a detector with nLayers layers is analyzed "
+		"(6, 8, 12, 16 or 32;" << endl << "\tdefault: " <<
+		defNoOfLayers << ")." << endl <<
+		"\tEach -S adds a configuration with its own minDelay, " <<
+		"mergeWindow (ns) and" << endl << "\tfinder variant " <<
+		"(default: " << fp13Analysis::defMinDelay << ", " <<
+		fp13Input::defMergeWindow << ", default), which is " <<
+		"analyzed in the" << endl << "\tsame pass; its " <<
+		"histograms go to the directory name of the" << endl <<
+		"\toutput file. Empty fields keep their default." << endl <<
+		"\tWith -c, every decay and afterpulse candidate is also " <<
+		"written unbinned" << endl << "\t(event, layer, delay, " <<
+		"type, event flags) to the compressed table" << endl <<
+		"\tcandidateFile." << endl <<
+		"\tWith -k, the events with a muon in the first time bin "
+		"and at least" << endl << "\ttwo time bins are written to " <<
+		"skimFile in the binary format, and" << endl <<
+		"\tthe number of events read to " <<
+		fp13SkimOutput::summaryFileName("skimFile") << "." << endl <<
+		"\tWith -b, the event flags and the last layer of the muon "
+		"of every" << endl << "\tanalyzed event are written as "
+		"compressed bitmaps to flagIndexFile;" << endl <<
+		"\tuse fp13query to select events from it." << endl <<
+		"\tWith -w, the input is a continuous stream of hits (time "
+		"in ns, layer)," << endl << "\tone per line. Events are "
+		"built from it by a trigger on the layers" << endl <<
+		"\tin triggerMask within coincidence ns, a readout window "
+		"of window ns" << endl << "\tand a dead time of deadTime "
+		"ns after it (default: " <<
+		fp13HitStreamConfig::defWindow << ", " <<
+		fp13HitStreamConfig::defDeadTime << ", " << endl << "\t" <<
+		fp13HitStreamConfig::defCoincidence << ", " <<
+		fp13HitStreamConfig::defTriggerMask << ")." << endl <<
 		"\tThe options -q and -v make " << myname << " more quiet"
 		" or more verbose and may" << endl <<
 		"\tbe given more than once." << endl;
 }
 
+// Erstellen des Ereignisindex zur Eingabedatei
+static int buildIndex(const string& inputDataFileName)
+{
+	fp13Input* input = fp13Input::open(inputDataFileName);
+	if (!input) {
+		error << "Fehler beim Oeffnen der Eingabedatei " <<
+			inputDataFileName << "." << endl;
+		return -1;
+	}
+	fp13EventIndex index(inputDataFileName);
+	const string indexFileName =
+		fp13EventIndex::indexFileName(inputDataFileName);
+	int retVal = 0;
+	if (!index.build(*input)) {
+		error << "Zu " << inputDataFileName << " kann kein "
+			"Ereignisindex erstellt werden." << endl;
+		retVal = -1;
+	} else if (!index.save()) {
+		error << "Fehler beim Schreiben von " << indexFileName <<
+			"." << endl;
+		retVal = -1;
+	} else {
+		info << "Ereignisindex " << indexFileName << " mit " <<
+			index.getNoOfEvents() << " Ereignissen erstellt." <<
+			endl;
+	}
+	delete input;
+	return retVal;
+}
+
+// Ausgeben des Ereignisses eventNr im Format der Textdateien
+// (mit zusammengefassten Zeitbins, wie sie die Analyse sieht)
+static int dumpEvent(const string& inputDataFileName, unsigned long eventNr)
+{
+	fp13Input* input = fp13Input::open(inputDataFileName);
+	if (!input) {
+		error << "Fehler beim Oeffnen der Eingabedatei " <<
+			inputDataFileName << "." << endl;
+		return -1;
+	}
+	vector<int> hitMask, hitTimes;
+	unsigned long eventCounter = fp13EventIndex::seek(*input, 0, eventNr);
+	for (;;) {
+		if (input->readEvent(hitMask, hitTimes, eventCounter) != 0) {
+			error << "Ereignis " << eventNr << " nicht gefunden, " <<
+				inputDataFileName << " enthaelt nur " <<
+				eventCounter << " Ereignisse." << endl;
+			delete input;
+			return -1;
+		}
+		if (eventCounter++ == eventNr)
+			break;
+	}
+	for (unsigned i = 0; i < hitMask.size(); ++i)
+		cout << setw(10) << (i + 1) << setw(10) << hitMask[i] <<
+			setw(10) << hitTimes[i] << endl;
+	cout << "###" << endl;
+	delete input;
+	return 0;
+}
+
+// Hinzufuegen der Eingabedatei(en) name zu fileNames; Namen mit
+// Platzhaltern (*, ?, [) werden wie von der Shell erweitert
+// gibt false zurueck, falls keine Datei auf den Namen passt
+static bool addInputFiles(const string& name, vector<string>& fileNames)
+{
+	if (string::npos == name.find_first_of("*?[")) {
+		fileNames.push_back(name);
+		return true;
+	}
+	glob_t matches;
+	if (0 != glob(name.c_str(), 0, 0, &matches)) {
+		error << "Keine Eingabedatei passt auf " << name << "." <<
+			endl;
+		globfree(&matches);
+		return false;
+	}
+	for (size_t i = 0; i < matches.gl_pathc; ++i)
+		fileNames.push_back(matches.gl_pathv[i]);
+	globfree(&matches);
+	return true;
+}
+
+// Analyse mehrerer Laeufe mit einem Detektor aus N Lagen
+template <int N>
+static int analyzeRuns(const vector<string>& inputDataFileNames,
+		const string& rootOutputFileName, unsigned long maxNoOfEvents,
+		unsigned nReadThreads, unsigned nThreads)
+{
+	// die Summe schreibt ein Analyseobjekt ohne eigene Eingabe, die
+	// Laeufe analysieren Worker-Objekte davon
+	fp13BasicRunSet<N> runs(new fp13BasicAnalysis<N>(rootOutputFileName),
+			nReadThreads);
+	for (size_t i = 0; i < inputDataFileNames.size(); ++i)
+		if (!runs.add(inputDataFileNames[i]))
+			return -1;
+	return runs.analyze(maxNoOfEvents, nThreads) ? 0 : -1;
+}
+
+// Signalhandler fuer SIGINT und SIGTERM beim Verfolgen der Eingabedatei
+static void stopFollowing(int)
+{ fp13FollowInput::requestStop(); }
+
+// Einstellungen aus der Kommandozeile fuer analyze
+struct fp13Options
+{
+	vector<string> inputDataFileNames;
+	string rootOutputFileName;
+	unsigned long firstEvent, maxNoOfEvents;
+	unsigned nReadThreads, nThreads;
+	bool follow;
+	unsigned refreshInterval;
+	vector<fp13ScanConfig> scanConfigs;
+	string candidateFileName, skimFileName, flagIndexFileName;
+	// 0, falls die Eingabe kein Hitstrom ist
+	const fp13HitStreamConfig* hitStreamConfig;
+};
+
+// Analyse mit einem Detektor aus N Lagen
+template <int N>
+static int analyze(const fp13Options& options)
+{
+	if (options.inputDataFileNames.size() > 1)
+		return analyzeRuns<N>(options.inputDataFileNames,
+				options.rootOutputFileName,
+				options.maxNoOfEvents, options.nReadThreads,
+				options.nThreads);
+	const string& inputDataFileName = options.inputDataFileNames[0];
+
+	// Erzeuge Instanz der Analyseklasse
+	// Das Oeffnen der Dateien und Buchen der Histogramme uebernimmt
+	// der Konstruktor, das Speichern der Histogramme und schliessen
+	// der Dateien der Destruktor
+	fp13BasicAnalysis<N> *analysisObject;
+	if (options.hitStreamConfig) {
+		// Ereignisse aus einem Hitstrom
+		fp13HitStreamInput* input = fp13HitStreamInput::open(
+				inputDataFileName, *options.hitStreamConfig);
+		if (!input) {
+			error << "Fehler beim Oeffnen der Eingabedatei " <<
+				inputDataFileName << "." << endl;
+			return -1;
+		}
+		analysisObject = new fp13BasicAnalysis<N>(input,
+				options.rootOutputFileName);
+	} else if (options.scanConfigs.empty()) {
+		analysisObject = new fp13BasicAnalysis<N>(inputDataFileName,
+				options.rootOutputFileName,
+				options.nReadThreads, options.follow);
+	} else {
+		// mehrere Konfigurationen: fp13BasicScan gibt jedes
+		// Ereignis an alle weiter
+		fp13BasicScan<N>* scan = new fp13BasicScan<N>(
+				inputDataFileName, options.rootOutputFileName,
+				options.nReadThreads);
+		analysisObject = scan;
+		for (size_t i = 0; i < options.scanConfigs.size(); ++i) {
+			if (!scan->addConfiguration(options.scanConfigs[i])) {
+				delete analysisObject;
+				return -1;
+			}
+		}
+	}
+
+	// Tabelle der Kandidaten (erst nach den Konfigurationen, die selbst
+	// keine schreiben)
+	if (!options.candidateFileName.empty() &&
+			!analysisObject->writeCandidates(
+				options.candidateFileName)) {
+		delete analysisObject;
+		return -1;
+	}
+	if (!options.skimFileName.empty() &&
+			!analysisObject->writeSkim(options.skimFileName)) {
+		delete analysisObject;
+		return -1;
+	}
+	if (!options.flagIndexFileName.empty() &&
+			!analysisObject->writeFlagIndex(
+				options.flagIndexFileName)) {
+		delete analysisObject;
+		return -1;
+	}
+
+	if (options.follow) {
+		// analyzeFollowing laeuft, bis der Benutzer mit Ctrl-C
+		// abbricht, und kuemmert sich auch um das Ueberspringen
+		signal(SIGINT, stopFollowing);
+		signal(SIGTERM, stopFollowing);
+		analysisObject->analyzeFollowing(options.firstEvent,
+				options.maxNoOfEvents, options.refreshInterval);
+		delete analysisObject;
+		return 0;
+	}
+
+	// Ueberspringe Events, falls das gewuenscht wird
+	// Die skipEvents Methode gibt einen Wert ungleich 0 zurueck, falls
+	// das Ende der Datei erreicht wurde. In diesem Fall sind wir fertig.
+	if (analysisObject->skipEvents(options.firstEvent) != 0)
+		return 0;
+		
+	if (options.nThreads > 1) {
+		// mit mehreren Threads uebernimmt analyzeParallel das Lesen
+		// und Analysieren
+		analysisObject->analyzeParallel(options.maxNoOfEvents,
+				options.nThreads);
+	} else {
+		// Loope ueber alle verbleibenden Ereignisse
+		while (analysisObject->readEvent() == 0) {
+			// Analysiere das Ereignis
+			analysisObject->analyze();
+			// Abbrechen, falls gewuensche Anzahl Ereignisse
+			// analysiert
+			if (analysisObject->getNoOfAnalyzedEvents() >=
+					options.maxNoOfEvents)
+				break;
+		}
+	}
+
+	// die Instanz der Analyseklasse loeschen und den Speicher freigeben
+	// (der delete-Operator ruft den Destruktor der Klasse)
+	delete analysisObject;
+
+	return 0;
+}
+
 int main(int argc, char *argv[]) 
 {
 	// Setzte Standardwerte fuer die Anzahl der zu prozessierenden
@@ -69,12 +426,38 @@ int main(int argc, char *argv[])
 	unsigned long maxNoOfEvents = defMaxNoOfEvents;
 	// Anzahl zu ueberspringender Events
 	unsigned long firstEvent = defFirstEvent;
-	string inputDataFileName = defInputDataFileName;
+	// Eingabedateien (mehrere: Laeufe, s. fp13RunSet.h)
+	vector<string> inputDataFileNames;
 	string rootOutputFileName = defRootOutputFileName;
+	// Anzahl der Threads zum Lesen der Eingabedatei
+	unsigned nReadThreads = defNoOfReadThreads;
+	// Anzahl der Threads zum Analysieren
+	unsigned nThreads = defNoOfThreads;
+	// nur Ereignisindex erstellen bzw. ein Ereignis ausgeben
+	bool onlyBuildIndex = false;
+	bool onlyDumpEvent = false;
+	unsigned long dumpEventNr = 0;
+	// Eingabedatei verfolgen, waehrend sie waechst
+	bool follow = false;
+	// Abstand der Aktualisierungen der Ausgabedatei beim Verfolgen
+	unsigned refreshInterval = defRefreshInterval;
+	// Anzahl der Detektorlagen
+	int nLayers = defNoOfLayers;
+	// Konfigurationen fuer systematische Studien
+	vector<fp13ScanConfig> scanConfigs;
+	// Datei fuer die Tabelle der Kandidaten (leer: keine)
+	string candidateFileName;
+	// Datei fuer den Skim (leer: keiner)
+	string skimFileName;
+	// Datei fuer den Flag-Index (leer: keiner)
+	string flagIndexFileName;
+	// Ereignisbildung aus einem Hitstrom
+	bool hitStream = false;
+	fp13HitStreamConfig hitStreamConfig;
 
 	// Lese Programmoptionen aus
 	int c;
-	while ((c = getopt(argc, argv, "hqvn:i:o:s:")) != -1) {
+	while ((c = getopt(argc, argv, "hqvxfn:i:o:s:p:j:e:u:l:S:c:k:b:w:")) != -1) {
 		switch (c) {
 			case 'n':// Anzahl der zu verarbeitenden Ereignisse
 				// istringstream vorbereiten, aus dem die
@@ -92,12 +475,86 @@ int main(int argc, char *argv[])
 				  stream >> firstEvent; // Lesen
 				}
 				break;
-			case 'i':// Name der Eingabedatei
-				inputDataFileName = optarg;
+			case 'p':// Anzahl der Threads zum Lesen
+				{
+				  istringstream stream(optarg);
+				  stream >> nReadThreads; // Lesen
+				}
+				if (nReadThreads < 1)
+					nReadThreads = 1;
+				break;
+			case 'j':// Anzahl der Threads zum Analysieren
+				{
+				  istringstream stream(optarg);
+				  stream >> nThreads; // Lesen
+				}
+				if (nThreads < 1)
+					nThreads = 1;
+				break;
+			case 'x':// nur Ereignisindex erstellen
+				onlyBuildIndex = true;
+				break;
+			case 'e':// nur ein Ereignis ausgeben
+				{
+				  istringstream stream(optarg);
+				  stream >> dumpEventNr; // Lesen
+				}
+				onlyDumpEvent = true;
+				break;
+			case 'f':// Eingabedatei verfolgen
+				follow = true;
+				break;
+			case 'u':// Abstand der Aktualisierungen
+				{
+				  istringstream stream(optarg);
+				  stream >> refreshInterval; // Lesen
+				}
+				break;
+			case 'l':// Anzahl der Detektorlagen
+				{
+				  istringstream stream(optarg);
+				  stream >> nLayers; // Lesen
+				}
+				break;
+			case 'S':// Konfiguration fuer den Scan
+				{
+				  fp13ScanConfig config;
+				  if (!config.parse(optarg)) {
+					  error << "Ungueltige Konfiguration " <<
+						  optarg << " (erwartet: name:"
+						  "minDelay:mergeWindow[:variant])." <<
+						  endl;
+					  return -1;
+				  }
+				  scanConfigs.push_back(config);
+				}
+				break;
+			case 'i':// Name der Eingabedatei(en)
+				if (!addInputFiles(optarg, inputDataFileNames))
+					return -1;
 				break;
 			case 'o':// Name der Ausgabedatei
 				rootOutputFileName = optarg;
 				break;
+			case 'c':// Name der Tabelle der Kandidaten
+				candidateFileName = optarg;
+				break;
+			case 'k':// Name des Skims
+				skimFileName = optarg;
+				break;
+			case 'b':// Name des Flag-Index
+				flagIndexFileName = optarg;
+				break;
+			case 'w':// Ereignisse aus einem Hitstrom bilden
+				if (!hitStreamConfig.parse(optarg)) {
+					error << "Ungueltige Parameter " << optarg <<
+						" fuer die Ereignisbildung (erwartet: "
+						"window[:deadTime[:coincidence"
+						"[:triggerMask]]])." << endl;
+					return -1;
+				}
+				hitStream = true;
+				break;
 			case '?':// Unbekannter Optionsbuchstabe
 			case 'h':// Hilfe
 				help(argv[0]);
@@ -117,44 +574,137 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	// Benutzer informieren, was getan wird
-	info << endl << string(72, '*') << endl <<
-		"Eingabedatei:\t\t" << inputDataFileName << endl <<
-		"Ausgabedatei:\t\t" << rootOutputFileName << endl <<
-		"Bearbeite maximal\t" << maxNoOfEvents << " Ereignisse" << endl <<
-		"Ueberspringe\t\t" << firstEvent << " Ereignisse" << endl <<
-		string(72, '*') << endl << endl;
+	// weitere Eingabedateien nach den Optionen
+	for (int i = optind; i < argc; ++i)
+		if (!addInputFiles(argv[i], inputDataFileNames))
+			return -1;
+	if (inputDataFileNames.empty())
+		inputDataFileNames.push_back(defInputDataFileName);
+	const string& inputDataFileName = inputDataFileNames[0];
+	const bool manyRuns = inputDataFileNames.size() > 1;
+	// die Laeufe werden nur gelesen und analysiert; Ereignisnummern
+	// (fuer -s, -c, -k, -b) gibt es nur innerhalb einer Datei
+	if (manyRuns && (onlyBuildIndex || onlyDumpEvent || follow ||
+				!scanConfigs.empty() || firstEvent ||
+				!candidateFileName.empty() ||
+				!skimFileName.empty() ||
+				!flagIndexFileName.empty() || hitStream)) {
+		error << "Mit mehreren Eingabedateien koennen -x, -e, -f, -S, "
+			"-s, -c, -k, -b und -w nicht benutzt werden." << endl;
+		return -1;
+	}
 
-	// Erzeuge Instanz der Analyseklasse
-	// Das Oeffnen der Dateien und Buchen der Histogramme uebernimmt
-	// der Konstruktor, das Speichern der Histogramme und schliessen
-	// der Dateien der Destruktor
-	fp13Analysis *analysisObject = 
-		new fp13Analysis(inputDataFileName, rootOutputFileName);
+	if (onlyBuildIndex)
+		return buildIndex(inputDataFileName);
+	if (onlyDumpEvent)
+		return dumpEvent(inputDataFileName, dumpEventNr);
 
-	// Ueberspringe Events, falls das gewuenscht wird
-	while (analysisObject->getNoOfEvents() < firstEvent) {
-		// Die readEvent Methode gibt einen Wert ungleich 0
-		// zurueck, falls das Ende der Datei erreicht wurde.
-		// In diesem Fall sind wir fertig.
-		if (analysisObject->readEvent() != 0)
-			return 0;
+	// beim Verfolgen wird in einem Thread gelesen und analysiert
+	if (follow)
+		nReadThreads = nThreads = 1;
+	if (follow && !scanConfigs.empty()) {
+		error << "-S und -f koennen nicht zusammen benutzt werden." <<
+			endl;
+		return -1;
 	}
-		
-	// Loope ueber alle verbleibenden Ereignisse
-	while (analysisObject->readEvent() == 0) {
-		// Analysiere das Ereignis
-		analysisObject->analyze();
-		// Abbrechen, falls gewuensche Anzahl Ereignisse analysiert
-		if (analysisObject->getNoOfAnalyzedEvents() >=
-				maxNoOfEvents)
-			break;
+	// nach einem Neustart aus dem Checkpoint fehlten die Kandidaten
+	// von vorher
+	if (follow && !candidateFileName.empty()) {
+		error << "-c und -f koennen nicht zusammen benutzt werden." <<
+			endl;
+		return -1;
+	}
+	if (follow && !skimFileName.empty()) {
+		error << "-k und -f koennen nicht zusammen benutzt werden." <<
+			endl;
+		return -1;
+	}
+	if (follow && !flagIndexFileName.empty()) {
+		error << "-b und -f koennen nicht zusammen benutzt werden." <<
+			endl;
+		return -1;
+	}
+	// Hitstroms werden nur von fp13BasicAnalysis selbst gelesen, ohne
+	// Ereignisindex und nicht beim Verfolgen; die Nummern im Flag-Index
+	// waeren die der gebildeten Ereignisse, fp13query sucht sie aber
+	// ueber den Ereignisindex der Textdatei
+	if (hitStream && (follow || !scanConfigs.empty() || onlyBuildIndex ||
+				onlyDumpEvent || !flagIndexFileName.empty())) {
+		error << "-w kann nicht zusammen mit -f, -S, -x, -e oder -b "
+			"benutzt werden." << endl;
+		return -1;
+	}
+	// der Scan liest die Zeitbins nicht zusammengefasst (s. fp13Scan.h)
+	if (!scanConfigs.empty() && !skimFileName.empty()) {
+		error << "-k und -S koennen nicht zusammen benutzt werden." <<
+			endl;
+		return -1;
 	}
 
-	// die Instanz der Analyseklasse loeschen und den Speicher freigeben
-	// (der delete-Operator ruft den Destruktor der Klasse)
-	delete analysisObject;
+	// Benutzer informieren, was getan wird
+	info << endl << string(72, '*') << endl;
+	if (manyRuns)
+		info << "Eingabedateien:\t\t" << inputDataFileNames.size() <<
+			" Laeufe, " << inputDataFileNames.front() << " ... " <<
+			inputDataFileNames.back() << endl;
+	else
+		info << "Eingabedatei:\t\t" << inputDataFileName << endl;
+	info << "Ausgabedatei:\t\t" << rootOutputFileName << endl <<
+		"Bearbeite maximal\t" << maxNoOfEvents << " Ereignisse" << endl <<
+		"Ueberspringe\t\t" << firstEvent << " Ereignisse" << endl <<
+		"Threads zum Lesen\t" << nReadThreads << endl <<
+		"Threads zum Analysieren\t" << nThreads << endl <<
+		"Detektorlagen\t\t" << nLayers << endl;
+	if (!scanConfigs.empty())
+		info << "Konfigurationen\t\t" << scanConfigs.size() << endl;
+	if (!candidateFileName.empty())
+		info << "Kandidaten\t\t" << candidateFileName << endl;
+	if (!skimFileName.empty())
+		info << "Skim\t\t\t" << skimFileName << endl;
+	if (!flagIndexFileName.empty())
+		info << "Flag-Index\t\t" << flagIndexFileName << endl;
+	if (hitStream)
+		info << "Hitstrom\t\tFenster " << hitStreamConfig.window <<
+			" ns, Totzeit " << hitStreamConfig.deadTime <<
+			" ns, Koinzidenz " << hitStreamConfig.coincidence <<
+			" ns, Trigger " << hitStreamConfig.triggerMask << endl;
+	if (follow)
+		info << "Verfolge Eingabedatei, aktualisiere alle " <<
+			refreshInterval << " s" << endl;
+	info << string(72, '*') << endl << endl;
 
-	// wir sind fehlerfrei durchgelaufen und geben daher 0 zurueck
-	return 0;
+	// Analyse fuer die gewuenschte Anzahl von Detektorlagen; jede
+	// Anzahl ist eine eigene Instanz von fp13BasicAnalysis
+	static const struct {
+		int nLayers;
+		int (*analyze)(const fp13Options&);
+	} analyses[] = {
+		{ 6, analyze<6> },
+		{ 8, analyze<8> },
+		{ 12, analyze<12> },
+		{ 16, analyze<16> },
+		{ 32, analyze<32> }
+	};
+	fp13Options options;
+	options.inputDataFileNames = inputDataFileNames;
+	options.rootOutputFileName = rootOutputFileName;
+	options.firstEvent = firstEvent;
+	options.maxNoOfEvents = maxNoOfEvents;
+	options.nReadThreads = nReadThreads;
+	options.nThreads = nThreads;
+	options.follow = follow;
+	options.refreshInterval = refreshInterval;
+	options.scanConfigs = scanConfigs;
+	options.candidateFileName = candidateFileName;
+	options.skimFileName = skimFileName;
+	options.flagIndexFileName = flagIndexFileName;
+	options.hitStreamConfig = hitStream ? &hitStreamConfig : 0;
+	for (size_t i = 0; i < sizeof(analyses) / sizeof(analyses[0]); ++i)
+		if (analyses[i].nLayers == nLayers)
+			return analyses[i].analyze(options);
+	error << "Detektoren mit " << nLayers << " Lagen werden "
+		"nicht unterstuetzt (6, 8, 12, 16 oder 32)." << endl;
+	return -1;
 }
+
+// Dateiende
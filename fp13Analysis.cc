@@ -32,26 +32,49 @@
 
 #include <string>
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <sstream>
-#include <iomanip>
+#include <thread>
+#include <typeinfo>
+#include <cstdio>
+#include <ctime>
+
+// C header files (fuer stat)
+#include <sys/stat.h>
+
+#include <TROOT.h>
+#include <TParameter.h>
 
+#include "fp13Index.h"
+#include "fp13FollowInput.h"
+#include "fp13Classify.h"
+#include "fp13Skim.h"
 #include "logstream.h"
 
 using namespace logstreams;
 
 // Konstruktor
-fp13Analysis::fp13Analysis(const string& ifilename, const string& ofilename) :
+template <int N>
+fp13BasicAnalysis<N>::fp13BasicAnalysis(const string& ifilename,
+		const string& ofilename, unsigned nReadThreads, bool follow) :
+	minDelay(defMinDelay),
 	eventCounter(0), analyzedCounter(0),
-	inputFile((ifilename == "-")?cin:
-			(* new ifstream(ifilename.c_str()))),
+	inputFile(follow ? fp13FollowInput::open(ifilename) :
+			fp13Input::open(ifilename, nReadThreads)),
 	outputFile(* new TFile(ofilename.c_str(), "RECREATE")),
+	outputDirectory(&outputFile),
 	inputFileName(ifilename),
 	outputFileName(ofilename),
-	eventFlags(FlagNone)
+	eventFlags(FlagNone),
+	isWorker(false),
+	classifier(0),
+	candidateWriter(0), candidates(0), currentEvent(0),
+	skim(0),
+	flagIndex(0), flagFirstEvent(0)
 {
 	// Fehler fuer Eingabedatei aufgetreten? (D.h. ist Datei offen?)
-	if (inputFile.fail()) {
+	if (!inputFile) {
 		delete &outputFile;
 		error << "Fehler beim Oeffnen der Eingabedatei " <<
 			ifilename << "." << endl;
@@ -59,10 +82,7 @@ fp13Analysis::fp13Analysis(const string& ifilename, const string& ofilename) :
 	}
 	// Ausgabedatei offen?
 	if (outputFile.IsZombie()) {
-		// falls die Daten von cin kommen, darf der Speicher
-		// nicht zurueckgegeben werden
-		if (&inputFile != &cin)
-			delete &inputFile;
+		delete inputFile;
 		error << "Fehler beim Oeffnen der Ausgabedatei " <<
 			ofilename << "." << endl;
 		throw;
@@ -77,21 +97,148 @@ fp13Analysis::fp13Analysis(const string& ifilename, const string& ofilename) :
 	detectorHitTimes.reserve(32);
 }
 
+// Konstruktor mit schon geoeffneter Eingabe
+template <int N>
+fp13BasicAnalysis<N>::fp13BasicAnalysis(fp13Input* input,
+		const string& ofilename) :
+	minDelay(defMinDelay),
+	eventCounter(0), analyzedCounter(0),
+	inputFile(input),
+	outputFile(* new TFile(ofilename.c_str(), "RECREATE")),
+	outputDirectory(&outputFile),
+	inputFileName(input ? input->getFileName() : string()),
+	outputFileName(ofilename),
+	eventFlags(FlagNone),
+	isWorker(false),
+	classifier(0),
+	candidateWriter(0), candidates(0), currentEvent(0),
+	skim(0),
+	flagIndex(0), flagFirstEvent(0)
+{
+	if (!inputFile) {
+		delete &outputFile;
+		error << "Keine Eingabe." << endl;
+		throw;
+	}
+	if (outputFile.IsZombie()) {
+		delete inputFile;
+		error << "Fehler beim Oeffnen der Ausgabedatei " <<
+			ofilename << "." << endl;
+		throw;
+	}
+
+	bookHistograms();
+
+	detectorHitMask.reserve(32);
+	detectorHitTimes.reserve(32);
+}
+
+// Konstruktor ohne eigene Eingabe
+template <int N>
+fp13BasicAnalysis<N>::fp13BasicAnalysis(const string& ofilename) :
+	minDelay(defMinDelay),
+	eventCounter(0), analyzedCounter(0),
+	inputFile(0),
+	outputFile(* new TFile(ofilename.c_str(), "RECREATE")),
+	outputDirectory(&outputFile),
+	outputFileName(ofilename),
+	eventFlags(FlagNone),
+	isWorker(false),
+	classifier(0),
+	candidateWriter(0), candidates(0), currentEvent(0),
+	skim(0),
+	flagIndex(0), flagFirstEvent(0)
+{
+	if (outputFile.IsZombie()) {
+		error << "Fehler beim Oeffnen der Ausgabedatei " <<
+			ofilename << "." << endl;
+		throw;
+	}
+
+	bookHistograms();
+
+	detectorHitMask.reserve(32);
+	detectorHitTimes.reserve(32);
+}
+
+// Konstruktor fuer Worker-Objekte
+template <int N>
+fp13BasicAnalysis<N>::fp13BasicAnalysis(const fp13BasicAnalysis& master) :
+	minDelay(master.minDelay),
+	eventCounter(0), analyzedCounter(0),
+	inputFile(0),
+	outputFile(master.outputFile),
+	outputDirectory(master.outputDirectory),
+	inputFileName(master.inputFileName),
+	outputFileName(master.outputFileName),
+	eventFlags(FlagNone),
+	isWorker(true),
+	classifier(0),
+	candidateWriter(master.candidateWriter),
+	candidates(master.candidateWriter ? new fp13CandidateBlock : 0),
+	currentEvent(0),
+	skim(0),
+	flagIndex(master.flagIndex), flagFirstEvent(0)
+{
+	// Histogramme buchen; sie werden am Ende zu denen des Hauptobjekts
+	// addiert
+	bookHistograms();
+
+	detectorHitMask.reserve(32);
+	detectorHitTimes.reserve(32);
+}
+
 // Destruktor
-fp13Analysis::~fp13Analysis()
+template <int N>
+fp13BasicAnalysis<N>::~fp13BasicAnalysis()
 {
+	delete classifier;
+	// restliche Kandidaten schreiben
+	flushCandidates();
+	delete candidates;
+	// und die restlichen Eintraege fuer den Flag-Index
+	flushFlagIndex();
+	// Worker-Objekte besitzen nur ihre eigenen Histogramme (und
+	// Kandidaten)
+	if (isWorker) {
+		deleteHistograms();
+		return;
+	}
+
 	// Anzahl der verarbeiteten Events ausgeben
 	info << string(72, '*') << endl <<
 		setw(8) << eventCounter << " Ereignisse gelesen, davon " <<
 		setw(8) << analyzedCounter << " Ereignisse analysiert." <<
 		endl << string(72, '*') << endl << endl;
+	if (candidateWriter) {
+		info << candidateWriter->getNoOfCandidates() << " Kandidaten "
+			"nach " << candidateWriter->getFileName() <<
+			" geschrieben." << endl;
+		delete candidateWriter;
+	}
+	if (skim) {
+		info << skim->getNoOfSelectedEvents() << " von " <<
+			skim->getNoOfEvents() << " Ereignissen nach " <<
+			skim->getFileName() << " geschrieben." << endl;
+		delete skim;
+	}
+	if (flagIndex) {
+		if (flagIndex->write())
+			info << "Flag-Index fuer " <<
+				flagIndex->getNoOfAnalyzedEvents() <<
+				" Ereignisse nach " << flagIndex->getFileName() <<
+				" geschrieben." << endl;
+		else
+			error << "Fehler beim Schreiben von " <<
+				flagIndex->getFileName() << "." << endl;
+		delete flagIndex;
+	}
 
-	outputFile.Write();
-	outputFile.Flush();
+	refreshOutput();
 
 	// allokierte Objekte freigeben
-	if (&inputFile != &cin)
-		delete (ifstream*) &inputFile;
+	deleteHistograms();
+	delete inputFile;
 	delete &outputFile;
 }
 
@@ -99,11 +246,15 @@ fp13Analysis::~fp13Analysis()
 // PUBLIC MEMEBER FUNCTIONS
 ////////////////////////////////////////////////////////////////////////
 // Einlesen und Formatieren der Daten
-int fp13Analysis::readEvent() 
+template <int N>
+int fp13BasicAnalysis<N>::readEvent() 
 {
-	// falls das Ende der Datei erreicht wurde, wird -1 zurueckgegeben
-	if (inputFile.eof())
-		return -1;
+	// ohne eigene Eingabe kommen die Ereignisse von aussen
+	if (!inputFile) {
+		error << "Dieses Analyseobjekt hat keine eigene "
+			"Eingabedatei." << endl;
+		throw;
+	}
 
 	// Statusreport alle 10000 Ereignisse
 	if ((eventCounter % 10000) == 0) {
@@ -112,352 +263,786 @@ int fp13Analysis::readEvent()
 			" analysiert." << endl;
 	}
 
-	// Initialisiere alle ereignisbezogenen Klassenvariablen
-	detectorHitMask.clear();
-	detectorHitTimes.clear();
+	// Das Lesen und Formatieren der Zeilen uebernimmt die Eingabequelle
+	// (siehe fp13Input.cc); falls das Ende der Datei erreicht wurde,
+	// wird -1 zurueckgegeben
+	// (beim Verfolgen der Datei 1, falls gerade kein Ereignis da ist)
+	int retVal;
+	while (0 == (retVal = inputFile->readEvent(inputHitMask,
+					detectorHitTimes, eventCounter))) {
+		// Zaehle die erfolgreich gelesenen Ereignisse
+		currentEvent = eventCounter++;
+		if (setHitMask(inputHitMask))
+			break;
+		if (skim)
+			skim->countEvent(currentEvent);
+	}
+	if (0 != retVal)
+		return (retVal > 0) ? 1 : -1;
+	if (skim)
+		skimEvent();
+
+	// Event erfolgreich gelesen
+	return 0;
+}
 
-	// string zum Einlesen einer Zeile aus dem Eingabefile
-	string buf;
-	// istringstream zum Lesen der Zahlen aus der Zeile in buf
-	istringstream bufStream;
-	// Format der Daten in dem Textinputfile:
-	// Beispiel eines Ereignisses (Zerfall nach unten)
-	//
-	// Zeitbinnumerierung     Binaeres Detektorhitmuster     Zeitpunkt der Hits [ns]
-	//         1                        127                            50
-	//         2                        128                          2370
-	//        ###
-	//
-	// Die Zeichenfolge ### markiert das Ende eines Ereignisses
-	//
-	// Mit eingelesenes carriage return '\r' aus Dateien mit DOS-Zeilen-
-	// endkonvention wird im Folgenden geflissentlich ignoriert
-	// Solange kein Fehler auftritt:
-	unsigned merged = 0;
-	while (getline(inputFile, buf).good()) {
-		// Verlasse die Schleife, wenn die Zeichenfolge fuer das Ende
-		// eines Ereignisses gefunden wurde. Ein einzelnes "###" am
-		// Anfang des Ereignisses wird ueberlesen, da die Datenfiles
-		// mit "###" anfangen...
-		if (buf.find("###", 0) != string::npos) {
-			if (detectorHitMask.empty())
-				continue;
-			else
-				break;
+// Ueberspringen der Ereignisse bis zum Ereignis event
+template <int N>
+int fp13BasicAnalysis<N>::skipEvents(unsigned long event)
+{
+	if (!inputFile) {
+		error << "Dieses Analyseobjekt hat keine eigene "
+			"Eingabedatei." << endl;
+		throw;
+	}
+	// beim Ueberspringen gelesene Ereignisse kommen nicht in den Skim
+	fp13SkimOutput* const skimOutput = skim;
+	skim = 0;
+	// moeglichst weit springen...
+	eventCounter = fp13EventIndex::seek(*inputFile, eventCounter, event);
+	// ... und den Rest lesen
+	int retVal = 0;
+	while (eventCounter < event) {
+		if (readEvent() < 0) {
+			retVal = -1;
+			break;
 		}
+	}
+	skim = skimOutput;
+	return retVal;
+}
 
-		// Wir wollen aus der Zeile in buf Zahlen in Variablen
-		// lesen. Dazu muss bufStream ueber den neuen Inhalt von
-		// buf Bescheid wissen.
-		bufStream.str(buf);
-
-		// Variablen zum Zwischenspeichern der ausgelesenen Daten
-		int hitMask, hitTime;
-		unsigned nBin;
-		// Extrahieren der einzelnen Informationen aus dem Buffer
-		// und Zwischenspeicherung
-		bufStream >> nBin >> hitMask >> hitTime;
-		// Auf Fehler beim Einlesen der drei Zahlen pruefen
-		if (bufStream.fail()) {
-			warn << "Ungueltig formatierte Daten in Ereignis " <<
-				eventCounter << " Zeitbin " <<
-				detectorHitMask.size() <<
-				", mache trotzdem weiter." << endl;
-			continue;
+// Analyse der Daten und Fuellen der Histogramme
+template <int N>
+void fp13BasicAnalysis<N>::analyze() 
+{
+	// ohne eigene Methoden zum Finden von Zerfaellen und Nachpulsen
+	// geht es mit den vorab berechneten Tabellen schneller (die es fuer
+	// bis zu 8 Lagen gibt; N steht beim Uebersetzen fest)
+	if (N <= 8 && !hasOwnFinders()) {
+		analyzeWithTables();
+	} else {
+		// sonst werden die Methoden zum Finden von Zerfaellen und
+		// Nachpulsen virtuell aufgerufen, so dass abgeleitete Klassen
+		// sie ueberschreiben koennen (ohne virtuelle Aufrufe s.
+		// fp13StaticAnalysis.h)
+		analyzeEvent(*this);
+	}
+	// eventFlags und lastMuonLayer stehen fest
+	indexEvent();
+}
+
+// Lesen und Analysieren mit mehreren Threads
+template <int N>
+void fp13BasicAnalysis<N>::analyzeParallel(unsigned long maxNoOfEvents,
+		unsigned nThreads)
+{
+	// so viele Ereignisse werden auf einmal an einen Thread uebergeben
+	static const size_t batchSize = 4096;
+
+	// ein Worker-Objekt pro Thread anlegen
+	vector<fp13BasicAnalysis*> workers;
+	for (unsigned i = 0; i < nThreads; ++i) {
+		fp13BasicAnalysis* worker = createWorker();
+		if (typeid(*worker) != typeid(*this)) {
+			error << typeid(*this).name() << " muss createWorker "
+				"ueberschreiben, um mit mehreren Threads "
+				"zu analysieren." << endl;
+			throw;
 		}
-		// Zeiten und Hitmasken kommen in je einen Vektor
-		detectorHitMask.push_back(hitMask);
-		detectorHitTimes.push_back(hitTime);
-		// check for increasing times
-		if (detectorHitMask.size() > 1) {
-			int delay = hitTime -
-				detectorHitTimes[detectorHitMask.size() - 2];
-			int deltadata = hitMask ^
-				detectorHitMask[detectorHitMask.size() - 2];
-			if (delay <= 0)
-				warn << "In Ereignis " <<
-					(eventCounter + 1) << ": Zeit steigt"
-					" nicht streng monoton an: Bin " <<
-					detectorHitMask.size() << " delay " <<
-					delay << " deltaData " << deltadata <<
-					"." << endl;
-      //Wenn signale 40ns oder naeher zusammenliegen werden sie zusammengefuegt (endl. Zeitaufloesung)
-			if (delay <= 60){ 
-				detectorHitMask[detectorHitMask.size() - 2] = detectorHitMask[detectorHitMask.size() - 2] | hitMask;
-				detectorHitMask.pop_back();
-				detectorHitTimes.pop_back();
-				merged++;
+		workers.push_back(worker);
+	}
+
+	// Threads starten
+	ROOT::EnableThreadSafety();
+	BatchQueue queue(2 * nThreads);
+	vector<thread> threads;
+	for (unsigned i = 0; i < nThreads; ++i)
+		threads.push_back(thread(&fp13BasicAnalysis::workerLoop,
+					workers[i], ref(queue)));
+
+	// Ereignisse lesen und paketweise an die Threads verteilen; das
+	// Abbruchkriterium ist dasselbe wie in der Schleife in fp13.cc
+	Batch* batch = queue.getFree();
+	while (readEvent() == 0) {
+		// Ereignisse, die nicht mehr ins Paket passen (mehr als
+		// UINT32_MAX Zeitbins), werden gleich hier analysiert; da die
+		// Histogramme am Ende ohnehin addiert werden, kommt dasselbe
+		// heraus (analyze zaehlt analyzedCounter selbst mit)
+		// Damit die Ereignisse jedes Pakets fortlaufend nummeriert
+		// sind, wird das Paket vorher abgeschickt.
+		if (!batch->size())
+			batch->setFirstEvent(currentEvent);
+		if (batch->append(detectorHitMask, detectorHitTimes)) {
+			++analyzedCounter;
+		} else {
+			if (batch->size()) {
+				queue.push(batch);
+				batch = queue.getFree();
 			}
+			analyze();
 		}
-		// Ueberpruefen, ob konsistent mit der Zaehlung im Datenfile
-		if (nBin != (detectorHitMask.size()+merged)) {
-			// Wenn nicht, ist irgendetwas faul...
-			// EventCounter wird erst erhoeht, wenn das Ereignis
-			// komplett gelesen wurde, daher das "+ 1" unten
-			warn << "In Ereignis " << (eventCounter + 1) <<
-				": Zeitbinzaehlung unstimmig (Bin " <<
-				detectorHitMask.size() << " in Eingabedaten "
-				"erscheint als " <<
-				nBin << " beim Lesen). merged = " << merged << endl;
+		if (analyzedCounter >= maxNoOfEvents)
+			break;
+		if (batch->size() >= batchSize) {
+			queue.push(batch);
+			batch = queue.getFree();
 		}
 	}
-	// OK, Event eingelesen oder Fehler aufgetreten
+	if (batch->size())
+		queue.push(batch);
+	else
+		queue.release(batch);
+	queue.finish();
 
-	// auf Lesefehler pruefen (nicht Ende der Eingabedatei)
-	if (inputFile.bad()) {
-		error << "Fehler beim Lesen der Eingabedatei " <<
-			inputFileName << "." << endl;
-		throw;
+	// warten, bis alle Threads fertig sind, und Histogramme in fester
+	// Reihenfolge aufaddieren
+	for (unsigned i = 0; i < nThreads; ++i) {
+		threads[i].join();
+		mergeHistograms(*workers[i]);
+		delete workers[i];
 	}
-	// falls das Ende der Datei erreicht wurde, wird -1 zurueckgegeben
-	if (inputFile.eof() && detectorHitMask.empty())
-		return -1;
-	// falls nicht Ende der Datei aber trotzdem leeres Event, Fehler-
-	// meldung ausgeben...
-	if (detectorHitMask.empty()) {
-		warn << "leeres Event in der Eingabedatei " <<
-			inputFileName << "." << endl;
+}
+
+template <int N>
+unsigned long fp13BasicAnalysis<N>::getNoOfEvents()
+{ return eventCounter; }
+
+template <int N>
+unsigned long fp13BasicAnalysis<N>::getNoOfAnalyzedEvents()
+{ return analyzedCounter; }
+
+template <int N>
+int fp13BasicAnalysis<N>::getMinDelay() const
+{ return minDelay; }
+
+template <int N>
+void fp13BasicAnalysis<N>::setMinDelay(int delay)
+{
+	minDelay = delay;
+	// der Classifier kennt noch den alten Wert
+	delete classifier;
+	classifier = 0;
+}
+
+// Schreiben der Tabelle der Kandidaten
+template <int N>
+bool fp13BasicAnalysis<N>::writeCandidates(const string& fileName)
+{
+	fp13CandidateWriter* writer = new fp13CandidateWriter(fileName,
+			nLayers);
+	if (!writer->isOpen()) {
+		error << "Fehler beim Oeffnen der Ausgabedatei " << fileName <<
+			"." << endl;
+		delete writer;
+		return false;
+	}
+	// eine vorher angegebene Tabelle abschliessen
+	flushCandidates();
+	delete candidates;
+	delete candidateWriter;
+	candidateWriter = writer;
+	candidates = new fp13CandidateBlock;
+	return true;
+}
+
+// Schreiben eines Skims
+template <int N>
+bool fp13BasicAnalysis<N>::writeSkim(const string& fileName)
+{
+	if (!inputFile) {
+		error << "Dieses Analyseobjekt hat keine eigene "
+			"Eingabedatei." << endl;
+		return false;
+	}
+	// Hitmuster so breit wie in den Paketen (s. fp13LayerMask)
+	fp13SkimOutput* output = new fp13SkimOutput(fileName, sizeof(Mask),
+			inputFileName, inputFile->getMergeWindow());
+	if (!output->isOpen()) {
+		error << "Fehler beim Oeffnen der Ausgabedatei " << fileName <<
+			"." << endl;
+		delete output;
+		return false;
+	}
+	delete skim;
+	skim = output;
+	return true;
+}
+
+// Schreiben eines Flag-Index
+template <int N>
+bool fp13BasicAnalysis<N>::writeFlagIndex(const string& fileName)
+{
+	fp13FlagIndexWriter* writer = new fp13FlagIndexWriter(fileName,
+			nLayers);
+	if (!writer->isOpen()) {
+		error << "Fehler beim Oeffnen der Ausgabedatei " << fileName <<
+			"." << endl;
+		delete writer;
+		return false;
+	}
+	// ein vorher angegebener Index wird nicht geschrieben
+	flagCodes.clear();
+	delete flagIndex;
+	flagIndex = writer;
+	return true;
+}
+
+// Auswahl der Ereignisse fuer den Skim
+template <int N>
+void fp13BasicAnalysis<N>::skimEvent()
+{
+	skim->countEvent(currentEvent);
+	// dieselben Bedingungen wie in analyze, bevor nach Zerfaellen und
+	// Nachpulsen gesucht wird
+	if (2 > detectorHitMask.size() ||
+			-1 == determineLastLayerHitByIncomingMuon())
+		return;
+	if (!skim->writeEvent(inputHitMask, detectorHitTimes))
+		warn << "Hitmuster in Ereignis " << currentEvent << " passt "
+			"nicht in den Skim." << endl;
+}
+
+// Uebernehmen der gelesenen Hitmuster
+template <int N>
+bool fp13BasicAnalysis<N>::setHitMask(const vector<int>& mask)
+{
+	for (size_t i = 0; i < mask.size(); ++i) {
+		if (!Batch::fits(mask[i])) {
+			warn << "Hitmuster " << mask[i] << " in Ereignis " <<
+				currentEvent << " passt nicht zu " << nLayers <<
+				" Lagen, ueberspringe das Ereignis." << endl;
+			return false;
+		}
+	}
+	detectorHitMask.assign(mask.begin(), mask.end());
+	return true;
+}
+
+// Verfolgen der wachsenden Eingabedatei
+template <int N>
+void fp13BasicAnalysis<N>::analyzeFollowing(unsigned long firstEvent,
+		unsigned long maxNoOfEvents, unsigned refreshInterval)
+{
+	fp13FollowInput* followInput = dynamic_cast<fp13FollowInput*>(inputFile);
+	if (!followInput) {
+		error << "analyzeFollowing braucht ein mit follow erzeugtes "
+			"Analyseobjekt." << endl;
 		throw;
 	}
+	const string checkpointFileName = outputFileName + ".ckpt";
 
-	// Zaehle die erfolgreich gelesenen Ereignisse
-	eventCounter++;
+	// beim letzten Checkpoint weitermachen, falls moeglich
+	size_t offset;
+	if (loadCheckpoint(checkpointFileName, offset) &&
+			followInput->seek(offset)) {
+		info << "Mache bei Ereignis " << eventCounter << " (" <<
+			analyzedCounter << " analysiert) aus Checkpoint " <<
+			checkpointFileName << " weiter." << endl;
+	} else {
+		// Histogramme aus einem unbrauchbaren Checkpoint verwerfen
+		vector<fp13Histogram*> histograms;
+		getHistograms(histograms);
+		for (size_t i = 0; i < histograms.size(); ++i)
+			histograms[i]->reset();
+		eventCounter = analyzedCounter = 0;
+		if (skipEvents(firstEvent) != 0)
+			return;
+	}
 
-	// Event erfolgreich gelesen
-	return 0;
+	bool checkpointFailed = false;
+	time_t lastRefresh = time(0);
+	for (;;) {
+		const int retVal = readEvent();
+		if (retVal < 0)
+			break;
+		if (0 == retVal) {
+			analyze();
+			if (analyzedCounter >= maxNoOfEvents)
+				break;
+		}
+		// regelmaessig Ausgabedatei und Checkpoint schreiben
+		if (time(0) - lastRefresh >=
+				static_cast<time_t>(refreshInterval)) {
+			refreshOutput();
+			if (!saveCheckpoint(checkpointFileName,
+						followInput->tell()) &&
+					!checkpointFailed) {
+				warn << "Kann Checkpoint " <<
+					checkpointFileName << " nicht "
+					"schreiben, mache trotzdem weiter." <<
+					endl;
+				checkpointFailed = true;
+			}
+			lastRefresh = time(0);
+		}
+	}
+
+	// Endstand sichern; die Ausgabedatei schreibt der Destruktor
+	if (!saveCheckpoint(checkpointFileName, followInput->tell()))
+		warn << "Kann Checkpoint " << checkpointFileName <<
+			" nicht schreiben." << endl;
 }
 
-// Analyse der Daten und Fuellen der Histogramme
-void fp13Analysis::analyze() 
+////////////////////////////////////////////////////////////////////////
+// PRIVATE MEMEBER FUNCTIONS
+////////////////////////////////////////////////////////////////////////
+
+// Erzeugen eines Worker-Objekts
+template <int N>
+fp13BasicAnalysis<N>* fp13BasicAnalysis<N>::createWorker() const
+{ return new fp13BasicAnalysis(*this); }
+
+// Schleife eines Worker-Threads
+template <int N>
+void fp13BasicAnalysis<N>::workerLoop(BatchQueue& queue)
 {
-	// Mitzaehlen, wie viele Ereignisse analysiert wurden
-	++analyzedCounter;
-	// Eintreten in das Outputfile
-	outputFile.cd();
-	// Flags zuruecksetzen
-	eventFlags = FlagNone;
-	lastMuonLayer = -1;
+	while (Batch* batch = queue.pop()) {
+		analyzeBatch(*batch);
+		queue.release(batch);
+	}
+}
+
+// Analyse aller Ereignisse eines Pakets
+template <int N>
+void fp13BasicAnalysis<N>::analyzeBatch(const Batch& batch)
+{
+	// abgeleitete Klassen koennen die Methoden zum Finden von
+	// Zerfaellen und Nachpulsen ueberschreiben, dann wird jedes Ereignis
+	// einzeln mit analyze untersucht
+	if (hasOwnFinders()) {
+		analyzeEachEvent(batch);
+		return;
+	}
+	// sonst alle Zeitbins auf einmal klassifizieren (s. fp13Classify.h)
+	classifyBatch(batch);
+}
 
-	// Fuelle Histogramm mit der Anzahl der Zeitbins, die einen Hit
-	// enthalten
-	h6->Fill(detectorHitMask.size());
+// Analyse aller Ereignisse eines Pakets, eines nach dem anderen
+template <int N>
+void fp13BasicAnalysis<N>::analyzeEachEvent(const Batch& batch)
+{
+	for (size_t i = 0; i < batch.size(); ++i) {
+		batch.getEvent(i, detectorHitMask, detectorHitTimes);
+		currentEvent = batch.getFirstEvent() + i;
+		analyze();
+	}
+}
 
-	// Loop ueber alle Detektorlagen
-	for (int iDetectorLayer = 0; iDetectorLayer < nLayers;
-			iDetectorLayer++) {
-		// Loop ueber alle Zeitbins
-		for (unsigned iTimeBin = 0; iTimeBin < detectorHitMask.size();
-				iTimeBin++) {
-			// Histogramme als Funktion der Detektorlage
-
-			// Anzahl der Hits in den Detekorlagen
-			// Teste, ob die aktuelle Lage im betrachteten
-			// Zeitfenster getroffen wurde
-			if (detectorHitMask[iTimeBin] &
-					(1 << iDetectorLayer))
-				h1->Fill(iDetectorLayer);
+// Klassifizieren aller Zeitbins eines Pakets mit fp13Classifier
+template <int N>
+void fp13BasicAnalysis<N>::classifyBatch(const fp13EventBatch& batch)
+{
+	if (!classifier)
+		classifier = new fp13Classifier(nLayers, minDelay);
+	classifier->classify(batch);
+	fillClassified(batch, *classifier);
+}
+
+// Fuellen der Histogramme aus dem Ergebnis von fp13Classifier
+template <int N>
+void fp13BasicAnalysis<N>::fillClassified(const fp13EventBatch& batch,
+		const fp13Classifier& result)
+{
+	if (!isWorker)
+		outputDirectory->cd();
+	const uint8_t* masks = batch.getMasks();
+	const int32_t* times = batch.getTimes();
+	const uint32_t* offsets = batch.getOffsets();
+	const int8_t* muonLayer = result.getLastMuonLayer();
+	const int32_t* delay = result.getDelay();
+	const uint8_t* decayUp = result.getDecayUp();
+	const uint8_t* afterpulses = result.getAfterpulses();
+	const fp13MaskTable& table = fp13MaskTable::get(nLayers);
+	const int layers = Layers::layersUpTo(nLayers - 1);
+
+	// es werden dieselben Werte gefuellt wie in analyze (die Reihenfolge
+	// spielt keine Rolle, da alle Werte ganzzahlig sind)
+	for (size_t e = 0; e < batch.size(); ++e) {
+		++analyzedCounter;
+		currentEvent = batch.getFirstEvent() + e;
+		const uint32_t begin = offsets[e], end = offsets[e + 1];
+		const unsigned nBins = end - begin;
+
+		eventFlags = FlagNone;
+		lastMuonLayer = -1;
+
+		h6->Fill(nBins);
+		// nur die getroffenen Lagen durchgehen
+		for (uint32_t i = begin; i < end; ++i)
+			for (int m = masks[i] & layers; m; m &= m - 1)
+				h1->Fill(table.lowestLayer[m]);
+		if (!nBins) {
+			indexEvent();
+			continue;
 		}
-		// Zeitpunkt des Hits im ersten Zeitbin in jeder Detektorlage 
-		//   -- falls es noch einen ersten Zeitbin gibt und 
-		//   -- falls ein solcher vorhanden war
-		if (detectorHitMask.empty())
+		for (int m = masks[begin] & layers; m; m &= m - 1)
+			h21[table.lowestLayer[m]]->Fill(times[begin]);
+
+		lastMuonLayer = muonLayer[e];
+		if (-1 == lastMuonLayer) {
+			indexEvent();
+			continue;
+		}
+		h8->Fill(lastMuonLayer);
+		if (2 > nBins) {
+			indexEvent();
 			continue;
-		if (detectorHitMask[0] & (1 << iDetectorLayer))
-			h21[iDetectorLayer]->Fill(
-					detectorHitTimes[0]);
-	}
-
-	// wie weit ist das Myon im Detektor gekommen?
-	// wird in der Membervariable lastMuonLayer gespeichert
-	lastMuonLayer = determineLastLayerHitByIncomingMuon();
-	// falls kein durchfliegendes Myon im ersten Zeitbin gefunden
-	// wurde, brauchen wir auch nicht nach Zerfaellen oder
-	// Nachpulsen suchen!
-	if (-1 == lastMuonLayer) return;
-	// Fuelle Histogramm, falls eine Lage unter der Lage 0
-	// (alles ab 2. von oben) getroffen wurde
-	h8->Fill(lastMuonLayer);
-	// Falls es nur Hits im ersten Zeitbin gibt, dann beende die
-	// Methode hier, da es weder Nachpulse noch Zerfaelle gibt
-	if (2 > detectorHitMask.size()) return;
-
-	// Loope ueber alle Zeitbins, um zu schauen, ob Zerfaelle oder
-	// Nachpulse gefunden werden
-	// Das nullte Zeitbin ist das, in dem das Einfallende Myon
-	// beobachtet wurde, daher muss man erst ab dem ersten Zeitbin
-	// nach Zerfaellen und Nachpulsen schauen
-	for (unsigned iTimeBin = 1; iTimeBin < detectorHitMask.size();
-			++iTimeBin) {
-		// Zeitverzoegerung schon mal ausrechnen...
-		int delay = detectorHitTimes[iTimeBin] - detectorHitTimes[0];
-		// falls delay klein, werfen wir das Zeitbin weg, weil wir
-		// den Detektor fuer so kleine Zeiten nicht gut genug
-		// verstehen
-		if (delay < minDelay) continue;
-
-		// die Methoden, die die Existenz von Nachpulsen oder
-		// Zerfaellen nach oben/unten pruefen, geben -1 zurueck,
-		// falls nichts gefunden wurde, andernfalls wird die Lage
-		// des Nachpulses/Zerfalls angegeben
-		int where = -1;
-	
-		where = findDecayUpward(iTimeBin);
-		if (-1 != where) {
-			// OK, Zerfall nach oben gefunden - Flags setzen
-			eventFlags = static_cast<EventFlags>(
-				eventFlags | FlagDecayUp);
-			// Detektorlage des Zerfalls nach oben
-			h3->Fill(where);
-			// Histogramm der Verzoegerungszeit fuer die
-			// getroffene Detektorlage
-			h23[where]->Fill(delay);
 		}
 
-		// Zerfall nach unten: Bestimme Lage und Verzoegerungszeit
-		// FIXME: Diese Methode sollen Sie selbst schreiben; weiter
-		// unten steht eine Version, die nur sagt, dass sie nichts
-		// gefunden hat
-		where = findDecayDownward(iTimeBin);
-		if (-1 != where) {
-			// OK, Zerfall nach unten gefunden - Flags setzen
-			eventFlags = static_cast<EventFlags>(
-				eventFlags | FlagDecayDown);
-			// Detektorlage des Zerfalls nach unten
-			h4->Fill(where);
-			// Histogramm der Verzoegerungszeit fuer die
-			// getroffene Detektorlage
-			h24[where]->Fill(delay);
+		for (uint32_t i = begin + 1; i < end; ++i) {
+			if (decayUp[i]) {
+				eventFlags = static_cast<EventFlags>(
+					eventFlags | FlagDecayUp);
+				h3->Fill(lastMuonLayer);
+				h23[lastMuonLayer]->Fill(delay[i]);
+				recordCandidate(FlagDecayUp, lastMuonLayer,
+						delay[i]);
+			}
+			// Nachpulse von unten nach oben, wie sie
+			// findAfterpulsesUsingThroughGoingMuons liefert
+			if (afterpulses[i]) {
+				eventFlags = static_cast<EventFlags>(
+					eventFlags | FlagAfterpulseSimple);
+				for (int m = afterpulses[i]; m;
+						m &= ~(1 << table.highestLayer[m])) {
+					const int where = table.highestLayer[m];
+					h5->Fill(where);
+					h25[where]->Fill(delay[i]);
+					recordCandidate(FlagAfterpulseSimple,
+							where, delay[i]);
+				}
+			}
 		}
+		finishCandidates();
+		if (eventFlags & FlagDecay)
+			h7->Fill(nBins);
+		indexEvent();
+	}
+}
+
+// Haben abgeleitete Klassen eigene Methoden zum Finden von Zerfaellen
+// und Nachpulsen?
+template <int N>
+bool fp13BasicAnalysis<N>::hasOwnFinders() const
+{ return typeid(*this) != typeid(fp13BasicAnalysis); }
+
+// Analyse eines Ereignisses mit den Tabellen aus fp13Classify.h
+// (liefert dasselbe wie analyze mit den Methoden dieser Klasse)
+template <int N>
+void fp13BasicAnalysis<N>::analyzeWithTables()
+{
+	++analyzedCounter;
+	if (!isWorker)
+		outputDirectory->cd();
+	eventFlags = FlagNone;
+	lastMuonLayer = -1;
+
+	const fp13MaskTable& table = fp13MaskTable::get(nLayers);
+	const int layers = Layers::layersUpTo(nLayers - 1);
+	const unsigned nBins = detectorHitMask.size();
+	h6->Fill(nBins);
+	// nur die getroffenen Lagen durchgehen
+	for (unsigned iTimeBin = 0; iTimeBin < nBins; ++iTimeBin)
+		for (int m = detectorHitMask[iTimeBin] & layers; m; m &= m - 1)
+			h1->Fill(table.lowestLayer[m]);
+	if (!nBins)
+		return;
+	const int first = detectorHitMask[0];
+	for (int m = first & layers; m; m &= m - 1)
+		h21[table.lowestLayer[m]]->Fill(detectorHitTimes[0]);
+
+	// Hitmuster, die nicht in die Tabelle passen, koennen kein
+	// durchlaufendes Myon enthalten (es gibt hoechstens 8 Lagen)
+	if (first < 0 || first > 255)
+		return;
+	lastMuonLayer = table.lastMuonLayer[first];
+	if (-1 == lastMuonLayer)
+		return;
+	h8->Fill(lastMuonLayer);
+	if (2 > nBins)
+		return;
 
-		// Suche Nachpulse mit durchgehenden Myonen
-		where = -1;
-		// Fuelle die Histogramme, solange wir Nachpulse finden
-		while (-1 != (where = findAfterpulsesUsingThroughGoingMuons(
-						iTimeBin, where))) {
-			// Nachpuls gefunden - Flags setzen
+	const int up = table.upLayer[first];
+	const int afterpulseLayers = table.afterpulseLayers[first];
+	for (unsigned iTimeBin = 1; iTimeBin < nBins; ++iTimeBin) {
+		const int delay = detectorHitTimes[iTimeBin] -
+			detectorHitTimes[0];
+		if (delay < minDelay)
+			continue;
+		const int mask = detectorHitMask[iTimeBin];
+		if (mask & up) {
 			eventFlags = static_cast<EventFlags>(
-				eventFlags | FlagAfterpulseSimple);
-			// Detektorlage des Nachpulses
-			h5->Fill(where);
-			// Histogramm der Verzoegerungszeit fuer die
-			// getroffene Detektorlage
-			h25[where]->Fill(delay);
+				eventFlags | FlagDecayUp);
+			h3->Fill(lastMuonLayer);
+			h23[lastMuonLayer]->Fill(delay);
+			recordCandidate(FlagDecayUp, lastMuonLayer, delay);
 		}
-
-		// Verbesserte Nachpuls-Analyse
-		// FIXME: Diese Methode sollen Sie selbst schreiben; weiter
-		// unten steht eine Version, die nur sagt, dass sie nichts
-		// gefunden hat. Ueberlegen Sie sich, wie man die Nachpuls-
-		// erkennung, die oben verwendet wird verbessern kann!
-		where = -1;
-		// Fuelle die Histogramme, solange wir Nachpulse finden
-		while (-1 != (where = findAfterpulsesImproved(
-						iTimeBin, where))) {
-			// Nachpuls gefunden - Flags setzen
+		if (mask & afterpulseLayers) {
 			eventFlags = static_cast<EventFlags>(
-				eventFlags | FlagAfterpulseImproved);
-			// Detektorlage des Nachpulses
-			h2->Fill(where);
-			// Histogramm der Verzoegerungszeit fuer die
-			// getroffene Detektorlage
-			h22[where]->Fill(delay);
+				eventFlags | FlagAfterpulseSimple);
+			for (int m = mask & afterpulseLayers; m;
+					m &= ~(1 << table.highestLayer[m])) {
+				const int where = table.highestLayer[m];
+				h5->Fill(where);
+				h25[where]->Fill(delay);
+				recordCandidate(FlagAfterpulseSimple, where,
+						delay);
+			}
 		}
-	} // Ende des Loops ueber die Zeitbins
-
-	// Fuelle Anzahl der beruecksichtigten Zeitfenster in dem Ereignis
-	// Fuelle nur, falls ein Zerfall nach oben oder unten gefunden wurde
+	}
+	finishCandidates();
 	if (eventFlags & FlagDecay)
-		h7->Fill(detectorHitMask.size());	
-	// Glueckwunsch - Analyse des Events ist hier beendet! ;)
+		h7->Fill(nBins);
 }
 
-unsigned long fp13Analysis::getNoOfEvents()
-{ return eventCounter; }
+// Addieren der Histogramme eines Worker-Objekts
+template <int N>
+void fp13BasicAnalysis<N>::mergeHistograms(const fp13BasicAnalysis& worker)
+{
+	h1->add(*worker.h1);
+	h2->add(*worker.h2);
+	h3->add(*worker.h3);
+	h4->add(*worker.h4);
+	h5->add(*worker.h5);
+	h6->add(*worker.h6);
+	h7->add(*worker.h7);
+	h8->add(*worker.h8);
+	for (int iLayer = 0; iLayer < nLayers; ++iLayer) {
+		h21[iLayer]->add(*worker.h21[iLayer]);
+		h22[iLayer]->add(*worker.h22[iLayer]);
+		h23[iLayer]->add(*worker.h23[iLayer]);
+		h24[iLayer]->add(*worker.h24[iLayer]);
+		h25[iLayer]->add(*worker.h25[iLayer]);
+	}
+}
 
-unsigned long fp13Analysis::getNoOfAnalyzedEvents()
-{ return analyzedCounter; }
+// Schreiben der gesammelten Kandidaten
+template <int N>
+void fp13BasicAnalysis<N>::flushCandidates()
+{
+	if (!candidates || candidates->empty())
+		return;
+	candidateWriter->write(*candidates);
+	candidates->clear();
+}
 
-////////////////////////////////////////////////////////////////////////
-// PRIVATE MEMEBER FUNCTIONS
-////////////////////////////////////////////////////////////////////////
+// Abgeben der Kodes fuer den Flag-Index
+template <int N>
+void fp13BasicAnalysis<N>::flushFlagIndex()
+{
+	if (flagIndex)
+		flagIndex->add(flagFirstEvent, flagCodes);
+	flagFirstEvent = currentEvent;
+}
 
 // Erstellen der benoetigten Histogramme
-void fp13Analysis::bookHistograms()
+template <int N>
+void fp13BasicAnalysis<N>::bookHistograms()
 {
-	// Eintreten in das Output file
-	// alle gebuchten Histogramme werden mit dem File assoziiert
-	outputFile.cd();
-	//
-	// Buchen der Einzelhistogramme inklusive der Fehlerhistogramme
-	h1 = new TH1D("h1",
+	// Buchen der Einzelhistogramme
+	// (die Fehlerhistogramme entstehen erst in writeHistograms)
+	h1 = new fp13Histogram("h1",
 		"Gesamtzahl der Hits in den Detektorlagen; Detektorlage; Anzahl der Hits",
 		nLayers, -0.5, -0.5 + nLayers);
-	h2 = new TH1D("h2",
+	h2 = new fp13Histogram("h2",
 		"Anzahl der Nachpulse in den Detektorlagen; Detektorlage; Anzahl der Nachpulse",
 		nLayers, -0.5, -0.5 + nLayers);
-	h3 = new TH1D("h3",
+	h3 = new fp13Histogram("h3",
 		"Lage der Zerfaelle nach oben; Lage; Anzahl der Hits",
 		nLayers, -0.5, -0.5 + nLayers);
-	h4 = new TH1D("h4",
+	h4 = new fp13Histogram("h4",
 		"Lage der Zerfaelle nach unten; Lage; Anzahl der Hits",
 		nLayers, -0.5, -0.5 + nLayers);
-	h5 = new TH1D("h5",
+	h5 = new fp13Histogram("h5",
 		"Detektor der Nachpulse; Detektor; Anzahl der Hits",
 		nLayers, -0.5, -0.5 + nLayers);
-	h6 = new TH1D("h6",
+	h6 = new fp13Histogram("h6",
 		"Anzahl aller Slices; Slices; Anzahl der Hits",
 		40, 0., 20.);
-	h7 = new TH1D("h7",
+	h7 = new fp13Histogram("h7",
 		"Anzahl der genommenen Slices; Slices; Anzahl der Hits",
 		40, 0., 20.);    
-	h8 = new TH1D("h8",
+	h8 = new fp13Histogram("h8",
 		"Letzte vom einlaufenden Myon kontinuierlich getroffene Detektorlage; Detektorlage; Anzahl der Hits",
 		nLayers, -0.5, -0.5 + nLayers);
-	// Buchen der Histogramme in den Vektoren
+	// Buchen der Histogramme in den Feldern
 	for (int iDetectorLayer = 0; iDetectorLayer < nLayers;
 			iDetectorLayer++ ) {
-		h21.push_back(new TH1D(Form("z%i",iDetectorLayer),
+		h21[iDetectorLayer] = new fp13Histogram(Form("z%i",iDetectorLayer),
 					Form("Zeit des ersten Hits fuer Lage %i; "
 						"Zeit [ns]; Anzahl der Hits",
 						iDetectorLayer ),
-					40, 0.,   200.));
-		h22.push_back(new TH1D(Form("x%i", iDetectorLayer), 
+					40, 0.,   200.);
+		h22[iDetectorLayer] = new fp13Histogram(Form("x%i", iDetectorLayer), 
 					Form("Nachpulse fuer Detektor %i; "
 						"Zeit [ns]; Anzahl der Hits",
 						iDetectorLayer),
-					125, 0., 50000.));
-		h23.push_back(new TH1D(Form("a%i", iDetectorLayer), 
+					125, 0., 50000.);
+		h23[iDetectorLayer] = new fp13Histogram(Form("a%i", iDetectorLayer), 
 					Form("Zerfall nach oben in Lage %i; "
 						"Zeit [ns]; Anzahl der Hits",
 						iDetectorLayer),
-					125, 0., 50000.));
-		h24.push_back(new TH1D(Form("b%i", iDetectorLayer), 
+					125, 0., 50000.);
+		h24[iDetectorLayer] = new fp13Histogram(Form("b%i", iDetectorLayer), 
 					Form("Zerfall nach unten in Lage %i; "
 						"Zeit [ns]; Anzahl der Hits",
 						iDetectorLayer),
-					125, 0., 50000.));
-		h25.push_back(new TH1D(Form("w%i", iDetectorLayer), 
+					125, 0., 50000.);
+		h25[iDetectorLayer] = new fp13Histogram(Form("w%i", iDetectorLayer), 
 					Form("Nachpulse2 fuer Detektor %i; "
 						"Zeit [ns]; Anzahl der Hits",
 						iDetectorLayer),
-					125, 0., 50000.));
-	}
-
-	// Fehler auf bins ausrechnen: Inhalt(bin i) +/- sqrt(Inhalt(bin i))
-	h1->Sumw2();
-	h2->Sumw2();
-	h3->Sumw2();
-	h4->Sumw2();
-	h5->Sumw2();
-	h6->Sumw2();
-	h7->Sumw2();
-	h8->Sumw2();
+					125, 0., 50000.);
+	}
+}
+
+// alle Histogramme in der Reihenfolge der Ausgabedatei
+template <int N>
+void fp13BasicAnalysis<N>::getHistograms(vector<fp13Histogram*>& histograms) const
+{
+	fp13Histogram* single[] = { h1, h2, h3, h4, h5, h6, h7, h8 };
+	histograms.assign(single, single + 8);
 	for (int iLayer = 0; iLayer < nLayers; ++iLayer) {
-		h21[iLayer]->Sumw2();
-		h22[iLayer]->Sumw2();
-		h23[iLayer]->Sumw2();
-		h24[iLayer]->Sumw2();
-		h25[iLayer]->Sumw2();
+		histograms.push_back(h21[iLayer]);
+		histograms.push_back(h22[iLayer]);
+		histograms.push_back(h23[iLayer]);
+		histograms.push_back(h24[iLayer]);
+		histograms.push_back(h25[iLayer]);
+	}
+}
+
+// Umwandeln der Histogramme in TH1D in der Ausgabedatei
+template <int N>
+void fp13BasicAnalysis<N>::writeHistograms()
+{
+	// Eintreten in das Output file
+	// alle erzeugten Histogramme werden mit dem File (bzw. dem
+	// Verzeichnis darin) assoziiert
+	outputDirectory->cd();
+	// Fehler auf bins: Inhalt(bin i) +/- sqrt(Inhalt(bin i))
+	// (s. fp13Histogram::toTH1D)
+	vector<fp13Histogram*> histograms;
+	getHistograms(histograms);
+	for (size_t i = 0; i < histograms.size(); ++i) {
+		// beim wiederholten Schreiben gibt es das TH1D schon
+		TH1D* h = dynamic_cast<TH1D*>(outputDirectory->FindObject(
+					histograms[i]->getName().c_str()));
+		if (h)
+			histograms[i]->copyTo(*h);
+		else
+			histograms[i]->toTH1D();
+	}
+	// Anzahl der Detektorlagen fuer die Makros (gehoert danach der
+	// Datei und wird mit ihr geschrieben)
+	if (!outputDirectory->FindObject("nLayers"))
+		outputDirectory->Append(
+				new TParameter<int>("nLayers", nLayers));
+}
+
+// Schreiben des aktuellen Stands in die Ausgabedatei
+template <int N>
+void fp13BasicAnalysis<N>::refreshOutput()
+{
+	writeHistograms();
+	// beim wiederholten Schreiben die alte Version ersetzen
+	outputFile.Write(0, TObject::kOverwrite);
+	outputFile.Flush();
+}
+
+// Schreiben eines Checkpoints
+// Format (Text): Kennung und Version, Name und Inode der Eingabedatei,
+// Leseposition, Ereigniszaehler, danach eine Zeile pro Histogramm (s.
+// fp13Histogram::save)
+template <int N>
+bool fp13BasicAnalysis<N>::saveCheckpoint(const string& fileName,
+		size_t offset) const
+{
+	struct stat st;
+	if (0 != stat(inputFileName.c_str(), &st))
+		return false;
+	// erst in eine temporaere Datei schreiben und dann umbenennen, so
+	// dass immer ein vollstaendiger Checkpoint da ist
+	const string tmpFileName = fileName + ".tmp";
+	{
+		ofstream out(tmpFileName.c_str(), ios::trunc);
+		out << "FP13CKPT 1" << endl <<
+			inputFileName << endl <<
+			st.st_ino << ' ' << offset << ' ' <<
+			eventCounter << ' ' << analyzedCounter << endl;
+		vector<fp13Histogram*> histograms;
+		getHistograms(histograms);
+		for (size_t i = 0; i < histograms.size(); ++i)
+			histograms[i]->save(out);
+		out.close();
+		if (out.fail())
+			return false;
+	}
+	return 0 == rename(tmpFileName.c_str(), fileName.c_str());
+}
+
+// Laden eines Checkpoints
+template <int N>
+bool fp13BasicAnalysis<N>::loadCheckpoint(const string& fileName, size_t& offset)
+{
+	ifstream in(fileName.c_str());
+	string magic, name;
+	unsigned version;
+	if (!(in >> magic >> version) || "FP13CKPT" != magic ||
+			1 != version)
+		return false;
+	in.ignore(1);
+	getline(in, name);
+	unsigned long long inode;
+	unsigned long events, analyzed;
+	if (!(in >> inode >> offset >> events >> analyzed))
+		return false;
+
+	// gehoert der Checkpoint zu dieser Eingabedatei? (eine neue Datei
+	// unter demselben Namen hat einen anderen Inode, eine gekuerzte
+	// Datei ist kuerzer als die gespeicherte Leseposition)
+	struct stat st;
+	if (name != inputFileName || 0 != stat(inputFileName.c_str(), &st) ||
+			st.st_ino != inode ||
+			static_cast<unsigned long long>(st.st_size) < offset) {
+		warn << "Checkpoint " << fileName << " passt nicht zur "
+			"Eingabedatei " << inputFileName << ", fange von "
+			"vorne an." << endl;
+		return false;
+	}
+
+	vector<fp13Histogram*> histograms;
+	getHistograms(histograms);
+	for (size_t i = 0; i < histograms.size(); ++i) {
+		if (!histograms[i]->load(in)) {
+			warn << "Checkpoint " << fileName << " ist "
+				"fehlerhaft, fange von vorne an." << endl;
+			return false;
+		}
+	}
+	eventCounter = events;
+	analyzedCounter = analyzed;
+	return true;
+}
+
+// Freigeben der Histogramme
+template <int N>
+void fp13BasicAnalysis<N>::deleteHistograms()
+{
+	delete h1;
+	delete h2;
+	delete h3;
+	delete h4;
+	delete h5;
+	delete h6;
+	delete h7;
+	delete h8;
+	for (int iLayer = 0; iLayer < nLayers; ++iLayer) {
+		delete h21[iLayer];
+		delete h22[iLayer];
+		delete h23[iLayer];
+		delete h24[iLayer];
+		delete h25[iLayer];
 	}
 }
 
@@ -465,7 +1050,8 @@ void fp13Analysis::bookHistograms()
 
 // Bestimmung der letzten Detektorlage, die vom einlaufenden Myon beim
 // kontinuierlichen Durchlaufen getroffen wurde
-int fp13Analysis::determineLastLayerHitByIncomingMuon()
+template <int N>
+int fp13BasicAnalysis<N>::determineLastLayerHitByIncomingMuon()
 {
     // Loope ueber alle ausser die obersten beiden Detektorlagen, d.h. 2
     // ... nLayers, starte mit unterster Lage, da der maximale
@@ -483,7 +1069,11 @@ int fp13Analysis::determineLastLayerHitByIncomingMuon()
 	//
 	// 2^(n+1)	(1 << (n+1))		1   0     0   ... 0 0 0
 		// 2^(n+1) - 1	((1 << (n+1)) - 1)	0   1     1   ... 1 1 1
-		if (detectorHitMask[0] == ((1 << (iLayer + 1)) - 1)) {
+		//
+		// Layers::layersUpTo(n) rechnet genau das aus, mit uint32_t,
+		// damit es auch fuer 32 Lagen stimmt (s. fp13Analysis.h)
+		if (static_cast<uint32_t>(detectorHitMask[0]) ==
+				Layers::layersUpTo(iLayer)) {
 			// Detektorlage iLayer ist die letzte kontinuerlich
 			// getroffene Lage, und wir sind fertig
 			return iLayer;
@@ -498,7 +1088,8 @@ int fp13Analysis::determineLastLayerHitByIncomingMuon()
 // Eingabewert:	timeBin - Zeitbin, das auf Zerfall nach oben zu untersuchen ist
 // Rueckgabewert: Detektorlage, in der Zerfall nach oben gefunden wurde
 // 		  -1, falls nichts gefunden wurde
-int fp13Analysis::findDecayUpward(int timeBin)
+template <int N>
+int fp13BasicAnalysis<N>::findDecayUpward(int timeBin)
 {
 	// die Membervariable lastMuonLayer haelt fest, wie weit das Myon im
 	// Detektor gekommen ist
@@ -510,7 +1101,7 @@ int fp13Analysis::findDecayUpward(int timeBin)
 	// Teste, ob ein Teilchen nach oben emittiert wird
 	// (der Test funktioniert wie oben in der Methode
 	// determineLastLayerHitByIncomingMuon())
-	if ((1 << lastMuonLayer) & detectorHitMask[timeBin]) {
+	if (Layers::layer(lastMuonLayer) & detectorHitMask[timeBin]) {
 		// das Zerfallselektron/-positron wird in der gleichen Lage
 		// registriert, in der das Myon zuletzt gesehen wurde, also
 		// lastMuonLayer
@@ -525,7 +1116,8 @@ int fp13Analysis::findDecayUpward(int timeBin)
 // Eingabewert:	timeBin - Zeitbin, das auf Zerfall nach unten zu untersuchen ist
 // Rueckgabewert: Detektorlage, in der Zerfall nach unten gefunden wurde
 // 		  -1, falls nichts gefunden wurde
-int fp13Analysis::findDecayDownward(int timeBin)
+template <int N>
+int fp13BasicAnalysis<N>::findDecayDownward(int timeBin)
 {
 	// FIXME: Studenten sollen diese Routine selber schreiben
 	// gib -1 zurueck, falls kein Zerfall nach unten stattfand
@@ -538,7 +1130,8 @@ int fp13Analysis::findDecayDownward(int timeBin)
 //              startLayer - Lage, ueber der gesucht wird
 // Rueckgabewert: Detektorlage, in der Nachpuls gefunden wurde
 // 		  -1, falls nichts gefunden wurde
-int fp13Analysis::findAfterpulsesUsingThroughGoingMuons(int timeBin,
+template <int N>
+int fp13BasicAnalysis<N>::findAfterpulsesUsingThroughGoingMuons(int timeBin,
 		int startLayer)
 {
 	// die Membervariable lastMuonLayer haelt fest, wie weit das Myon im
@@ -557,7 +1150,7 @@ int fp13Analysis::findAfterpulsesUsingThroughGoingMuons(int timeBin,
 	// ueber der an, wo wir zuletzt etwas gefunden haben
 	for (int iLayer = startLayer - 1; iLayer >= 0; iLayer--) {
 		// teste, ob nur in der Lage iLayer ein Puls registriert wurde
-		if ((1 << iLayer) & detectorHitMask[timeBin]) {
+		if (Layers::layer(iLayer) & detectorHitMask[timeBin]) {
 			// ja, gib die Lage zurueck
 			return iLayer;
 		}
@@ -578,10 +1171,20 @@ int fp13Analysis::findAfterpulsesUsingThroughGoingMuons(int timeBin,
 // FIXME: Ueberlegen Sie sich, was im Vergleich zur einfachen Nachpuls-
 // erkennung oben verbessert werden kann, und implementieren Sie Ihre
 // Verbesserung(en)
-int fp13Analysis::findAfterpulsesImproved(int timeBin, int startLayer)
+template <int N>
+int fp13BasicAnalysis<N>::findAfterpulsesImproved(int timeBin, int startLayer)
 {
 	// momentan findet diese Methode nichts
 	return -1;
 }
 
+////////////////////////////////////////////////////////////////////////
+// Instanzen fuer die unterstuetzten Detektorgroessen (fp13 -l)
+////////////////////////////////////////////////////////////////////////
+template class fp13BasicAnalysis<6>;
+template class fp13BasicAnalysis<8>;
+template class fp13BasicAnalysis<12>;
+template class fp13BasicAnalysis<16>;
+template class fp13BasicAnalysis<32>;
+
 // Dateiende
@@ -26,27 +26,79 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <type_traits>
+// C headers (fuer uint8_t, uint16_t, uint32_t)
+#include <stdint.h>
 // ROOT headers
 #include <TFile.h>
 #include <TH1.h>
 
+#include "fp13Input.h"
+#include "fp13Histogram.h"
+#include "fp13EventQueue.h"
+#include "fp13Candidates.h"
+#include "fp13FlagIndex.h"
+
 // Namen aus dem Namensraum std verfuegbar machen
 using namespace std;
 
+class fp13Classifier;
+class fp13SkimOutput;
+template <int N> class fp13BasicScan;
+template <int N> class fp13BasicEventStream;
+template <int N> class fp13BasicRunSet;
+
+// Hitmuster eines Detektors mit N Lagen
+//
+// Bit i eines Hitmusters steht fuer Lage i. Mask ist der kleinste
+// vorzeichenlose Typ, in den N Bits passen; darin werden die Hitmuster in
+// den Paketen von Ereignissen gespeichert (s. fp13EventQueue.h). Gerechnet
+// wird mit uint32_t, so dass auch (2 << 31) - 1 fuer 32 Lagen stimmt.
+template <int N>
+struct fp13LayerMask
+{
+	static_assert(N >= 2 && N <= 32, "2 bis 32 Detektorlagen");
+
+	typedef typename conditional<(N <= 8), uint8_t,
+		typename conditional<(N <= 16), uint16_t,
+			uint32_t>::type>::type Mask;
+
+	// Bit der Lage iLayer
+	static constexpr uint32_t layer(int iLayer)
+	{ return static_cast<uint32_t>(1) << iLayer; }
+	// Lagen 0 bis einschliesslich iLayer
+	static constexpr uint32_t layersUpTo(int iLayer)
+	{ return (static_cast<uint32_t>(2) << iLayer) - 1; }
+};
+
 // Geruest des Analyse-Objekts deklarieren
-class fp13Analysis 
+//
+// Die Analyse ist ein Template fuer einen Detektor mit N Lagen, damit die
+// Schleifen ueber die Lagen beim Uebersetzen feststehen. Instanziiert
+// werden 6, 8, 12, 16 und 32 Lagen (am Ende von fp13Analysis.cc);
+// fp13Analysis ist die Analyse des Detektors im Praktikum mit 6 Lagen.
+// Die Anzahl der Lagen steht als TParameter<int> "nLayers" in der
+// Ausgabedatei, so dass die Makros sie von dort lesen koennen.
+template <int N>
+class fp13BasicAnalysis
 {
 protected:
 	// Klassenvariablen - sie sind "protected", d.h. nur die Klasse selbst
 	// und deren Kinder koennen auf diese Variablen zugreifen
 
 	// Anzahl der Detektorlagen
-	static const int nLayers = 6;
+	static const int nLayers = N;
+	// Hitmuster und Pakete von Ereignissen fuer nLayers Lagen
+	typedef fp13LayerMask<N> Layers;
+	typedef typename Layers::Mask Mask;
+	typedef fp13BasicEventBatch<Mask> Batch;
+	typedef fp13BasicBatchQueue<Mask> BatchQueue;
 	// Minimale Verzoegerung zwischen Zeitbins, damit Ergebnisse
 	// beruecksichtigt werden (in ns)
 	// (Detektor/Auslesekette hat Totzeit! 55 ns scheinen sinnvoll,
-	// entsprechen etwa der doppelten Pulsbreite nach Diskriminator)
-	static const int minDelay = 55;
+	// entsprechen etwa der doppelten Pulsbreite nach Diskriminator,
+	// s. defMinDelay)
+	int minDelay;
 
 	// Ereigniszaehler
 	unsigned long eventCounter;
@@ -60,50 +112,58 @@ protected:
 
 	// Vektoren, die fuer jedes Zeitbin mit Hits einen Eintrag enthalten:
 	// Bitmasken der Detektorlagen, die anzeigen, welche Lage gefeuert hat
-	vector<int> detectorHitMask;
+	vector<Mask> detectorHitMask;
 	// Zeiten zu den registrierten Detektorhits
 	vector<int> detectorHitTimes; 
+	// Hitmuster, wie sie die Eingabequelle liefert (s. setHitMask)
+	vector<int> inputHitMask;
 
-	// Input Datenfile
-	istream& inputFile; 
+	// Input Datenfile (Eingabequelle, siehe fp13Input.h)
+	fp13Input* inputFile;
 	// Output Histogrammfile (spezieller Datentyp fuer ROOT-Files)
 	TFile& outputFile;
+	// Verzeichnis darin, in das die Histogramme geschrieben werden
+	// (normalerweise die Datei selbst, s. fp13Scan.h)
+	TDirectory* outputDirectory;
 
 	// Namen von Ein- und Ausgabedatei
 	string inputFileName, outputFileName;
 	
 	// Benoetigte Histogramme, die abgespeichert werden
+	// (gefuellt wird in einfache Zaehlhistogramme, die erst beim
+	// Schreiben der Ausgabedatei in TH1D gleichen Namens umgewandelt
+	// werden, s. fp13Histogram.h)
 	// Anzahl der Hits in den Detekorlagen
-	TH1D *h1;
+	fp13Histogram *h1;
 	// Anzahl der Nachpulse in den Detektorlagen aus durchgehenden
 	// und stoppenden Myonen
-	TH1D *h2;
+	fp13Histogram *h2;
 	// Anzahl der Zerfaelle nach oben in den Detektorlagen
-	TH1D *h3;
+	fp13Histogram *h3;
 	// Anzahl der Zerfaelle nach unten in den Detektorlagen
-	TH1D *h4;
+	fp13Histogram *h4;
 	// Anzahl der Nachpulse in den Detektorlagen aus durchgehenden
 	// Myonen
-	TH1D *h5;
+	fp13Histogram *h5;
 	// Anzahl der Hits in den Zeitfenstern
-	TH1D *h6;
+	fp13Histogram *h6;
 	// Anzahl der Hits in den beruecksichtitgen Zeitfenstern
-	TH1D *h7;
+	fp13Histogram *h7;
 	// Anzahl der Hits des einlaufenden Muons in den Detektorlagen
-	TH1D *h8;
+	fp13Histogram *h8;
 	
-	// Vektoren von Histogrammen -- fuer jede Detektorlage eines
+	// Felder von Histogrammen -- fuer jede Detektorlage eines
 	// Zeit des ersten Hits
-	vector<TH1D *> h21;
+	fp13Histogram *h21[N];
 	// Zeit der Nachpulse (aus der verbesserten Analysemethode)
-	vector<TH1D *> h22;
+	fp13Histogram *h22[N];
 	// Zeit der Zerfaelle nach oben
-	vector<TH1D *> h23;
+	fp13Histogram *h23[N];
 	// Zeit der Zerfaelle nach unten
-	vector<TH1D *> h24;
+	fp13Histogram *h24[N];
 	// Zeit der Nachpulse aus durchgehenden Myonen (aus der
 	// vereinfachten Nachpulsanalyse)
-	vector<TH1D *> h25;
+	fp13Histogram *h25[N];
 
 	// Datentyp definieren: Aufzaehlung der moeglichen Eventtypen fuer
 	// Flags
@@ -120,24 +180,75 @@ protected:
 	// (Datentyp: EventFlags, Variablenname: eventFlags (!))
 	EventFlags eventFlags;
 
+	// true fuer Worker-Objekte, die in analyzeParallel in einem eigenen
+	// Thread analysieren (s. createWorker)
+	bool isWorker;
+
+	// Klassifizieren ganzer Pakete in analyzeBatch (s. fp13Classify.h)
+	fp13Classifier* classifier;
+
+	// Tabelle der gefundenen Kandidaten (s. writeCandidates), 0 falls
+	// keine geschrieben wird; Worker-Objekte schreiben mit dem
+	// fp13CandidateWriter des Hauptobjekts, sammeln aber in einem
+	// eigenen Block
+	fp13CandidateWriter* candidateWriter;
+	fp13CandidateBlock* candidates;
+	// Nummer des Ereignisses, das gerade analysiert wird (ab 0)
+	unsigned long currentEvent;
+
+	// Skim der analysierbaren Ereignisse (s. writeSkim), 0 falls keiner
+	// geschrieben wird
+	fp13SkimOutput* skim;
+
+	// Flag-Index (s. writeFlagIndex), 0 falls keiner geschrieben wird;
+	// jedes Objekt sammelt die Kodes der fortlaufend nummerierten
+	// Ereignisse ab flagFirstEvent und gibt sie abschnittsweise an den
+	// fp13FlagIndexWriter des Hauptobjekts
+	fp13FlagIndexWriter* flagIndex;
+	vector<uint16_t> flagCodes;
+	unsigned long flagFirstEvent;
+
 public:
 	// Oeffentlich verfuegbare Methode (koennen von ausserhalb des
 	// Objektes angesprochen werden)
 	
 	// Konstruktor - initialisiert ein neues Analyseobjekt
-	fp13Analysis(const string& inputFileName,
-			const string& outputFileName);
+	// nReadThreads gibt an, mit wie vielen Threads die Eingabedatei
+	// gelesen wird (s. fp13ParallelInput.h); ist follow gesetzt, wird
+	// die Eingabedatei verfolgt, waehrend sie waechst (s.
+	// fp13FollowInput.h und analyzeFollowing)
+	fp13BasicAnalysis(const string& inputFileName,
+			const string& outputFileName,
+			unsigned nReadThreads = 1, bool follow = false);
+
+	// Konstruktor mit einer schon geoeffneten Eingabe input, die dabei
+	// in den Besitz des Analyseobjekts uebergeht (z.B. ein Hitstrom, s.
+	// fp13HitStream.h)
+	fp13BasicAnalysis(fp13Input* input, const string& outputFileName);
+
+	// Konstruktor fuer Analyseobjekte ohne eigene Eingabe, die ihre
+	// Ereignisse von einem fp13EventStream bekommen (s.
+	// fp13EventStream.h); readEvent und skipEvents gehen dann nicht
+	explicit fp13BasicAnalysis(const string& outputFileName);
 	
 	// Destruktor - erledigt die Aufraeumarbeiten, wenn das Objekt nicht
 	// mehr gebraucht wird
-	virtual ~fp13Analysis(); 
+	virtual ~fp13BasicAnalysis(); 
 
 	// Analysefunktionen, die extern angesprochen werden koennen
 	
 	// Einlesen eines Ereignisses
-	// gibt im Erfolgsfall 0 zurueck
+	// gibt im Erfolgsfall 0 zurueck, -1 am Ende der Eingabe und 1,
+	// falls beim Verfolgen der Eingabedatei gerade kein neues Ereignis
+	// da ist
 	virtual int readEvent();
 
+	// Ueberspringen der Ereignisse bis zum Ereignis event (gezaehlt ab
+	// 0); springt bei eingeblendeten Dateien mit dem Ereignisindex
+	// (s. fp13Index.h) und liest nur die restlichen Ereignisse
+	// gibt 0 zurueck, -1 falls vorher das Ende der Datei erreicht wurde
+	int skipEvents(unsigned long event);
+
 	// Durchfuehrung der Analyse eines Ereignisses
 	// Aufgaben der Methode:
 	// - Erkennen von Myonen, die im Detektor stoppen und dann nach oben
@@ -147,18 +258,203 @@ public:
 	//   entsprechender Histogramme
 	virtual void analyze(); 
 
+	// Analyse aller Ereignisse eines Pakets (s. fp13EventQueue.h)
+	// das Paket ist die Einheit, in der Ereignisse zwischen Threads
+	// weitergereicht werden; in der Standardanalyse werden alle
+	// Zeitbins des Pakets auf einmal mit Vektorbefehlen klassifiziert
+	// (s. fp13Classify.h, nur bis 8 Lagen), in abgeleiteten Klassen wird
+	// fuer jedes Ereignis analyze aufgerufen
+	virtual void analyzeBatch(const Batch& batch);
+
+	// Lesen und Analysieren von hoechstens maxNoOfEvents Ereignissen
+	// mit nThreads Threads
+	// Jeder Thread analysiert mit einem eigenen Worker-Objekt (s.
+	// createWorker) und fuellt dessen Histogramme; am Ende werden die
+	// Histogramme aller Worker zu denen dieses Objekts addiert.
+	// Bininhalte und Anzahl der Eintraege sind Ganzzahlen und damit
+	// exakt dieselben wie bei der Analyse in einem Thread; die Summen von
+	// x und x^2 fuer Mittelwert und RMS sind double (s. fp13Histogram.h)
+	// und koennen in den letzten Stellen abweichen, sobald sie ueber 2^53
+	// liegen (bei Verzoegerungen um 1e4 ns nach etwa 1e8 Eintraegen, bei
+	// 3e4 ns schon nach 1e7).
+	void analyzeParallel(unsigned long maxNoOfEvents, unsigned nThreads);
+
+	// Verfolgen der wachsenden Eingabedatei (nur mit follow im
+	// Konstruktor): analysiert neue Ereignisse, sobald sie vollstaendig
+	// in der Datei stehen, bis fp13FollowInput::requestStop aufgerufen
+	// wird oder maxNoOfEvents Ereignisse analysiert sind
+	// Alle refreshInterval Sekunden werden die Ausgabedatei und ein
+	// Checkpoint (<Ausgabedatei>.ckpt) mit Leseposition und Histogrammen
+	// geschrieben. Passt ein vorhandener Checkpoint zur Eingabedatei,
+	// wird dort weitergemacht, sonst werden zuerst firstEvent Ereignisse
+	// uebersprungen.
+	void analyzeFollowing(unsigned long firstEvent,
+			unsigned long maxNoOfEvents, unsigned refreshInterval);
+
 	unsigned long getNoOfEvents();
 	unsigned long getNoOfAnalyzedEvents();
+
+	// Minimale Verzoegerung (s. minDelay)
+	static const int defMinDelay = 55;
+	int getMinDelay() const;
+	void setMinDelay(int delay);
+
+	// Schreiben aller gefundenen Zerfaelle und Nachpulse mit
+	// Ereignisnummer, Lage, Verzoegerung, Art und eventFlags als Tabelle
+	// nach fileName (s. fp13Candidates.h); vor dem Analysieren aufrufen
+	// gibt false zurueck, falls die Datei nicht angelegt werden kann
+	bool writeCandidates(const string& fileName);
+
+	// Schreiben aller gelesenen Ereignisse, in denen Zerfaelle oder
+	// Nachpulse gesucht werden, als Skim nach fileName (s. fp13Skim.h);
+	// vor dem Analysieren aufrufen (die beim Ueberspringen gelesenen
+	// Ereignisse kommen nicht in den Skim)
+	// gibt false zurueck, falls die Datei nicht angelegt werden kann
+	bool writeSkim(const string& fileName);
+
+	// Schreiben von eventFlags und lastMuonLayer aller analysierten
+	// Ereignisse als Bitmap-Index nach fileName (s. fp13FlagIndex.h);
+	// vor dem Analysieren aufrufen, geschrieben wird im Destruktor
+	// gibt false zurueck, falls die Datei nicht angelegt werden kann
+	bool writeFlagIndex(const string& fileName);
 	
 protected:
 	// "protected" Hilfsfunktionen, die nur von Methoden innerhalb der
 	// Klasse (und deren Kindern, daher nicht private sondern protected)
 	// aufgerufen werden koennen
 	
+	// Konstruktor fuer Worker-Objekte
+	// das Worker-Objekt hat eigene Histogramme, die nicht in der
+	// Ausgabedatei landen, und liest keine Ereignisse selbst
+	fp13BasicAnalysis(const fp13BasicAnalysis& master);
+
+	// Erzeugen eines Worker-Objekts fuer analyzeParallel
+	// Abgeleitete Klassen, die mit mehreren Threads analysieren sollen,
+	// muessen diese Methode ueberschreiben, damit die Worker ihre
+	// Methoden benutzen, also z.B.
+	//
+	// 	fp13Analysis* MyAnalysis::createWorker() const
+	// 	{ return new MyAnalysis(*this); }
+	virtual fp13BasicAnalysis* createWorker() const;
+
+	// Schleife eines Worker-Threads: analysiert die Ereignisse aus
+	// der Warteschlange, bis sie leer ist
+	void workerLoop(BatchQueue& queue);
+
+	// Hat die Klasse eigene Methoden zum Finden von Zerfaellen und
+	// Nachpulsen (findDecayUpward usw.)? Nur ohne sie koennen analyze und
+	// analyzeBatch mit den vorab berechneten Tabellen bzw. Vektorbefehlen
+	// arbeiten (s. fp13Classify.h; die Tabellen gibt es fuer bis zu 8
+	// Lagen, mit mehr Lagen wird immer Lage fuer Lage gesucht).
+	// Standard: true fuer alle abgeleiteten Klassen; wer keine dieser
+	// Methoden ueberschreibt, kann hier false zurueckgeben.
+	virtual bool hasOwnFinders() const;
+
+	// Analyse des aktuellen Ereignisses mit den Tabellen aus
+	// fp13Classify.h (fuer analyze, falls hasOwnFinders false ist)
+	void analyzeWithTables();
+
+	// Analyse des aktuellen Ereignisses wie in analyze, wobei
+	// determineLastLayerHitByIncomingMuon, findDecayUpward usw. von
+	// finders aufgerufen werden; analyze uebergibt *this (also virtuelle
+	// Aufrufe), fp13StaticAnalysis ein Objekt, das die Methoden der
+	// abgeleiteten Klasse direkt aufruft
+	template <class Finders>
+	void analyzeEvent(Finders& finders);
+
+	// Analyse aller Ereignisse von batch, eines nach dem anderen mit
+	// analyze
+	void analyzeEachEvent(const Batch& batch);
+	// Klassifizieren aller Zeitbins von batch mit fp13Classifier und
+	// Fuellen der Histogramme; fp13Classifier arbeitet mit Hitmustern in
+	// einem Byte, fuer andere Pakete (mehr als 8 Lagen) waehlt der
+	// Compiler die zweite Variante, die jedes Ereignis einzeln analysiert
+	void classifyBatch(const fp13EventBatch& batch);
+	template <class OtherBatch>
+	void classifyBatch(const OtherBatch& batch)
+	{ analyzeEachEvent(batch); }
+
+	// Fuellen der Histogramme fuer alle Ereignisse von batch aus dem
+	// Ergebnis von fp13Classifier (wie in analyze)
+	void fillClassified(const fp13EventBatch& batch,
+			const fp13Classifier& result);
+
+	// Addieren der Histogramme eines Worker-Objekts
+	virtual void mergeHistograms(const fp13BasicAnalysis& worker);
+
 	// Buchen der Histogramme
 	// wird im Konstruktor aufgerufen, daher nicht virtuell
 	void bookHistograms();
 
+	// alle Histogramme in der Reihenfolge, in der sie in der
+	// Ausgabedatei stehen
+	void getHistograms(vector<fp13Histogram*>& histograms) const;
+
+	// Umwandeln der Histogramme in TH1D in der Ausgabedatei
+	// bereits vorhandene TH1D werden aktualisiert
+	// wird im Destruktor vor dem Schreiben der Datei aufgerufen
+	void writeHistograms();
+	// Schreiben des aktuellen Stands in die Ausgabedatei
+	void refreshOutput();
+
+	// Schreiben eines Checkpoints mit Leseposition offset, Zaehlern
+	// und Histogrammen
+	// gibt false zurueck, falls er nicht geschrieben werden kann
+	bool saveCheckpoint(const string& fileName, size_t offset) const;
+	// Laden eines Checkpoints, setzt offset auf die Leseposition
+	// gibt false zurueck, falls er fehlt oder nicht zur Eingabedatei
+	// passt
+	bool loadCheckpoint(const string& fileName, size_t& offset);
+
+	// Freigeben der Histogramme
+	void deleteHistograms();
+
+	// Eintragen eines Kandidaten der Art type (EventFlags) aus dem
+	// aktuellen Ereignis in die Tabelle, falls eine geschrieben wird
+	void recordCandidate(int type, int layer, int delay)
+	{
+		if (candidates)
+			candidates->add(currentEvent, layer, delay, type);
+	}
+	// Abschliessen des Ereignisses in der Tabelle (setzt die eventFlags
+	// seiner Kandidaten)
+	void finishCandidates()
+	{
+		if (candidates) {
+			candidates->finishEvent(eventFlags);
+			if (candidates->full())
+				flushCandidates();
+		}
+	}
+	// Schreiben der gesammelten Kandidaten
+	void flushCandidates();
+
+	// Eintragen von eventFlags und lastMuonLayer des gerade analysierten
+	// Ereignisses in den Flag-Index, falls einer geschrieben wird
+	void indexEvent()
+	{
+		if (!flagIndex)
+			return;
+		if (flagCodes.size() >= fp13FlagIndexWriter::maxSegment ||
+				currentEvent != flagFirstEvent + flagCodes.size())
+			flushFlagIndex();
+		flagCodes.push_back(fp13FlagIndexFormat::code(eventFlags,
+					lastMuonLayer));
+	}
+	// Abgeben der gesammelten Kodes an den fp13FlagIndexWriter
+	void flushFlagIndex();
+
+	// Schreiben des gerade gelesenen Ereignisses in den Skim, falls es
+	// ein Myon im ersten und mindestens ein weiteres Zeitbin hat
+	// (wird von readEvent aufgerufen)
+	void skimEvent();
+
+	// Uebernehmen der gelesenen Hitmuster mask des Ereignisses
+	// currentEvent nach detectorHitMask; passt ein Hitmuster nicht in
+	// Mask (nur bei kaputten Daten), gibt es eine Warnung und false
+	// zurueck, das Ereignis wird dann nicht analysiert
+	bool setHitMask(const vector<int>& mask);
+
 	// Bestimmung der letzten Detektorlage, die vom einlaufenden Myon
 	// beim kontinuierlichen Durchlaufen des Detektors getroffen wurde
 	// setzt lastMuonLayer (s. o.)
@@ -191,8 +487,179 @@ protected:
 	// Routine an, dass in einem neuen Zeitbin gesucht wird und setzt
 	// startLayer auf einen sinnvollen Anfangswer
 	virtual int findAfterpulsesImproved(int timeBin, int startLayer);
+
+	// fp13BasicScan reicht die Ereignisse an die Analyseobjekte seiner
+	// Konfigurationen weiter und schreibt deren Histogramme
+	friend class fp13BasicScan<N>;
+	// ebenso fp13BasicEventStream fuer alle Analyseobjekte, die sich
+	// einen Ereignisstrom teilen
+	friend class fp13BasicEventStream<N>;
+	// und fp13BasicRunSet fuer die Analyseobjekte der einzelnen Laeufe
+	friend class fp13BasicRunSet<N>;
 };
 
+// Analyse des aktuellen Ereignisses (s. analyze)
+// steht im Header, damit fp13StaticAnalysis (s. fp13StaticAnalysis.h) sie
+// mit den Methoden abgeleiteter Klassen instanziieren kann
+template <int N>
+template <class Finders>
+void fp13BasicAnalysis<N>::analyzeEvent(Finders& finders)
+{
+	// Mitzaehlen, wie viele Ereignisse analysiert wurden
+	++analyzedCounter;
+	// Eintreten in das Outputfile (Worker-Objekte fuellen nur ihre
+	// eigenen Histogramme)
+	if (!isWorker)
+		outputDirectory->cd();
+	// Flags zuruecksetzen
+	eventFlags = FlagNone;
+	lastMuonLayer = -1;
+
+	// Fuelle Histogramm mit der Anzahl der Zeitbins, die einen Hit
+	// enthalten
+	h6->Fill(detectorHitMask.size());
+
+	// Loop ueber alle Detektorlagen
+	for (int iDetectorLayer = 0; iDetectorLayer < nLayers;
+			iDetectorLayer++) {
+		// Loop ueber alle Zeitbins
+		for (unsigned iTimeBin = 0; iTimeBin < detectorHitMask.size();
+				iTimeBin++) {
+			// Histogramme als Funktion der Detektorlage
+
+			// Anzahl der Hits in den Detekorlagen
+			// Teste, ob die aktuelle Lage im betrachteten
+			// Zeitfenster getroffen wurde
+			// (Layers::layer(i) ist 1 << i, s. fp13LayerMask)
+			if (detectorHitMask[iTimeBin] &
+					Layers::layer(iDetectorLayer))
+				h1->Fill(iDetectorLayer);
+		}
+		// Zeitpunkt des Hits im ersten Zeitbin in jeder Detektorlage 
+		//   -- falls es noch einen ersten Zeitbin gibt und 
+		//   -- falls ein solcher vorhanden war
+		if (detectorHitMask.empty())
+			continue;
+		if (detectorHitMask[0] & Layers::layer(iDetectorLayer))
+			h21[iDetectorLayer]->Fill(
+					detectorHitTimes[0]);
+	}
+
+	// wie weit ist das Myon im Detektor gekommen?
+	// wird in der Membervariable lastMuonLayer gespeichert
+	lastMuonLayer = finders.determineLastLayerHitByIncomingMuon();
+	// falls kein durchfliegendes Myon im ersten Zeitbin gefunden
+	// wurde, brauchen wir auch nicht nach Zerfaellen oder
+	// Nachpulsen suchen!
+	if (-1 == lastMuonLayer) return;
+	// Fuelle Histogramm, falls eine Lage unter der Lage 0
+	// (alles ab 2. von oben) getroffen wurde
+	h8->Fill(lastMuonLayer);
+	// Falls es nur Hits im ersten Zeitbin gibt, dann beende die
+	// Methode hier, da es weder Nachpulse noch Zerfaelle gibt
+	if (2 > detectorHitMask.size()) return;
+
+	// Loope ueber alle Zeitbins, um zu schauen, ob Zerfaelle oder
+	// Nachpulse gefunden werden
+	// Das nullte Zeitbin ist das, in dem das Einfallende Myon
+	// beobachtet wurde, daher muss man erst ab dem ersten Zeitbin
+	// nach Zerfaellen und Nachpulsen schauen
+	for (unsigned iTimeBin = 1; iTimeBin < detectorHitMask.size();
+			++iTimeBin) {
+		// Zeitverzoegerung schon mal ausrechnen...
+		int delay = detectorHitTimes[iTimeBin] - detectorHitTimes[0];
+		// falls delay klein, werfen wir das Zeitbin weg, weil wir
+		// den Detektor fuer so kleine Zeiten nicht gut genug
+		// verstehen
+		if (delay < minDelay) continue;
+
+		// die Methoden, die die Existenz von Nachpulsen oder
+		// Zerfaellen nach oben/unten pruefen, geben -1 zurueck,
+		// falls nichts gefunden wurde, andernfalls wird die Lage
+		// des Nachpulses/Zerfalls angegeben
+		int where = -1;
+	
+		where = finders.findDecayUpward(iTimeBin);
+		if (-1 != where) {
+			// OK, Zerfall nach oben gefunden - Flags setzen
+			eventFlags = static_cast<EventFlags>(
+				eventFlags | FlagDecayUp);
+			// Detektorlage des Zerfalls nach oben
+			h3->Fill(where);
+			// Histogramm der Verzoegerungszeit fuer die
+			// getroffene Detektorlage
+			h23[where]->Fill(delay);
+			recordCandidate(FlagDecayUp, where, delay);
+		}
+
+		// Zerfall nach unten: Bestimme Lage und Verzoegerungszeit
+		// FIXME: Diese Methode sollen Sie selbst schreiben; in
+		// fp13Analysis.cc steht eine Version, die nur sagt, dass
+		// sie nichts gefunden hat
+		where = finders.findDecayDownward(iTimeBin);
+		if (-1 != where) {
+			// OK, Zerfall nach unten gefunden - Flags setzen
+			eventFlags = static_cast<EventFlags>(
+				eventFlags | FlagDecayDown);
+			// Detektorlage des Zerfalls nach unten
+			h4->Fill(where);
+			// Histogramm der Verzoegerungszeit fuer die
+			// getroffene Detektorlage
+			h24[where]->Fill(delay);
+			recordCandidate(FlagDecayDown, where, delay);
+		}
+
+		// Suche Nachpulse mit durchgehenden Myonen
+		where = -1;
+		// Fuelle die Histogramme, solange wir Nachpulse finden
+		while (-1 != (where =
+				finders.findAfterpulsesUsingThroughGoingMuons(
+					iTimeBin, where))) {
+			// Nachpuls gefunden - Flags setzen
+			eventFlags = static_cast<EventFlags>(
+				eventFlags | FlagAfterpulseSimple);
+			// Detektorlage des Nachpulses
+			h5->Fill(where);
+			// Histogramm der Verzoegerungszeit fuer die
+			// getroffene Detektorlage
+			h25[where]->Fill(delay);
+			recordCandidate(FlagAfterpulseSimple, where, delay);
+		}
+
+		// Verbesserte Nachpuls-Analyse
+		// FIXME: Diese Methode sollen Sie selbst schreiben; in
+		// fp13Analysis.cc steht eine Version, die nur sagt, dass
+		// sie nichts gefunden hat. Ueberlegen Sie sich, wie man
+		// die Nachpulserkennung, die oben verwendet wird,
+		// verbessern kann!
+		where = -1;
+		// Fuelle die Histogramme, solange wir Nachpulse finden
+		while (-1 != (where = finders.findAfterpulsesImproved(
+						iTimeBin, where))) {
+			// Nachpuls gefunden - Flags setzen
+			eventFlags = static_cast<EventFlags>(
+				eventFlags | FlagAfterpulseImproved);
+			// Detektorlage des Nachpulses
+			h2->Fill(where);
+			// Histogramm der Verzoegerungszeit fuer die
+			// getroffene Detektorlage
+			h22[where]->Fill(delay);
+			recordCandidate(FlagAfterpulseImproved, where, delay);
+		}
+	} // Ende des Loops ueber die Zeitbins
+	// die Kandidaten bekommen die Flags des ganzen Ereignisses
+	finishCandidates();
+
+	// Fuelle Anzahl der beruecksichtigten Zeitfenster in dem Ereignis
+	// Fuelle nur, falls ein Zerfall nach oben oder unten gefunden wurde
+	if (eventFlags & FlagDecay)
+		h7->Fill(detectorHitMask.size());	
+	// Glueckwunsch - Analyse des Events ist hier beendet! ;)
+}
+
+// die Analyse fuer den Detektor im Praktikum
+typedef fp13BasicAnalysis<6> fp13Analysis;
+
 #endif
 
 // Dateiende
@@ -0,0 +1,86 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Wiederverwendbarer Speicher fuer viele kleine Felder (s. fp13Arena.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Arena.h"
+
+#include <new>
+
+fp13Arena::fp13Arena(size_t size) :
+	blockSize(size), current(0), used(0)
+{ }
+
+fp13Arena::~fp13Arena()
+{ freeBlocks(); }
+
+void fp13Arena::freeBlocks()
+{
+	for (size_t i = 0; i < blocks.size(); ++i)
+		::operator delete(blocks[i]);
+	blocks.clear();
+	sizes.clear();
+	current = used = 0;
+}
+
+// Anlegen eines neuen Blocks
+void fp13Arena::addBlock(size_t size)
+{
+	// ::operator new liefert Speicher, der fuer jeden einfachen Typ
+	// ausgerichtet ist; die 64-Byte-Ausrichtung macht allocate selbst,
+	// dafuer wird etwas Platz zugegeben
+	if (size < blockSize)
+		size = blockSize;
+	size += alignment;
+	blocks.push_back(static_cast<char*>(::operator new(size)));
+	sizes.push_back(size);
+}
+
+void* fp13Arena::allocate(size_t size)
+{
+	for (;;) {
+		if (current < blocks.size()) {
+			// naechste ausgerichtete Adresse im aktuellen Block
+			char* base = blocks[current];
+			const size_t misalign = reinterpret_cast<size_t>(
+					base + used) % alignment;
+			const size_t offset = used +
+				(misalign ? alignment - misalign : 0);
+			if (offset + size <= sizes[current]) {
+				used = offset + size;
+				return base + offset;
+			}
+			// passt nicht mehr, im naechsten Block weitermachen
+			if (current + 1 < blocks.size()) {
+				++current;
+				used = 0;
+				continue;
+			}
+		}
+		// neuer Block
+		addBlock(size);
+		current = blocks.size() - 1;
+		used = 0;
+	}
+}
+
+void fp13Arena::reset()
+{
+	// mehrere Bloecke durch einen ersetzen, in den alles passt
+	if (blocks.size() > 1) {
+		const size_t total = capacity();
+		freeBlocks();
+		addBlock(total);
+	}
+	current = used = 0;
+}
+
+size_t fp13Arena::capacity() const
+{
+	size_t total = 0;
+	for (size_t i = 0; i < sizes.size(); ++i)
+		total += sizes[i];
+	return total;
+}
+
+// Dateiende
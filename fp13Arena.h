@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Speicher fuer viele kleine Felder, der wiederverwendet wird
+//
+// fp13Arena teilt Speicher aus grossen Bloecken einfach hintereinander
+// aus (bump allocation); einzelne Felder werden nie freigegeben, sondern
+// alle auf einmal mit reset. Der Speicher selbst bleibt dabei erhalten:
+// Hat ein Durchgang mehrere Bloecke gebraucht, werden sie beim reset zu
+// einem Block zusammengefasst, der gross genug fuer alles ist. Nach
+// dem ersten Paket Ereignisse (s. fp13EventQueue.h) wird also kein
+// Speicher mehr angefordert.
+//
+// Alle Felder sind auf alignment Bytes ausgerichtet, damit sie sich
+// auch mit Vektorbefehlen (SSE/AVX) gut verarbeiten lassen.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13ARENA_H
+#define FP13ARENA_H
+
+// C++ headers
+#include <vector>
+#include <cstddef>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13Arena
+{
+public:
+	// Bloecke haben mindestens blockSize Bytes
+	fp13Arena(size_t blockSize = 1 << 20);
+	~fp13Arena();
+
+	// Ausrichtung aller Felder in Bytes
+	static const size_t alignment = 64;
+
+	// Speicher fuer size Bytes
+	void* allocate(size_t size);
+	// Speicher fuer ein Feld aus n Elementen vom Typ T (die Elemente
+	// werden nicht initialisiert, T sollte also ein einfacher Typ sein)
+	template <class T>
+	T* allocate(size_t n)
+	{ return static_cast<T*>(allocate(n * sizeof(T))); }
+
+	// Freigeben aller Felder auf einmal, der Speicher bleibt erhalten
+	void reset();
+
+	// insgesamt angeforderter Speicher in Bytes
+	size_t capacity() const;
+
+private:
+	// Anlegen eines neuen Blocks mit mindestens size Bytes
+	void addBlock(size_t size);
+	// Freigeben aller Bloecke
+	void freeBlocks();
+
+	size_t blockSize;
+	// Bloecke und ihre Groesse
+	vector<char*> blocks;
+	vector<size_t> sizes;
+	// Block, aus dem gerade ausgeteilt wird, und wie viel davon schon
+	// vergeben ist
+	size_t current;
+	size_t used;
+
+	// nicht kopierbar
+	fp13Arena(const fp13Arena&);
+	fp13Arena& operator=(const fp13Arena&);
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Einlesen von stdin und named pipes in einem eigenen Thread
+// (s. fp13AsyncReader.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13AsyncReader.h"
+
+#include <cerrno>
+#include <cstring>
+
+// C header files (fuer read, close, poll)
+#include <unistd.h>
+#include <poll.h>
+
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// fp13AsyncReader
+////////////////////////////////////////////////////////////////////////
+fp13AsyncReader::fp13AsyncReader(int f, bool owner) :
+	fd(f), ownsFd(owner)
+{
+	init();
+	start();
+}
+
+fp13AsyncReader::fp13AsyncReader() :
+	fd(-1), ownsFd(false)
+{
+	init();
+}
+
+fp13AsyncReader::~fp13AsyncReader()
+{
+	stop();
+	if (ownsFd)
+		::close(fd);
+}
+
+// Anlegen der Puffer
+void fp13AsyncReader::init()
+{
+	buffers.resize(nBuffers);
+	current = 0;
+	finished = stopping = false;
+	for (unsigned i = 0; i < nBuffers; ++i) {
+		buffers[i].data.resize(bufferSize);
+		buffers[i].size = 0;
+		free.push_back(&buffers[i]);
+	}
+}
+
+void fp13AsyncReader::start()
+{
+	reader = thread(&fp13AsyncReader::readLoop, this);
+}
+
+void fp13AsyncReader::stop()
+{
+	// lesenden Thread anhalten; er bemerkt das spaetestens nach
+	// pollInterval, auch wenn gerade keine Daten kommen
+	{
+		unique_lock<mutex> guard(bufferMutex);
+		stopping = true;
+	}
+	bufferChanged.notify_all();
+	if (reader.joinable())
+		reader.join();
+}
+
+bool fp13AsyncReader::isStopping()
+{
+	unique_lock<mutex> guard(bufferMutex);
+	return stopping;
+}
+
+// Fuellen eines Puffers mit dem, was gerade lesbar ist
+bool fp13AsyncReader::fill(Buffer& buffer, bool& atEnd, string& err)
+{
+	while (buffer.size < bufferSize) {
+		// auf Daten warten; ist schon etwas im Puffer, wird er
+		// abgegeben, sobald nicht sofort mehr Daten da sind
+		struct pollfd p;
+		p.fd = fd;
+		p.events = POLLIN;
+		p.revents = 0;
+		const int ready = poll(&p, 1, buffer.size ? 0 : pollInterval);
+		if (-1 == ready && EINTR != errno) {
+			err = strerror(errno);
+			return true;
+		}
+		if (ready <= 0) {
+			if (buffer.size)
+				return true;
+			if (isStopping())
+				return false;
+			continue;
+		}
+
+		const ssize_t n = ::read(fd, buffer.data.data() + buffer.size,
+				bufferSize - buffer.size);
+		if (-1 == n) {
+			if (EINTR == errno || EAGAIN == errno)
+				continue;
+			err = strerror(errno);
+			return true;
+		}
+		if (0 == n) {
+			// Ende der Eingabe
+			atEnd = true;
+			return true;
+		}
+		buffer.size += n;
+	}
+	return true;
+}
+
+// Hauptschleife des lesenden Threads
+void fp13AsyncReader::readLoop()
+{
+	for (;;) {
+		// warten, bis ein Puffer frei ist
+		Buffer* buffer;
+		{
+			unique_lock<mutex> guard(bufferMutex);
+			while (free.empty() && !stopping)
+				bufferChanged.wait(guard);
+			if (stopping)
+				return;
+			buffer = free.front();
+			free.pop_front();
+		}
+
+		// das Fuellen selbst passiert ohne Lock
+		bool atEnd = false;
+		string err;
+		buffer->size = 0;
+		const bool ok = fill(*buffer, atEnd, err);
+
+		bool done;
+		{
+			unique_lock<mutex> guard(bufferMutex);
+			if (ok)
+				full.push_back(buffer);
+			else
+				free.push_back(buffer);
+			// nach einem Fehler gibt es auch nichts mehr zu lesen
+			readError = err;
+			finished = atEnd || !err.empty();
+			done = !ok || finished;
+		}
+		bufferChanged.notify_all();
+		if (done)
+			return;
+	}
+}
+
+// naechsten gefuellten Puffer holen
+fp13AsyncReader::int_type fp13AsyncReader::underflow()
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	unique_lock<mutex> guard(bufferMutex);
+	// abgearbeiteten Puffer zurueckgeben
+	if (current) {
+		free.push_back(current);
+		current = 0;
+		bufferChanged.notify_all();
+	}
+	for (;;) {
+		while (full.empty() && !finished && !stopping)
+			bufferChanged.wait(guard);
+		if (full.empty()) {
+			if (!readError.empty()) {
+				error << "Fehler beim Lesen der Eingabe: " <<
+					readError << "." << endl;
+				throw;
+			}
+			setg(0, 0, 0);
+			return traits_type::eof();
+		}
+		current = full.front();
+		full.pop_front();
+		if (current->size)
+			break;
+		// leerer Puffer (nur am Ende der Eingabe)
+		free.push_back(current);
+		current = 0;
+		bufferChanged.notify_all();
+	}
+	char* data = current->data.data();
+	setg(data, data, data + current->size);
+	return traits_type::to_int_type(*gptr());
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13IStream
+////////////////////////////////////////////////////////////////////////
+fp13IStream::fp13IStream(streambuf* b) :
+	istream(b), buf(b)
+{ }
+
+fp13IStream::~fp13IStream()
+{ delete buf; }
+
+// Dateiende
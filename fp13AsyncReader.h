@@ -0,0 +1,125 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Einlesen von stdin und named pipes in einem eigenen Thread
+//
+// Kommen die Daten ueber eine Pipe (z.B. "zcat run.txt.gz | fp13 -i -"
+// oder direkt von der Datennahme), wartet der analysierende Thread sonst
+// bei jedem Lesen, bis wieder Daten da sind. fp13AsyncReader liest
+// stattdessen in einem eigenen Thread in eine feste Anzahl grosser
+// Puffer und reicht die gefuellten Puffer ueber eine Warteschlange an
+// den Leser weiter; waehrenddessen kann dieser die vorigen Daten
+// zerlegen und analysieren. Sind alle Puffer voll, wartet der lesende
+// Thread, so dass der Speicherbedarf begrenzt bleibt.
+//
+// fp13AsyncReader ist ein streambuf, die Eingabequellen fuer Streams
+// (fp13StreamInput, fp13BinaryInput) lesen also unveraendert ueber einen
+// fp13IStream.
+//
+// Abgeleitete Klassen koennen die Puffer statt aus einem
+// Dateideskriptor auch anders fuellen, indem sie fill ueberschreiben
+// (s. fp13Compressed.h); sie muessen dann im Konstruktor start und im
+// Destruktor stop aufrufen.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13ASYNCREADER_H
+#define FP13ASYNCREADER_H
+
+// C++ headers
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13AsyncReader : public streambuf
+{
+public:
+	// liest im Hintergrund vom Dateideskriptor fd; falls owner gesetzt
+	// ist, wird fd im Destruktor geschlossen
+	fp13AsyncReader(int fd, bool owner);
+	virtual ~fp13AsyncReader();
+
+	// Groesse und Anzahl der Puffer
+	static const size_t bufferSize = 1 << 20;
+	static const unsigned nBuffers = 4;
+	// so oft sieht der lesende Thread nach, ob er aufhoeren soll, in ms
+	static const int pollInterval = 100;
+
+	// Anhalten des lesenden Threads; ein wartendes underflow liefert
+	// danach das Ende der Eingabe
+	virtual void stop();
+
+protected:
+	// Konstruktor fuer abgeleitete Klassen, die fill ueberschreiben
+	fp13AsyncReader();
+
+	// Starten des lesenden Threads
+	void start();
+	// soll der lesende Thread aufhoeren?
+	bool isStopping();
+
+	// naechsten gefuellten Puffer holen (wird von istream aufgerufen)
+	virtual int_type underflow();
+
+	struct Buffer {
+		vector<char> data;
+		size_t size;
+	};
+
+	// Fuellen eines Puffers (im lesenden Thread); setzt atEnd am Ende
+	// der Eingabe und err bei einem Fehler, der Inhalt des Puffers wird
+	// in beiden Faellen noch abgeliefert
+	// gibt false zurueck, falls der Thread aufhoeren soll
+	virtual bool fill(Buffer& buffer, bool& atEnd, string& err);
+
+	// Hauptschleife des lesenden Threads
+	void readLoop();
+
+	int fd;
+	bool ownsFd;
+	vector<Buffer> buffers;
+	// gefuellte und freie Puffer
+	deque<Buffer*> full, free;
+	// Puffer, aus dem gerade gelesen wird
+	Buffer* current;
+	// Ende der Eingabe erreicht bzw. Fehlermeldung
+	bool finished;
+	string readError;
+	// der lesende Thread soll aufhoeren
+	bool stopping;
+
+	thread reader;
+	mutex bufferMutex;
+	condition_variable bufferChanged;
+
+private:
+	// Anlegen der Puffer
+	void init();
+
+	// nicht kopierbar
+	fp13AsyncReader(const fp13AsyncReader&);
+	fp13AsyncReader& operator=(const fp13AsyncReader&);
+};
+
+// istream, der ueber einen eigenen streambuf liest und ihn im Destruktor
+// freigibt
+class fp13IStream : public istream
+{
+public:
+	fp13IStream(streambuf* buf);
+	virtual ~fp13IStream();
+
+protected:
+	streambuf* buf;
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,340 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Kompaktes Binaerformat fuer die Ereignisdaten (s. fp13Binary.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Binary.h"
+
+#include <string>
+#include <iostream>
+#include <cstring>
+
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// Hilfsfunktionen zum Kodieren und Dekodieren
+////////////////////////////////////////////////////////////////////////
+// Lesen eines varint ab p; gibt false zurueck, falls der Puffer vorher
+// zu Ende ist oder die Zahl nicht in 64 Bit passt
+static inline bool getVarint(const unsigned char*& p,
+		const unsigned char* end, unsigned long long& value)
+{
+	value = 0;
+	for (unsigned shift = 0; shift < 64 && p != end; shift += 7) {
+		unsigned char byte = *p++;
+		value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// Anhaengen eines varint an buf
+static inline void putVarint(vector<unsigned char>& buf,
+		unsigned long long value)
+{
+	while (value >= 0x80) {
+		buf.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	buf.push_back(static_cast<unsigned char>(value));
+}
+
+// zigzag-Kodierung vorzeichenbehafteter Zahlen
+static inline unsigned long long zigzag(long long value)
+{
+	return (static_cast<unsigned long long>(value) << 1) ^
+		static_cast<unsigned long long>(value >> 63);
+}
+
+static inline long long unzigzag(unsigned long long value)
+{
+	return static_cast<long long>(value >> 1) ^
+		-static_cast<long long>(value & 1);
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13BinaryFormat
+////////////////////////////////////////////////////////////////////////
+const char fp13BinaryFormat::magic[8] =
+	{ '\x89', 'F', 'P', '1', '3', 'E', 'V', '\n' };
+
+bool fp13BinaryFormat::hasMagic(const char* begin, const char* end)
+{
+	return end - begin >= static_cast<long>(sizeof(magic)) &&
+		0 == memcmp(begin, magic, sizeof(magic));
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13BinaryInput
+////////////////////////////////////////////////////////////////////////
+fp13BinaryInput::fp13BinaryInput(const string& name, fp13MappedFile* f) :
+	fp13Input(name), maskBytes(1), file(f),
+	current(reinterpret_cast<const unsigned char*>(f->begin())),
+	dataEnd(reinterpret_cast<const unsigned char*>(f->end())),
+	inputStream(0), ownsStream(false)
+{
+	if (static_cast<size_t>(dataEnd - current) <
+			fp13BinaryFormat::headerSize) {
+		error << "Unvollstaendiger Dateikopf in " << fileName <<
+			"." << endl;
+		throw;
+	}
+	readHeader(current);
+	current += fp13BinaryFormat::headerSize;
+}
+
+fp13BinaryInput::fp13BinaryInput(const string& name, istream& stream,
+		bool owner) :
+	fp13Input(name), maskBytes(1), file(0), current(0), dataEnd(0),
+	inputStream(&stream), ownsStream(owner)
+{
+	unsigned char header[fp13BinaryFormat::headerSize];
+	stream.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (static_cast<size_t>(stream.gcount()) != sizeof(header) ||
+			!fp13BinaryFormat::hasMagic(
+				reinterpret_cast<const char*>(header),
+				reinterpret_cast<const char*>(header) +
+				sizeof(header))) {
+		error << "Unvollstaendiger Dateikopf in " << fileName <<
+			"." << endl;
+		throw;
+	}
+	readHeader(header);
+}
+
+fp13BinaryInput::~fp13BinaryInput()
+{
+	delete file;
+	// falls die Daten von cin kommen, darf der Speicher
+	// nicht zurueckgegeben werden
+	if (ownsStream)
+		delete inputStream;
+}
+
+// Pruefen des Dateikopfs
+void fp13BinaryInput::readHeader(const unsigned char* header)
+{
+	unsigned version = header[8] | (header[9] << 8);
+	if (fp13BinaryFormat::version != version) {
+		error << "Version " << version << " des Binaerformats in " <<
+			fileName << " wird nicht unterstuetzt." << endl;
+		throw;
+	}
+	maskBytes = header[10];
+	if (1 != maskBytes && 2 != maskBytes && 4 != maskBytes) {
+		error << "Ungueltige Breite der Hitmuster (" << maskBytes <<
+			" Bytes) in " << fileName << "." << endl;
+		throw;
+	}
+}
+
+int fp13BinaryInput::readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned long eventCounter)
+{
+	hitMask.clear();
+	hitTimes.clear();
+
+	const unsigned char *begin, *end;
+	unsigned long long length;
+	if (file) {
+		// Ereignis direkt aus der eingeblendeten Datei dekodieren
+		if (current == dataEnd)
+			return -1;
+		if (!getVarint(current, dataEnd, length) ||
+				length > static_cast<unsigned long long>(
+					dataEnd - current)) {
+			warn << "Unvollstaendiges Ereignis " <<
+				(eventCounter + 1) << " am Ende von " <<
+				fileName << "." << endl;
+			current = dataEnd;
+			return -1;
+		}
+		begin = current;
+		current += length;
+		end = current;
+	} else {
+		// Laenge Byte fuer Byte lesen, dann das ganze Ereignis
+		int c = inputStream->get();
+		if (EOF == c)
+			return -1;
+		length = 0;
+		bool complete = false;
+		for (unsigned shift = 0; shift < 64; shift += 7) {
+			length |= static_cast<unsigned long long>(c & 0x7f) <<
+				shift;
+			if (!(c & 0x80)) {
+				complete = true;
+				break;
+			}
+			if (EOF == (c = inputStream->get()))
+				break;
+		}
+		// passt die Laenge nicht in 64 Bit, ist die Datei kaputt
+		if (!complete && EOF != c) {
+			error << "Fehlerhafte Laenge von Ereignis " <<
+				(eventCounter + 1) << " in " << fileName <<
+				"." << endl;
+			throw;
+		}
+		buf.resize(length);
+		if (EOF == c || !inputStream->read(
+					reinterpret_cast<char*>(buf.data()),
+					length)) {
+			// auf Lesefehler pruefen (nicht Ende der Eingabedatei)
+			if (inputStream->bad()) {
+				error << "Fehler beim Lesen der Eingabedatei " <<
+					fileName << "." << endl;
+				throw;
+			}
+			warn << "Unvollstaendiges Ereignis " <<
+				(eventCounter + 1) << " am Ende von " <<
+				fileName << "." << endl;
+			return -1;
+		}
+		begin = buf.data();
+		end = begin + length;
+	}
+
+	if (!decodeEvent(begin, end, hitMask, hitTimes, eventCounter)) {
+		error << "Fehlerhaftes Ereignis " << (eventCounter + 1) <<
+			" in " << fileName << "." << endl;
+		throw;
+	}
+
+	// Event erfolgreich gelesen
+	return 0;
+}
+
+const fp13MappedFile* fp13BinaryInput::getMappedFile() const
+{ return file; }
+
+size_t fp13BinaryInput::firstEventOffset() const
+{ return fp13BinaryFormat::headerSize; }
+
+bool fp13BinaryInput::skipEvent(size_t& offset) const
+{
+	const unsigned char* begin =
+		reinterpret_cast<const unsigned char*>(file->begin());
+	const unsigned char* p = begin + offset;
+	// nur die Laenge lesen, der Inhalt wird uebersprungen
+	unsigned long long length;
+	if (p >= dataEnd || !getVarint(p, dataEnd, length) ||
+			length > static_cast<unsigned long long>(dataEnd - p))
+		return false;
+	offset = (p - begin) + length;
+	return true;
+}
+
+bool fp13BinaryInput::seek(size_t offset)
+{
+	if (!file || offset < fp13BinaryFormat::headerSize ||
+			offset > file->size())
+		return false;
+	current = reinterpret_cast<const unsigned char*>(file->begin()) +
+		offset;
+	return true;
+}
+
+// Dekodieren eines Ereignisses
+bool fp13BinaryInput::decodeEvent(const unsigned char* p,
+		const unsigned char* end,
+		vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned long eventCounter)
+{
+	unsigned long long nBins;
+	if (!getVarint(p, end, nBins) || 0 == nBins ||
+			nBins * maskBytes > static_cast<unsigned long long>(
+				end - p))
+		return false;
+	// Hitmuster stehen am Stueck, danach kommen die Zeiten
+	const unsigned char* masks = p;
+	p += nBins * maskBytes;
+
+	unsigned merged = 0;
+	long long time = 0;
+	for (unsigned long long iBin = 0; iBin < nBins; ++iBin) {
+		unsigned long long delta;
+		if (!getVarint(p, end, delta))
+			return false;
+		time += unzigzag(delta);
+		unsigned mask = masks[0];
+		if (maskBytes > 1)
+			mask |= masks[1] << 8;
+		if (maskBytes > 2)
+			mask |= (masks[2] << 16) |
+				(static_cast<unsigned>(masks[3]) << 24);
+		masks += maskBytes;
+		// Hit anfuegen (und ggf. mit dem vorhergehenden
+		// zusammenfassen), genau wie beim Lesen von Textdateien
+		addHit(static_cast<int>(mask), static_cast<int>(time),
+				hitMask, hitTimes, merged, eventCounter,
+				warnings);
+	}
+	flushWarnings();
+	return p == end;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13BinaryOutput
+////////////////////////////////////////////////////////////////////////
+fp13BinaryOutput::fp13BinaryOutput(ostream& o, unsigned bytes) :
+	out(o), maskBytes(bytes)
+{
+	buf.reserve(256);
+}
+
+// Schreiben des Dateikopfs
+void fp13BinaryOutput::writeHeader()
+{
+	unsigned char header[fp13BinaryFormat::headerSize];
+	memset(header, 0, sizeof(header));
+	memcpy(header, fp13BinaryFormat::magic, sizeof(fp13BinaryFormat::magic));
+	header[8] = fp13BinaryFormat::version & 0xff;
+	header[9] = fp13BinaryFormat::version >> 8;
+	header[10] = maskBytes;
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+// Schreiben eines Ereignisses
+bool fp13BinaryOutput::writeEvent(const vector<int>& hitMask,
+		const vector<int>& hitTimes)
+{
+	// groesstes Hitmuster, das in maskBytes Bytes passt
+	const unsigned long long maxMask = (4 == maskBytes) ? 0xffffffffull :
+		((1ull << (8 * maskBytes)) - 1);
+
+	buf.clear();
+	putVarint(buf, hitMask.size());
+	for (unsigned iBin = 0; iBin < hitMask.size(); ++iBin) {
+		// mit 4 Bytes wird das Bitmuster des int gespeichert (Hitmuster
+		// ueber INT_MAX, s. fp13Input::parseLine)
+		unsigned mask = static_cast<unsigned>(hitMask[iBin]);
+		if ((hitMask[iBin] < 0 && 4 != maskBytes) || mask > maxMask)
+			return false;
+		for (unsigned iByte = 0; iByte < maskBytes; ++iByte)
+			buf.push_back((mask >> (8 * iByte)) & 0xff);
+	}
+	long long previous = 0;
+	for (unsigned iBin = 0; iBin < hitTimes.size(); ++iBin) {
+		putVarint(buf, zigzag(hitTimes[iBin] - previous));
+		previous = hitTimes[iBin];
+	}
+
+	// Laenge voranstellen
+	unsigned char length[10];
+	unsigned nLength = 0;
+	unsigned long long value = buf.size();
+	while (value >= 0x80) {
+		length[nLength++] = static_cast<unsigned char>(value | 0x80);
+		value >>= 7;
+	}
+	length[nLength++] = static_cast<unsigned char>(value);
+	out.write(reinterpret_cast<const char*>(length), nLength);
+	out.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+	return true;
+}
+
+// Dateiende
@@ -0,0 +1,128 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Kompaktes Binaerformat fuer die Ereignisdaten
+//
+// Das Einlesen der Textdateien kostet bei wiederholten Durchlaeufen den
+// Grossteil der Rechenzeit. fp13convert wandelt eine Textdatei daher
+// einmalig in das folgende Binaerformat um, das fp13Input::open anhand
+// der Kennung am Dateianfang automatisch erkennt.
+//
+// Aufbau einer Binaerdatei (alle Zahlen little endian):
+//
+// Dateikopf (16 Bytes)
+// 	8 Bytes		Kennung "\x89" "FP13EV" "\n"
+// 	2 Bytes		Version des Formats (derzeit 1)
+// 	1 Byte		Breite der Hitmuster in Bytes (1, 2 oder 4)
+// 	5 Bytes		reserviert (0)
+//
+// danach folgen die Ereignisse, jeweils
+// 	varint		Laenge des restlichen Ereignisses in Bytes
+// 	varint		Anzahl n der Zeitbins
+// 	n * Breite	Hitmuster der Zeitbins
+// 	n * varint	Zeiten der Zeitbins; die erste absolut, alle weiteren
+// 			als Differenz zur vorhergehenden (zigzag-kodiert)
+//
+// varint: 7 Bit pro Byte, niederwertigste zuerst; ist das oberste Bit
+// gesetzt, folgt noch ein Byte
+// zigzag: 0, -1, 1, -2, 2, ... werden auf 0, 1, 2, 3, 4, ... abgebildet
+//
+// Gespeichert werden die Zeitbins so, wie sie in der Textdatei stehen,
+// also noch nicht zusammengefasst; das Zusammenfassen zeitlich naher
+// Zeitbins (s. fp13Input::setMergeWindow) passiert beim Lesen, genau wie
+// bei Textdateien.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13BINARY_H
+#define FP13BINARY_H
+
+// C++ headers
+#include <iostream>
+#include <vector>
+#include <string>
+
+#include "fp13Input.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+// Konstanten und Hilfsfunktionen zum Binaerformat
+struct fp13BinaryFormat
+{
+	// Kennung am Dateianfang
+	static const char magic[8];
+	// aktuelle Version des Formats
+	static const unsigned version = 1;
+	// Groesse des Dateikopfs in Bytes
+	static const unsigned headerSize = 16;
+
+	// beginnt der Puffer [begin, end) mit der Kennung?
+	static bool hasMagic(const char* begin, const char* end);
+};
+
+// Lesen von Binaerdateien
+class fp13BinaryInput : public fp13Input
+{
+public:
+	// liest aus der eingeblendeten Datei file, die dabei in den Besitz
+	// des fp13BinaryInput uebergeht
+	fp13BinaryInput(const string& fileName, fp13MappedFile* file);
+	// liest aus stream; falls owner gesetzt ist, wird der Stream im
+	// Destruktor freigegeben
+	fp13BinaryInput(const string& fileName, istream& stream, bool owner);
+	virtual ~fp13BinaryInput();
+
+	virtual int readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter);
+
+	// Springen ist nur bei eingeblendeten Dateien moeglich
+	virtual const fp13MappedFile* getMappedFile() const;
+	virtual size_t firstEventOffset() const;
+	virtual bool skipEvent(size_t& offset) const;
+	virtual bool seek(size_t offset);
+
+protected:
+	// Pruefen des Dateikopfs, setzt maskBytes
+	void readHeader(const unsigned char* header);
+	// Dekodieren eines Ereignisses aus [p, end)
+	// gibt false zurueck, falls das Ereignis fehlerhaft ist
+	bool decodeEvent(const unsigned char* p, const unsigned char* end,
+			vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter);
+
+	// Breite der Hitmuster in Bytes
+	unsigned maskBytes;
+	// Eingabe aus eingeblendeter Datei: aktuelle Position und Ende
+	fp13MappedFile* file;
+	const unsigned char* current;
+	const unsigned char* dataEnd;
+	// Eingabe aus einem Stream, mit Puffer fuer ein Ereignis
+	istream* inputStream;
+	bool ownsStream;
+	vector<unsigned char> buf;
+};
+
+// Schreiben von Binaerdateien
+class fp13BinaryOutput
+{
+public:
+	// schreibt auf out, Hitmuster werden mit maskBytes Bytes gespeichert
+	fp13BinaryOutput(ostream& out, unsigned maskBytes = 1);
+
+	// Schreiben des Dateikopfs
+	void writeHeader();
+	// Schreiben eines Ereignisses
+	// gibt false zurueck, falls ein Hitmuster nicht in maskBytes passt
+	bool writeEvent(const vector<int>& hitMask,
+			const vector<int>& hitTimes);
+
+protected:
+	ostream& out;
+	unsigned maskBytes;
+	// Puffer fuer ein Ereignis
+	vector<unsigned char> buf;
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,421 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Tabelle aller gefundenen Zerfaelle und Nachpulse (s. fp13Candidates.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Candidates.h"
+
+#include <cstring>
+
+// Bibliotheken zum Packen
+#ifdef FP13_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FP13_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "fp13Input.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// Hilfsfunktionen zum Kodieren und Dekodieren
+////////////////////////////////////////////////////////////////////////
+// Schreiben und Lesen von Zahlen mit 4 bzw. 8 Bytes, little endian
+static inline void putU32(unsigned char* p, uint32_t value)
+{
+	for (unsigned i = 0; i < 4; ++i)
+		p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+static inline void putU64(unsigned char* p, uint64_t value)
+{
+	for (unsigned i = 0; i < 8; ++i)
+		p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+static inline uint32_t getU32(const unsigned char* p)
+{
+	return static_cast<uint32_t>(p[0]) |
+		(static_cast<uint32_t>(p[1]) << 8) |
+		(static_cast<uint32_t>(p[2]) << 16) |
+		(static_cast<uint32_t>(p[3]) << 24);
+}
+
+static inline uint64_t getU64(const unsigned char* p)
+{
+	return static_cast<uint64_t>(getU32(p)) |
+		(static_cast<uint64_t>(getU32(p + 4)) << 32);
+}
+
+// varint und zigzag wie im Binaerformat (s. fp13Binary.h)
+static inline void putVarint(vector<unsigned char>& buf,
+		unsigned long long value)
+{
+	while (value >= 0x80) {
+		buf.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	buf.push_back(static_cast<unsigned char>(value));
+}
+
+static inline bool getVarint(const unsigned char*& p,
+		const unsigned char* end, unsigned long long& value)
+{
+	value = 0;
+	for (unsigned shift = 0; shift < 64 && p != end; shift += 7) {
+		unsigned char byte = *p++;
+		value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static inline unsigned long long zigzag(long long value)
+{
+	return (static_cast<unsigned long long>(value) << 1) ^
+		static_cast<unsigned long long>(value >> 63);
+}
+
+static inline long long unzigzag(unsigned long long value)
+{
+	return static_cast<long long>(value >> 1) ^
+		-static_cast<long long>(value & 1);
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13CandidateFormat
+////////////////////////////////////////////////////////////////////////
+const char fp13CandidateFormat::magic[8] =
+	{ '\x89', 'F', 'P', '1', '3', 'C', 'A', '\n' };
+
+fp13CandidateFormat::Compression fp13CandidateFormat::defaultCompression()
+{
+#if defined(FP13_HAVE_ZSTD)
+	return Zstd;
+#elif defined(FP13_HAVE_ZLIB)
+	return Zlib;
+#else
+	return None;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13CandidateBlock
+////////////////////////////////////////////////////////////////////////
+fp13CandidateBlock::fp13CandidateBlock()
+{
+	events.reserve(maxSize);
+	layers.reserve(maxSize);
+	delays.reserve(maxSize);
+	types.reserve(maxSize);
+	flags.reserve(maxSize);
+}
+
+size_t fp13CandidateBlock::size() const
+{ return events.size(); }
+
+bool fp13CandidateBlock::empty() const
+{ return events.empty(); }
+
+bool fp13CandidateBlock::full() const
+{ return events.size() >= maxSize; }
+
+void fp13CandidateBlock::clear()
+{
+	events.clear();
+	layers.clear();
+	delays.clear();
+	types.clear();
+	flags.clear();
+}
+
+// Kodieren als Block
+void fp13CandidateBlock::encode(vector<unsigned char>& out,
+		fp13CandidateFormat::Compression compression) const
+{
+	const size_t n = size();
+	const uint64_t firstEvent = n ? events[0] : 0;
+
+	// ungepackte Spalten: zuerst die Ereignisnummern als Differenzen...
+	raw.clear();
+	uint64_t previous = firstEvent;
+	for (size_t i = 0; i < n; ++i) {
+		putVarint(raw, zigzag(static_cast<long long>(
+						events[i] - previous)));
+		previous = events[i];
+	}
+	// ... dann die Spalten fester Breite
+	size_t pos = raw.size();
+	raw.resize(pos + 7 * n);
+	for (size_t i = 0; i < n; ++i, pos += 4)
+		putU32(&raw[pos], static_cast<uint32_t>(delays[i]));
+	memcpy(&raw[pos], layers.data(), n);
+	memcpy(&raw[pos + n], types.data(), n);
+	// fuer ein nicht abgeschlossenes Ereignis gibt es noch keine Flags
+	memcpy(&raw[pos + 2 * n], flags.data(), min(n, flags.size()));
+	if (flags.size() < n)
+		memset(&raw[pos + 2 * n + flags.size()], 0, n - flags.size());
+
+	// packen; falls das nicht klappt, ungepackt speichern
+	const unsigned headerSize = fp13CandidateFormat::blockHeaderSize;
+	size_t packedSize = 0;
+	bool packed = false;
+	switch (compression) {
+#ifdef FP13_HAVE_ZSTD
+		case fp13CandidateFormat::Zstd:
+			{
+			  out.resize(headerSize + ZSTD_compressBound(raw.size()));
+			  const size_t ret = ZSTD_compress(&out[headerSize],
+					  out.size() - headerSize, raw.data(),
+					  raw.size(), 3);
+			  packed = !ZSTD_isError(ret);
+			  packedSize = ret;
+			}
+			break;
+#endif
+#ifdef FP13_HAVE_ZLIB
+		case fp13CandidateFormat::Zlib:
+			{
+			  uLongf size = compressBound(raw.size());
+			  out.resize(headerSize + size);
+			  packed = Z_OK == compress2(&out[headerSize], &size,
+					  raw.data(), raw.size(), 6);
+			  packedSize = size;
+			}
+			break;
+#endif
+		default:
+			break;
+	}
+	if (!packed) {
+		compression = fp13CandidateFormat::None;
+		out.resize(headerSize);
+		out.insert(out.end(), raw.begin(), raw.end());
+		packedSize = raw.size();
+	}
+	out.resize(headerSize + packedSize);
+
+	// Blockkopf
+	memset(&out[0], 0, headerSize);
+	putU32(&out[0], n);
+	putU32(&out[4], packedSize);
+	putU32(&out[8], raw.size());
+	out[12] = compression;
+	putU64(&out[16], firstEvent);
+}
+
+// Dekodieren eines Blocks
+bool fp13CandidateBlock::decode(const unsigned char* begin,
+		const unsigned char* end)
+{
+	const unsigned headerSize = fp13CandidateFormat::blockHeaderSize;
+	if (end - begin < headerSize)
+		return false;
+	const size_t n = getU32(begin);
+	const size_t packedSize = getU32(begin + 4);
+	const size_t rawSize = getU32(begin + 8);
+	const int compression = begin[12];
+	uint64_t event = getU64(begin + 16);
+	const unsigned char* data = begin + headerSize;
+	if (static_cast<size_t>(end - data) < packedSize)
+		return false;
+
+	// entpacken
+	raw.resize(rawSize);
+	switch (compression) {
+		case fp13CandidateFormat::None:
+			if (packedSize != rawSize)
+				return false;
+			memcpy(raw.data(), data, rawSize);
+			break;
+#ifdef FP13_HAVE_ZSTD
+		case fp13CandidateFormat::Zstd:
+			if (ZSTD_decompress(raw.data(), rawSize, data,
+						packedSize) != rawSize)
+				return false;
+			break;
+#endif
+#ifdef FP13_HAVE_ZLIB
+		case fp13CandidateFormat::Zlib:
+			{
+			  uLongf size = rawSize;
+			  if (Z_OK != uncompress(raw.data(), &size, data,
+						  packedSize) || size != rawSize)
+				  return false;
+			}
+			break;
+#endif
+		default:
+			return false;
+	}
+
+	// Spalten auspacken
+	events.resize(n);
+	layers.resize(n);
+	delays.resize(n);
+	types.resize(n);
+	flags.resize(n);
+	const unsigned char* p = raw.data();
+	const unsigned char* rawEnd = p + rawSize;
+	for (size_t i = 0; i < n; ++i) {
+		unsigned long long diff;
+		if (!getVarint(p, rawEnd, diff))
+			return false;
+		event += unzigzag(diff);
+		events[i] = event;
+	}
+	if (static_cast<size_t>(rawEnd - p) != 7 * n)
+		return false;
+	for (size_t i = 0; i < n; ++i, p += 4)
+		delays[i] = static_cast<int32_t>(getU32(p));
+	memcpy(layers.data(), p, n);
+	memcpy(types.data(), p + n, n);
+	memcpy(flags.data(), p + 2 * n, n);
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13CandidateWriter
+////////////////////////////////////////////////////////////////////////
+fp13CandidateWriter::fp13CandidateWriter(const string& name, int nLayers) :
+	fileName(name),
+	out(name.c_str(), ios::out | ios::binary | ios::trunc),
+	compression(fp13CandidateFormat::defaultCompression()),
+	nCandidates(0)
+{
+	if (!out)
+		return;
+	unsigned char header[fp13CandidateFormat::headerSize];
+	memset(header, 0, sizeof(header));
+	memcpy(header, fp13CandidateFormat::magic,
+			sizeof(fp13CandidateFormat::magic));
+	header[8] = fp13CandidateFormat::version & 0xff;
+	header[9] = fp13CandidateFormat::version >> 8;
+	header[10] = nLayers;
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+fp13CandidateWriter::~fp13CandidateWriter()
+{
+	if (!out.is_open())
+		return;
+	out.flush();
+	if (!out)
+		error << "Fehler beim Schreiben von " << fileName << "." << endl;
+}
+
+bool fp13CandidateWriter::isOpen() const
+{ return out.is_open() && out.good(); }
+
+const string& fp13CandidateWriter::getFileName() const
+{ return fileName; }
+
+unsigned long long fp13CandidateWriter::getNoOfCandidates() const
+{ return nCandidates; }
+
+// Schreiben eines Blocks
+void fp13CandidateWriter::write(const fp13CandidateBlock& block)
+{
+	if (block.empty())
+		return;
+	// packen ohne die Sperre, damit mehrere Threads gleichzeitig
+	// packen koennen
+	vector<unsigned char> buf;
+	block.encode(buf, compression);
+	unique_lock<mutex> guard(writeMutex);
+	out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+	nCandidates += block.size();
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13CandidateReader
+////////////////////////////////////////////////////////////////////////
+fp13CandidateReader::fp13CandidateReader(const string& name) :
+	fileName(name), file(new fp13MappedFile(name)), nLayers(0),
+	nCandidates(0)
+{
+	if (!file->isOpen()) {
+		error << "Fehler beim Oeffnen der Datei " << fileName << "." <<
+			endl;
+		delete file;
+		file = 0;
+		return;
+	}
+	const unsigned char* p =
+		reinterpret_cast<const unsigned char*>(file->begin());
+	const unsigned char* end =
+		reinterpret_cast<const unsigned char*>(file->end());
+
+	// Dateikopf pruefen
+	if (end - p < fp13CandidateFormat::headerSize ||
+			0 != memcmp(p, fp13CandidateFormat::magic,
+				sizeof(fp13CandidateFormat::magic))) {
+		error << fileName << " ist keine Tabelle von Kandidaten." <<
+			endl;
+		delete file;
+		file = 0;
+		return;
+	}
+	const unsigned version = p[8] | (p[9] << 8);
+	if (fp13CandidateFormat::version != version) {
+		error << "Version " << version << " der Tabelle in " <<
+			fileName << " wird nicht unterstuetzt." << endl;
+		delete file;
+		file = 0;
+		return;
+	}
+	nLayers = p[10];
+	p += fp13CandidateFormat::headerSize;
+
+	// Bloecke suchen; ein abgeschnittener letzter Block (z.B. nach
+	// einem Absturz) wird ignoriert
+	const unsigned headerSize = fp13CandidateFormat::blockHeaderSize;
+	while (p != end) {
+		if (end - p < headerSize ||
+				static_cast<size_t>(end - p - headerSize) <
+				getU32(p + 4)) {
+			warn << fileName << " ist abgeschnitten, der letzte "
+				"Block wird ignoriert." << endl;
+			break;
+		}
+		blockBegin.push_back(p);
+		nCandidates += getU32(p);
+		p += headerSize + getU32(p + 4);
+		blockEnd.push_back(p);
+	}
+}
+
+fp13CandidateReader::~fp13CandidateReader()
+{ delete file; }
+
+bool fp13CandidateReader::isOpen() const
+{ return 0 != file; }
+
+int fp13CandidateReader::getNoOfLayers() const
+{ return nLayers; }
+
+size_t fp13CandidateReader::getNoOfBlocks() const
+{ return blockBegin.size(); }
+
+unsigned long long fp13CandidateReader::getNoOfCandidates() const
+{ return nCandidates; }
+
+// Lesen eines Blocks
+bool fp13CandidateReader::readBlock(size_t i, fp13CandidateBlock& block) const
+{
+	if (i >= blockBegin.size())
+		return false;
+	if (!block.decode(blockBegin[i], blockEnd[i])) {
+		error << "Block " << i << " in " << fileName << " ist "
+			"fehlerhaft oder mit einer nicht unterstuetzten "
+			"Kompression gepackt." << endl;
+		return false;
+	}
+	return true;
+}
+
+// Dateiende
@@ -0,0 +1,240 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Tabelle aller gefundenen Zerfaelle und Nachpulse (fp13 -c)
+//
+// In den Histogrammen h22 bis h25 sind die Verzoegerungszeiten fest in
+// 125 Bins eingeteilt; wer fuer Lebensdauer.C oder Einfangzeiten.C
+// anders binnen, den Fitbereich aendern oder ungebinnt fitten will,
+// muesste die ganze Messung neu analysieren. Mit fp13 -c schreibt die
+// Analyse zusaetzlich jeden Kandidaten (Zerfall nach oben/unten,
+// Nachpuls) als Zeile einer Tabelle mit den Spalten
+//
+// 	event	Nummer des Ereignisses in der Eingabedatei (ab 0)
+// 	layer	Detektorlage
+// 	delay	Verzoegerung zum ersten Zeitbin in ns
+// 	type	Art des Kandidaten (fp13CandidateFormat::Type)
+// 	flags	eventFlags des ganzen Ereignisses (gleiche Bits wie type)
+//
+// Gespeichert wird spaltenweise in Bloecken zu hoechstens
+// fp13CandidateBlock::maxSize Zeilen, jeder Block fuer sich mit zstd
+// (oder zlib, falls zstd nicht mit uebersetzt wurde) gepackt. Ein
+// Kandidat braucht ungepackt meist 11 Bytes, gepackt deutlich weniger.
+// Da die Bloecke unabhaengig sind, kann fp13CandidateReader sie in
+// beliebiger Reihenfolge und aus mehreren Threads lesen.
+//
+// Innerhalb eines Blocks stehen die Kandidaten nach Ereignisnummer
+// sortiert; mit mehreren Threads (fp13 -j) schreibt jeder Thread seine
+// eigenen Bloecke, deren Reihenfolge in der Datei dann nicht festliegt.
+//
+// Aufbau der Datei (alle Zahlen little endian):
+//
+// Dateikopf (16 Bytes)
+// 	8 Bytes		Kennung "\x89" "FP13CA" "\n"
+// 	2 Bytes		Version des Formats (derzeit 1)
+// 	1 Byte		Anzahl der Detektorlagen
+// 	5 Bytes		reserviert (0)
+//
+// danach folgen die Bloecke, jeweils
+// 	4 Bytes		Anzahl n der Kandidaten
+// 	4 Bytes		Laenge der gepackten Daten in Bytes
+// 	4 Bytes		Laenge der ungepackten Daten in Bytes
+// 	1 Byte		Kompression (fp13CandidateFormat::Compression)
+// 	3 Bytes		reserviert (0)
+// 	8 Bytes		Ereignisnummer des ersten Kandidaten
+// 	...		gepackte Daten, entpackt:
+// 	n * varint	Ereignisnummer als Differenz zum vorigen Kandidaten
+// 			(beim ersten zur Ereignisnummer im Blockkopf),
+// 			zigzag-kodiert wie in fp13Binary.h
+// 	n * 4 Bytes	delay (vorzeichenbehaftet)
+// 	n * 1 Byte	layer
+// 	n * 1 Byte	type
+// 	n * 1 Byte	flags
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13CANDIDATES_H
+#define FP13CANDIDATES_H
+
+// C++ headers
+#include <fstream>
+#include <vector>
+#include <string>
+#include <mutex>
+// C headers (fuer uint8_t, int32_t, uint64_t)
+#include <stdint.h>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13MappedFile;
+
+// Konstanten zum Dateiformat
+struct fp13CandidateFormat
+{
+	// Art des Kandidaten, dieselben Bits wie die EventFlags in
+	// fp13BasicAnalysis
+	enum Type {
+		DecayDown = 1,
+		DecayUp = 2,
+		AfterpulseSimple = 4,
+		AfterpulseImproved = 8
+	};
+	// Kompression der Bloecke
+	enum Compression { None = 0, Zlib = 1, Zstd = 2 };
+
+	// Kennung am Dateianfang
+	static const char magic[8];
+	// aktuelle Version des Formats
+	static const unsigned version = 1;
+	// Groesse von Dateikopf und Blockkopf in Bytes
+	static const unsigned headerSize = 16;
+	static const unsigned blockHeaderSize = 24;
+
+	// Kompression, mit der geschrieben wird (die beste, die mit
+	// uebersetzt wurde)
+	static Compression defaultCompression();
+};
+
+// ein Block von Kandidaten, spaltenweise
+class fp13CandidateBlock
+{
+public:
+	// so viele Kandidaten hat ein Block hoechstens
+	static const size_t maxSize = 1 << 16;
+
+	fp13CandidateBlock();
+
+	// Anzahl der Kandidaten
+	size_t size() const;
+	bool empty() const;
+	// ist der Block voll? (dann sollte er geschrieben werden)
+	bool full() const;
+	// Leeren des Blocks
+	void clear();
+
+	// Anhaengen eines Kandidaten aus dem Ereignis event; flags wird
+	// erst am Ende des Ereignisses mit finishEvent gesetzt
+	void add(uint64_t event, int layer, int delay, int type)
+	{
+		events.push_back(event);
+		layers.push_back(static_cast<uint8_t>(layer));
+		delays.push_back(delay);
+		types.push_back(static_cast<uint8_t>(type));
+	}
+	// Setzen der eventFlags fuer alle Kandidaten seit dem letzten
+	// Aufruf
+	void finishEvent(int eventFlags)
+	{
+		flags.resize(events.size(), static_cast<uint8_t>(eventFlags));
+	}
+
+	// Spalten (gueltig bis zum naechsten add oder clear)
+	const uint64_t* getEvents() const
+	{ return events.data(); }
+	const uint8_t* getLayers() const
+	{ return layers.data(); }
+	const int32_t* getDelays() const
+	{ return delays.data(); }
+	const uint8_t* getTypes() const
+	{ return types.data(); }
+	const uint8_t* getFlags() const
+	{ return flags.data(); }
+
+	// Kodieren als Block (mit Blockkopf) nach out
+	void encode(vector<unsigned char>& out,
+			fp13CandidateFormat::Compression compression) const;
+	// Dekodieren des Blocks [begin, end) (mit Blockkopf)
+	// gibt false zurueck, falls er fehlerhaft ist oder mit einer
+	// Kompression gepackt ist, die nicht mit uebersetzt wurde
+	bool decode(const unsigned char* begin, const unsigned char* end);
+
+private:
+	vector<uint64_t> events;
+	vector<uint8_t> layers;
+	vector<int32_t> delays;
+	vector<uint8_t> types;
+	vector<uint8_t> flags;
+	// Puffer fuer die ungepackten Spalten
+	mutable vector<unsigned char> raw;
+};
+
+// Schreiben einer Tabelle von Kandidaten
+class fp13CandidateWriter
+{
+public:
+	// legt die Datei fileName an und schreibt den Dateikopf;
+	// isOpen() gibt Auskunft, ob das geklappt hat
+	fp13CandidateWriter(const string& fileName, int nLayers);
+	~fp13CandidateWriter();
+
+	bool isOpen() const;
+	const string& getFileName() const;
+
+	// Schreiben eines Blocks; kann aus mehreren Threads gleichzeitig
+	// aufgerufen werden (gepackt wird im aufrufenden Thread)
+	void write(const fp13CandidateBlock& block);
+
+	// Anzahl der geschriebenen Kandidaten
+	unsigned long long getNoOfCandidates() const;
+
+private:
+	string fileName;
+	ofstream out;
+	fp13CandidateFormat::Compression compression;
+	unsigned long long nCandidates;
+	mutex writeMutex;
+
+	// nicht kopierbar
+	fp13CandidateWriter(const fp13CandidateWriter&);
+	fp13CandidateWriter& operator=(const fp13CandidateWriter&);
+};
+
+// Lesen einer Tabelle von Kandidaten
+//
+// Die Datei wird eingeblendet und beim Oeffnen einmal ueberflogen, um die
+// Bloecke zu finden; readBlock kann danach aus mehreren Threads
+// gleichzeitig aufgerufen werden, z.B. fuer ungebinnte Fits:
+//
+// 	fp13CandidateReader reader("fp13.cand");
+// 	fp13CandidateBlock block;
+// 	for (size_t i = 0; i < reader.getNoOfBlocks(); ++i) {
+// 		reader.readBlock(i, block);
+// 		for (size_t j = 0; j < block.size(); ++j)
+// 			if (block.getTypes()[j] == fp13CandidateFormat::DecayUp)
+// 				h->Fill(block.getDelays()[j]);
+// 	}
+class fp13CandidateReader
+{
+public:
+	// oeffnet die Datei fileName; isOpen() gibt Auskunft, ob das
+	// geklappt hat (sonst gibt es eine Fehlermeldung)
+	fp13CandidateReader(const string& fileName);
+	~fp13CandidateReader();
+
+	bool isOpen() const;
+	// Anzahl der Detektorlagen aus dem Dateikopf
+	int getNoOfLayers() const;
+	// Anzahl der Bloecke und Kandidaten
+	size_t getNoOfBlocks() const;
+	unsigned long long getNoOfCandidates() const;
+
+	// Lesen von Block i nach block
+	// gibt false zurueck, falls er fehlerhaft ist
+	bool readBlock(size_t i, fp13CandidateBlock& block) const;
+
+private:
+	string fileName;
+	fp13MappedFile* file;
+	int nLayers;
+	// Anfang und Ende jedes Blocks in der Datei
+	vector<const unsigned char*> blockBegin, blockEnd;
+	unsigned long long nCandidates;
+
+	// nicht kopierbar
+	fp13CandidateReader(const fp13CandidateReader&);
+	fp13CandidateReader& operator=(const fp13CandidateReader&);
+};
+
+#endif
+
+// Dateiende
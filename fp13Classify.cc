@@ -0,0 +1,275 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Klassifizieren aller Zeitbins eines Pakets (s. fp13Classify.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Classify.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// die Vektorvarianten gibt es nur fuer x86 mit gcc oder clang, die
+// einzelne Funktionen fuer andere Befehlssaetze uebersetzen koennen
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FP13_HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////
+// fp13MaskTable
+////////////////////////////////////////////////////////////////////////
+// alle Tabellen werden beim Uebersetzen ausgerechnet
+static constexpr fp13MaskTable maskTables[8] = {
+	fp13MaskTable(1), fp13MaskTable(2), fp13MaskTable(3),
+	fp13MaskTable(4), fp13MaskTable(5), fp13MaskTable(6),
+	fp13MaskTable(7), fp13MaskTable(8)
+};
+static_assert(5 == maskTables[5].lastMuonLayer[63] &&
+		-1 == maskTables[5].lastMuonLayer[1] &&
+		(1 << 2) == maskTables[5].upLayer[7] &&
+		31 == maskTables[5].afterpulseLayers[63],
+		"fp13MaskTable stimmt nicht mit fp13Analysis ueberein");
+
+const fp13MaskTable& fp13MaskTable::get(int nLayers)
+{ return maskTables[nLayers - 1]; }
+
+////////////////////////////////////////////////////////////////////////
+// Varianten des Kernels
+////////////////////////////////////////////////////////////////////////
+// ein Zeitbin: Verzoegerung (mit Ueberlauf wie bei den Vektorbefehlen),
+// Schnitt auf minDelay, Zerfall nach oben und Nachpulse
+static inline void classifyBin(size_t i, int minDelay,
+		const uint8_t* masks, const int32_t* times,
+		const int32_t* refTimes, const uint8_t* upLayer,
+		const uint8_t* afterpulseLayers, int32_t* delay,
+		uint8_t* decayUp, uint8_t* afterpulses)
+{
+	const int32_t d = static_cast<int32_t>(
+			static_cast<uint32_t>(times[i]) -
+			static_cast<uint32_t>(refTimes[i]));
+	const bool pass = d >= minDelay;
+	delay[i] = d;
+	decayUp[i] = (pass && (masks[i] & upLayer[i])) ? 1 : 0;
+	afterpulses[i] = pass ? (masks[i] & afterpulseLayers[i]) : 0;
+}
+
+static void classifyScalar(size_t n, int minDelay,
+		const uint8_t* masks, const int32_t* times,
+		const int32_t* refTimes, const uint8_t* upLayer,
+		const uint8_t* afterpulseLayers, int32_t* delay,
+		uint8_t* decayUp, uint8_t* afterpulses)
+{
+	for (size_t i = 0; i < n; ++i)
+		classifyBin(i, minDelay, masks, times, refTimes, upLayer,
+				afterpulseLayers, delay, decayUp, afterpulses);
+}
+
+#ifdef FP13_HAVE_X86_KERNELS
+// 16 Zeitbins auf einmal mit SSE2
+__attribute__((target("sse2")))
+static void classifySSE2(size_t n, int minDelay,
+		const uint8_t* masks, const int32_t* times,
+		const int32_t* refTimes, const uint8_t* upLayer,
+		const uint8_t* afterpulseLayers, int32_t* delay,
+		uint8_t* decayUp, uint8_t* afterpulses)
+{
+	const __m128i threshold = _mm_set1_epi32(minDelay - 1);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		// Verzoegerungen und Schnitt, je 4 Zeitbins
+		__m128i pass[4];
+		for (int k = 0; k < 4; ++k) {
+			const __m128i t = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(
+					times + i + 4 * k));
+			const __m128i r = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(
+					refTimes + i + 4 * k));
+			const __m128i d = _mm_sub_epi32(t, r);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(
+						delay + i + 4 * k), d);
+			pass[k] = _mm_cmpgt_epi32(d, threshold);
+		}
+		// Ergebnis des Schnitts auf Bytes zusammenschieben (0 oder
+		// 0xff pro Zeitbin, Saettigung erhaelt beides)
+		const __m128i p = _mm_packs_epi16(
+				_mm_packs_epi32(pass[0], pass[1]),
+				_mm_packs_epi32(pass[2], pass[3]));
+
+		const __m128i m = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(masks + i));
+		const __m128i up = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(upLayer + i));
+		const __m128i ap = _mm_loadu_si128(
+				reinterpret_cast<const __m128i*>(
+					afterpulseLayers + i));
+		// Zerfall nach oben: Lage getroffen und Schnitt bestanden
+		const __m128i hitUp = _mm_andnot_si128(
+				_mm_cmpeq_epi8(_mm_and_si128(m, up), zero), p);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(decayUp + i),
+				_mm_and_si128(hitUp, one));
+		// Nachpulse: getroffene Lagen, falls Schnitt bestanden
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(afterpulses + i),
+				_mm_and_si128(_mm_and_si128(m, ap), p));
+	}
+	for (; i < n; ++i)
+		classifyBin(i, minDelay, masks, times, refTimes, upLayer,
+				afterpulseLayers, delay, decayUp, afterpulses);
+}
+
+// 32 Zeitbins auf einmal mit AVX2
+__attribute__((target("avx2")))
+static void classifyAVX2(size_t n, int minDelay,
+		const uint8_t* masks, const int32_t* times,
+		const int32_t* refTimes, const uint8_t* upLayer,
+		const uint8_t* afterpulseLayers, int32_t* delay,
+		uint8_t* decayUp, uint8_t* afterpulses)
+{
+	const __m256i threshold = _mm256_set1_epi32(minDelay - 1);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i one = _mm256_set1_epi8(1);
+	// packs arbeitet in den beiden 128-Bit-Haelften getrennt, danach
+	// stehen die Gruppen von 4 Zeitbins in der Reihenfolge
+	// 0 2 4 6 1 3 5 7 und muessen umsortiert werden
+	const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	size_t i = 0;
+	for (; i + 32 <= n; i += 32) {
+		// Verzoegerungen und Schnitt, je 8 Zeitbins
+		__m256i pass[4];
+		for (int k = 0; k < 4; ++k) {
+			const __m256i t = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(
+					times + i + 8 * k));
+			const __m256i r = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(
+					refTimes + i + 8 * k));
+			const __m256i d = _mm256_sub_epi32(t, r);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(
+						delay + i + 8 * k), d);
+			pass[k] = _mm256_cmpgt_epi32(d, threshold);
+		}
+		const __m256i p = _mm256_permutevar8x32_epi32(
+				_mm256_packs_epi16(
+					_mm256_packs_epi32(pass[0], pass[1]),
+					_mm256_packs_epi32(pass[2], pass[3])),
+				order);
+
+		const __m256i m = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(masks + i));
+		const __m256i up = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(upLayer + i));
+		const __m256i ap = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(
+					afterpulseLayers + i));
+		const __m256i hitUp = _mm256_andnot_si256(
+				_mm256_cmpeq_epi8(_mm256_and_si256(m, up), zero),
+				p);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(decayUp + i),
+				_mm256_and_si256(hitUp, one));
+		_mm256_storeu_si256(
+				reinterpret_cast<__m256i*>(afterpulses + i),
+				_mm256_and_si256(_mm256_and_si256(m, ap), p));
+	}
+	for (; i < n; ++i)
+		classifyBin(i, minDelay, masks, times, refTimes, upLayer,
+				afterpulseLayers, delay, decayUp, afterpulses);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////
+// Auswahl der Variante
+////////////////////////////////////////////////////////////////////////
+struct fp13KernelChoice
+{
+	fp13Classifier::Kernel kernel;
+	const char* name;
+};
+
+static fp13KernelChoice chooseKernel()
+{
+	fp13KernelChoice choice = { classifyScalar, "scalar" };
+	const char* wanted = getenv("FP13_SIMD");
+#ifdef FP13_HAVE_X86_KERNELS
+	__builtin_cpu_init();
+	if ((!wanted || !strcmp(wanted, "avx2")) &&
+			__builtin_cpu_supports("avx2")) {
+		choice.kernel = classifyAVX2;
+		choice.name = "avx2";
+	} else if ((!wanted || !strcmp(wanted, "avx2") ||
+				!strcmp(wanted, "sse2")) &&
+			__builtin_cpu_supports("sse2")) {
+		choice.kernel = classifySSE2;
+		choice.name = "sse2";
+	}
+#else
+	(void) wanted;
+#endif
+	return choice;
+}
+
+// die Auswahl passiert genau einmal, auch wenn mehrere Threads
+// gleichzeitig anfangen
+static const fp13KernelChoice& kernelChoice()
+{
+	static const fp13KernelChoice choice = chooseKernel();
+	return choice;
+}
+
+const char* fp13Classifier::getKernelName()
+{ return kernelChoice().name; }
+
+////////////////////////////////////////////////////////////////////////
+// fp13Classifier
+////////////////////////////////////////////////////////////////////////
+fp13Classifier::fp13Classifier(int layers, int delay) :
+	nLayers(layers), minDelay(delay), table(fp13MaskTable::get(layers))
+{ }
+
+void fp13Classifier::classify(const fp13EventBatch& batch)
+{
+	const size_t nEvents = batch.size();
+	const size_t nBins = batch.getNoOfBins();
+	const uint8_t* masks = batch.getMasks();
+	const uint32_t* offsets = batch.getOffsets();
+
+	arena.reset();
+	lastMuonLayer = arena.allocate<int8_t>(nEvents);
+	refTimes = arena.allocate<int32_t>(nBins);
+	upLayer = arena.allocate<uint8_t>(nBins);
+	afterpulseLayers = arena.allocate<uint8_t>(nBins);
+	delay = arena.allocate<int32_t>(nBins);
+	decayUp = arena.allocate<uint8_t>(nBins);
+	afterpulses = arena.allocate<uint8_t>(nBins);
+
+	// pro Ereignis: letzte Lage des Myons und daraus die Lagen, in
+	// denen Zerfaelle nach oben bzw. Nachpulse gesucht werden, fuer
+	// alle Zeitbins des Ereignisses eintragen
+	const int32_t* times = batch.getTimes();
+	for (size_t e = 0; e < nEvents; ++e) {
+		const uint32_t begin = offsets[e], end = offsets[e + 1];
+		if (begin == end) {
+			lastMuonLayer[e] = -1;
+			continue;
+		}
+		const uint8_t first = masks[begin];
+		lastMuonLayer[e] = table.lastMuonLayer[first];
+		const uint8_t up = table.upLayer[first];
+		const uint8_t ap = table.afterpulseLayers[first];
+		// das erste Zeitbin selbst wird nicht untersucht
+		refTimes[begin] = times[begin];
+		upLayer[begin] = afterpulseLayers[begin] = 0;
+		for (uint32_t i = begin + 1; i < end; ++i) {
+			refTimes[i] = times[begin];
+			upLayer[i] = up;
+			afterpulseLayers[i] = ap;
+		}
+	}
+
+	// pro Zeitbin mit Vektorbefehlen
+	kernelChoice().kernel(nBins, minDelay, masks, times, refTimes,
+			upLayer, afterpulseLayers, delay, decayUp, afterpulses);
+}
+
+// Dateiende
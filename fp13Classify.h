@@ -0,0 +1,166 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Klassifizieren aller Zeitbins eines Pakets von Ereignissen auf einmal
+//
+// fp13Analysis::analyze ruft fuer jedes Zeitbin die virtuellen Methoden
+// findDecayUpward, findAfterpulsesUsingThroughGoingMuons usw. auf, die
+// jeweils die Detektorlagen einzeln durchgehen. Fuer die Standardanalyse
+// (ohne abgeleitete Klasse) rechnet fp13Classifier dasselbe fuer alle
+// Zeitbins eines fp13EventBatch in einem Durchgang aus:
+//
+//  - pro Ereignis die letzte Lage des einlaufenden Myons (lastMuonLayer,
+//    wie determineLastLayerHitByIncomingMuon, aus fp13MaskTable)
+//  - pro Zeitbin die Verzoegerung zum ersten Zeitbin, den Schnitt auf
+//    minDelay, ob ein Zerfall nach oben gefunden wird (wie
+//    findDecayUpward) und die Lagen mit Nachpulsen (als Bitmaske, wie
+//    findAfterpulsesUsingThroughGoingMuons)
+//
+// Zerfaelle nach unten und die verbesserte Nachpulsanalyse finden in
+// der Standardanalyse nichts (die Methoden sollen die Studenten selbst
+// schreiben); wer sie implementiert, leitet ab und bekommt damit
+// automatisch wieder die Analyse Zeitbin fuer Zeitbin.
+//
+// Der Teil pro Zeitbin laeuft mit Vektorbefehlen ueber viele Zeitbins
+// gleichzeitig: mit AVX2 32, mit SSE2 16 Zeitbins auf einmal. Welche
+// Variante benutzt wird, wird beim ersten Aufruf anhand des Prozessors
+// entschieden; mit der Umgebungsvariable FP13_SIMD (avx2, sse2 oder
+// scalar) kann man eine bestimmte Variante erzwingen, z.B. um die
+// Ergebnisse zu vergleichen. Alle Varianten liefern exakt dasselbe.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13CLASSIFY_H
+#define FP13CLASSIFY_H
+
+// C++ headers
+#include <cstddef>
+// C headers (fuer uint8_t, int8_t, int32_t)
+#include <stdint.h>
+
+#include "fp13Arena.h"
+#include "fp13EventQueue.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+// Ergebnisse, die nur vom Hitmuster des ersten Zeitbins abhaengen
+//
+// Mit hoechstens 8 Lagen gibt es nur 256 Hitmuster, die Ergebnisse von
+// determineLastLayerHitByIncomingMuon und die Lagen, in denen
+// findDecayUpward und findAfterpulsesUsingThroughGoingMuons suchen,
+// stehen daher schon beim Uebersetzen fest (constexpr). Dazu kommen die
+// unterste und oberste Lage jedes Hitmusters, mit denen man die
+// getroffenen Lagen durchgehen kann, ohne jede Lage einzeln zu testen.
+struct fp13MaskTable
+{
+	// letzte vom Myon durchlaufene Lage, -1 falls keine
+	int8_t lastMuonLayer[256];
+	// Lage (als Bitmaske), in der ein Zerfall nach oben gesucht wird
+	uint8_t upLayer[256];
+	// Lagen (als Bitmaske), in denen Nachpulse gesucht werden
+	uint8_t afterpulseLayers[256];
+	// niedrigste und hoechste getroffene Lage, -1 falls keine
+	int8_t lowestLayer[256];
+	int8_t highestLayer[256];
+
+	constexpr fp13MaskTable(int nLayers) :
+		lastMuonLayer(), upLayer(), afterpulseLayers(),
+		lowestLayer(), highestLayer()
+	{
+		for (int m = 0; m < 256; ++m) {
+			// wie determineLastLayerHitByIncomingMuon
+			int last = -1;
+			for (int iLayer = nLayers - 1; iLayer >= 1; --iLayer) {
+				if (m == ((1 << (iLayer + 1)) - 1)) {
+					last = iLayer;
+					break;
+				}
+			}
+			lastMuonLayer[m] = last;
+			// wie findDecayUpward bzw.
+			// findAfterpulsesUsingThroughGoingMuons
+			upLayer[m] = (-1 != last && nLayers - 1 != last) ?
+				(1 << last) : 0;
+			afterpulseLayers[m] = (nLayers - 1 == last) ?
+				((1 << (nLayers - 1)) - 1) : 0;
+			lowestLayer[m] = highestLayer[m] = -1;
+			for (int iLayer = 0; iLayer < 8; ++iLayer) {
+				if (!(m & (1 << iLayer)))
+					continue;
+				if (-1 == lowestLayer[m])
+					lowestLayer[m] = iLayer;
+				highestLayer[m] = iLayer;
+			}
+		}
+	}
+
+	// Tabelle fuer nLayers Lagen (1 bis 8)
+	static const fp13MaskTable& get(int nLayers);
+};
+
+class fp13Classifier
+{
+public:
+	// Detektor mit nLayers Lagen (hoechstens 8), Zeitbins mit einer
+	// Verzoegerung unter minDelay werden nicht beruecksichtigt
+	fp13Classifier(int nLayers, int minDelay);
+
+	// Klassifizieren aller Zeitbins von batch; die Ergebnisse gelten
+	// bis zum naechsten Aufruf
+	void classify(const fp13EventBatch& batch);
+
+	// Ergebnisse pro Ereignis: letzte vom Myon durchlaufene Lage (-1,
+	// falls kein Myon)
+	const int8_t* getLastMuonLayer() const
+	{ return lastMuonLayer; }
+	// Ergebnisse pro Zeitbin (wie in fp13EventBatch durchnumeriert):
+	// Verzoegerung zum ersten Zeitbin des Ereignisses
+	const int32_t* getDelay() const
+	{ return delay; }
+	// 1, falls ein Zerfall nach oben (in Lage lastMuonLayer) gefunden
+	// wurde, sonst 0
+	const uint8_t* getDecayUp() const
+	{ return decayUp; }
+	// Bitmaske der Lagen mit Nachpulsen aus durchgehenden Myonen
+	const uint8_t* getAfterpulses() const
+	{ return afterpulses; }
+
+	// Name der benutzten Variante (avx2, sse2 oder scalar)
+	static const char* getKernelName();
+
+	// Variante fuer den Teil pro Zeitbin: fuer n Zeitbins wird aus
+	// Hitmuster, Zeit, Zeit des ersten Zeitbins und den Lagenmasken
+	// fuer Zerfall nach oben und Nachpulse die Verzoegerung und das
+	// Ergebnis ausgerechnet
+	typedef void (*Kernel)(size_t n, int minDelay,
+			const uint8_t* masks, const int32_t* times,
+			const int32_t* refTimes, const uint8_t* upLayer,
+			const uint8_t* afterpulseLayers, int32_t* delay,
+			uint8_t* decayUp, uint8_t* afterpulses);
+
+private:
+	int nLayers;
+	int minDelay;
+	const fp13MaskTable& table;
+
+	// Speicher fuer Zwischen- und Endergebnisse
+	fp13Arena arena;
+	// pro Ereignis
+	int8_t* lastMuonLayer;
+	// pro Zeitbin: Eingaben fuer den Kernel...
+	int32_t* refTimes;
+	uint8_t* upLayer;
+	uint8_t* afterpulseLayers;
+	// ... und Ergebnisse
+	int32_t* delay;
+	uint8_t* decayUp;
+	uint8_t* afterpulses;
+
+	// nicht kopierbar
+	fp13Classifier(const fp13Classifier&);
+	fp13Classifier& operator=(const fp13Classifier&);
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,474 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Lesen komprimierter Eingabedateien (s. fp13Compressed.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Compressed.h"
+
+#include <algorithm>
+
+#include "fp13Input.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// fp13Compression
+////////////////////////////////////////////////////////////////////////
+// Art der Kompression anhand der Kennung
+fp13Compression::Type fp13Compression::detect(const char* begin,
+		const char* end)
+{
+	const unsigned char* p = reinterpret_cast<const unsigned char*>(begin);
+	if (end - begin >= 2 && 0x1f == p[0] && 0x8b == p[1])
+		return Gzip;
+	if (end - begin >= 4 && 0x28 == p[0] && 0xb5 == p[1] &&
+			0x2f == p[2] && 0xfd == p[3])
+		return Zstd;
+	return None;
+}
+
+// bei Streams entscheidet das erste Zeichen (Textdateien beginnen mit
+// einer Ziffer, Binaerdateien mit ihrer Kennung)
+fp13Compression::Type fp13Compression::detect(int firstChar)
+{
+	switch (firstChar) {
+		case 0x1f:
+			return Gzip;
+		case 0x28:
+			return Zstd;
+		default:
+			return None;
+	}
+}
+
+const char* fp13Compression::getName(Type type)
+{
+	switch (type) {
+		case Gzip:
+			return "gzip";
+		case Zstd:
+			return "zstd";
+		default:
+			return "keiner Kompression";
+	}
+}
+
+bool fp13Compression::isSupported(Type type)
+{
+	switch (type) {
+#ifdef FP13_HAVE_ZLIB
+		case Gzip:
+			return true;
+#endif
+#ifdef FP13_HAVE_ZSTD
+		case Zstd:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+streambuf* fp13Compression::open(Type type, fp13MappedFile* file,
+		unsigned nThreads)
+{
+	switch (type) {
+#ifdef FP13_HAVE_ZLIB
+		case Gzip:
+			return new fp13GzipReader(file);
+#endif
+#ifdef FP13_HAVE_ZSTD
+		case Zstd:
+			{
+				// mehrere Frames lohnen sich parallel zu entpacken
+				vector<pair<size_t, size_t> > frames;
+				if (nThreads > 1 &&
+						fp13ZstdParallelReader::findFrames(
+							file->begin(), file->end(),
+							frames) && frames.size() > 1)
+					return new fp13ZstdParallelReader(file,
+							frames, nThreads);
+				return new fp13ZstdReader(file);
+			}
+#endif
+		default:
+			(void) nThreads;
+			delete file;
+			return 0;
+	}
+}
+
+streambuf* fp13Compression::open(Type type, istream* in)
+{
+	switch (type) {
+#ifdef FP13_HAVE_ZLIB
+		case Gzip:
+			return new fp13GzipReader(in);
+#endif
+#ifdef FP13_HAVE_ZSTD
+		case Zstd:
+			return new fp13ZstdReader(in);
+#endif
+		default:
+			delete in;
+			return 0;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13Decompressor
+////////////////////////////////////////////////////////////////////////
+fp13Decompressor::fp13Decompressor(fp13MappedFile* f) :
+	file(f), in(0), inputPos(0)
+{ }
+
+fp13Decompressor::fp13Decompressor(istream* i) :
+	file(0), in(i), inputPos(0), inBuf(inputSize)
+{ }
+
+fp13Decompressor::~fp13Decompressor()
+{
+	// abgeleitete Klassen haben den Thread schon angehalten
+	delete file;
+	delete in;
+}
+
+// Anhalten des Threads
+void fp13Decompressor::stop()
+{
+	// wartet der Thread gerade auf Daten aus einem Stream, der selbst in
+	// einem eigenen Thread liest, bekommt er so das Ende der Eingabe
+	if (in) {
+		fp13AsyncReader* source =
+			dynamic_cast<fp13AsyncReader*>(in->rdbuf());
+		if (source)
+			source->stop();
+	}
+	fp13AsyncReader::stop();
+}
+
+// naechstes Stueck der komprimierten Daten
+bool fp13Decompressor::readInput(const char*& begin, size_t& size)
+{
+	if (file) {
+		// die eingeblendete Datei wird in Stuecken abgeliefert, deren
+		// Laenge auch zlib (unsigned int) noch verarbeiten kann
+		const size_t maxSize = 1 << 30;
+		const size_t offset = inputPos;
+		if (offset >= file->size())
+			return false;
+		begin = file->begin() + offset;
+		size = min(maxSize, file->size() - offset);
+		inputPos += size;
+		return true;
+	}
+
+	// aus dem Stream nehmen, was gerade da ist, aber mindestens ein
+	// Zeichen (dafuer wird, falls noetig, gewartet)
+	streambuf* buf = in->rdbuf();
+	if (streambuf::traits_type::eof() == buf->sgetc())
+		return false;
+	const streamsize avail = buf->in_avail();
+	const streamsize n = buf->sgetn(inBuf.data(),
+			min<streamsize>(max<streamsize>(avail, 1), inBuf.size()));
+	if (n <= 0)
+		return false;
+	begin = inBuf.data();
+	size = n;
+	return true;
+}
+
+#ifdef FP13_HAVE_ZLIB
+////////////////////////////////////////////////////////////////////////
+// fp13GzipReader
+////////////////////////////////////////////////////////////////////////
+fp13GzipReader::fp13GzipReader(fp13MappedFile* file) :
+	fp13Decompressor(file)
+{ init(); }
+
+fp13GzipReader::fp13GzipReader(istream* in) :
+	fp13Decompressor(in)
+{ init(); }
+
+void fp13GzipReader::init()
+{
+	z.zalloc = Z_NULL;
+	z.zfree = Z_NULL;
+	z.opaque = Z_NULL;
+	z.next_in = Z_NULL;
+	z.avail_in = 0;
+	// 15 + 32: groesstes Fenster, gzip- und zlib-Kopf erkennen
+	if (Z_OK != inflateInit2(&z, 15 + 32)) {
+		error << "Fehler beim Initialisieren von zlib." << endl;
+		throw;
+	}
+	inputEnded = false;
+	memberEnded = false;
+	start();
+}
+
+fp13GzipReader::~fp13GzipReader()
+{
+	stop();
+	inflateEnd(&z);
+}
+
+bool fp13GzipReader::fill(Buffer& buffer, bool& atEnd, string& err)
+{
+	z.next_out = reinterpret_cast<Bytef*>(buffer.data.data());
+	z.avail_out = bufferSize;
+	while (z.avail_out) {
+		if (0 == z.avail_in && !inputEnded) {
+			const char* p;
+			size_t n;
+			if (readInput(p, n)) {
+				z.next_in = reinterpret_cast<Bytef*>(
+						const_cast<char*>(p));
+				z.avail_in = n;
+			} else {
+				inputEnded = true;
+			}
+		}
+
+		const uInt inBefore = z.avail_in, outBefore = z.avail_out;
+		const int ret = inflate(&z, Z_NO_FLUSH);
+		if (Z_STREAM_END == ret) {
+			// dahinter kann ein weiterer Teil folgen (wie bei
+			// "cat a.gz b.gz")
+			memberEnded = true;
+			inflateReset(&z);
+			continue;
+		}
+		if (Z_OK != ret && Z_BUF_ERROR != ret) {
+			err = z.msg ? z.msg : "fehlerhafte gzip-Daten";
+			break;
+		}
+		if (z.avail_in != inBefore || z.avail_out != outBefore) {
+			memberEnded = false;
+		} else if (z.avail_in) {
+			err = "fehlerhafte gzip-Daten";
+			break;
+		} else if (inputEnded) {
+			if (!memberEnded)
+				err = "unvollstaendige gzip-Daten";
+			atEnd = true;
+			break;
+		}
+	}
+	buffer.size = bufferSize - z.avail_out;
+	return true;
+}
+#endif
+
+#ifdef FP13_HAVE_ZSTD
+////////////////////////////////////////////////////////////////////////
+// fp13ZstdReader
+////////////////////////////////////////////////////////////////////////
+fp13ZstdReader::fp13ZstdReader(fp13MappedFile* file) :
+	fp13Decompressor(file)
+{ init(); }
+
+fp13ZstdReader::fp13ZstdReader(istream* in) :
+	fp13Decompressor(in)
+{ init(); }
+
+void fp13ZstdReader::init()
+{
+	stream = ZSTD_createDStream();
+	if (!stream || ZSTD_isError(ZSTD_initDStream(stream))) {
+		error << "Fehler beim Initialisieren von zstd." << endl;
+		throw;
+	}
+	input.src = 0;
+	input.size = input.pos = 0;
+	inputEnded = false;
+	frameEnded = false;
+	start();
+}
+
+fp13ZstdReader::~fp13ZstdReader()
+{
+	stop();
+	ZSTD_freeDStream(stream);
+}
+
+bool fp13ZstdReader::fill(Buffer& buffer, bool& atEnd, string& err)
+{
+	ZSTD_outBuffer output = { buffer.data.data(), bufferSize, 0 };
+	while (output.pos < output.size) {
+		if (input.pos == input.size && !inputEnded) {
+			const char* p;
+			size_t n;
+			if (readInput(p, n)) {
+				input.src = p;
+				input.size = n;
+				input.pos = 0;
+			} else {
+				inputEnded = true;
+			}
+		}
+
+		// aufeinanderfolgende Frames entpackt ZSTD_decompressStream
+		// von selbst hintereinander
+		const size_t inBefore = input.pos, outBefore = output.pos;
+		const size_t ret = ZSTD_decompressStream(stream, &output, &input);
+		if (ZSTD_isError(ret)) {
+			err = ZSTD_getErrorName(ret);
+			break;
+		}
+		if (input.pos != inBefore || output.pos != outBefore) {
+			frameEnded = (0 == ret);
+		} else if (input.pos != input.size) {
+			err = "fehlerhafte zstd-Daten";
+			break;
+		} else if (inputEnded) {
+			if (!frameEnded)
+				err = "unvollstaendige zstd-Daten";
+			atEnd = true;
+			break;
+		}
+	}
+	buffer.size = output.pos;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13ZstdParallelReader
+////////////////////////////////////////////////////////////////////////
+// Anfang und Laenge jedes Frames
+bool fp13ZstdParallelReader::findFrames(const char* begin, const char* end,
+		vector<pair<size_t, size_t> >& frames)
+{
+	frames.clear();
+	for (size_t offset = 0; begin + offset != end; ) {
+		const char* p = begin + offset;
+		const size_t size = ZSTD_findFrameCompressedSize(p, end - p);
+		if (ZSTD_isError(size))
+			return false;
+		// die entpackte Laenge muss im Kopf stehen (das schreibt zstd
+		// immer, ausser beim Komprimieren aus einem Stream) und darf
+		// nicht zu gross sein, damit der Speicherbedarf begrenzt bleibt
+		const unsigned long long contentSize =
+			ZSTD_getFrameContentSize(p, size);
+		if (ZSTD_CONTENTSIZE_UNKNOWN == contentSize ||
+				ZSTD_CONTENTSIZE_ERROR == contentSize ||
+				contentSize > maxFrameSize)
+			return false;
+		frames.push_back(make_pair(offset, size));
+		offset += size;
+	}
+	return true;
+}
+
+fp13ZstdParallelReader::fp13ZstdParallelReader(fp13MappedFile* f,
+		const vector<pair<size_t, size_t> >& fr, unsigned nThreads) :
+	file(f), frames(fr), slots(2 * nThreads), nextToDecompress(0),
+	current(0), haveCurrent(false), stopping(false)
+{
+	for (unsigned i = 0; i < slots.size(); ++i) {
+		slots[i].index = static_cast<size_t>(-1);
+		slots[i].done = false;
+	}
+	for (unsigned i = 0; i < nThreads; ++i)
+		threads.push_back(thread(&fp13ZstdParallelReader::worker, this));
+}
+
+fp13ZstdParallelReader::~fp13ZstdParallelReader()
+{
+	// Threads anhalten und warten, bis alle fertig sind
+	{
+		unique_lock<mutex> guard(slotMutex);
+		stopping = true;
+	}
+	slotChanged.notify_all();
+	for (unsigned i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	delete file;
+}
+
+// Entpacken des Frames index
+void fp13ZstdParallelReader::decompressFrame(ZSTD_DCtx* ctx, size_t index,
+		Slot& slot) const
+{
+	const char* src = file->begin() + frames[index].first;
+	const size_t srcSize = frames[index].second;
+	// die Laenge ist bekannt (s. findFrames); Frames, die nur Metadaten
+	// enthalten (skippable frames), haben die Laenge 0
+	slot.err.clear();
+	slot.data.resize(ZSTD_getFrameContentSize(src, srcSize));
+	const size_t ret = ZSTD_decompressDCtx(ctx, slot.data.data(),
+			slot.data.size(), src, srcSize);
+	if (ZSTD_isError(ret))
+		slot.err = ZSTD_getErrorName(ret);
+	else
+		slot.data.resize(ret);
+}
+
+// Hauptschleife der Threads: naechsten Frame holen und entpacken
+void fp13ZstdParallelReader::worker()
+{
+	ZSTD_DCtx* ctx = ZSTD_createDCtx();
+	unique_lock<mutex> guard(slotMutex);
+	for (;;) {
+		// warten, bis ein Puffer frei wird
+		while (!stopping && nextToDecompress < frames.size() &&
+				nextToDecompress >= current + slots.size())
+			slotChanged.wait(guard);
+		if (stopping || nextToDecompress >= frames.size())
+			break;
+		const size_t index = nextToDecompress++;
+		Slot& slot = slots[index % slots.size()];
+
+		// das Entpacken selbst passiert ohne Lock
+		guard.unlock();
+		decompressFrame(ctx, index, slot);
+		guard.lock();
+
+		slot.index = index;
+		slot.done = true;
+		slotChanged.notify_all();
+	}
+	guard.unlock();
+	ZSTD_freeDCtx(ctx);
+}
+
+// naechsten entpackten Frame holen
+fp13ZstdParallelReader::int_type fp13ZstdParallelReader::underflow()
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	unique_lock<mutex> guard(slotMutex);
+	for (;;) {
+		// abgearbeiteten Frame freigeben
+		if (haveCurrent) {
+			++current;
+			haveCurrent = false;
+			slotChanged.notify_all();
+		}
+		if (current >= frames.size()) {
+			setg(0, 0, 0);
+			return traits_type::eof();
+		}
+
+		// warten, bis der Frame entpackt ist
+		Slot& slot = slots[current % slots.size()];
+		while (!(slot.done && current == slot.index))
+			slotChanged.wait(guard);
+		haveCurrent = true;
+		if (!slot.err.empty()) {
+			error << "Fehler beim Entpacken der Eingabe: " <<
+				slot.err << "." << endl;
+			throw;
+		}
+		if (!slot.data.empty()) {
+			char* data = slot.data.data();
+			setg(data, data, data + slot.data.size());
+			return traits_type::to_int_type(*gptr());
+		}
+	}
+}
+#endif
+
+// Dateiende
@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Lesen komprimierter Eingabedateien (gzip, zstd)
+//
+// Die archivierten Messungen liegen komprimiert vor. Statt sie mit zcat
+// durch eine Pipe zu schicken, erkennt fp13Input::open komprimierte
+// Daten an ihrer Kennung (magic bytes) und entpackt sie selbst:
+//
+//  - fp13GzipReader und fp13ZstdReader sind fp13AsyncReader, die die
+//    Puffer in einem eigenen Thread mit den entpackten Daten fuellen;
+//    der analysierende Thread liest sie wie stdin ueber einen
+//    fp13IStream. Gelesen wird entweder aus einer eingeblendeten Datei
+//    oder aus einem anderen Stream (stdin, named pipe).
+//  - Eine eingeblendete zstd-Datei aus mehreren unabhaengigen Frames
+//    (z.B. von pzstd oder durch Aneinanderhaengen mehrerer .zst-Dateien)
+//    entpackt fp13ZstdParallelReader mit mehreren Threads gleichzeitig
+//    und liefert die Frames in der Reihenfolge der Datei ab.
+//
+// Die entpackten Daten koennen Text oder das Binaerformat sein. Springen
+// (fp13Input::seek) ist in komprimierten Daten nicht moeglich.
+//
+// Unkomprimierte Dateien sind davon nicht betroffen: sie werden wie
+// bisher eingeblendet, es werden nur die ersten vier Bytes angesehen.
+//
+// gzip wird nur unterstuetzt, wenn mit FP13_HAVE_ZLIB uebersetzt wurde,
+// zstd nur mit FP13_HAVE_ZSTD (das Makefile setzt beides, falls die
+// Bibliotheken gefunden werden).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13COMPRESSED_H
+#define FP13COMPRESSED_H
+
+// C++ headers
+#include <iostream>
+#include <streambuf>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Bibliotheken zum Entpacken
+#ifdef FP13_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef FP13_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "fp13AsyncReader.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13MappedFile;
+
+// Erkennen und Oeffnen komprimierter Daten
+class fp13Compression
+{
+public:
+	enum Type { None, Gzip, Zstd };
+
+	// Art der Kompression der Daten [begin, end) anhand der Kennung
+	static Type detect(const char* begin, const char* end);
+	// dasselbe fuer Streams, bei denen man nur das erste Zeichen
+	// ansehen kann (Ergebnis von istream::peek)
+	static Type detect(int firstChar);
+
+	// Name der Kompression fuer Meldungen
+	static const char* getName(Type type);
+	// wurde die Unterstuetzung fuer type mit uebersetzt?
+	static bool isSupported(Type type);
+
+	// streambuf mit den entpackten Daten der eingeblendeten Datei
+	// file, die dabei in seinen Besitz uebergeht; zstd-Dateien aus
+	// mehreren Frames werden mit nThreads Threads entpackt
+	static streambuf* open(Type type, fp13MappedFile* file,
+			unsigned nThreads);
+	// streambuf mit den entpackten Daten aus dem Stream in, der dabei
+	// in seinen Besitz uebergeht
+	static streambuf* open(Type type, istream* in);
+};
+
+// Basisklasse fuer das Entpacken in einem eigenen Thread
+class fp13Decompressor : public fp13AsyncReader
+{
+public:
+	virtual ~fp13Decompressor();
+
+	// haelt auch einen Stream an, aus dem gerade gelesen wird
+	virtual void stop();
+
+	// Groesse der Stuecke, die aus einem Stream gelesen werden
+	static const size_t inputSize = 1 << 18;
+
+protected:
+	// Daten aus der eingeblendeten Datei file bzw. dem Stream in, die
+	// dabei in den Besitz des fp13Decompressor uebergehen
+	fp13Decompressor(fp13MappedFile* file);
+	fp13Decompressor(istream* in);
+
+	// naechstes Stueck der komprimierten Daten nach [begin, begin+size)
+	// gibt false am Ende der Daten zurueck
+	bool readInput(const char*& begin, size_t& size);
+
+	fp13MappedFile* file;
+	istream* in;
+	// so weit ist die eingeblendete Datei schon abgeliefert
+	size_t inputPos;
+	vector<char> inBuf;
+};
+
+#ifdef FP13_HAVE_ZLIB
+// Entpacken von gzip-Daten (auch mehrere aneinandergehaengte Teile)
+class fp13GzipReader : public fp13Decompressor
+{
+public:
+	fp13GzipReader(fp13MappedFile* file);
+	fp13GzipReader(istream* in);
+	virtual ~fp13GzipReader();
+
+protected:
+	void init();
+	virtual bool fill(Buffer& buffer, bool& atEnd, string& err);
+
+	z_stream z;
+	// Ende der Eingabe erreicht
+	bool inputEnded;
+	// der letzte Teil ist vollstaendig entpackt
+	bool memberEnded;
+};
+#endif
+
+#ifdef FP13_HAVE_ZSTD
+// Entpacken von zstd-Daten in einem Thread
+class fp13ZstdReader : public fp13Decompressor
+{
+public:
+	fp13ZstdReader(fp13MappedFile* file);
+	fp13ZstdReader(istream* in);
+	virtual ~fp13ZstdReader();
+
+protected:
+	void init();
+	virtual bool fill(Buffer& buffer, bool& atEnd, string& err);
+
+	ZSTD_DStream* stream;
+	ZSTD_inBuffer input;
+	bool inputEnded;
+	// der letzte Frame ist vollstaendig entpackt
+	bool frameEnded;
+};
+
+// Entpacken einer eingeblendeten zstd-Datei aus mehreren Frames mit
+// mehreren Threads
+class fp13ZstdParallelReader : public streambuf
+{
+public:
+	// Anfang und Laenge jedes Frames der Daten [begin, end)
+	// gibt false zurueck, falls die Daten nicht aus gueltigen Frames
+	// bestehen
+	static bool findFrames(const char* begin, const char* end,
+			vector<pair<size_t, size_t> >& frames);
+
+	// entpackt die Frames frames der Datei file, die dabei in den
+	// Besitz des fp13ZstdParallelReader uebergeht, mit nThreads Threads
+	fp13ZstdParallelReader(fp13MappedFile* file,
+			const vector<pair<size_t, size_t> >& frames,
+			unsigned nThreads);
+	virtual ~fp13ZstdParallelReader();
+
+	// groesste entpackte Laenge eines Frames, die parallel entpackt wird
+	static const unsigned long long maxFrameSize = 256ULL << 20;
+
+protected:
+	// ein entpackter Frame
+	struct Slot {
+		// Nummer des Frames, der in diesem Puffer liegt
+		size_t index;
+		// fertig entpackt?
+		bool done;
+		vector<char> data;
+		// Fehlermeldung, falls das Entpacken nicht geklappt hat
+		string err;
+	};
+
+	// naechsten entpackten Frame holen (wird von istream aufgerufen)
+	virtual int_type underflow();
+
+	// Entpacken des Frames index in slot
+	void decompressFrame(ZSTD_DCtx* ctx, size_t index, Slot& slot) const;
+	// Hauptschleife der Threads
+	void worker();
+
+	fp13MappedFile* file;
+	vector<pair<size_t, size_t> > frames;
+	// Puffer fuer die Frames in Arbeit; Frame i liegt in
+	// slots[i % slots.size()]
+	vector<Slot> slots;
+	// naechster zu entpackender Frame
+	size_t nextToDecompress;
+	// Frame, aus dem gerade gelesen wird
+	size_t current;
+	bool haveCurrent;
+	// Threads werden beendet
+	bool stopping;
+
+	vector<thread> threads;
+	mutex slotMutex;
+	condition_variable slotChanged;
+
+private:
+	// nicht kopierbar
+	fp13ZstdParallelReader(const fp13ZstdParallelReader&);
+	fp13ZstdParallelReader& operator=(const fp13ZstdParallelReader&);
+};
+#endif
+
+#endif
+
+// Dateiende
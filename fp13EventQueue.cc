@@ -0,0 +1,215 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Pakete von Ereignissen und Warteschlange (s. fp13EventQueue.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13EventQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+////////////////////////////////////////////////////////////////////////
+// fp13BasicEventBatch
+////////////////////////////////////////////////////////////////////////
+template <class Mask>
+fp13BasicEventBatch<Mask>::fp13BasicEventBatch() :
+	masks(0), times(0), offsets(0), nEvents(0), nBins(0), firstEvent(0),
+	eventCapacity(0), binCapacity(0)
+{ clear(); }
+
+template <class Mask>
+size_t fp13BasicEventBatch<Mask>::size() const
+{ return nEvents; }
+
+template <class Mask>
+size_t fp13BasicEventBatch<Mask>::getNoOfBins() const
+{ return nBins; }
+
+template <class Mask>
+void fp13BasicEventBatch<Mask>::clear()
+{
+	// fuer die naechsten Ereignisse gleich wieder so viel Platz wie
+	// bisher anlegen, das braucht nach dem reset keinen neuen Speicher
+	const size_t events = eventCapacity, bins = binCapacity;
+	arena.reset();
+	nEvents = nBins = eventCapacity = binCapacity = 0;
+	firstEvent = 0;
+	masks = 0;
+	times = 0;
+	offsets = 0;
+	reserve(bins ? bins : 1 << 14, events ? events : 1 << 12);
+	offsets[0] = 0;
+}
+
+// Platz schaffen; die bisherigen Felder bleiben bis zum naechsten clear
+// ungenutzt in der Arena
+template <class Mask>
+void fp13BasicEventBatch<Mask>::reserve(size_t bins, size_t events)
+{
+	if (bins > binCapacity) {
+		bins = max(bins, 2 * binCapacity);
+		Mask* newMasks = arena.template allocate<Mask>(bins);
+		int32_t* newTimes = arena.template allocate<int32_t>(bins);
+		if (nBins) {
+			memcpy(newMasks, masks, nBins * sizeof(Mask));
+			memcpy(newTimes, times, nBins * sizeof(int32_t));
+		}
+		masks = newMasks;
+		times = newTimes;
+		binCapacity = bins;
+	}
+	// offsets hat einen Eintrag mehr als es Ereignisse gibt
+	if (events > eventCapacity) {
+		events = max(events, 2 * eventCapacity);
+		uint32_t* newOffsets =
+			arena.template allocate<uint32_t>(events + 1);
+		if (offsets)
+			memcpy(newOffsets, offsets,
+					(nEvents + 1) * sizeof(uint32_t));
+		offsets = newOffsets;
+		eventCapacity = events;
+	}
+}
+
+template <class Mask>
+bool fp13BasicEventBatch<Mask>::append(const vector<int>& mask,
+		const vector<int>& times)
+{
+	// passen alle Hitmuster (und die Anzahl der Zeitbins)?
+	const size_t n = mask.size();
+	for (size_t i = 0; i < n; ++i)
+		if (!fits(mask[i]))
+			return false;
+	if (nBins + n > UINT32_MAX)
+		return false;
+
+	reserve(nBins + n, nEvents + 1);
+	for (size_t i = 0; i < n; ++i) {
+		masks[nBins + i] = static_cast<Mask>(mask[i]);
+		this->times[nBins + i] = times[i];
+	}
+	nBins += n;
+	offsets[++nEvents] = nBins;
+	return true;
+}
+
+template <class Mask>
+bool fp13BasicEventBatch<Mask>::append(const vector<Mask>& mask,
+		const vector<int>& times)
+{
+	// die Hitmuster passen schon
+	const size_t n = mask.size();
+	if (nBins + n > UINT32_MAX)
+		return false;
+
+	reserve(nBins + n, nEvents + 1);
+	copy(mask.begin(), mask.end(), masks + nBins);
+	copy(times.begin(), times.end(), this->times + nBins);
+	nBins += n;
+	offsets[++nEvents] = nBins;
+	return true;
+}
+
+template <class Mask>
+void fp13BasicEventBatch<Mask>::getEvent(size_t i, vector<Mask>& mask,
+		vector<int>& times) const
+{
+	mask.assign(masks + offsets[i], masks + offsets[i + 1]);
+	times.assign(this->times + offsets[i], this->times + offsets[i + 1]);
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13BasicBatchQueue
+////////////////////////////////////////////////////////////////////////
+template <class Mask>
+fp13BasicBatchQueue<Mask>::fp13BasicBatchQueue(size_t nBatches) :
+	finished(false)
+{
+	for (size_t i = 0; i < nBatches; ++i) {
+		batches.push_back(new Batch);
+		free.push_back(batches.back());
+	}
+}
+
+template <class Mask>
+fp13BasicBatchQueue<Mask>::~fp13BasicBatchQueue()
+{
+	for (size_t i = 0; i < batches.size(); ++i)
+		delete batches[i];
+}
+
+template <class Mask>
+fp13BasicEventBatch<Mask>* fp13BasicBatchQueue<Mask>::getFree()
+{
+	unique_lock<mutex> guard(queueMutex);
+	while (free.empty())
+		queueChanged.wait(guard);
+	Batch* batch = free.front();
+	free.pop_front();
+	batch->clear();
+	return batch;
+}
+
+template <class Mask>
+void fp13BasicBatchQueue<Mask>::push(Batch* batch)
+{
+	{
+		unique_lock<mutex> guard(queueMutex);
+		full.push_back(batch);
+	}
+	queueChanged.notify_all();
+}
+
+template <class Mask>
+fp13BasicEventBatch<Mask>* fp13BasicBatchQueue<Mask>::pop()
+{
+	unique_lock<mutex> guard(queueMutex);
+	while (full.empty() && !finished)
+		queueChanged.wait(guard);
+	if (full.empty())
+		return 0;
+	Batch* batch = full.front();
+	full.pop_front();
+	return batch;
+}
+
+template <class Mask>
+void fp13BasicBatchQueue<Mask>::release(Batch* batch)
+{
+	{
+		unique_lock<mutex> guard(queueMutex);
+		free.push_back(batch);
+	}
+	queueChanged.notify_all();
+}
+
+template <class Mask>
+void fp13BasicBatchQueue<Mask>::finish()
+{
+	{
+		unique_lock<mutex> guard(queueMutex);
+		finished = true;
+	}
+	queueChanged.notify_all();
+}
+
+template <class Mask>
+void fp13BasicBatchQueue<Mask>::waitIdle()
+{
+	unique_lock<mutex> guard(queueMutex);
+	while (free.size() < batches.size())
+		queueChanged.wait(guard);
+}
+
+////////////////////////////////////////////////////////////////////////
+// Instanzen fuer die Hitmuster aller Detektorgroessen (s. fp13LayerMask
+// in fp13Analysis.h)
+////////////////////////////////////////////////////////////////////////
+template class fp13BasicEventBatch<uint8_t>;
+template class fp13BasicEventBatch<uint16_t>;
+template class fp13BasicEventBatch<uint32_t>;
+template class fp13BasicBatchQueue<uint8_t>;
+template class fp13BasicBatchQueue<uint16_t>;
+template class fp13BasicBatchQueue<uint32_t>;
+
+// Dateiende
@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Pakete von Ereignissen und eine Warteschlange, ueber die sie zwischen
+// Threads weitergereicht werden
+//
+// fp13Analysis::analyzeParallel liest die Ereignisse in einem Thread,
+// packt sie in Pakete (fp13EventBatch) zu je einigen tausend Ereignissen
+// und reicht diese ueber eine fp13BatchQueue an die Threads weiter, die
+// sie mit fp13Analysis::analyzeBatch analysieren. Die Warteschlange
+// verwaltet eine feste Anzahl von Paketen; sind alle in Benutzung,
+// wartet der lesende Thread, so dass der Speicherbedarf begrenzt bleibt.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13EVENTQUEUE_H
+#define FP13EVENTQUEUE_H
+
+// C++ headers
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+// C headers (fuer uint8_t, uint16_t, int32_t, uint32_t)
+#include <stdint.h>
+
+#include "fp13Arena.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+// Paket von Ereignissen
+//
+// Die Ereignisse liegen spaltenweise hintereinander (structure of
+// arrays): ein Feld mit den Hitmustern aller Zeitbins als Mask, eines
+// mit den Zeiten als int32_t und eines mit dem Anfang jedes Ereignisses
+// darin. Ereignis i umfasst die Zeitbins [offsets[i], offsets[i + 1]).
+// Der Speicher kommt aus einer fp13Arena, die beim Leeren des Pakets
+// erhalten bleibt, so dass ein wiederverwendetes Paket keinen Speicher
+// mehr anfordert.
+//
+// Mask ist ein vorzeichenloser Typ, in den die Hitmuster des Detektors
+// passen (s. fp13LayerMask in fp13Analysis.h); instanziiert werden
+// uint8_t, uint16_t und uint32_t (in fp13EventQueue.cc). fp13EventBatch
+// ist das Paket fuer Detektoren mit bis zu 8 Lagen.
+template <class Mask>
+class fp13BasicEventBatch
+{
+public:
+	fp13BasicEventBatch();
+
+	// Anzahl der Ereignisse im Paket
+	size_t size() const;
+	// Anzahl der Zeitbins aller Ereignisse zusammen
+	size_t getNoOfBins() const;
+	// Leeren des Pakets
+	void clear();
+	// Anhaengen eines Ereignisses
+	// gibt false zurueck (und laesst das Paket unveraendert), falls
+	// ein Hitmuster nicht in Mask passt
+	bool append(const vector<int>& mask, const vector<int>& times);
+	bool append(const vector<Mask>& mask, const vector<int>& times);
+	// Kopieren von Ereignis i nach mask/times
+	void getEvent(size_t i, vector<Mask>& mask, vector<int>& times) const;
+
+	// Nummer des ersten Ereignisses im Paket in der Eingabedatei; die
+	// Ereignisse eines Pakets sind fortlaufend nummeriert, Ereignis i
+	// hat also die Nummer getFirstEvent() + i (wird beim ersten append
+	// nach clear vom Fuellenden gesetzt)
+	void setFirstEvent(unsigned long event)
+	{ firstEvent = event; }
+	unsigned long getFirstEvent() const
+	{ return firstEvent; }
+
+	// Felder mit den Daten (gueltig bis zum naechsten append oder clear)
+	// Hitmuster und Zeiten aller Zeitbins
+	const Mask* getMasks() const
+	{ return masks; }
+	const int32_t* getTimes() const
+	{ return times; }
+	// Anfang jedes Ereignisses in masks/times (size() + 1 Eintraege)
+	const uint32_t* getOffsets() const
+	{ return offsets; }
+
+	// passt das Hitmuster mask in ein Paket? (in ein uint32_t passt
+	// jedes int als Bitmuster)
+	static bool fits(int mask)
+	{
+		return sizeof(Mask) >= sizeof(int) || (mask >= 0 &&
+			mask <= static_cast<int>(static_cast<Mask>(-1)));
+	}
+
+private:
+	// Platz fuer nBins Zeitbins und nEvents Ereignisse schaffen
+	void reserve(size_t nBins, size_t nEvents);
+
+	fp13Arena arena;
+	Mask* masks;
+	int32_t* times;
+	uint32_t* offsets;
+	// Anzahl der Ereignisse und Zeitbins
+	size_t nEvents, nBins;
+	// Nummer des ersten Ereignisses
+	unsigned long firstEvent;
+	// Platz in den Feldern
+	size_t eventCapacity, binCapacity;
+
+	// nicht kopierbar
+	fp13BasicEventBatch(const fp13BasicEventBatch&);
+	fp13BasicEventBatch& operator=(const fp13BasicEventBatch&);
+};
+
+typedef fp13BasicEventBatch<uint8_t> fp13EventBatch;
+
+// Warteschlange fuer Pakete von Ereignissen
+template <class Mask>
+class fp13BasicBatchQueue
+{
+public:
+	typedef fp13BasicEventBatch<Mask> Batch;
+
+	// legt nBatches leere Pakete an
+	fp13BasicBatchQueue(size_t nBatches);
+	~fp13BasicBatchQueue();
+
+	// Holen eines leeren Pakets zum Fuellen; wartet, bis eins frei ist
+	Batch* getFree();
+	// Einreihen eines gefuellten Pakets
+	void push(Batch* batch);
+	// Holen des naechsten gefuellten Pakets; wartet, bis eins da ist
+	// gibt 0 zurueck, wenn finish aufgerufen wurde und die Warteschlange
+	// leer ist
+	Batch* pop();
+	// Zurueckgeben eines abgearbeiteten Pakets
+	void release(Batch* batch);
+	// es kommen keine weiteren Pakete mehr
+	void finish();
+	// Warten, bis alle eingereihten Pakete abgearbeitet und
+	// zurueckgegeben sind; der Aufrufer darf selbst kein Paket halten
+	void waitIdle();
+
+private:
+	vector<Batch*> batches;
+	deque<Batch*> full, free;
+	bool finished;
+	mutex queueMutex;
+	condition_variable queueChanged;
+
+	// nicht kopierbar
+	fp13BasicBatchQueue(const fp13BasicBatchQueue&);
+	fp13BasicBatchQueue& operator=(const fp13BasicBatchQueue&);
+};
+
+typedef fp13BasicBatchQueue<uint8_t> fp13BatchQueue;
+
+#endif
+
+// Dateiende
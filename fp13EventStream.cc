@@ -0,0 +1,212 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Mehrere Analysen, die sich einen Ereignisstrom teilen (s.
+// fp13EventStream.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13EventStream.h"
+
+#include <iomanip>
+#include <thread>
+
+#include <TROOT.h>
+
+#include "fp13Input.h"
+#include "fp13Index.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+// so viele Ereignisse werden auf einmal weitergegeben
+static const size_t batchSize = 4096;
+
+// Konstruktor
+template <int N>
+fp13BasicEventStream<N>::fp13BasicEventStream(const string& inputFileName,
+		unsigned nReadThreads) :
+	inputFile(fp13Input::open(inputFileName, nReadThreads)),
+	eventCounter(0), analyzedCounter(0)
+{
+	if (!inputFile) {
+		error << "Fehler beim Oeffnen der Eingabedatei " <<
+			inputFileName << "." << endl;
+		throw;
+	}
+	hitMask.reserve(32);
+	hitTimes.reserve(32);
+}
+
+// Destruktor
+template <int N>
+fp13BasicEventStream<N>::~fp13BasicEventStream()
+{
+	for (size_t i = 0; i < analyses.size(); ++i) {
+		// fuer die Meldung im Destruktor der Analyse
+		analyses[i]->eventCounter = eventCounter;
+		delete analyses[i];
+	}
+	delete inputFile;
+}
+
+template <int N>
+void fp13BasicEventStream<N>::add(Analysis* analysis)
+{ analyses.push_back(analysis); }
+
+template <int N>
+unsigned long fp13BasicEventStream<N>::getNoOfEvents() const
+{ return eventCounter; }
+
+template <int N>
+unsigned long fp13BasicEventStream<N>::getNoOfAnalyzedEvents() const
+{ return analyzedCounter; }
+
+// Einlesen eines Ereignisses (wie fp13BasicAnalysis::readEvent)
+template <int N>
+int fp13BasicEventStream<N>::readEvent()
+{
+	if ((eventCounter % 10000) == 0) {
+		info << "Ereignis " << setw(8) << eventCounter <<
+			", davon " << setw(8) << analyzedCounter <<
+			" analysiert." << endl;
+	}
+	while (0 == inputFile->readEvent(hitMask, hitTimes, eventCounter)) {
+		++eventCounter;
+		// Ereignisse mit Hitmustern, die nicht zu N Lagen passen (nur
+		// bei kaputten Daten), werden wie in der Analyse uebersprungen
+		bool fits = true;
+		for (size_t i = 0; i < hitMask.size() && fits; ++i)
+			fits = Batch::fits(hitMask[i]);
+		if (fits)
+			return 0;
+		warn << "Hitmuster in Ereignis " << (eventCounter - 1) <<
+			" passt nicht zu " << N << " Lagen, ueberspringe das "
+			"Ereignis." << endl;
+	}
+	return -1;
+}
+
+// Ueberspringen von Ereignissen
+template <int N>
+int fp13BasicEventStream<N>::skipEvents(unsigned long event)
+{
+	eventCounter = fp13EventIndex::seek(*inputFile, eventCounter, event);
+	while (eventCounter < event) {
+		if (readEvent() < 0)
+			return -1;
+	}
+	return 0;
+}
+
+// Analysieren eines Ereignisses, das nicht in ein Paket passt
+template <int N>
+void fp13BasicEventStream<N>::analyzeSingle(Analysis& analysis)
+{
+	analysis.currentEvent = eventCounter - 1;
+	analysis.setHitMask(hitMask);
+	analysis.detectorHitTimes = hitTimes;
+	analysis.analyze();
+}
+
+// Lesen und Analysieren
+template <int N>
+void fp13BasicEventStream<N>::analyze(unsigned long maxNoOfEvents,
+		bool threaded)
+{
+	if (analyses.empty()) {
+		warn << "Keine Analyseobjekte angemeldet." << endl;
+		return;
+	}
+	if (threaded && analyses.size() > 1)
+		analyzeThreaded(maxNoOfEvents);
+	else
+		analyzeSerial(maxNoOfEvents);
+}
+
+// alle Analyseobjekte nacheinander in einem Thread
+template <int N>
+void fp13BasicEventStream<N>::analyzeSerial(unsigned long maxNoOfEvents)
+{
+	Batch batch;
+	while (analyzedCounter < maxNoOfEvents && readEvent() == 0) {
+		++analyzedCounter;
+		if (!batch.size())
+			batch.setFirstEvent(eventCounter - 1);
+		if (!batch.append(hitMask, hitTimes)) {
+			// Paket voll: zuerst das Paket, dann das
+			// Ereignis einzeln analysieren
+			for (size_t i = 0; i < analyses.size(); ++i) {
+				if (batch.size())
+					analyses[i]->analyzeBatch(batch);
+				analyzeSingle(*analyses[i]);
+			}
+			batch.clear();
+		} else if (batch.size() >= batchSize) {
+			for (size_t i = 0; i < analyses.size(); ++i)
+				analyses[i]->analyzeBatch(batch);
+			batch.clear();
+		}
+	}
+	for (size_t i = 0; i < analyses.size() && batch.size(); ++i)
+		analyses[i]->analyzeBatch(batch);
+}
+
+// ein Thread pro Analyseobjekt
+template <int N>
+void fp13BasicEventStream<N>::analyzeThreaded(unsigned long maxNoOfEvents)
+{
+	const size_t nAnalyses = analyses.size();
+	ROOT::EnableThreadSafety();
+	vector<BatchQueue*> queues;
+	vector<Batch*> batches;
+	vector<thread> threads;
+	for (size_t i = 0; i < nAnalyses; ++i) {
+		queues.push_back(new BatchQueue(2));
+		batches.push_back(queues[i]->getFree());
+		threads.push_back(thread(&Analysis::workerLoop, analyses[i],
+					ref(*queues[i])));
+	}
+
+	while (analyzedCounter < maxNoOfEvents && readEvent() == 0) {
+		++analyzedCounter;
+		for (size_t i = 0; i < nAnalyses; ++i) {
+			if (!batches[i]->size())
+				batches[i]->setFirstEvent(eventCounter - 1);
+			if (!batches[i]->append(hitMask, hitTimes)) {
+				// Paket voll: warten, bis der Thread
+				// alles Bisherige analysiert hat, und dann hier
+				// analysieren (der Thread wartet derweil auf
+				// das naechste Paket)
+				queues[i]->push(batches[i]);
+				queues[i]->waitIdle();
+				analyzeSingle(*analyses[i]);
+				batches[i] = queues[i]->getFree();
+			} else if (batches[i]->size() >= batchSize) {
+				queues[i]->push(batches[i]);
+				batches[i] = queues[i]->getFree();
+			}
+		}
+	}
+
+	for (size_t i = 0; i < nAnalyses; ++i) {
+		if (batches[i]->size())
+			queues[i]->push(batches[i]);
+		else
+			queues[i]->release(batches[i]);
+		queues[i]->finish();
+	}
+	for (size_t i = 0; i < nAnalyses; ++i) {
+		threads[i].join();
+		delete queues[i];
+	}
+}
+
+////////////////////////////////////////////////////////////////////////
+// Instanzen fuer die unterstuetzten Detektorgroessen (fp13 -l)
+////////////////////////////////////////////////////////////////////////
+template class fp13BasicEventStream<6>;
+template class fp13BasicEventStream<8>;
+template class fp13BasicEventStream<12>;
+template class fp13BasicEventStream<16>;
+template class fp13BasicEventStream<32>;
+
+// Dateiende
@@ -0,0 +1,109 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Mehrere Analysen, die sich einen Ereignisstrom teilen
+//
+// Wer mehrere Analyseklassen (z.B. verschiedene Methoden fuer Zerfaelle
+// nach unten oder Nachpulse) mit denselben Daten vergleichen will, muss
+// sonst fuer jede die Eingabedatei neu lesen. fp13EventStream liest und
+// zerlegt jedes Ereignis nur einmal und gibt es an alle angemeldeten
+// Analyseobjekte weiter; jedes schreibt seine eigene Ausgabedatei.
+//
+// Die Analyseobjekte werden mit dem Konstruktor ohne Eingabedatei
+// erzeugt (den abgeleitete Klassen entsprechend anbieten muessen):
+//
+// 	fp13EventStream stream("fp13.txt");
+// 	stream.add(new fp13Analysis("standard.root"));
+// 	stream.add(new MyAnalysis("mine.root"));
+// 	stream.analyze(maxNoOfEvents, true);
+//
+// Die Ereignisse werden in Paketen (s. fp13EventQueue.h) mit
+// analyzeBatch weitergegeben, die Standardanalyse klassifiziert also
+// weiter ganze Pakete auf einmal. Mit threaded laeuft jedes
+// Analyseobjekt in einem eigenen Thread und bekommt seine Pakete ueber
+// eine eigene Warteschlange; gelesen wird weiter in einem Thread, mit
+// nReadThreads im Konstruktor auch parallel (s. fp13ParallelInput.h).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13EVENTSTREAM_H
+#define FP13EVENTSTREAM_H
+
+// C++ headers
+#include <string>
+#include <vector>
+
+#include "fp13Analysis.h"
+#include "fp13EventQueue.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13Input;
+
+template <int N>
+class fp13BasicEventStream
+{
+public:
+	typedef fp13BasicAnalysis<N> Analysis;
+	typedef fp13BasicEventBatch<typename fp13LayerMask<N>::Mask> Batch;
+	typedef fp13BasicBatchQueue<typename fp13LayerMask<N>::Mask>
+		BatchQueue;
+
+	// Oeffnen der Eingabedatei (wie bei fp13BasicAnalysis)
+	fp13BasicEventStream(const string& inputFileName,
+			unsigned nReadThreads = 1);
+	// loescht alle Analyseobjekte, die dabei ihre Ausgabedateien
+	// schreiben
+	~fp13BasicEventStream();
+
+	// Anmelden eines Analyseobjekts, das damit in den Besitz des
+	// Ereignisstroms uebergeht
+	void add(Analysis* analysis);
+
+	// Ueberspringen der Ereignisse bis zum Ereignis event (s.
+	// fp13BasicAnalysis::skipEvents)
+	// gibt 0 zurueck, -1 falls vorher das Ende der Datei erreicht wurde
+	int skipEvents(unsigned long event);
+
+	// Lesen von hoechstens maxNoOfEvents Ereignissen und Analysieren
+	// mit allen Analyseobjekten; mit threaded jedes in einem eigenen
+	// Thread
+	void analyze(unsigned long maxNoOfEvents, bool threaded);
+
+	unsigned long getNoOfEvents() const;
+	unsigned long getNoOfAnalyzedEvents() const;
+
+private:
+	// Einlesen eines Ereignisses nach hitMask/hitTimes
+	// gibt 0 zurueck, -1 am Ende der Eingabe
+	int readEvent();
+
+	// Analysieren des aktuellen Ereignisses mit analysis, falls es
+	// nicht mehr in ein Paket passt (mehr als UINT32_MAX Zeitbins)
+	void analyzeSingle(Analysis& analysis);
+
+	// Analysieren aller Ereignisse in einem Thread
+	void analyzeSerial(unsigned long maxNoOfEvents);
+	// Analysieren mit einem Thread pro Analyseobjekt
+	void analyzeThreaded(unsigned long maxNoOfEvents);
+
+	fp13Input* inputFile;
+	vector<Analysis*> analyses;
+	// Ereigniszaehler
+	unsigned long eventCounter;
+	unsigned long analyzedCounter;
+	// das aktuelle Ereignis
+	vector<int> hitMask;
+	vector<int> hitTimes;
+
+	// nicht kopierbar
+	fp13BasicEventStream(const fp13BasicEventStream&);
+	fp13BasicEventStream& operator=(const fp13BasicEventStream&);
+};
+
+// Ereignisstrom fuer den Detektor im Praktikum
+typedef fp13BasicEventStream<6> fp13EventStream;
+
+#endif
+
+// Dateiende
@@ -0,0 +1,893 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Kompilierte Fits der Lebensdauer (s. fp13Fit.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Fit.h"
+
+#include <iomanip>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+#include <TList.h>
+
+// hoechstens so viele Parameter hat ein Fit
+static const unsigned maxParameters = 8;
+
+// Loesen von m * v = b fuer die Parameter i mit free[i] mit
+// Gauss-Elimination und Pivotsuche (m ist n x n und wird dabei
+// ueberschrieben, v landet in b, fuer die anderen Parameter 0)
+// gibt false zurueck, falls m singulaer ist
+static bool solve(unsigned n, double* m, double* b, const bool* free)
+{
+	unsigned idx[maxParameters], k = 0;
+	for (unsigned i = 0; i < n; ++i) {
+		if (free[i])
+			idx[k++] = i;
+		else
+			b[i] = 0.;
+	}
+	for (unsigned c = 0; c < k; ++c) {
+		unsigned pivot = c;
+		for (unsigned r = c + 1; r < k; ++r)
+			if (fabs(m[idx[r] * n + idx[c]]) >
+					fabs(m[idx[pivot] * n + idx[c]]))
+				pivot = r;
+		const double mcc = m[idx[pivot] * n + idx[c]];
+		if (!(fabs(mcc) > 0.) || !isfinite(mcc))
+			return false;
+		if (pivot != c) {
+			for (unsigned j = 0; j < k; ++j)
+				swap(m[idx[c] * n + idx[j]],
+						m[idx[pivot] * n + idx[j]]);
+			swap(b[idx[c]], b[idx[pivot]]);
+		}
+		for (unsigned r = c + 1; r < k; ++r) {
+			const double factor = m[idx[r] * n + idx[c]] / mcc;
+			for (unsigned j = c; j < k; ++j)
+				m[idx[r] * n + idx[j]] -=
+					factor * m[idx[c] * n + idx[j]];
+			b[idx[r]] -= factor * b[idx[c]];
+		}
+	}
+	for (unsigned c = k; c-- > 0; ) {
+		double sum = b[idx[c]];
+		for (unsigned j = c + 1; j < k; ++j)
+			sum -= m[idx[c] * n + idx[j]] * b[idx[j]];
+		b[idx[c]] = sum / m[idx[c] * n + idx[c]];
+	}
+	return true;
+}
+
+const char* const fp13LifetimeFit::parameterNames[nParameters] = {
+	"BG", "N_mu", "tau_0"
+};
+
+// Konstruktor
+fp13LifetimeFit::fp13LifetimeFit(Method m) :
+	method(m), minimum(0.), ndf(0), nIterations(0), converged(false)
+{
+	// wie setFitFunction in Lebensdauer.C
+	static const double defPar[nParameters] = { 10., 5000., 2000. };
+	static const double defLower[nParameters] = { 0.01, 0., 1000. };
+	static const double defUpper[nParameters] = { 100000., 100000., 10000. };
+	for (unsigned i = 0; i < nParameters; ++i) {
+		par[i] = defPar[i];
+		lower[i] = defLower[i];
+		upper[i] = defUpper[i];
+	}
+	fill(covariance, covariance + nParameters * nParameters, 0.);
+}
+
+// das Modell (wie fitFuncF in Lebensdauer.C)
+double fp13LifetimeFit::model(double x, const double* p)
+{ return p[NoOfMuons] * exp(-x / p[Lifetime]) + p[Background]; }
+
+// Daten aus einem Histogramm
+unsigned fp13LifetimeFit::setData(const TH1& h, double xmin, double xmax)
+{
+	vector<double> centers, contents, errors;
+	for (int bin = 1; bin <= h.GetNbinsX(); ++bin) {
+		const double center = h.GetXaxis()->GetBinCenter(bin);
+		if (center < xmin || center > xmax)
+			continue;
+		centers.push_back(center);
+		contents.push_back(h.GetBinContent(bin));
+		errors.push_back(h.GetBinError(bin));
+	}
+	return setData(centers, contents, errors);
+}
+
+// Daten aus Feldern
+unsigned fp13LifetimeFit::setData(const vector<double>& centers,
+		const vector<double>& contents, const vector<double>& errors)
+{
+	x.clear();
+	y.clear();
+	w.clear();
+	for (size_t i = 0; i < centers.size(); ++i) {
+		if (Chi2 == method) {
+			// leere Bins zaehlen nicht (wie bei TH1::Fit)
+			if (!(errors[i] > 0.))
+				continue;
+			w.push_back(1. / (errors[i] * errors[i]));
+		} else {
+			w.push_back((contents[i] > 0.) ?
+					(contents[i] * log(contents[i])) : 0.);
+		}
+		x.push_back(centers[i]);
+		y.push_back(contents[i]);
+	}
+	ex.resize(x.size());
+	ndf = int(x.size()) - int(nParameters);
+	return x.size();
+}
+
+void fp13LifetimeFit::setParameters(const double* p)
+{ copy(p, p + nParameters, par); }
+
+void fp13LifetimeFit::setParameter(unsigned i, double value)
+{ par[i] = value; }
+
+void fp13LifetimeFit::setLimits(unsigned i, double lo, double hi)
+{
+	lower[i] = lo;
+	upper[i] = hi;
+}
+
+fp13LifetimeFit::Method fp13LifetimeFit::getMethod() const
+{ return method; }
+
+double fp13LifetimeFit::getParameter(unsigned i) const
+{ return par[i]; }
+
+const double* fp13LifetimeFit::getParameters() const
+{ return par; }
+
+double fp13LifetimeFit::getError(unsigned i) const
+{ return sqrt(covariance[i * nParameters + i]); }
+
+double fp13LifetimeFit::getCovariance(unsigned i, unsigned j) const
+{ return covariance[i * nParameters + j]; }
+
+double fp13LifetimeFit::getMinimum() const
+{ return minimum; }
+
+int fp13LifetimeFit::getNdf() const
+{ return ndf; }
+
+unsigned fp13LifetimeFit::getNoOfBins() const
+{ return x.size(); }
+
+unsigned fp13LifetimeFit::getNoOfIterations() const
+{ return nIterations; }
+
+bool fp13LifetimeFit::hasConverged() const
+{ return converged; }
+
+// Auswerten von Q mit Ableitungen
+//
+// mit e = exp(-x / tau) ist f = b + N e, die Ableitungen nach (b, N, tau)
+// sind d = (1, e, N e x / tau^2), die zweiten Ableitungen ungleich 0
+// f_N,tau = e x / tau^2 und f_tau,tau = N e x / tau^3 (x / tau - 2)
+double fp13LifetimeFit::evaluate(const double* p, double* gradient,
+		double* curvature, double* hessian)
+{
+	const size_t n = x.size();
+	const double b = p[Background], nMu = p[NoOfMuons];
+	const double invTau = 1. / p[Lifetime], invTau2 = invTau * invTau;
+	const double* const xs = x.data();
+	const double* const ys = y.data();
+	const double* const ws = w.data();
+	double* const es = ex.data();
+
+	// erster Durchgang: Exponentialfunktion
+	for (size_t i = 0; i < n; ++i)
+		es[i] = exp(-xs[i] * invTau);
+
+	// zweiter Durchgang: Summen fuer Q, Gradient (g), Kruemmung (a,
+	// symmetrisch) und die Terme der zweiten Ableitungen von f (s12, s22)
+	double q = 0., g0 = 0., g1 = 0., g2 = 0.;
+	double a00 = 0., a01 = 0., a02 = 0., a11 = 0., a12 = 0., a22 = 0.;
+	double h00 = 0., h01 = 0., h02 = 0., h11 = 0., h12 = 0., h22 = 0.;
+	double s12 = 0., s22 = 0.;
+	if (Chi2 == method) {
+		for (size_t i = 0; i < n; ++i) {
+			const double e = es[i], wi = ws[i];
+			const double d2 = nMu * e * xs[i] * invTau2;
+			const double r = ys[i] - b - nMu * e, wr = wi * r;
+			q += wr * r;
+			g0 += wr;
+			g1 += wr * e;
+			g2 += wr * d2;
+			a00 += wi;
+			a01 += wi * e;
+			a02 += wi * d2;
+			a11 += wi * e * e;
+			a12 += wi * e * d2;
+			a22 += wi * d2 * d2;
+			s12 += wr * e * xs[i];
+			s22 += wr * d2 * (xs[i] * invTau - 2.);
+		}
+		// Q = sum w r^2: g = -2 sum w r d, a = 2 sum w d d, die exakte
+		// zweite Ableitung hat zusaetzlich -2 sum w r f_jk
+		g0 *= -2.;
+		g1 *= -2.;
+		g2 *= -2.;
+		a00 *= 2.;
+		a01 *= 2.;
+		a02 *= 2.;
+		a11 *= 2.;
+		a12 *= 2.;
+		a22 *= 2.;
+		h00 = a00;
+		h01 = a01;
+		h02 = a02;
+		h11 = a11;
+		h12 = a12 - 2. * s12 * invTau2;
+		h22 = a22 - 2. * s22 * invTau;
+	} else {
+		double fMin = numeric_limits<double>::infinity();
+		for (size_t i = 0; i < n; ++i) {
+			const double e = es[i];
+			const double d2 = nMu * e * xs[i] * invTau2;
+			const double f = b + nMu * e, invF = 1. / f;
+			const double u = ys[i] * invF, c = 1. - u, uf = u * invF;
+			fMin = min(fMin, f);
+			q += f - ys[i] + ws[i] - ys[i] * log(f);
+			g0 += c;
+			g1 += c * e;
+			g2 += c * d2;
+			a00 += invF;
+			a01 += invF * e;
+			a02 += invF * d2;
+			a11 += invF * e * e;
+			a12 += invF * e * d2;
+			a22 += invF * d2 * d2;
+			h00 += uf;
+			h01 += uf * e;
+			h02 += uf * d2;
+			h11 += uf * e * e;
+			h12 += uf * e * d2;
+			h22 += uf * d2 * d2;
+			s12 += c * e * xs[i];
+			s22 += c * d2 * (xs[i] * invTau - 2.);
+		}
+		if (!(fMin > 0.))
+			return numeric_limits<double>::infinity();
+		// Q = 2 sum (f - y + y ln(y / f)): g = 2 sum (1 - y/f) d, als
+		// Kruemmung die erwartete 2 sum d d / f, die exakte zweite
+		// Ableitung ist 2 sum (y/f^2 d d + (1 - y/f) f_jk)
+		q *= 2.;
+		g0 *= 2.;
+		g1 *= 2.;
+		g2 *= 2.;
+		a00 *= 2.;
+		a01 *= 2.;
+		a02 *= 2.;
+		a11 *= 2.;
+		a12 *= 2.;
+		a22 *= 2.;
+		h00 *= 2.;
+		h01 *= 2.;
+		h02 *= 2.;
+		h11 *= 2.;
+		h12 = 2. * (h12 + s12 * invTau2);
+		h22 = 2. * (h22 + s22 * invTau);
+	}
+
+	gradient[0] = g0;
+	gradient[1] = g1;
+	gradient[2] = g2;
+	const double a[nParameters * nParameters] = {
+		a00, a01, a02,
+		a01, a11, a12,
+		a02, a12, a22
+	};
+	copy(a, a + nParameters * nParameters, curvature);
+	if (hessian) {
+		const double h[nParameters * nParameters] = {
+			h00, h01, h02,
+			h01, h11, h12,
+			h02, h12, h22
+		};
+		copy(h, h + nParameters * nParameters, hessian);
+	}
+	return q;
+}
+
+// Fit mit Levenberg-Marquardt
+bool fp13LifetimeFit::fit()
+{
+	const unsigned n = nParameters;
+	// konvergiert, sobald die erwartete Abnahme von Q (edm wie bei
+	// Minuit) darunter liegt
+	static const double tolerance = 1e-9;
+
+	nIterations = 0;
+	converged = false;
+	fill(covariance, covariance + n * n, 0.);
+	for (unsigned j = 0; j < n; ++j)
+		par[j] = min(max(par[j], lower[j]), upper[j]);
+	if (x.size() < n) {
+		minimum = numeric_limits<double>::quiet_NaN();
+		return false;
+	}
+
+	double g[nParameters], a[nParameters * nParameters];
+	double q = evaluate(par, g, a, 0);
+	if (!isfinite(q)) {
+		minimum = q;
+		return false;
+	}
+	double lambda = 1e-3;
+	for (; nIterations < maxIterations; ++nIterations) {
+		// Parameter an einer Grenze, die weiter hinaus wollen, bleiben
+		// stehen
+		bool free[nParameters];
+		for (unsigned j = 0; j < n; ++j)
+			free[j] = !((par[j] <= lower[j] && g[j] > 0.) ||
+					(par[j] >= upper[j] && g[j] < 0.));
+
+		double m[nParameters * nParameters], v[nParameters];
+		copy(a, a + n * n, m);
+		copy(g, g + n, v);
+		if (solve(n, m, v, free)) {
+			double edm = 0.;
+			for (unsigned j = 0; j < n; ++j)
+				edm += 0.5 * g[j] * v[j];
+			if (edm < tolerance) {
+				converged = true;
+				break;
+			}
+		}
+
+		// gedaempfter Schritt
+		copy(a, a + n * n, m);
+		for (unsigned j = 0; j < n; ++j) {
+			m[j * n + j] *= 1. + lambda;
+			v[j] = -g[j];
+		}
+		double trial[nParameters];
+		copy(par, par + n, trial);
+		if (solve(n, m, v, free))
+			for (unsigned j = 0; j < n; ++j)
+				if (free[j])
+					trial[j] = min(max(par[j] + v[j],
+								lower[j]), upper[j]);
+		double gt[nParameters], at[nParameters * nParameters];
+		const double qt = evaluate(trial, gt, at, 0);
+		if (isfinite(qt) && qt <= q) {
+			copy(trial, trial + n, par);
+			copy(gt, gt + n, g);
+			copy(at, at + n * n, a);
+			q = qt;
+			lambda = max(0.1 * lambda, 1e-12);
+		} else {
+			lambda *= 10.;
+			if (lambda > 1e12)
+				break;
+		}
+	}
+
+	// Fehler aus der exakten zweiten Ableitung (Q steigt um 1 bei einer
+	// Standardabweichung), Parameter an einer Grenze ohne Fehler
+	double h[nParameters * nParameters];
+	minimum = evaluate(par, g, a, h);
+	bool free[nParameters];
+	for (unsigned j = 0; j < n; ++j)
+		free[j] = par[j] > lower[j] && par[j] < upper[j];
+	for (unsigned pass = 0; pass < 2; ++pass) {
+		// falls die exakte zweite Ableitung nicht positiv ist, die
+		// Kruemmungsmatrix
+		const double* const matrix = pass ? a : h;
+		bool ok = true;
+		for (unsigned k = 0; k < n && ok; ++k) {
+			if (!free[k])
+				continue;
+			double m[nParameters * nParameters], v[nParameters];
+			copy(matrix, matrix + n * n, m);
+			fill(v, v + n, 0.);
+			v[k] = 1.;
+			ok = solve(n, m, v, free) && v[k] > 0.;
+			for (unsigned j = 0; j < n; ++j)
+				covariance[j * n + k] = 2. * v[j];
+		}
+		if (ok)
+			break;
+		fill(covariance, covariance + n * n, 0.);
+	}
+	return converged;
+}
+
+// Ausgeben des Ergebnisses
+void fp13LifetimeFit::print(ostream& os) const
+{
+	const ios::fmtflags flags = os.flags();
+	const streamsize precision = os.precision();
+	os << ((Chi2 == method) ? "chi^2" : "-2 ln(L/L_sat)") << " / ndf = " <<
+		setprecision(6) << minimum << " / " << ndf << " (" <<
+		x.size() << " Bins, " << nIterations << " Schritte" <<
+		(converged ? "" : ", nicht konvergiert") << ")" << endl;
+	for (unsigned j = 0; j < nParameters; ++j)
+		os << "  " << left << setw(8) << parameterNames[j] << right <<
+			setw(14) << par[j] << " +- " << setw(12) <<
+			getError(j) << endl;
+	os.flags(flags);
+	os.precision(precision);
+}
+
+// Fit eines TF1 wie mit TH1::Fit
+bool fp13LifetimeFit::fitFunction(TH1& h, TF1& f, double xmin, double xmax,
+		Method method)
+{
+	if (nParameters != static_cast<unsigned>(f.GetNpar())) {
+		cerr << f.GetName() << " hat nicht " << nParameters <<
+			" Parameter." << endl;
+		return false;
+	}
+	const double inf = numeric_limits<double>::infinity();
+	fp13LifetimeFit fit(method);
+	fit.setData(h, xmin, xmax);
+	for (unsigned i = 0; i < nParameters; ++i) {
+		// wie bei TF1: keine Grenzen, falls beide 0 sind, fest, falls
+		// sie gleich sind
+		double lo, hi;
+		f.GetParLimits(i, lo, hi);
+		if (0. == lo && 0. == hi)
+			fit.setLimits(i, -inf, inf);
+		else
+			fit.setLimits(i, lo, hi);
+		fit.setParameter(i, f.GetParameter(i));
+	}
+	const bool converged = fit.fit();
+	fit.print(cout);
+
+	for (unsigned i = 0; i < nParameters; ++i) {
+		f.SetParameter(i, fit.getParameter(i));
+		f.SetParError(i, fit.getError(i));
+	}
+	f.SetChisquare(fit.getMinimum());
+	f.SetNDF(fit.getNdf());
+	f.SetRange(xmin, xmax);
+	// TH1::Fit ersetzt eine gleichnamige Funktion von h
+	TList* functions = h.GetListOfFunctions();
+	TObject* old = functions->FindObject(f.GetName());
+	if (old) {
+		functions->Remove(old);
+		delete old;
+	}
+	functions->Add(f.Clone());
+	return converged;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13UnbinnedFit
+////////////////////////////////////////////////////////////////////////
+const char* const fp13UnbinnedFit::parameterNames[nParameters] = {
+	"BG", "A", "tau_0", "tau_c", "r"
+};
+
+// Integral von exp(-t / tau) ueber [a, b] und seine Ableitung nach tau
+static double decayIntegral(double tau, double a, double b)
+{ return tau * (exp(-a / tau) - exp(-b / tau)); }
+
+static double decayIntegralDerivative(double tau, double a, double b)
+{
+	const double ea = exp(-a / tau), eb = exp(-b / tau);
+	return (ea - eb) + (a * ea - b * eb) / tau;
+}
+
+// Konstruktor
+fp13UnbinnedFit::fp13UnbinnedFit(Model m, double lo, double hi,
+		unsigned threads) :
+	model(m), tmin(lo), tmax(hi), nThreads(threads ? threads : 1),
+	nUsedThreads(0),
+	nDecays(0.), minimum(0.), nIterations(0), converged(false)
+{
+	// wie setFitFunction in Lebensdauer.C bzw. Einfangzeiten.C
+	const double inf = numeric_limits<double>::infinity();
+	const double defPar[nParameters] = { 0., 0., 2000., 800., 1.275 };
+	const double defLower[nParameters] = { 0., 0.,
+		(CaptureModel == model) ? 1700. : 1000., 100., 0.05 };
+	const double defUpper[nParameters] = { inf, inf,
+		(CaptureModel == model) ? 2700. : 10000., 1500., 20. };
+	for (unsigned i = 0; i < nParameters; ++i) {
+		par[i] = defPar[i];
+		lower[i] = defLower[i];
+		upper[i] = defUpper[i];
+		fixed[i] = false;
+	}
+	// ohne Einfang gibt es tau_c und r nicht, mit ist r zunaechst fest
+	fixed[CaptureTime] = (CaptureModel != model);
+	fixed[Ratio] = true;
+	fill(covariance, covariance + nParameters * nParameters, 0.);
+}
+
+// Rate zur Zeit t
+double fp13UnbinnedFit::rate(double time, const double* p) const
+{
+	double s = exp(-time / p[Lifetime]);
+	if (CaptureModel == model)
+		s *= 1. + exp(-time / p[CaptureTime]) / p[Ratio];
+	return p[Background] + p[Amplitude] * s;
+}
+
+// erwartete Anzahl Zerfaelle im Fitfenster
+double fp13UnbinnedFit::expected(const double* p) const
+{
+	double signal = decayIntegral(p[Lifetime], tmin, tmax);
+	if (CaptureModel == model) {
+		// exp(-t / tau) exp(-t / tau_c) = exp(-t / tau')
+		const double tau2 = p[Lifetime] * p[CaptureTime] /
+			(p[Lifetime] + p[CaptureTime]);
+		signal += decayIntegral(tau2, tmin, tmax) / p[Ratio];
+	}
+	return (tmax - tmin) * p[Background] + p[Amplitude] * signal;
+}
+
+void fp13UnbinnedFit::add(double time, double weight)
+{
+	if (time < tmin || time > tmax)
+		return;
+	t.push_back(time);
+	w.push_back(weight);
+	nDecays += weight;
+}
+
+double fp13UnbinnedFit::getNoOfDecays() const
+{ return nDecays; }
+
+void fp13UnbinnedFit::setParameters(const double* p)
+{ copy(p, p + nParameters, par); }
+
+void fp13UnbinnedFit::setParameter(unsigned i, double value)
+{ par[i] = value; }
+
+void fp13UnbinnedFit::setLimits(unsigned i, double lo, double hi)
+{
+	lower[i] = lo;
+	upper[i] = hi;
+}
+
+void fp13UnbinnedFit::fixParameter(unsigned i, double value)
+{
+	par[i] = value;
+	fixed[i] = true;
+}
+
+void fp13UnbinnedFit::releaseParameter(unsigned i)
+{
+	// ohne Einfang bleiben tau_c und r fest
+	if (CaptureModel == model || i < CaptureTime)
+		fixed[i] = false;
+}
+
+bool fp13UnbinnedFit::isFixed(unsigned i) const
+{ return fixed[i]; }
+
+fp13UnbinnedFit::Model fp13UnbinnedFit::getModel() const
+{ return model; }
+
+double fp13UnbinnedFit::getParameter(unsigned i) const
+{ return par[i]; }
+
+const double* fp13UnbinnedFit::getParameters() const
+{ return par; }
+
+double fp13UnbinnedFit::getError(unsigned i) const
+{ return sqrt(covariance[i * nParameters + i]); }
+
+double fp13UnbinnedFit::getCovariance(unsigned i, unsigned j) const
+{ return covariance[i * nParameters + j]; }
+
+double fp13UnbinnedFit::getMinimum() const
+{ return minimum; }
+
+unsigned fp13UnbinnedFit::getNoOfIterations() const
+{ return nIterations; }
+
+bool fp13UnbinnedFit::hasConverged() const
+{ return converged; }
+
+unsigned fp13UnbinnedFit::getNoOfUsedThreads() const
+{ return nUsedThreads; }
+
+// Teilsummen ueber [begin, end)
+//
+// mit e1 = exp(-t / tau), e2 = e1 exp(-t / tau_c) und s = e1 + e2 / r
+// ist lambda = B + A s, die Ableitungen nach (B, A, tau, tau_c, r) sind
+// (1, s, A s t / tau^2, A e2 t / (r tau_c^2), -A e2 / r^2)
+template <bool capture>
+void fp13UnbinnedFit::sumRange(const fp13UnbinnedFit* fit, const double* p,
+		size_t begin, size_t end, Sums* sums)
+{
+	const unsigned n = capture ? nParameters : unsigned(CaptureTime);
+	const double b = p[Background], a = p[Amplitude];
+	const double invTau = 1. / p[Lifetime], invTau2 = invTau * invTau;
+	const double invTauC = capture ? (1. / p[CaptureTime]) : 0.;
+	const double invR = capture ? (1. / p[Ratio]) : 0.;
+	const double* const ts = fit->t.data();
+	const double* const ws = fit->w.data();
+
+	double logL = 0., lambdaMin = numeric_limits<double>::infinity();
+	double g[nParameters] = { 0. };
+	double c[nParameters * nParameters] = { 0. };
+	for (size_t i = begin; i < end; ++i) {
+		const double ti = ts[i], wi = ws[i];
+		const double e1 = exp(-ti * invTau);
+		const double e2 = capture ? (e1 * exp(-ti * invTauC)) : 0.;
+		const double s = e1 + e2 * invR;
+		const double lambda = b + a * s, invLambda = 1. / lambda;
+		lambdaMin = min(lambdaMin, lambda);
+		logL += wi * log(lambda);
+		// Ableitungen von ln lambda
+		double v[nParameters];
+		v[Background] = invLambda;
+		v[Amplitude] = s * invLambda;
+		v[Lifetime] = a * s * ti * invTau2 * invLambda;
+		if (capture) {
+			v[CaptureTime] = a * e2 * invR * ti * invTauC *
+				invTauC * invLambda;
+			v[Ratio] = -a * e2 * invR * invR * invLambda;
+		}
+		for (unsigned j = 0; j < n; ++j) {
+			const double wv = wi * v[j];
+			g[j] += wv;
+			for (unsigned k = 0; k <= j; ++k)
+				c[j * nParameters + k] += wv * v[k];
+		}
+	}
+	sums->logL = (lambdaMin > 0.) ? logL :
+		-numeric_limits<double>::infinity();
+	for (unsigned j = 0; j < nParameters; ++j) {
+		sums->gradient[j] = g[j];
+		for (unsigned k = 0; k < nParameters; ++k)
+			sums->curvature[j * nParameters + k] = (k <= j) ?
+				c[j * nParameters + k] : c[k * nParameters + j];
+	}
+}
+
+// Teilsummen der Bloecke k, k + n, k + 2n, ...
+void fp13UnbinnedFit::sumBlocks(const fp13UnbinnedFit* fit,
+		const double* p, unsigned k, unsigned n, vector<Sums>* sums)
+{
+	const size_t nTimes = fit->t.size();
+	for (size_t b = k; b < sums->size(); b += n) {
+		const size_t begin = b * timesPerBlock;
+		const size_t end = min(begin + timesPerBlock, nTimes);
+		if (CaptureModel == fit->model)
+			sumRange<true>(fit, p, begin, end, &(*sums)[b]);
+		else
+			sumRange<false>(fit, p, begin, end, &(*sums)[b]);
+	}
+}
+
+// Auswerten von -2 ln L
+double fp13UnbinnedFit::evaluate(const double* p, double* gradient,
+		double* curvature)
+{
+	const unsigned n = nParameters;
+	// Teilsummen der Bloecke, hoechstens ein Thread pro Block
+	const size_t nBlocks = max<size_t>(1, (t.size() + timesPerBlock - 1) /
+			timesPerBlock);
+	vector<Sums> sums(nBlocks);
+	nUsedThreads = unsigned(min<size_t>(nThreads, nBlocks));
+	vector<thread> threads;
+	for (unsigned k = 1; k < nUsedThreads; ++k)
+		threads.push_back(thread(sumBlocks, this, p, k, nUsedThreads,
+					&sums));
+	sumBlocks(this, p, 0, nUsedThreads, &sums);
+	for (size_t k = 0; k < threads.size(); ++k)
+		threads[k].join();
+
+	// in fester Reihenfolge addieren
+	double logL = 0.;
+	fill(gradient, gradient + n, 0.);
+	fill(curvature, curvature + n * n, 0.);
+	for (size_t k = 0; k < nBlocks; ++k) {
+		logL += sums[k].logL;
+		for (unsigned j = 0; j < n; ++j)
+			gradient[j] += sums[k].gradient[j];
+		for (unsigned j = 0; j < n * n; ++j)
+			curvature[j] += sums[k].curvature[j];
+	}
+	if (!isfinite(logL))
+		return numeric_limits<double>::infinity();
+
+	// mu und seine Ableitungen
+	const double tau = p[Lifetime];
+	double dMu[nParameters] = { tmax - tmin,
+		decayIntegral(tau, tmin, tmax),
+		p[Amplitude] * decayIntegralDerivative(tau, tmin, tmax),
+		0., 0. };
+	if (CaptureModel == model) {
+		const double tauC = p[CaptureTime], invR = 1. / p[Ratio];
+		const double tau2 = tau * tauC / (tau + tauC);
+		const double d2 = decayIntegral(tau2, tmin, tmax);
+		const double dd2 = decayIntegralDerivative(tau2, tmin, tmax);
+		dMu[Amplitude] += d2 * invR;
+		dMu[Lifetime] += p[Amplitude] * invR * dd2 *
+			(tau2 / tau) * (tau2 / tau);
+		dMu[CaptureTime] = p[Amplitude] * invR * dd2 *
+			(tau2 / tauC) * (tau2 / tauC);
+		dMu[Ratio] = -p[Amplitude] * invR * invR * d2;
+	}
+	for (unsigned j = 0; j < n; ++j)
+		gradient[j] = 2. * (dMu[j] - gradient[j]);
+	for (unsigned j = 0; j < n * n; ++j)
+		curvature[j] *= 2.;
+	return 2. * (expected(p) - logL);
+}
+
+// Startwerte: 5% Untergrund, der Rest Zerfaelle
+void fp13UnbinnedFit::guessParameters()
+{
+	double p[nParameters];
+	copy(par, par + nParameters, p);
+	p[Background] = 0.;
+	p[Amplitude] = 1.;
+	par[Background] = 0.05 * nDecays / (tmax - tmin);
+	par[Amplitude] = 0.95 * nDecays / expected(p);
+}
+
+// Fit mit Levenberg-Marquardt wie fp13LifetimeFit::fit
+bool fp13UnbinnedFit::fit()
+{
+	const unsigned n = nParameters;
+	// -2 ln L ist eine Summe ueber viele Zerfaelle und nur auf etwa 1e-6
+	// genau; konvergiert wird wie bei Migrad mit den Standardwerten von
+	// ROOT (edm < 0.001 * 0.01 * up)
+	static const double tolerance = 1e-5;
+
+	nIterations = 0;
+	converged = false;
+	fill(covariance, covariance + n * n, 0.);
+	if (!(nDecays > 0.)) {
+		minimum = numeric_limits<double>::quiet_NaN();
+		return false;
+	}
+	if (0. == par[Background] && 0. == par[Amplitude])
+		guessParameters();
+	for (unsigned j = 0; j < n; ++j)
+		par[j] = min(max(par[j], lower[j]), upper[j]);
+
+	double g[nParameters], a[nParameters * nParameters];
+	double q = evaluate(par, g, a);
+	if (!isfinite(q)) {
+		minimum = q;
+		return false;
+	}
+	double lambda = 1e-3;
+	for (; nIterations < maxIterations; ++nIterations) {
+		bool free[nParameters];
+		for (unsigned j = 0; j < n; ++j)
+			free[j] = !fixed[j] &&
+				!((par[j] <= lower[j] && g[j] > 0.) ||
+				  (par[j] >= upper[j] && g[j] < 0.));
+
+		double m[nParameters * nParameters], v[nParameters];
+		copy(a, a + n * n, m);
+		copy(g, g + n, v);
+		if (solve(n, m, v, free)) {
+			double edm = 0.;
+			for (unsigned j = 0; j < n; ++j)
+				edm += 0.5 * g[j] * v[j];
+			if (edm < tolerance) {
+				converged = true;
+				break;
+			}
+		}
+
+		copy(a, a + n * n, m);
+		for (unsigned j = 0; j < n; ++j) {
+			m[j * n + j] *= 1. + lambda;
+			v[j] = -g[j];
+		}
+		double trial[nParameters];
+		copy(par, par + n, trial);
+		if (solve(n, m, v, free))
+			for (unsigned j = 0; j < n; ++j)
+				if (free[j])
+					trial[j] = min(max(par[j] + v[j],
+								lower[j]), upper[j]);
+		double gt[nParameters], at[nParameters * nParameters];
+		const double qt = evaluate(trial, gt, at);
+		if (isfinite(qt) && qt <= q) {
+			copy(trial, trial + n, par);
+			copy(gt, gt + n, g);
+			copy(at, at + n * n, a);
+			q = qt;
+			lambda = max(0.1 * lambda, 1e-12);
+		} else {
+			lambda *= 10.;
+			if (lambda > 1e12)
+				break;
+		}
+	}
+	minimum = evaluate(par, g, a);
+
+	// Fehler: zweite Ableitung aus Differenzen des analytischen
+	// Gradienten, Schrittweite etwa ein Tausendstel des Fehlers
+	bool free[nParameters];
+	for (unsigned j = 0; j < n; ++j)
+		free[j] = !fixed[j] && par[j] > lower[j] && par[j] < upper[j];
+	double h[nParameters * nParameters];
+	fill(h, h + n * n, 0.);
+	for (unsigned j = 0; j < n; ++j) {
+		if (!free[j])
+			continue;
+		const double step = (a[j * n + j] > 0.) ?
+			(1e-3 * sqrt(2. / a[j * n + j])) :
+			(1e-6 * max(fabs(par[j]), 1.));
+		double up[nParameters], down[nParameters];
+		copy(par, par + n, up);
+		copy(par, par + n, down);
+		up[j] = min(par[j] + step, upper[j]);
+		down[j] = max(par[j] - step, lower[j]);
+		double gUp[nParameters], gDown[nParameters];
+		double tmp[nParameters * nParameters];
+		evaluate(up, gUp, tmp);
+		evaluate(down, gDown, tmp);
+		for (unsigned k = 0; k < n; ++k)
+			h[k * n + j] = (gUp[k] - gDown[k]) / (up[j] - down[j]);
+	}
+	for (unsigned j = 0; j < n; ++j)
+		for (unsigned k = 0; k < j; ++k)
+			h[j * n + k] = h[k * n + j] =
+				0.5 * (h[j * n + k] + h[k * n + j]);
+	for (unsigned pass = 0; pass < 2; ++pass) {
+		// falls die zweite Ableitung nicht positiv ist, die
+		// Kruemmungsmatrix
+		const double* const matrix = pass ? a : h;
+		bool ok = true;
+		for (unsigned k = 0; k < n && ok; ++k) {
+			if (!free[k])
+				continue;
+			double m[nParameters * nParameters], v[nParameters];
+			copy(matrix, matrix + n * n, m);
+			fill(v, v + n, 0.);
+			v[k] = 1.;
+			ok = solve(n, m, v, free) && v[k] > 0.;
+			for (unsigned j = 0; j < n; ++j)
+				covariance[j * n + k] = 2. * v[j];
+		}
+		if (ok)
+			break;
+		fill(covariance, covariance + n * n, 0.);
+	}
+	return converged;
+}
+
+// Ausgeben des Ergebnisses
+void fp13UnbinnedFit::print(ostream& os) const
+{
+	static const char* const units[nParameters] = {
+		"1/ns", "1/ns", "ns", "ns", ""
+	};
+	const ios::fmtflags flags = os.flags();
+	const streamsize precision = os.precision();
+	os << "-2 ln L = " << setprecision(10) << minimum <<
+		setprecision(6) << " (" << nDecays << " Zerfaelle in [" <<
+		tmin << ", " << tmax << "] ns, erwartet " << expected(par) <<
+		", " << nIterations << " Schritte, " << nUsedThreads <<
+		" Threads" << (converged ? "" : ", nicht konvergiert") << ")" <<
+		endl;
+	const unsigned n = (CaptureModel == model) ? nParameters :
+		unsigned(CaptureTime);
+	for (unsigned j = 0; j < n; ++j) {
+		os << "  " << left << setw(8) << parameterNames[j] << right <<
+			setw(14) << par[j];
+		if (fixed[j])
+			os << " (fest)";
+		else
+			os << " +- " << setw(12) << getError(j);
+		os << ' ' << units[j] << endl;
+	}
+	os.flags(flags);
+	os.precision(precision);
+}
+
+// Dateiende
@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Kompilierte Fits der Lebensdauer (fp13fit)
+//
+// Lebensdauer.C fittet fitFuncF,
+//
+// 	f(x) = par[0] + par[1] * exp(-x / par[2])
+//
+// (Untergrund, Anzahl der Myonen, Lebensdauer) mit TH1::Fit; ROOT ruft
+// dabei fuer jeden Bin und jeden Schritt von Minuit die interpretierte
+// Funktion ueber ein TF1 auf und leitet numerisch ab. fp13LifetimeFit
+// fittet dasselbe Modell kompiliert:
+//
+// - Chi2: minimiert wird chi^2 = sum ((y - f(x)) / dy)^2 ueber die Bins,
+//   deren Mitte im Fitbereich liegt; leere Bins (dy = 0) zaehlen nicht,
+//   genau wie bei TH1::Fit(f, "", "", xmin, xmax)
+// - Poisson: minimiert wird -2 ln(L / L_sat) = 2 sum (f - y + y ln(y/f))
+//   mit der Poisson-Likelihood L ueber alle Bins im Fitbereich, auch die
+//   leeren (wie TH1::Fit mit Option "L"); am Minimum ist das wie chi^2
+//   verteilt
+//
+// f wird wie bei TH1::Fit in der Binmitte ausgewertet. Minimiert wird mit
+// Levenberg-Marquardt und analytischem Gradienten; Parameter an einer
+// Grenze (setLimits) bleiben dort stehen, solange der Gradient nach
+// draussen zeigt. Die Fehler stammen wie bei Minuit (HESSE) aus der
+// exakten, hier analytischen zweiten Ableitung am Minimum und stimmen
+// mit denen von ROOT ueberein, solange kein Parameter an einer Grenze
+// liegt.
+//
+// Ausgewertet wird in Durchgaengen ueber Felder mit Binmitten und
+// Inhalten ohne Verzweigungen in den Schleifen; die Exponentialfunktion
+// wird einmal pro Bin und Schritt berechnet, Gradient und Kruemmung
+// ergeben sich aus denselben Werten.
+//
+// Aus einem ROOT-Makro kann man den Fit mit ACLiC laden (fp13Fit.cc
+// braucht ausser ROOT nichts):
+//
+// 	.L fp13Fit.cc+
+// 	fp13LifetimeFit fit;
+// 	fit.setData(*hL, 300., 20000.);
+// 	fit.fit();
+// 	fit.print(cout);
+//
+// fitFunction fittet statt hL->Fit(fitFunc, "", "", xmin, xmax) mit den
+// Startwerten und Grenzen aus fitFunc und traegt das Ergebnis wie
+// TH1::Fit in fitFunc und in die Funktionen von hL ein, so dass es
+// gezeichnet wird; Lebensdauer.C benutzt das mit compiledFit = true.
+//
+// fp13UnbinnedFit fittet ungebinnt an die einzelnen Verzoegerungen aus der
+// Tabelle der Kandidaten (fp13 -c), also ohne die 400 ns breiten Bins von
+// a<i> und b<i>. Das Modell ist eine Rate in Zerfaellen pro ns,
+//
+// 	Lebensdauer:	lambda(t) = B + A exp(-t / tau)
+// 	mit Einfang:	lambda(t) = B + A exp(-t / tau)
+// 				(1 + exp(-t / tau_c) / r)
+//
+// (wie fitFuncF in Lebensdauer.C bzw. Einfangzeiten.C, dort pro Bin statt
+// pro ns; r ist das Verhaeltnis von mu+ zu mu-). Minimiert wird die
+// erweiterte Likelihood
+//
+// 	-2 ln L = 2 (mu - sum ln lambda(t_i)),
+//
+// mu ist das Integral von lambda ueber das Fitfenster [tmin, tmax]; nur
+// Zerfaelle im Fitfenster zaehlen, und mu normiert das Modell auf genau
+// dieses Fenster, so dass ein Fenster, das nicht bei 0 anfaengt oder vor
+// dem Abklingen aufhoert, das Ergebnis nicht verzerrt. Die Summe ueber die
+// Zerfaelle wird in Bloecken von je timesPerBlock Zeiten gebildet, die
+// sich die Threads teilen, und die Teilsummen am Ende in fester
+// Reihenfolge addiert; die Bloecke haengen nicht von der Anzahl der
+// Threads ab, das Ergebnis also auch nicht. Zerfaelle mit gleicher Zeit
+// kann man mit einem Gewicht zusammenfassen (add); die Verzoegerungen aus
+// der Kandidatentabelle sind ganze ns, fp13fit fasst sie so zusammen
+// (hoechstens einige 10000 Zeiten, also einige 10 Bloecke).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13FIT_H
+#define FP13FIT_H
+
+// C++ headers
+#include <iostream>
+#include <vector>
+
+// ROOT headers
+#include <TH1.h>
+#include <TF1.h>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13LifetimeFit
+{
+public:
+	// Art des Fits
+	enum Method { Chi2, Poisson };
+	// Parameter (wie par[] in fitFuncF)
+	enum Parameter { Background, NoOfMuons, Lifetime };
+	static const unsigned nParameters = 3;
+	static const char* const parameterNames[nParameters];
+
+	explicit fp13LifetimeFit(Method method = Chi2);
+
+	// das Modell f(x) fuer die Parameter par
+	static double model(double x, const double* par);
+
+	// Fitten an die Bins von h, deren Mitte in [xmin, xmax] liegt
+	// gibt die Anzahl der benutzten Bins zurueck
+	unsigned setData(const TH1& h, double xmin, double xmax);
+	// Fitten an Punkte mit Binmitten x, Inhalten y und Fehlern dy (dy
+	// wird nur fuer Chi2 gebraucht)
+	unsigned setData(const vector<double>& x, const vector<double>& y,
+			const vector<double>& dy);
+
+	// Startwerte und Grenzen der Parameter; Standard wie in
+	// setFitFunction in Lebensdauer.C
+	void setParameters(const double* par);
+	void setParameter(unsigned i, double value);
+	void setLimits(unsigned i, double lower, double upper);
+
+	// Fit ab den aktuellen Parametern, die danach das Ergebnis sind
+	// gibt false zurueck, falls er nicht konvergiert
+	bool fit();
+
+	Method getMethod() const;
+	double getParameter(unsigned i) const;
+	const double* getParameters() const;
+	double getError(unsigned i) const;
+	double getCovariance(unsigned i, unsigned j) const;
+	// chi^2 bzw. -2 ln(L / L_sat) am Minimum und Anzahl der Freiheitsgrade
+	double getMinimum() const;
+	int getNdf() const;
+	unsigned getNoOfBins() const;
+	unsigned getNoOfIterations() const;
+	bool hasConverged() const;
+
+	// Ausgeben des Ergebnisses
+	void print(ostream& os) const;
+
+	// Fit von f (drei Parameter wie fitFuncF) an h wie
+	// h.Fit(&f, "", "", xmin, xmax), Startwerte und Grenzen aus f; das
+	// Ergebnis wird ausgegeben und steht danach in f und in einer Kopie
+	// von f in h.GetListOfFunctions()
+	// gibt false zurueck, falls der Fit nicht konvergiert
+	static bool fitFunction(TH1& h, TF1& f, double xmin, double xmax,
+			Method method = Chi2);
+
+private:
+	// Anzahl der Schritte, nach der aufgegeben wird
+	static const unsigned maxIterations = 500;
+
+	// Auswerten der minimierten Groesse Q fuer die Parameter par, dazu
+	// Gradient, Kruemmungsmatrix fuer die Schritte (positiv definit) und,
+	// falls hessian nicht 0 ist, die exakte zweite Ableitung
+	// gibt unendlich zurueck, falls f fuer Poisson nicht positiv ist
+	double evaluate(const double* par, double* gradient,
+			double* curvature, double* hessian);
+
+	Method method;
+	// Daten: Binmitten, Inhalte und 1/dy^2 bzw. y ln y
+	vector<double> x, y, w;
+	// exp(-x / tau) pro Bin
+	vector<double> ex;
+	double par[nParameters], lower[nParameters], upper[nParameters];
+	double covariance[nParameters * nParameters];
+	double minimum;
+	int ndf;
+	unsigned nIterations;
+	bool converged;
+};
+
+// ungebinnter Fit an einzelne Zerfallszeiten
+class fp13UnbinnedFit
+{
+public:
+	// Modell: Lebensdauer (Lebensdauer.C) oder mit Einfang negativer
+	// Myonen (Einfangzeiten.C)
+	enum Model { LifetimeModel, CaptureModel };
+	// Parameter: Untergrund und Amplitude in 1/ns, Lebensdauer und
+	// Einfangzeit in ns, Verhaeltnis mu+/mu-; die letzten beiden gibt es
+	// nur mit CaptureModel
+	enum Parameter { Background, Amplitude, Lifetime, CaptureTime, Ratio };
+	static const unsigned nParameters = 5;
+	static const char* const parameterNames[nParameters];
+
+	// Fit an Zerfaelle im Fitfenster [tmin, tmax] (in ns) mit nThreads
+	// Threads
+	fp13UnbinnedFit(Model model, double tmin, double tmax,
+			unsigned nThreads = 1);
+
+	// Rate lambda(t) in 1/ns und ihr Integral mu ueber das Fitfenster
+	double rate(double t, const double* par) const;
+	double expected(const double* par) const;
+
+	// Hinzufuegen von weight Zerfaellen zur Zeit t; Zeiten ausserhalb des
+	// Fitfensters werden ignoriert
+	void add(double t, double weight = 1.);
+	// Summe der Gewichte im Fitfenster
+	double getNoOfDecays() const;
+
+	// Startwerte und Grenzen der Parameter; Standard wie in
+	// setFitFunction in Lebensdauer.C bzw. Einfangzeiten.C (also auch
+	// r fest auf 1.275), Untergrund und Amplitude schaetzt fit aus den
+	// Daten, solange beide 0 sind
+	void setParameters(const double* par);
+	void setParameter(unsigned i, double value);
+	void setLimits(unsigned i, double lower, double upper);
+	// Festhalten bzw. Freigeben eines Parameters
+	void fixParameter(unsigned i, double value);
+	void releaseParameter(unsigned i);
+	bool isFixed(unsigned i) const;
+
+	// Fit ab den aktuellen Parametern, die danach das Ergebnis sind
+	// gibt false zurueck, falls er nicht konvergiert
+	bool fit();
+
+	Model getModel() const;
+	double getParameter(unsigned i) const;
+	const double* getParameters() const;
+	double getError(unsigned i) const;
+	double getCovariance(unsigned i, unsigned j) const;
+	// -2 ln L am Minimum
+	double getMinimum() const;
+	unsigned getNoOfIterations() const;
+	bool hasConverged() const;
+	// Anzahl der Threads, die die Summe zuletzt gebildet haben
+	// (hoechstens einer pro Block)
+	unsigned getNoOfUsedThreads() const;
+
+	// Ausgeben des Ergebnisses
+	void print(ostream& os) const;
+
+private:
+	// Anzahl der Schritte, nach der aufgegeben wird
+	static const unsigned maxIterations = 500;
+	// so viele Zeiten hat ein Block; jede kostet einige 10 ns (exp, log
+	// und die Kruemmungsmatrix), ein Block also einige 10 us, mehr als
+	// das Starten eines Threads
+	static const size_t timesPerBlock = 1 << 10;
+
+	// Teilsummen ueber einen Bereich von Zeiten
+	struct Sums {
+		double logL;
+		double gradient[nParameters];
+		double curvature[nParameters * nParameters];
+	};
+	// Bilden der Teilsummen fuer die Zeiten [begin, end)
+	template <bool capture>
+	static void sumRange(const fp13UnbinnedFit* fit, const double* par,
+			size_t begin, size_t end, Sums* sums);
+	// Bilden der Teilsummen der Bloecke k, k + n, k + 2n, ... (ein
+	// Thread)
+	static void sumBlocks(const fp13UnbinnedFit* fit, const double* par,
+			unsigned k, unsigned n, vector<Sums>* sums);
+	// Auswerten von -2 ln L mit Gradient und Kruemmungsmatrix fuer die
+	// Schritte (positiv definit)
+	// gibt unendlich zurueck, falls lambda nicht ueberall positiv ist
+	double evaluate(const double* par, double* gradient,
+			double* curvature);
+	// Startwerte fuer Untergrund und Amplitude aus den Daten
+	void guessParameters();
+
+	Model model;
+	double tmin, tmax;
+	unsigned nThreads, nUsedThreads;
+	// Zeiten und Gewichte
+	vector<double> t, w;
+	double nDecays;
+	double par[nParameters], lower[nParameters], upper[nParameters];
+	bool fixed[nParameters];
+	double covariance[nParameters * nParameters];
+	double minimum;
+	unsigned nIterations;
+	bool converged;
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,380 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Scan des Fitbereichs fuer die Lebensdauer (s. fp13FitScan.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13FitScan.h"
+
+#include <sstream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <TH2.h>
+#include <TParameter.h>
+
+////////////////////////////////////////////////////////////////////////
+// fp13ScanGrid
+////////////////////////////////////////////////////////////////////////
+fp13ScanGrid::fp13ScanGrid(double f, double l, unsigned number) :
+	first(f), last(l), n(number)
+{ }
+
+// Lesen aus "first:last:n"
+bool fp13ScanGrid::parse(const string& spec)
+{
+	istringstream stream(spec);
+	char colon1 = 0, colon2 = 0;
+	double f, l;
+	int number;
+	if (!(stream >> f >> colon1 >> l >> colon2 >> number) ||
+			':' != colon1 || ':' != colon2 || !stream.eof() ||
+			number < 1 || f > l || (number > 1 && f == l))
+		return false;
+	first = f;
+	last = l;
+	n = number;
+	return true;
+}
+
+double fp13ScanGrid::at(unsigned i) const
+{ return (n > 1) ? (first + i * (last - first) / (n - 1)) : first; }
+
+unsigned fp13ScanGrid::nearest(double x) const
+{
+	if (n < 2 || x <= first)
+		return 0;
+	if (x >= last)
+		return n - 1;
+	return unsigned(floor((x - first) / (last - first) * (n - 1) + 0.5));
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13FitRangeScan
+////////////////////////////////////////////////////////////////////////
+// ein Job: die ersten Punkte (row == firstPoints) oder eine Zeile
+struct fp13FitRangeScan::Job {
+	static const unsigned firstPoints = ~0u;
+	fp13FitRangeScan* scan;
+	unsigned row;
+};
+
+// Jobs, die sich die Threads teilen, und der naechste freie
+struct fp13FitRangeScan::JobList {
+	vector<Job> jobs;
+	size_t next;
+	mutex jobMutex;
+};
+
+// Konstruktor
+fp13FitRangeScan::fp13FitRangeScan(fp13LifetimeFit::Method m,
+		const fp13ScanGrid& lo, const fp13ScanGrid& hi) :
+	method(m), xmin(lo), xmax(hi)
+{
+	const fp13LifetimeFit fit(method);
+	copy(fit.getParameters(), fit.getParameters() +
+			fp13LifetimeFit::nParameters, defaults);
+}
+
+// Fit am Punkt (i, j)
+void fp13FitRangeScan::fitPoint(unsigned i, unsigned j, const double* start)
+{
+	Point& point = points[i * xmax.n + j];
+	point.valid = false;
+	point.error = point.chi2 = 0.;
+	point.ndf = 0;
+
+	// Binmitten sind aufsteigend sortiert
+	const size_t begin = lower_bound(centers.begin(), centers.end(),
+			xmin.at(i)) - centers.begin();
+	const size_t end = upper_bound(centers.begin(), centers.end(),
+			xmax.at(j)) - centers.begin();
+	if (end <= begin)
+		return;
+	const vector<double> x(centers.begin() + begin, centers.begin() + end);
+	const vector<double> y(contents.begin() + begin,
+			contents.begin() + end);
+	const vector<double> dy(errors.begin() + begin, errors.begin() + end);
+
+	fp13LifetimeFit fit(method);
+	if (fit.setData(x, y, dy) <= fp13LifetimeFit::nParameters)
+		return;
+	fit.setParameters(start);
+	if (!fit.fit() && !equal(start, start + fp13LifetimeFit::nParameters,
+				defaults)) {
+		// nochmal wie Lebensdauer.C
+		fit.setParameters(defaults);
+		fit.fit();
+	}
+	if (!fit.hasConverged())
+		return;
+	copy(fit.getParameters(), fit.getParameters() +
+			fp13LifetimeFit::nParameters, point.par);
+	point.error = fit.getError(fp13LifetimeFit::Lifetime);
+	point.chi2 = fit.getMinimum();
+	point.ndf = fit.getNdf();
+	// tau an einer Grenze hat keinen Fehler
+	point.valid = point.error > 0.;
+}
+
+unsigned fp13FitRangeScan::firstColumn(unsigned i) const
+{
+	unsigned j = 0;
+	while (j < xmax.n && !(xmin.at(i) < xmax.at(j)))
+		++j;
+	return j;
+}
+
+// Fitten der ersten Punkte, jeder ab dem vorigen
+void fp13FitRangeScan::fitFirstPoints()
+{
+	const double* start = defaults;
+	for (unsigned i = 0; i < xmin.n; ++i) {
+		const unsigned j = firstColumn(i);
+		if (j >= xmax.n)
+			continue;
+		fitPoint(i, j, start);
+		if (points[i * xmax.n + j].valid)
+			start = points[i * xmax.n + j].par;
+	}
+}
+
+// Fitten der Zeile i
+void fp13FitRangeScan::fitRow(unsigned i)
+{
+	const unsigned first = firstColumn(i);
+	if (first >= xmax.n)
+		return;
+	const double* start = points[i * xmax.n + first].valid ?
+		points[i * xmax.n + first].par : defaults;
+	for (unsigned j = first + 1; j < xmax.n; ++j) {
+		fitPoint(i, j, start);
+		const Point& point = points[i * xmax.n + j];
+		if (point.valid)
+			start = point.par;
+	}
+}
+
+// Schleife eines Threads
+void fp13FitRangeScan::workerLoop(JobList* jobs)
+{
+	for (;;) {
+		Job job;
+		{
+			lock_guard<mutex> lock(jobs->jobMutex);
+			if (jobs->next == jobs->jobs.size())
+				return;
+			job = jobs->jobs[jobs->next++];
+		}
+		if (Job::firstPoints == job.row)
+			job.scan->fitFirstPoints();
+		else
+			job.scan->fitRow(job.row);
+	}
+}
+
+// Abarbeiten der Jobs
+void fp13FitRangeScan::runJobs(JobList& jobs, unsigned nThreads)
+{
+	jobs.next = 0;
+	if (nThreads < 1)
+		nThreads = 1;
+	if (nThreads > jobs.jobs.size())
+		nThreads = jobs.jobs.size();
+	vector<thread> threads;
+	for (unsigned k = 1; k < nThreads; ++k)
+		threads.push_back(thread(workerLoop, &jobs));
+	workerLoop(&jobs);
+	for (size_t k = 0; k < threads.size(); ++k)
+		threads[k].join();
+}
+
+// Scan fuer ein Histogramm
+void fp13FitRangeScan::scan(const TH1& h, unsigned nThreads)
+{
+	scan(vector<fp13FitRangeScan*>(1, this),
+			vector<const TH1*>(1, &h), nThreads);
+}
+
+// Scan fuer mehrere Histogramme
+void fp13FitRangeScan::scan(const vector<fp13FitRangeScan*>& scans,
+		const vector<const TH1*>& histograms, unsigned nThreads)
+{
+	JobList jobs;
+	// erst die ersten Punkte, ein Job pro Histogramm
+	for (size_t k = 0; k < scans.size(); ++k) {
+		scans[k]->setData(*histograms[k]);
+		const Job job = { scans[k], Job::firstPoints };
+		jobs.jobs.push_back(job);
+	}
+	runJobs(jobs, nThreads);
+
+	// dann alle Zeilen, die mehr als einen Punkt haben
+	jobs.jobs.clear();
+	for (size_t k = 0; k < scans.size(); ++k) {
+		for (unsigned i = 0; i < scans[k]->xmin.n; ++i) {
+			if (scans[k]->firstColumn(i) + 1 >= scans[k]->xmax.n)
+				continue;
+			const Job job = { scans[k], i };
+			jobs.jobs.push_back(job);
+		}
+	}
+	runJobs(jobs, nThreads);
+}
+
+// Lesen der Bins
+void fp13FitRangeScan::setData(const TH1& h)
+{
+	centers.clear();
+	contents.clear();
+	errors.clear();
+	for (int bin = 1; bin <= h.GetNbinsX(); ++bin) {
+		centers.push_back(h.GetXaxis()->GetBinCenter(bin));
+		contents.push_back(h.GetBinContent(bin));
+		errors.push_back(h.GetBinError(bin));
+	}
+	Point empty;
+	fill(empty.par, empty.par + fp13LifetimeFit::nParameters, 0.);
+	empty.error = empty.chi2 = 0.;
+	empty.ndf = 0;
+	empty.valid = false;
+	points.assign(xmin.n * xmax.n, empty);
+}
+
+bool fp13FitRangeScan::hasResult(unsigned i, unsigned j) const
+{ return points[i * xmax.n + j].valid; }
+
+double fp13FitRangeScan::getLifetime(unsigned i, unsigned j) const
+{ return points[i * xmax.n + j].par[fp13LifetimeFit::Lifetime]; }
+
+double fp13FitRangeScan::getError(unsigned i, unsigned j) const
+{ return points[i * xmax.n + j].error; }
+
+double fp13FitRangeScan::getChi2PerNdf(unsigned i, unsigned j) const
+{
+	const Point& point = points[i * xmax.n + j];
+	return (point.ndf > 0) ? (point.chi2 / point.ndf) : 0.;
+}
+
+// Zusammenfassung
+fp13FitRangeScan::Summary fp13FitRangeScan::summarize(double x1,
+		double x2) const
+{
+	const double nan = numeric_limits<double>::quiet_NaN();
+	Summary s;
+	s.iRef = xmin.nearest(x1);
+	s.jRef = xmax.nearest(x2);
+	const Point& ref = points[s.iRef * xmax.n + s.jRef];
+	s.tauRef = ref.valid ? ref.par[fp13LifetimeFit::Lifetime] : nan;
+	s.tauRefError = ref.valid ? ref.error : nan;
+	s.tauMean = s.tauRMS = s.tauMin = s.tauMax = s.maxDeviation = nan;
+	s.nPoints = s.nFailed = s.nNested = 0;
+
+	double sum = 0., sum2 = 0.;
+	for (unsigned i = 0; i < xmin.n; ++i) {
+		for (unsigned j = firstColumn(i); j < xmax.n; ++j) {
+			++s.nPoints;
+			const Point& point = points[i * xmax.n + j];
+			if (!point.valid) {
+				++s.nFailed;
+				continue;
+			}
+			const double tau = point.par[fp13LifetimeFit::Lifetime];
+			sum += tau;
+			sum2 += tau * tau;
+			// Minimum und Maximum sind anfangs NaN, der erste Punkt
+			// setzt sie
+			if (!(tau >= s.tauMin))
+				s.tauMin = tau;
+			if (!(tau <= s.tauMax))
+				s.tauMax = tau;
+			// Abweichung vom Bezug nach Barlow, nur fuer
+			// ineinanderliegende Fitbereiche; die Gitter sind
+			// aufsteigend, die Indizes genuegen also
+			const bool nested = (i <= s.iRef && j >= s.jRef) ||
+				(i >= s.iRef && j <= s.jRef);
+			if (!ref.valid || !nested ||
+					(i == s.iRef && j == s.jRef))
+				continue;
+			++s.nNested;
+			const double var = fabs(point.error * point.error -
+					s.tauRefError * s.tauRefError);
+			if (var > 0.) {
+				const double deviation = fabs(tau - s.tauRef) /
+					sqrt(var);
+				if (!(deviation <= s.maxDeviation))
+					s.maxDeviation = deviation;
+			}
+		}
+	}
+	const unsigned n = s.nPoints - s.nFailed;
+	if (n > 0) {
+		s.tauMean = sum / n;
+		s.tauRMS = sqrt(max(sum2 / n - s.tauMean * s.tauMean, 0.));
+	}
+	return s;
+}
+
+// Schreiben der Karten und der Zusammenfassung
+void fp13FitRangeScan::write(TDirectory* dir, const Summary& s) const
+{
+	// die Bins liegen um die Gitterpunkte
+	const double dx = (xmin.n > 1) ? ((xmin.last - xmin.first) /
+			(xmin.n - 1)) : 1.;
+	const double dy = (xmax.n > 1) ? ((xmax.last - xmax.first) /
+			(xmax.n - 1)) : 1.;
+	TH2D* tau = new TH2D("tau", "Lebensdauer;xmin [ns];xmax [ns]",
+			xmin.n, xmin.first - 0.5 * dx, xmin.last + 0.5 * dx,
+			xmax.n, xmax.first - 0.5 * dy, xmax.last + 0.5 * dy);
+	TH2D* chi2ndf = new TH2D("chi2ndf", "Q / ndf;xmin [ns];xmax [ns]",
+			xmin.n, xmin.first - 0.5 * dx, xmin.last + 0.5 * dx,
+			xmax.n, xmax.first - 0.5 * dy, xmax.last + 0.5 * dy);
+	for (unsigned i = 0; i < xmin.n; ++i) {
+		for (unsigned j = 0; j < xmax.n; ++j) {
+			if (!hasResult(i, j))
+				continue;
+			tau->SetBinContent(i + 1, j + 1, getLifetime(i, j));
+			tau->SetBinError(i + 1, j + 1, getError(i, j));
+			chi2ndf->SetBinContent(i + 1, j + 1, getChi2PerNdf(i, j));
+		}
+	}
+	tau->SetDirectory(dir);
+	chi2ndf->SetDirectory(dir);
+
+	dir->Append(new TParameter<double>("xminRef", xmin.at(s.iRef)));
+	dir->Append(new TParameter<double>("xmaxRef", xmax.at(s.jRef)));
+	dir->Append(new TParameter<double>("tauRef", s.tauRef));
+	dir->Append(new TParameter<double>("tauRefError", s.tauRefError));
+	dir->Append(new TParameter<double>("tauMean", s.tauMean));
+	dir->Append(new TParameter<double>("tauRMS", s.tauRMS));
+	dir->Append(new TParameter<double>("tauMin", s.tauMin));
+	dir->Append(new TParameter<double>("tauMax", s.tauMax));
+	dir->Append(new TParameter<double>("maxDeviation", s.maxDeviation));
+	dir->Append(new TParameter<int>("nPoints", s.nPoints));
+	dir->Append(new TParameter<int>("nFailed", s.nFailed));
+	dir->Append(new TParameter<int>("nNested", s.nNested));
+}
+
+// Ausgeben der Zusammenfassung
+void fp13FitRangeScan::print(ostream& os, const Summary& s) const
+{
+	const streamsize precision = os.precision();
+	os << setprecision(6) << xmin.n << " x " << xmax.n <<
+		" Fitbereiche, " << s.nPoints << " mit xmin < xmax, davon " <<
+		s.nFailed << " ohne Ergebnis" << endl;
+	os << "  Bezug " << xmin.at(s.iRef) << " ns bis " << xmax.at(s.jRef) <<
+		" ns: tau_0 = " << s.tauRef << " +- " << s.tauRefError <<
+		" ns" << endl;
+	os << "  tau_0 im Mittel " << s.tauMean << " ns, RMS " << s.tauRMS <<
+		" ns, von " << s.tauMin << " ns bis " << s.tauMax << " ns" <<
+		endl;
+	os << "  groesste Abweichung vom Bezug " << s.maxDeviation <<
+		" sigma (nach Barlow, " << s.nNested <<
+		" ineinanderliegende Fitbereiche)" << endl;
+	os.precision(precision);
+}
+
+// Dateiende
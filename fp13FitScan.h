@@ -0,0 +1,160 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Scan des Fitbereichs fuer die Lebensdauer (fp13fit -s)
+//
+// Wie stark haengt tau von xmin und xmax ab? Statt Lebensdauer.C von
+// Hand fuer jeden Fitbereich aufzurufen, fittet fp13FitRangeScan
+// fitFuncF (mit fp13LifetimeFit) fuer jeden Punkt eines Gitters von
+// Fitbereichen (xmin, xmax) an ein Histogramm:
+//
+// - die Bins werden einmal aus dem Histogramm gelesen, jeder Fit nimmt
+//   die, deren Mitte im Fitbereich liegt (wie fp13LifetimeFit::setData)
+// - jeder Fit startet beim Ergebnis des Nachbarpunktes: zuerst werden
+//   nacheinander die ersten Punkte aller Zeilen (gleiches xmin, kleinstes
+//   sinnvolles xmax) gefittet, dann die Zeilen parallel, jede von kleinem
+//   zu grossem xmax; konvergiert ein Fit von dort aus nicht, wird er mit
+//   den Startwerten aus Lebensdauer.C wiederholt. Die Reihenfolge haengt
+//   nicht von der Anzahl der Threads ab, das Ergebnis also auch nicht
+// - mehrere Histogramme (z.B. ho, hu und hL) scannt das statische scan
+//   zusammen: die Threads teilen sich erst die ersten Punkte (ein
+//   Histogramm pro Thread), dann die Zeilen aller Histogramme, so dass
+//   bis zu (Anzahl der Histogramme) x (Werte von xmin) Threads zu tun
+//   haben
+// - Punkte mit xmin >= xmax, zu wenigen Bins, ohne Konvergenz oder mit tau
+//   an einer Grenze haben kein Ergebnis
+//
+// Als Mass fuer die Stabilitaet vergleicht summarize jeden Punkt mit
+// einem Bezugspunkt (dem Fitbereich von fp13fit -r): Mittelwert, RMS,
+// Minimum und Maximum von tau und die groesste Abweichung vom Bezug in
+// Einheiten von sqrt(|sigma^2 - sigma_ref^2|). Das ist nach Barlow der
+// Fehler der Differenz, aber nur, wenn ein Fitbereich den anderen
+// enthaelt (der kleinere ist dann eine Teilmenge der Zerfaelle des
+// groesseren); die Abweichung zaehlt deshalb nur fuer diese Punkte
+// (nNested), Punkte mit z.B. xmin und xmax ueber denen des Bezugs gehen
+// nur in Mittelwert, RMS, Minimum und Maximum ein. Abweichungen deutlich
+// ueber 2 sprechen fuer eine Abhaengigkeit vom Fitbereich, nicht fuer
+// Statistik.
+//
+// write legt in einem Verzeichnis der Ausgabedatei die TH2D "tau"
+// (Fehler sigma_tau) und "chi2ndf" (Q / ndf) mit xmin auf der x- und
+// xmax auf der y-Achse an, Punkte ohne Ergebnis sind 0, dazu die
+// Zusammenfassung als TParameter<double> "xminRef", "xmaxRef",
+// "tauRef", "tauRefError", "tauMean", "tauRMS", "tauMin", "tauMax",
+// "maxDeviation" und TParameter<int> "nPoints", "nFailed", "nNested".
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13FITSCAN_H
+#define FP13FITSCAN_H
+
+// C++ headers
+#include <iostream>
+#include <string>
+#include <vector>
+
+// ROOT headers
+#include <TH1.h>
+#include <TDirectory.h>
+
+#include "fp13Fit.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+// eine Achse des Gitters: n Werte von first bis last
+struct fp13ScanGrid
+{
+	double first, last;
+	unsigned n;
+
+	fp13ScanGrid(double first = 0., double last = 0., unsigned n = 1);
+
+	// Lesen aus "first:last:n"
+	// gibt false zurueck, falls spec nicht so aussieht
+	bool parse(const string& spec);
+	// i-ter Wert
+	double at(unsigned i) const;
+	// Index des Werts, der x am naechsten liegt
+	unsigned nearest(double x) const;
+};
+
+class fp13FitRangeScan
+{
+public:
+	// Zusammenfassung (s. oben)
+	struct Summary {
+		unsigned iRef, jRef;
+		double tauRef, tauRefError;
+		double tauMean, tauRMS, tauMin, tauMax;
+		// nur ueber die Punkte mit Ergebnis, deren Fitbereich den
+		// Bezug enthaelt oder in ihm liegt (ohne den Bezug selbst)
+		double maxDeviation;
+		unsigned nPoints, nFailed, nNested;
+	};
+
+	fp13FitRangeScan(fp13LifetimeFit::Method method,
+			const fp13ScanGrid& xmin, const fp13ScanGrid& xmax);
+
+	// Scan fuer das Histogramm h mit nThreads Threads
+	void scan(const TH1& h, unsigned nThreads);
+	// Scan von scans[k] fuer histograms[k], alle zusammen mit nThreads
+	// Threads
+	static void scan(const vector<fp13FitRangeScan*>& scans,
+			const vector<const TH1*>& histograms, unsigned nThreads);
+
+	// Ergebnis am Punkt (xmin.at(i), xmax.at(j))
+	bool hasResult(unsigned i, unsigned j) const;
+	double getLifetime(unsigned i, unsigned j) const;
+	double getError(unsigned i, unsigned j) const;
+	// Q / ndf (s. fp13LifetimeFit::getMinimum)
+	double getChi2PerNdf(unsigned i, unsigned j) const;
+
+	// Zusammenfassung mit dem Gitterpunkt als Bezug, der (xmin, xmax)
+	// am naechsten liegt
+	Summary summarize(double xmin, double xmax) const;
+	// Schreiben der Karten und der Zusammenfassung nach dir
+	void write(TDirectory* dir, const Summary& summary) const;
+	// Ausgeben der Zusammenfassung
+	void print(ostream& os, const Summary& summary) const;
+
+private:
+	// Ergebnis eines Punktes
+	struct Point {
+		double par[fp13LifetimeFit::nParameters];
+		double error, chi2;
+		int ndf;
+		bool valid;
+	};
+
+	// Arbeit fuer die Threads (s. fp13FitScan.cc)
+	struct Job;
+	struct JobList;
+
+	// Lesen der Bins aus h, alle Punkte ohne Ergebnis
+	void setData(const TH1& h);
+	// Fit am Punkt (i, j) ab den Parametern start
+	void fitPoint(unsigned i, unsigned j, const double* start);
+	// erster Punkt der Zeile i mit xmin < xmax (xmax.n, falls keiner)
+	unsigned firstColumn(unsigned i) const;
+	// Fitten der ersten Punkte aller Zeilen, nacheinander
+	void fitFirstPoints();
+	// Fitten der Zeile i ab ihrem ersten Punkt
+	void fitRow(unsigned i);
+	// Abarbeiten der Jobs mit nThreads Threads
+	static void runJobs(JobList& jobs, unsigned nThreads);
+	// Schleife eines Threads: holt Jobs, bis keiner mehr da ist
+	static void workerLoop(JobList* jobs);
+
+	fp13LifetimeFit::Method method;
+	fp13ScanGrid xmin, xmax;
+	// Binmitten, Inhalte und Fehler des Histogramms
+	vector<double> centers, contents, errors;
+	// Ergebnisse, Punkt (i, j) an der Stelle i * xmax.n + j
+	vector<Point> points;
+	// Startwerte aus Lebensdauer.C
+	double defaults[fp13LifetimeFit::nParameters];
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,550 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Bitmap-Index der eventFlags und lastMuonLayer (s. fp13FlagIndex.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13FlagIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <sstream>
+
+#include "fp13Input.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// Hilfsfunktionen zum Kodieren und Dekodieren
+////////////////////////////////////////////////////////////////////////
+// Schreiben und Lesen von Zahlen mit 8 Bytes, little endian
+static inline void putU64(unsigned char* p, uint64_t value)
+{
+	for (unsigned i = 0; i < 8; ++i)
+		p[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+static inline uint64_t getU64(const unsigned char* p)
+{
+	uint64_t value = 0;
+	for (unsigned i = 0; i < 8; ++i)
+		value |= static_cast<uint64_t>(p[i]) << (8 * i);
+	return value;
+}
+
+// varint wie im Binaerformat (s. fp13Binary.h)
+static inline void putVarint(vector<unsigned char>& buf,
+		unsigned long long value)
+{
+	while (value >= 0x80) {
+		buf.push_back(static_cast<unsigned char>(value | 0x80));
+		value >>= 7;
+	}
+	buf.push_back(static_cast<unsigned char>(value));
+}
+
+static inline bool getVarint(const unsigned char*& p,
+		const unsigned char* end, unsigned long long& value)
+{
+	value = 0;
+	for (unsigned shift = 0; shift < 64 && p != end; shift += 7) {
+		unsigned char byte = *p++;
+		value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// Lauflaengenkodierung einer Bitmap, Wort fuer Wort
+//
+// Jede Gruppe in out besteht aus einer Folge gleicher Fuellworte (0 oder
+// alle Bits 1, auch keine) und den Worten bis zum naechsten Fuellwort.
+class fp13BitmapEncoder
+{
+public:
+	fp13BitmapEncoder(vector<unsigned char>& buf) :
+		out(buf), fill(0), nFill(0)
+	{ }
+
+	// Anhaengen von n Worten word
+	void put(uint64_t word, size_t n = 1)
+	{
+		if (!n)
+			return;
+		if (0 != word && ones != word) {
+			literals.insert(literals.end(), n, word);
+			return;
+		}
+		// ein Fuellwort beendet die Gruppe, wenn Worte dazwischen
+		// lagen oder die bisherigen Fuellworte anders sind
+		if (!literals.empty() || (nFill && word != fill))
+			flush();
+		fill = word;
+		nFill += n;
+	}
+
+	// Schreiben der letzten Gruppe
+	void finish()
+	{
+		if (nFill || !literals.empty())
+			flush();
+	}
+
+private:
+	static const uint64_t ones = ~static_cast<uint64_t>(0);
+
+	vector<unsigned char>& out;
+	uint64_t fill;
+	size_t nFill;
+	vector<uint64_t> literals;
+
+	void flush()
+	{
+		putVarint(out, (static_cast<unsigned long long>(nFill) << 1) |
+				(fill & 1));
+		putVarint(out, literals.size());
+		for (size_t i = 0; i < literals.size(); ++i) {
+			unsigned char buf[8];
+			putU64(buf, literals[i]);
+			out.insert(out.end(), buf, buf + 8);
+		}
+		fill = 0;
+		nFill = 0;
+		literals.clear();
+	}
+};
+
+// Lauflaengenkodierung der Bitmap words nach out
+static void encodeBitmap(const vector<uint64_t>& words,
+		vector<unsigned char>& out)
+{
+	fp13BitmapEncoder encoder(out);
+	for (size_t i = 0; i < words.size(); ++i)
+		encoder.put(words[i]);
+	encoder.finish();
+}
+
+// Dekodieren der Bitmap [p, end) in nWords Worte
+static bool decodeBitmap(const unsigned char* p, const unsigned char* end,
+		size_t nWords, vector<uint64_t>& words)
+{
+	words.assign(nWords, 0);
+	size_t i = 0;
+	while (p != end) {
+		unsigned long long marker, nLiteral;
+		if (!getVarint(p, end, marker) || !getVarint(p, end, nLiteral))
+			return false;
+		const unsigned long long nFill = marker >> 1;
+		if (nFill > nWords - i || nLiteral > nWords - i - nFill ||
+				nLiteral > static_cast<size_t>(end - p) / 8)
+			return false;
+		if (marker & 1)
+			fill(words.begin() + i, words.begin() + i + nFill,
+					~static_cast<uint64_t>(0));
+		i += nFill;
+		for (unsigned long long k = 0; k < nLiteral; ++k, p += 8)
+			words[i++] = getU64(p);
+	}
+	return i == nWords;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13FlagIndexFormat
+////////////////////////////////////////////////////////////////////////
+const char fp13FlagIndexFormat::magic[8] =
+	{ '\x89', 'F', 'P', '1', '3', 'F', 'X', '\n' };
+
+unsigned fp13FlagIndexFormat::noOfBitmaps(int nLayers)
+{ return Layer + nLayers; }
+
+string fp13FlagIndexFormat::getName(unsigned bitmap)
+{
+	static const char* names[] = { "analyzed", "muon", "decayDown",
+		"decayUp", "afterpulseSimple", "afterpulseImproved" };
+	if (bitmap < Layer)
+		return names[bitmap];
+	ostringstream name;
+	name << "layer" << (bitmap - Layer);
+	return name.str();
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13FlagIndexWriter
+////////////////////////////////////////////////////////////////////////
+fp13FlagIndexWriter::fp13FlagIndexWriter(const string& name, int layers) :
+	fileName(name), nLayers(layers),
+	out(name.c_str(), ios::out | ios::binary | ios::trunc),
+	nEvents(0),
+	counts(fp13FlagIndexFormat::noOfBitmaps(layers), 0),
+	nAnalyzed(0)
+{ }
+
+bool fp13FlagIndexWriter::isOpen() const
+{ return out.is_open() && out.good(); }
+
+const string& fp13FlagIndexWriter::getFileName() const
+{ return fileName; }
+
+unsigned long fp13FlagIndexWriter::getNoOfAnalyzedEvents() const
+{ return nAnalyzed; }
+
+void fp13FlagIndexWriter::add(unsigned long firstEvent,
+		vector<uint16_t>& codes)
+{
+	if (codes.empty())
+		return;
+
+	// die Bitmaps ueber die Worte des Abschnitts ungepackt aufbauen...
+	const unsigned nBitmaps = fp13FlagIndexFormat::noOfBitmaps(nLayers);
+	const unsigned long lastEvent = firstEvent + codes.size() - 1;
+	Segment segment;
+	segment.firstWord = firstEvent / 64;
+	segment.nWords = lastEvent / 64 - segment.firstWord + 1;
+	vector<vector<uint64_t> > bitmaps(nBitmaps,
+			vector<uint64_t>(segment.nWords, 0));
+	vector<unsigned long long> segmentCounts(nBitmaps, 0);
+	for (size_t i = 0; i < codes.size(); ++i) {
+		const unsigned long event = firstEvent + i;
+		const uint64_t bit = static_cast<uint64_t>(1) << (event % 64);
+		const size_t word = event / 64 - segment.firstWord;
+		const unsigned code = codes[i];
+		bitmaps[fp13FlagIndexFormat::Analyzed][word] |= bit;
+		++segmentCounts[fp13FlagIndexFormat::Analyzed];
+		const int layer = static_cast<int>((code >> 4) & 0x3f) - 1;
+		if (layer >= 0 && layer < nLayers) {
+			const unsigned b = fp13FlagIndexFormat::Layer + layer;
+			bitmaps[fp13FlagIndexFormat::Muon][word] |= bit;
+			++segmentCounts[fp13FlagIndexFormat::Muon];
+			bitmaps[b][word] |= bit;
+			++segmentCounts[b];
+		}
+		for (unsigned k = 0; k < 4; ++k) {
+			if (!(code & (1 << k)))
+				continue;
+			const unsigned b = fp13FlagIndexFormat::DecayDown + k;
+			bitmaps[b][word] |= bit;
+			++segmentCounts[b];
+		}
+	}
+	const size_t nCodes = codes.size();
+	vector<uint16_t>().swap(codes);
+
+	// ... und gleich packen
+	for (unsigned b = 0; b < nBitmaps; ++b) {
+		segment.offsets.push_back(segment.data.size());
+		encodeBitmap(bitmaps[b], segment.data);
+	}
+	segment.offsets.push_back(segment.data.size());
+	vector<unsigned char>(segment.data).swap(segment.data);
+
+	lock_guard<mutex> lock(addMutex);
+	segments.push_back(Segment());
+	segments.back().firstWord = segment.firstWord;
+	segments.back().nWords = segment.nWords;
+	segments.back().offsets.swap(segment.offsets);
+	segments.back().data.swap(segment.data);
+	nEvents = max(nEvents, lastEvent + 1);
+	for (unsigned b = 0; b < nBitmaps; ++b)
+		counts[b] += segmentCounts[b];
+	nAnalyzed += nCodes;
+}
+
+bool fp13FlagIndexWriter::write()
+{
+	lock_guard<mutex> lock(addMutex);
+	if (!out.is_open())
+		return false;
+
+	// Dateikopf
+	const unsigned nBitmaps = fp13FlagIndexFormat::noOfBitmaps(nLayers);
+	unsigned char header[fp13FlagIndexFormat::headerSize];
+	memset(header, 0, sizeof(header));
+	memcpy(header, fp13FlagIndexFormat::magic,
+			sizeof(fp13FlagIndexFormat::magic));
+	header[8] = fp13FlagIndexFormat::version & 0xff;
+	header[9] = fp13FlagIndexFormat::version >> 8;
+	header[10] = nLayers;
+	header[11] = nBitmaps;
+	putU64(header + 16, nEvents);
+	out.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+	// die Abschnitte koennen in beliebiger Reihenfolge gekommen sein
+	stable_sort(segments.begin(), segments.end());
+
+	// jede Bitmap aus den Abschnitten zusammensetzen: Worte vor dem
+	// Anfang eines Abschnitts aendern sich nicht mehr und werden
+	// weitergegeben, die restlichen warten in pending (ab Wort next)
+	const size_t nWords = (nEvents + 63) / 64;
+	vector<unsigned char> buf;
+	vector<uint64_t> words, pending;
+	for (unsigned b = 0; b < nBitmaps; ++b) {
+		buf.assign(fp13FlagIndexFormat::bitmapHeaderSize, 0);
+		fp13BitmapEncoder encoder(buf);
+		size_t next = 0;
+		pending.clear();
+		for (size_t s = 0; s < segments.size(); ++s) {
+			const Segment& segment = segments[s];
+			decodeBitmap(&segment.data[segment.offsets[b]],
+					&segment.data[0] +
+					segment.offsets[b + 1],
+					segment.nWords, words);
+			const size_t nDone = min(pending.size(),
+					segment.firstWord - next);
+			for (size_t i = 0; i < nDone; ++i)
+				encoder.put(pending[i]);
+			pending.erase(pending.begin(), pending.begin() + nDone);
+			// Luecke (nicht analysierte Ereignisse)
+			encoder.put(0, segment.firstWord - next - nDone);
+			next = segment.firstWord;
+			if (pending.size() < words.size())
+				pending.resize(words.size(), 0);
+			for (size_t i = 0; i < words.size(); ++i)
+				pending[i] |= words[i];
+		}
+		for (size_t i = 0; i < pending.size(); ++i)
+			encoder.put(pending[i]);
+		encoder.put(0, nWords - next - pending.size());
+		encoder.finish();
+
+		putU64(&buf[0], counts[b]);
+		putU64(&buf[8], buf.size() -
+				fp13FlagIndexFormat::bitmapHeaderSize);
+		out.write(reinterpret_cast<const char*>(&buf[0]), buf.size());
+	}
+	segments.clear();
+	out.close();
+	return !out.fail();
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13FlagIndex
+////////////////////////////////////////////////////////////////////////
+fp13FlagIndex::fp13FlagIndex(const string& name) :
+	fileName(name), file(new fp13MappedFile(name)), nLayers(0),
+	nEvents(0)
+{
+	if (!file->isOpen()) {
+		error << "Fehler beim Oeffnen der Datei " << fileName << "." <<
+			endl;
+		delete file;
+		file = 0;
+		return;
+	}
+	const unsigned char* p =
+		reinterpret_cast<const unsigned char*>(file->begin());
+	const unsigned char* end =
+		reinterpret_cast<const unsigned char*>(file->end());
+
+	// Dateikopf pruefen
+	if (end - p < fp13FlagIndexFormat::headerSize ||
+			0 != memcmp(p, fp13FlagIndexFormat::magic,
+				sizeof(fp13FlagIndexFormat::magic))) {
+		error << fileName << " ist kein Flag-Index." << endl;
+		delete file;
+		file = 0;
+		return;
+	}
+	const unsigned version = p[8] | (p[9] << 8);
+	if (fp13FlagIndexFormat::version != version) {
+		error << "Version " << version << " des Flag-Index in " <<
+			fileName << " wird nicht unterstuetzt." << endl;
+		delete file;
+		file = 0;
+		return;
+	}
+	nLayers = p[10];
+	const unsigned nBitmaps = p[11];
+	nEvents = getU64(p + 16);
+	p += fp13FlagIndexFormat::headerSize;
+
+	// Bitmaps suchen
+	const unsigned headerSize = fp13FlagIndexFormat::bitmapHeaderSize;
+	for (unsigned b = 0; b < nBitmaps; ++b) {
+		if (end - p < headerSize ||
+				static_cast<size_t>(end - p - headerSize) <
+				getU64(p + 8))
+			break;
+		counts.push_back(getU64(p));
+		bitmapBegin.push_back(p + headerSize);
+		p += headerSize + getU64(p + 8);
+		bitmapEnd.push_back(p);
+	}
+	if (nBitmaps != fp13FlagIndexFormat::noOfBitmaps(nLayers) ||
+			counts.size() != nBitmaps) {
+		error << fileName << " ist abgeschnitten oder fehlerhaft." <<
+			endl;
+		delete file;
+		file = 0;
+	}
+}
+
+fp13FlagIndex::~fp13FlagIndex()
+{ delete file; }
+
+bool fp13FlagIndex::isOpen() const
+{ return 0 != file; }
+
+int fp13FlagIndex::getNoOfLayers() const
+{ return nLayers; }
+
+unsigned long fp13FlagIndex::getNoOfEvents() const
+{ return nEvents; }
+
+size_t fp13FlagIndex::getNoOfWords() const
+{ return (nEvents + 63) / 64; }
+
+unsigned fp13FlagIndex::getNoOfBitmaps() const
+{ return counts.size(); }
+
+unsigned long long fp13FlagIndex::getCount(unsigned bitmap) const
+{ return counts[bitmap]; }
+
+int fp13FlagIndex::find(const string& name) const
+{
+	for (unsigned b = 0; b < counts.size(); ++b)
+		if (fp13FlagIndexFormat::getName(b) == name)
+			return b;
+	return -1;
+}
+
+bool fp13FlagIndex::readBitmap(unsigned bitmap, vector<uint64_t>& words) const
+{
+	if (decodeBitmap(bitmapBegin[bitmap], bitmapEnd[bitmap],
+				getNoOfWords(), words))
+		return true;
+	error << "Bitmap " << fp13FlagIndexFormat::getName(bitmap) <<
+		" in " << fileName << " ist fehlerhaft." << endl;
+	return false;
+}
+
+// Auswahl von Ereignissen
+bool fp13FlagIndex::select(const string& expression,
+		vector<uint64_t>& words) const
+{
+	size_t pos = 0;
+	if (!parseOr(expression, pos, words))
+		return false;
+	while (pos < expression.size() && isspace(expression[pos]))
+		++pos;
+	if (pos != expression.size()) {
+		error << "Unerwartetes Zeichen an Position " << pos <<
+			" in \"" << expression << "\"." << endl;
+		return false;
+	}
+	// nur analysierte Ereignisse (wichtig nach "!")
+	vector<uint64_t> analyzed;
+	if (!readBitmap(fp13FlagIndexFormat::Analyzed, analyzed))
+		return false;
+	for (size_t i = 0; i < words.size(); ++i)
+		words[i] &= analyzed[i];
+	return true;
+}
+
+// Teilausdruck a | b | ...
+bool fp13FlagIndex::parseOr(const string& expression, size_t& pos,
+		vector<uint64_t>& words) const
+{
+	if (!parseAnd(expression, pos, words))
+		return false;
+	vector<uint64_t> other;
+	for (;;) {
+		while (pos < expression.size() && isspace(expression[pos]))
+			++pos;
+		if (pos == expression.size() || '|' != expression[pos])
+			return true;
+		++pos;
+		if (!parseAnd(expression, pos, other))
+			return false;
+		for (size_t i = 0; i < words.size(); ++i)
+			words[i] |= other[i];
+	}
+}
+
+// Teilausdruck a & b & ...
+bool fp13FlagIndex::parseAnd(const string& expression, size_t& pos,
+		vector<uint64_t>& words) const
+{
+	if (!parseTerm(expression, pos, words))
+		return false;
+	vector<uint64_t> other;
+	for (;;) {
+		while (pos < expression.size() && isspace(expression[pos]))
+			++pos;
+		if (pos == expression.size() || '&' != expression[pos])
+			return true;
+		++pos;
+		if (!parseTerm(expression, pos, other))
+			return false;
+		for (size_t i = 0; i < words.size(); ++i)
+			words[i] &= other[i];
+	}
+}
+
+// Name, !Term oder (Ausdruck)
+bool fp13FlagIndex::parseTerm(const string& expression, size_t& pos,
+		vector<uint64_t>& words) const
+{
+	while (pos < expression.size() && isspace(expression[pos]))
+		++pos;
+	if (pos == expression.size()) {
+		error << "Unerwartetes Ende von \"" << expression << "\"." <<
+			endl;
+		return false;
+	}
+	if ('!' == expression[pos]) {
+		++pos;
+		if (!parseTerm(expression, pos, words))
+			return false;
+		for (size_t i = 0; i < words.size(); ++i)
+			words[i] = ~words[i];
+		return true;
+	}
+	if ('(' == expression[pos]) {
+		++pos;
+		if (!parseOr(expression, pos, words))
+			return false;
+		while (pos < expression.size() && isspace(expression[pos]))
+			++pos;
+		if (pos == expression.size() || ')' != expression[pos]) {
+			error << "Fehlende \")\" in \"" << expression <<
+				"\"." << endl;
+			return false;
+		}
+		++pos;
+		return true;
+	}
+
+	const size_t begin = pos;
+	while (pos < expression.size() && isalnum(expression[pos]))
+		++pos;
+	const string name = expression.substr(begin, pos - begin);
+	if (name.empty()) {
+		error << "Unerwartetes Zeichen an Position " << begin <<
+			" in \"" << expression << "\"." << endl;
+		return false;
+	}
+	// Abkuerzungen fuer beide Arten von Zerfaellen bzw. Nachpulsen
+	if ("decay" == name || "afterpulse" == name) {
+		const unsigned first = ("decay" == name) ?
+			fp13FlagIndexFormat::DecayDown :
+			fp13FlagIndexFormat::AfterpulseSimple;
+		vector<uint64_t> other;
+		if (!readBitmap(first, words) ||
+				!readBitmap(first + 1, other))
+			return false;
+		for (size_t i = 0; i < words.size(); ++i)
+			words[i] |= other[i];
+		return true;
+	}
+	const int bitmap = find(name);
+	if (bitmap < 0) {
+		error << "Unbekannte Bitmap " << name << " in \"" <<
+			expression << "\"." << endl;
+		return false;
+	}
+	return readBitmap(bitmap, words);
+}
+
+// Dateiende
@@ -0,0 +1,249 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Bitmap-Index der eventFlags und lastMuonLayer aller analysierten
+// Ereignisse (fp13 -b, Abfragen mit fp13query)
+//
+// Nach der Analyse eines Ereignisses sind eventFlags und lastMuonLayer
+// vergessen; wer spaeter z.B. alle Ereignisse mit einem Zerfall nach oben
+// in Lage 3 und einem Nachpuls sehen will, muesste die ganze Messung noch
+// einmal analysieren. Mit fp13 -b schreibt die Analyse stattdessen fuer
+// jede Eigenschaft eine Bitmap ueber alle Ereignisnummern (Bit e steht
+// fuer Ereignis e der Eingabedatei, ab 0):
+//
+// 	analyzed		Ereignis wurde analysiert
+// 	muon			Myon von oben (lastMuonLayer != -1)
+// 	decayDown		eventFlags & FlagDecayDown
+// 	decayUp			eventFlags & FlagDecayUp
+// 	afterpulseSimple	eventFlags & FlagAfterpulseSimple
+// 	afterpulseImproved	eventFlags & FlagAfterpulseImproved
+// 	layer0 ... layer<N-1>	lastMuonLayer == 0 ... N - 1
+//
+// Ein Zerfall nach oben wird in der Lage lastMuonLayer gefunden, "decayUp
+// & layer3" sind also die Zerfaelle nach oben in Lage 3. Ereignisse, die
+// nicht analysiert wurden (uebersprungen mit fp13 -s oder nach -n), haben
+// kein Bit gesetzt.
+//
+// Die Bitmaps sind in Worten zu 64 Ereignissen lauflaengenkodiert: Folgen
+// von Worten, in denen alle Bits 0 bzw. 1 sind, brauchen nur ein paar
+// Bytes, alle anderen Worte stehen unveraendert in der Datei. Seltene
+// Eigenschaften (Zerfaelle, Nachpulse) brauchen daher nur wenig Platz,
+// haeufige (analyzed) nicht mehr als ungepackt.
+//
+// Aufbau der Datei (alle Zahlen little endian):
+//
+// Dateikopf (32 Bytes)
+// 	8 Bytes		Kennung "\x89" "FP13FX" "\n"
+// 	2 Bytes		Version des Formats (derzeit 1)
+// 	1 Byte		Anzahl N der Detektorlagen
+// 	1 Byte		Anzahl der Bitmaps (6 + N, Reihenfolge wie oben)
+// 	4 Bytes		reserviert (0)
+// 	8 Bytes		Anzahl der Ereignisse (hoechste Ereignisnummer + 1)
+// 	8 Bytes		reserviert (0)
+//
+// danach folgen die Bitmaps, jeweils
+// 	8 Bytes		Anzahl der gesetzten Bits
+// 	8 Bytes		Laenge der kodierten Bitmap in Bytes
+// 	...		kodierte Bitmap, bis alle Worte da sind:
+// 	varint		(Anzahl k der Fuellworte << 1) | Fuellbit
+// 			(k Worte, deren Bits alle gleich dem Fuellbit sind)
+// 	varint		Anzahl l der folgenden Worte
+// 	l * 8 Bytes	Worte (Bit i von Wort j steht fuer Ereignis
+// 			64 * j + i)
+//
+// varint wie im Binaerformat (s. fp13Binary.h)
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13FLAGINDEX_H
+#define FP13FLAGINDEX_H
+
+// C++ headers
+#include <fstream>
+#include <vector>
+#include <string>
+#include <mutex>
+// C headers (fuer uint16_t, uint64_t)
+#include <stdint.h>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13MappedFile;
+
+// Konstanten zum Dateiformat
+struct fp13FlagIndexFormat
+{
+	// Nummern der Bitmaps in der Datei; fuer Lage i folgt danach die
+	// Bitmap Layer + i
+	enum Bitmap {
+		Analyzed = 0,
+		Muon = 1,
+		// fuer Bit k der eventFlags die Bitmap DecayDown + k
+		DecayDown = 2,
+		DecayUp = 3,
+		AfterpulseSimple = 4,
+		AfterpulseImproved = 5,
+		Layer = 6
+	};
+
+	// Kennung am Dateianfang
+	static const char magic[8];
+	// aktuelle Version des Formats
+	static const unsigned version = 1;
+	// Groesse des Dateikopfs und des Kopfes jeder Bitmap in Bytes
+	static const unsigned headerSize = 32;
+	static const unsigned bitmapHeaderSize = 16;
+
+	// Anzahl der Bitmaps fuer einen Detektor mit nLayers Lagen
+	static unsigned noOfBitmaps(int nLayers);
+	// Name der Bitmap bitmap (wie in der Tabelle oben)
+	static string getName(unsigned bitmap);
+
+	// eventFlags und lastMuonLayer eines analysierten Ereignisses in
+	// einem Wort: Bit 15 (analysiert), Bits 4-9 lastMuonLayer + 1,
+	// Bits 0-3 eventFlags
+	static uint16_t code(int eventFlags, int lastMuonLayer)
+	{
+		return static_cast<uint16_t>(0x8000 | (eventFlags & 0xf) |
+				((lastMuonLayer + 1) << 4));
+	}
+};
+
+// Sammeln und Schreiben eines Flag-Index
+//
+// Die Analyseobjekte (auch die Worker-Objekte in analyzeParallel) sammeln
+// die Kodes (fp13FlagIndexFormat::code) fortlaufend nummerierter
+// Ereignisse und geben sie abschnittsweise mit add ab; in welcher
+// Reihenfolge, ist egal. add packt jeden Abschnitt sofort in
+// lauflaengenkodierte Bitmaps ueber die Worte, die er beruehrt (wie in
+// der Datei), und gibt die Kodes frei; write setzt die Bitmaps der
+// Abschnitte am Ende der Reihe nach zusammen. Bis dahin brauchen seltene
+// Eigenschaften fast keinen Platz, statt zwei Bytes pro Ereignis.
+class fp13FlagIndexWriter
+{
+public:
+	// so viele Ereignisse sollte ein Abschnitt hoechstens haben
+	static const size_t maxSegment = 1 << 16;
+
+	// legt die Datei fileName an; isOpen() gibt Auskunft, ob das
+	// geklappt hat
+	fp13FlagIndexWriter(const string& fileName, int nLayers);
+
+	bool isOpen() const;
+	const string& getFileName() const;
+
+	// Uebernehmen der Kodes der Ereignisse firstEvent, firstEvent + 1,
+	// ...; codes ist danach leer
+	// kann aus mehreren Threads gleichzeitig aufgerufen werden
+	void add(unsigned long firstEvent, vector<uint16_t>& codes);
+
+	// Bauen und Schreiben der Bitmaps
+	// gibt false zurueck, falls die Datei nicht geschrieben werden kann
+	bool write();
+
+	// Anzahl der analysierten Ereignisse
+	unsigned long getNoOfAnalyzedEvents() const;
+
+private:
+	string fileName;
+	int nLayers;
+	ofstream out;
+	// gesammelte Abschnitte: die Bitmaps ueber die Worte firstWord bis
+	// firstWord + nWords - 1, Bitmap b kodiert in data[offsets[b]] bis
+	// data[offsets[b + 1]] (Worte am Rand koennen auch Bits der
+	// Nachbarabschnitte enthalten und werden beim Schreiben verodert)
+	struct Segment {
+		size_t firstWord, nWords;
+		vector<size_t> offsets;
+		vector<unsigned char> data;
+
+		bool operator<(const Segment& other) const
+		{ return firstWord < other.firstWord; }
+	};
+	vector<Segment> segments;
+	// Anzahl der Ereignisse (hoechste Ereignisnummer + 1) und der
+	// gesetzten Bits in jeder Bitmap
+	unsigned long nEvents;
+	vector<unsigned long long> counts;
+	unsigned long nAnalyzed;
+	mutex addMutex;
+
+	// nicht kopierbar
+	fp13FlagIndexWriter(const fp13FlagIndexWriter&);
+	fp13FlagIndexWriter& operator=(const fp13FlagIndexWriter&);
+};
+
+// Lesen eines Flag-Index und Auswahl von Ereignissen
+//
+// Ausdruecke fuer select bestehen aus den Namen der Bitmaps (s. o.,
+// dazu "decay" fuer decayDown | decayUp und "afterpulse" fuer
+// afterpulseSimple | afterpulseImproved), "!" (nicht), "&" (und), "|"
+// (oder) und Klammern, z.B.
+//
+// 	fp13FlagIndex index("fp13.flags");
+// 	vector<uint64_t> selected;
+// 	if (index.select("decayUp & layer3 & afterpulseImproved", selected))
+// 		for (unsigned long e = 0; e < index.getNoOfEvents(); ++e)
+// 			if (selected[e / 64] >> (e % 64) & 1)
+// 				...
+//
+// Ausgewaehlt werden nur analysierte Ereignisse, "!decay" sind also die
+// analysierten Ereignisse ohne Zerfall.
+class fp13FlagIndex
+{
+public:
+	// oeffnet die Datei fileName; isOpen() gibt Auskunft, ob das
+	// geklappt hat (sonst gibt es eine Fehlermeldung)
+	fp13FlagIndex(const string& fileName);
+	~fp13FlagIndex();
+
+	bool isOpen() const;
+	// Anzahl der Detektorlagen aus dem Dateikopf
+	int getNoOfLayers() const;
+	// Anzahl der Ereignisse (hoechste Ereignisnummer + 1) und der Worte
+	// einer entpackten Bitmap
+	unsigned long getNoOfEvents() const;
+	size_t getNoOfWords() const;
+	// Anzahl der Bitmaps und der gesetzten Bits in Bitmap bitmap
+	unsigned getNoOfBitmaps() const;
+	unsigned long long getCount(unsigned bitmap) const;
+	// Nummer der Bitmap mit dem Namen name, -1 falls es keine gibt
+	int find(const string& name) const;
+
+	// Entpacken der Bitmap bitmap nach words (getNoOfWords() Worte,
+	// Bit i von words[j] steht fuer Ereignis 64 * j + i)
+	// gibt false zurueck, falls sie fehlerhaft ist
+	bool readBitmap(unsigned bitmap, vector<uint64_t>& words) const;
+
+	// Auswahl der analysierten Ereignisse, auf die expression zutrifft,
+	// als Bitmap nach words
+	// gibt false zurueck (mit Fehlermeldung), falls der Ausdruck
+	// ungueltig ist
+	bool select(const string& expression, vector<uint64_t>& words) const;
+
+private:
+	string fileName;
+	fp13MappedFile* file;
+	int nLayers;
+	unsigned long nEvents;
+	// Anzahl der gesetzten Bits und Anfang und Ende jeder Bitmap
+	vector<unsigned long long> counts;
+	vector<const unsigned char*> bitmapBegin, bitmapEnd;
+
+	// Auswerten der Teilausdruecke (s. select), pos ist die Position
+	// in expression
+	bool parseOr(const string& expression, size_t& pos,
+			vector<uint64_t>& words) const;
+	bool parseAnd(const string& expression, size_t& pos,
+			vector<uint64_t>& words) const;
+	bool parseTerm(const string& expression, size_t& pos,
+			vector<uint64_t>& words) const;
+
+	// nicht kopierbar
+	fp13FlagIndex(const fp13FlagIndex&);
+	fp13FlagIndex& operator=(const fp13FlagIndex&);
+};
+
+#endif
+
+// Dateiende
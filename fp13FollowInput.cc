@@ -0,0 +1,152 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Verfolgen einer wachsenden Textdatei (s. fp13FollowInput.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13FollowInput.h"
+
+#include <cstring>
+#include <cerrno>
+
+// C header files (fuer open, read, lseek, usleep)
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logstream.h"
+
+using namespace logstreams;
+
+volatile sig_atomic_t fp13FollowInput::stopRequested = 0;
+
+fp13FollowInput* fp13FollowInput::open(const string& name)
+{
+	int fd = ("-" == name) ? 0 : ::open(name.c_str(), O_RDONLY);
+	if (-1 == fd)
+		return 0;
+	return new fp13FollowInput(name, fd);
+}
+
+fp13FollowInput::fp13FollowInput(const string& name, int f) :
+	fp13Input(name), fd(f), bufOffset(0), pos(0)
+{ }
+
+fp13FollowInput::~fp13FollowInput()
+{
+	// stdin wird nicht geschlossen
+	if (0 != fd)
+		::close(fd);
+}
+
+void fp13FollowInput::requestStop()
+{ stopRequested = 1; }
+
+size_t fp13FollowInput::tell() const
+{ return bufOffset + pos; }
+
+bool fp13FollowInput::seek(size_t offset)
+{
+	if (static_cast<off_t>(-1) == lseek(fd, offset, SEEK_SET))
+		return false;
+	buf.clear();
+	bufOffset = offset;
+	pos = 0;
+	return true;
+}
+
+// Ende des ersten vollstaendigen Ereignisses ab pos
+bool fp13FollowInput::findEventEnd(size_t& end) const
+{
+	// wie beim Lesen endet ein Ereignis mit der ersten "###"-Zeile
+	// nach einer gueltigen Zeile mit einem Hit; beruecksichtigt werden
+	// nur Zeilen, deren Zeilenende schon gelesen ist
+	const char* begin = buf.data();
+	const char* bufEnd = begin + buf.size();
+	bool haveHit = false;
+	for (const char* p = begin + pos; p != bufEnd; ) {
+		const char* eol = static_cast<const char*>(
+				memchr(p, '\n', bufEnd - p));
+		if (!eol)
+			return false;
+		if (isEndOfEvent(p, eol)) {
+			if (haveHit) {
+				end = eol + 1 - begin;
+				return true;
+			}
+		} else if (!haveHit) {
+			unsigned nBin;
+			int mask, time;
+			haveHit = (LineHit ==
+					parseLine(p, eol, nBin, mask, time));
+		}
+		p = eol + 1;
+	}
+	return false;
+}
+
+// Nachlesen angehaengter Daten
+size_t fp13FollowInput::readMore()
+{
+	// bereits abgelieferte Daten vorne wegwerfen
+	if (pos) {
+		buf.erase(0, pos);
+		bufOffset += pos;
+		pos = 0;
+	}
+	char tmp[1 << 16];
+	ssize_t n;
+	do {
+		n = ::read(fd, tmp, sizeof(tmp));
+	} while (-1 == n && EINTR == errno && !stopRequested);
+	if (-1 == n) {
+		if (EINTR == errno)
+			return 0;
+		error << "Fehler beim Lesen der Eingabedatei " << fileName <<
+			"." << endl;
+		throw;
+	}
+	buf.append(tmp, n);
+	return n;
+}
+
+int fp13FollowInput::readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned long eventCounter)
+{
+	hitMask.clear();
+	hitTimes.clear();
+
+	// warten, bis ein vollstaendiges Ereignis da ist
+	size_t end;
+	unsigned waited = 0;
+	for (;;) {
+		if (stopRequested)
+			return -1;
+		if (findEventEnd(end))
+			break;
+		if (readMore())
+			continue;
+		if (waited >= pollTimeout)
+			return 1;
+		usleep(1000 * pollInterval);
+		waited += pollInterval;
+	}
+
+	// Ereignis zeilenweise zerlegen, wie bei fp13MappedInput
+	unsigned merged = 0;
+	const char* p = buf.data() + pos;
+	const char* eventEnd = buf.data() + end;
+	while (p != eventEnd) {
+		const char* line = p;
+		const char* eol = static_cast<const char*>(
+				memchr(line, '\n', eventEnd - line));
+		p = eol + 1;
+		processLine(line, eol, hitMask, hitTimes, merged,
+				eventCounter, warnings);
+	}
+	flushWarnings();
+	pos = end;
+
+	// Event erfolgreich gelesen
+	return 0;
+}
+
+// Dateiende
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Verfolgen einer wachsenden Textdatei (fp13 -f)
+//
+// Waehrend der Messung haengt die Datennahme laufend neue Ereignisse an
+// die Datei an. fp13FollowInput liest die Datei wie "tail -f": was neu
+// dazugekommen ist, wird nachgelesen, und ein Ereignis wird erst
+// abgeliefert, wenn seine abschliessende "###"-Zeile vollstaendig (mit
+// Zeilenende) in der Datei steht. Ein gerade erst halb geschriebenes
+// Ereignis wird also nie gelesen.
+//
+// Ist kein vollstaendiges Ereignis da, wartet readEvent hoechstens
+// pollTimeout Millisekunden und gibt dann 1 zurueck, damit der Aufrufer
+// zwischendurch z.B. die Ausgabedatei aktualisieren kann. Das Ende der
+// Eingabe (-1) gibt es erst, nachdem requestStop aufgerufen wurde (z.B.
+// aus einem Signalhandler fuer SIGINT).
+//
+// tell und seek erlauben es, die Leseposition in einem Checkpoint zu
+// speichern und spaeter dort weiterzumachen (s.
+// fp13Analysis::analyzeFollowing).
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13FOLLOWINPUT_H
+#define FP13FOLLOWINPUT_H
+
+// C++ headers
+#include <vector>
+#include <string>
+// C headers (fuer sig_atomic_t)
+#include <csignal>
+
+#include "fp13Input.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13FollowInput : public fp13Input
+{
+public:
+	// Oeffnen der Datei fileName ("-" fuer stdin)
+	// gibt 0 zurueck, falls die Datei nicht geoeffnet werden konnte
+	static fp13FollowInput* open(const string& fileName);
+	virtual ~fp13FollowInput();
+
+	// Einlesen des naechsten vollstaendigen Ereignisses
+	// gibt 0 zurueck, falls ein Ereignis gelesen wurde, 1, falls nach
+	// pollTimeout noch keins da ist, und -1 nach requestStop
+	virtual int readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter);
+
+	// Weiterlesen ab offset (Anfang eines Ereignisses)
+	virtual bool seek(size_t offset);
+	// Position des naechsten Ereignisses in der Datei
+	size_t tell() const;
+
+	// Beenden des Verfolgens; darf aus einem Signalhandler aufgerufen
+	// werden
+	static void requestStop();
+
+	// Abstand, in dem nach neuen Daten gesehen wird, in ms
+	static const unsigned pollInterval = 200;
+	// so lange wartet readEvent hoechstens, in ms
+	static const unsigned pollTimeout = 1000;
+
+protected:
+	fp13FollowInput(const string& fileName, int fd);
+
+	// sucht das Ende des ersten vollstaendigen Ereignisses ab pos
+	// gibt false zurueck, falls noch keins vollstaendig im Puffer ist
+	bool findEventEnd(size_t& end) const;
+	// Nachlesen der an die Datei angehaengten Daten
+	// gibt die Anzahl der gelesenen Bytes zurueck
+	size_t readMore();
+
+	int fd;
+	// gelesene, noch nicht abgelieferte Daten; buf[0] steht in der
+	// Datei an Position bufOffset, das naechste Ereignis beginnt bei
+	// buf[pos]
+	string buf;
+	size_t bufOffset;
+	size_t pos;
+
+	static volatile sig_atomic_t stopRequested;
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Einfaches Histogramm mit festen, gleich breiten Bins
+// (s. fp13Histogram.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Histogram.h"
+
+#include <algorithm>
+
+#include <TArrayD.h>
+
+fp13Histogram::fp13Histogram(const string& n, const string& t,
+		int bins, double lo, double hi) :
+	name(n), title(t), nBins(bins), xmin(lo), xmax(hi),
+	counts(bins + 2, 0), entries(0), sumw(0), sumwx(0.), sumwx2(0.)
+{ }
+
+// Addieren der Eintraege eines Histogramms mit gleichem Binning
+void fp13Histogram::add(const fp13Histogram& other)
+{
+	for (int bin = 0; bin < nBins + 2; ++bin)
+		counts[bin] += other.counts[bin];
+	entries += other.entries;
+	sumw += other.sumw;
+	sumwx += other.sumwx;
+	sumwx2 += other.sumwx2;
+}
+
+// Zuruecksetzen aller Eintraege
+void fp13Histogram::reset()
+{
+	fill(counts.begin(), counts.end(), 0);
+	entries = sumw = 0;
+	sumwx = sumwx2 = 0.;
+}
+
+// Erzeugen eines TH1D mit demselben Inhalt
+TH1D* fp13Histogram::toTH1D() const
+{
+	TH1D* h = new TH1D(name.c_str(), title.c_str(), nBins, xmin, xmax);
+	// Fehler auf bins: Inhalt(bin i) +/- sqrt(Inhalt(bin i))
+	h->Sumw2();
+	copyTo(*h);
+	return h;
+}
+
+// Uebertragen des Inhalts in ein TH1D
+void fp13Histogram::copyTo(TH1D& h) const
+{
+	TArrayD& sumw2 = *h.GetSumw2();
+	for (int bin = 0; bin < nBins + 2; ++bin) {
+		h.SetBinContent(bin, counts[bin]);
+		// bei Gewicht 1 ist die Summe der Gewichtsquadrate gleich
+		// dem Bininhalt
+		sumw2[bin] = counts[bin];
+	}
+	// SetBinContent veraendert Statistik und Eintraege, daher erst
+	// jetzt setzen
+	double stats[4] = { double(sumw), double(sumw), sumwx, sumwx2 };
+	h.PutStats(stats);
+	h.SetEntries(entries);
+}
+
+// Speichern des Inhalts als eine Textzeile
+void fp13Histogram::save(ostream& os) const
+{
+	// die Summen sind ganzzahlig, mit 17 Stellen aber auch sonst exakt
+	const streamsize precision = os.precision(17);
+	os << name << ' ' << nBins << ' ' << entries << ' ' << sumw <<
+		' ' << sumwx << ' ' << sumwx2;
+	for (int bin = 0; bin < nBins + 2; ++bin)
+		os << ' ' << counts[bin];
+	os << endl;
+	os.precision(precision);
+}
+
+// Laden einer mit save gespeicherten Zeile
+bool fp13Histogram::load(istream& is)
+{
+	string n;
+	int bins;
+	if (!(is >> n >> bins) || name != n || nBins != bins)
+		return false;
+	is >> entries >> sumw >> sumwx >> sumwx2;
+	for (int bin = 0; bin < nBins + 2; ++bin)
+		is >> counts[bin];
+	return !is.fail();
+}
+
+const string& fp13Histogram::getName() const
+{ return name; }
+
+int fp13Histogram::getNbins() const
+{ return nBins; }
+
+unsigned long fp13Histogram::getBinContent(int bin) const
+{ return counts[bin]; }
+
+unsigned long fp13Histogram::getEntries() const
+{ return entries; }
+
+// Dateiende
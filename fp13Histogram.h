@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Einfaches Histogramm mit festen, gleich breiten Bins
+//
+// Waehrend der Ereignisschleife fuellt fp13Analysis pro Ereignis
+// mehrere Histogramme. TH1D::Fill ist dafuer unnoetig teuer (virtuelle
+// Aufrufe, allgemeine Binsuche, Fehlerarray). fp13Histogram zaehlt
+// stattdessen nur die Eintraege pro Bin in einem Array und fuehrt die
+// Summen fuer die Statistik (Mittelwert, RMS) mit, genau wie TH1.
+//
+// Erst beim Schreiben der Ausgabedatei wird mit toTH1D ein TH1D gleichen
+// Namens erzeugt, dessen Bininhalte, Fehler (sqrt(N), wie mit Sumw2),
+// Statistik und Anzahl der Eintraege denen entsprechen, die das Fuellen
+// eines TH1D mit denselben Werten ergeben haette. Die Makros
+// (Lebensdauer.C, ...) koennen die Ausgabedatei daher unveraendert lesen.
+//
+// Fill heisst wie bei TH1, damit Code wie h1->Fill(x) unveraendert
+// bleiben kann.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13HISTOGRAM_H
+#define FP13HISTOGRAM_H
+
+// C++ headers
+#include <iostream>
+#include <vector>
+#include <string>
+// ROOT headers
+#include <TH1.h>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13Histogram
+{
+public:
+	// nBins Bins gleicher Breite von xmin bis xmax, wie bei TH1D
+	fp13Histogram(const string& name, const string& title,
+			int nBins, double xmin, double xmax);
+
+	// Fuellen mit Gewicht 1
+	inline void Fill(double x);
+
+	// Addieren der Eintraege eines Histogramms mit gleichem Binning
+	void add(const fp13Histogram& other);
+	// Zuruecksetzen aller Eintraege
+	void reset();
+
+	// Erzeugen eines TH1D mit demselben Inhalt im aktuellen Verzeichnis
+	TH1D* toTH1D() const;
+	// Uebertragen des Inhalts in ein TH1D mit gleichem Binning
+	void copyTo(TH1D& h) const;
+
+	// Speichern des Inhalts als eine Textzeile (fuer Checkpoints)
+	void save(ostream& os) const;
+	// Laden einer mit save gespeicherten Zeile
+	// gibt false zurueck, falls sie nicht zu Name und Binning passt
+	bool load(istream& is);
+
+	const string& getName() const;
+	int getNbins() const;
+	// Inhalt von Bin bin (0: Unterlauf, nBins + 1: Ueberlauf)
+	unsigned long getBinContent(int bin) const;
+	// Anzahl der Aufrufe von Fill
+	unsigned long getEntries() const;
+
+protected:
+	string name, title;
+	int nBins;
+	double xmin, xmax;
+	// Eintraege pro Bin, inklusive Unter- und Ueberlauf
+	vector<unsigned long> counts;
+	// Anzahl der Aufrufe von Fill
+	unsigned long entries;
+	// Summen fuer die Statistik ueber Eintraege innerhalb des
+	// Histogrammbereichs: Anzahl, Summe von x und x^2
+	unsigned long sumw;
+	double sumwx, sumwx2;
+};
+
+// Fuellen mit Gewicht 1
+// die Bestimmung des Bins ist dieselbe wie in TAxis::FindBin, damit
+// Werte auf Bingrenzen im selben Bin landen wie bei TH1D
+inline void fp13Histogram::Fill(double x)
+{
+	++entries;
+	if (x < xmin) {
+		++counts[0];
+	} else if (!(x < xmax)) {
+		++counts[nBins + 1];
+	} else {
+		++counts[1 + int(nBins * (x - xmin) / (xmax - xmin))];
+		// wie TH1 zaehlen nur Eintraege im Histogrammbereich fuer
+		// die Statistik
+		++sumw;
+		sumwx += x;
+		sumwx2 += x * x;
+	}
+}
+
+#endif
+
+// Dateiende
@@ -0,0 +1,311 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Ereignisbildung aus einem fortlaufenden Hitstrom (s. fp13HitStream.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13HitStream.h"
+
+#include <sstream>
+#include <cstring>
+#include <cctype>
+
+// C header files (fuer open, stat)
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "fp13AsyncReader.h"
+#include "fp13Compressed.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// fp13HitStreamConfig
+////////////////////////////////////////////////////////////////////////
+fp13HitStreamConfig::fp13HitStreamConfig() :
+	window(defWindow), deadTime(defDeadTime),
+	coincidence(defCoincidence), triggerMask(defTriggerMask)
+{ }
+
+bool fp13HitStreamConfig::parse(const string& spec)
+{
+	// Felder zwischen den Doppelpunkten
+	vector<string> fields;
+	string::size_type begin = 0, end;
+	do {
+		end = spec.find(':', begin);
+		fields.push_back(spec.substr(begin, (string::npos == end) ?
+					string::npos : (end - begin)));
+		begin = end + 1;
+	} while (string::npos != end);
+	if (fields.size() > 4)
+		return false;
+
+	int* const numbers[] = { &window, &deadTime, &coincidence };
+	for (size_t i = 0; i < fields.size() && i < 3; ++i) {
+		if (fields[i].empty())
+			continue;
+		istringstream stream(fields[i]);
+		if (!(stream >> *numbers[i]) || !stream.eof())
+			return false;
+	}
+	if (fields.size() > 3 && !fields[3].empty()) {
+		istringstream stream(fields[3]);
+		if (!(stream >> triggerMask) || !stream.eof())
+			return false;
+	}
+	return window > 0 && deadTime >= 0 && coincidence >= 0 &&
+		0 != triggerMask;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13HitStreamInput
+////////////////////////////////////////////////////////////////////////
+// Oeffnen eines Hitstroms
+fp13HitStreamInput* fp13HitStreamInput::open(const string& fileName,
+		const fp13HitStreamConfig& config)
+{
+	istream* stream = 0;
+	if ("-" == fileName) {
+		stream = new fp13IStream(new fp13AsyncReader(0, false));
+	} else {
+		// regulaere Dateien werden eingeblendet
+		struct stat st;
+		if (0 == stat(fileName.c_str(), &st) && S_ISREG(st.st_mode)) {
+			fp13MappedFile* file = new fp13MappedFile(fileName);
+			if (file->isOpen()) {
+				const fp13Compression::Type type =
+					fp13Compression::detect(file->begin(),
+							file->end());
+				if (fp13Compression::None == type)
+					return new fp13HitStreamInput(fileName,
+							config, file, 0);
+				if (!fp13Compression::isSupported(type)) {
+					error << "Die Eingabedatei " <<
+						fileName << " ist mit " <<
+						fp13Compression::getName(type) <<
+						" komprimiert, fp13 wurde aber "
+						"ohne Unterstuetzung dafuer "
+						"uebersetzt." << endl;
+					delete file;
+					return 0;
+				}
+				return new fp13HitStreamInput(fileName, config,
+						0, new fp13IStream(
+							fp13Compression::open(type,
+								file, 1)));
+			}
+			delete file;
+		}
+		// alles andere wird als Stream gelesen
+		const int fd = ::open(fileName.c_str(), O_RDONLY);
+		if (-1 == fd)
+			return 0;
+		stream = new fp13IStream(new fp13AsyncReader(fd, true));
+	}
+
+	// komprimierte Streams werden beim Lesen entpackt
+	const fp13Compression::Type type = fp13Compression::detect(
+			stream->peek());
+	if (fp13Compression::None != type) {
+		if (!fp13Compression::isSupported(type)) {
+			error << "Die Eingabedatei " << fileName << " ist mit " <<
+				fp13Compression::getName(type) << " komprimiert, "
+				"fp13 wurde aber ohne Unterstuetzung dafuer "
+				"uebersetzt." << endl;
+			delete stream;
+			return 0;
+		}
+		stream = new fp13IStream(fp13Compression::open(type, stream));
+	}
+	return new fp13HitStreamInput(fileName, config, 0, stream);
+}
+
+// Konstruktor
+fp13HitStreamInput::fp13HitStreamInput(const string& name,
+		const fp13HitStreamConfig& cfg, fp13MappedFile* f,
+		istream* s) :
+	fp13Input(name), config(cfg),
+	file(f), current(f ? f->begin() : 0), stream(s),
+	havePending(false), lastTime(0), deadUntil(0),
+	nHits(0), nDeadHits(0), nUntriggeredHits(0), nUnorderedHits(0),
+	nEvents(0)
+{ }
+
+// Destruktor
+fp13HitStreamInput::~fp13HitStreamInput()
+{
+	info << nEvents << " Ereignisse aus " << nHits << " Hits gebildet; " <<
+		nDeadHits << " Hits in der Totzeit, " << nUntriggeredHits <<
+		" ohne Trigger." << endl;
+	if (nUnorderedHits)
+		warn << nUnorderedHits << " Hits mit fallender Zeit "
+			"verworfen." << endl;
+	delete file;
+	delete stream;
+}
+
+const fp13HitStreamConfig& fp13HitStreamInput::getConfig() const
+{ return config; }
+
+unsigned long long fp13HitStreamInput::getNoOfHits() const
+{ return nHits; }
+
+unsigned long long fp13HitStreamInput::getNoOfDeadHits() const
+{ return nDeadHits; }
+
+unsigned long long fp13HitStreamInput::getNoOfUntriggeredHits() const
+{ return nUntriggeredHits; }
+
+unsigned long long fp13HitStreamInput::getNoOfUnorderedHits() const
+{ return nUnorderedHits; }
+
+// naechste Zeile
+bool fp13HitStreamInput::nextLine(const char*& begin, const char*& end)
+{
+	if (file) {
+		// direkt im eingeblendeten Puffer
+		const char* mapEnd = file->end();
+		if (current == mapEnd)
+			return false;
+		const char* eol = static_cast<const char*>(
+				memchr(current, '\n', mapEnd - current));
+		begin = current;
+		end = eol ? eol : mapEnd;
+		current = eol ? (eol + 1) : mapEnd;
+		return true;
+	}
+	if (!getline(*stream, buf)) {
+		if (stream->bad()) {
+			error << "Fehler beim Lesen der Eingabedatei " <<
+				fileName << "." << endl;
+			throw;
+		}
+		return false;
+	}
+	begin = buf.data();
+	end = begin + buf.size();
+	return true;
+}
+
+// naechster Hit
+bool fp13HitStreamInput::nextHit(Hit& hit, unsigned long eventCounter)
+{
+	if (havePending) {
+		havePending = false;
+		hit = pending;
+		return true;
+	}
+	const char *begin, *end;
+	while (nextLine(begin, end)) {
+		if (LineHit != parseHitLine(begin, end, hit.time, hit.layer)) {
+			// leere Zeilen (z.B. am Ende) stoeren nicht
+			while (begin != end && isspace(*begin))
+				++begin;
+			if (begin != end)
+				addWarning(warnings, Warning::InvalidLine,
+						eventCounter, 0);
+			continue;
+		}
+		++nHits;
+		if (hit.time < lastTime) {
+			if (!nUnorderedHits++)
+				warn << "Zeit im Hitstrom " << fileName <<
+					" faellt (" << lastTime << " ns, dann " <<
+					hit.time << " ns), verwerfe solche "
+					"Hits." << endl;
+			continue;
+		}
+		lastTime = hit.time;
+		return true;
+	}
+	return false;
+}
+
+// Anfuegen eines Hits an das Ereignis
+void fp13HitStreamInput::addToEvent(const Hit& hit, long long start,
+		vector<int>& hitMask, vector<int>& hitTimes) const
+{
+	const int time = static_cast<int>(hit.time - start);
+	const int mask = 1 << hit.layer;
+	// Hits zur selben Zeit gehoeren in ein Zeitbin, sonst wie addHit
+	if (!hitTimes.empty() && (time == hitTimes.back() ||
+				(mergeWindow >= 0 &&
+				 time - hitTimes.back() <= mergeWindow))) {
+		hitMask.back() |= mask;
+		return;
+	}
+	hitMask.push_back(mask);
+	hitTimes.push_back(time);
+}
+
+// Bilden des naechsten Ereignisses
+int fp13HitStreamInput::readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned long eventCounter)
+{
+	hitMask.clear();
+	hitTimes.clear();
+
+	// auf den Trigger warten
+	Hit hit;
+	unsigned seen = 0;
+	while (seen != config.triggerMask) {
+		if (!nextHit(hit, eventCounter)) {
+			nUntriggeredHits += recent.size();
+			recent.clear();
+			flushWarnings();
+			return -1;
+		}
+		if (hit.time < deadUntil) {
+			++nDeadHits;
+			continue;
+		}
+		// Hits, die fuer die Koinzidenz zu alt sind, vergessen
+		while (!recent.empty() &&
+				recent.front().time < hit.time - config.coincidence) {
+			++nUntriggeredHits;
+			recent.pop_front();
+		}
+		recent.push_back(hit);
+		seen = 0;
+		for (deque<Hit>::const_iterator it = recent.begin();
+				it != recent.end(); ++it)
+			seen |= (1u << it->layer) & config.triggerMask;
+	}
+
+	// das Ereignis beginnt mit dem ersten Hit in einer Triggerlage
+	long long start = hit.time;
+	for (deque<Hit>::const_iterator it = recent.begin();
+			it != recent.end(); ++it) {
+		if ((1u << it->layer) & config.triggerMask) {
+			start = it->time;
+			break;
+		}
+	}
+	for (deque<Hit>::const_iterator it = recent.begin();
+			it != recent.end(); ++it) {
+		if (it->time < start)
+			++nUntriggeredHits;
+		else
+			addToEvent(*it, start, hitMask, hitTimes);
+	}
+	recent.clear();
+
+	// Auslesefenster
+	const long long windowEnd = start + config.window;
+	while (nextHit(hit, eventCounter)) {
+		if (hit.time >= windowEnd) {
+			pending = hit;
+			havePending = true;
+			break;
+		}
+		addToEvent(hit, start, hitMask, hitTimes);
+	}
+	deadUntil = windowEnd + config.deadTime;
+
+	++nEvents;
+	flushWarnings();
+	return 0;
+}
+
+// Dateiende
@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Ereignisbildung aus einem fortlaufenden Hitstrom (fp13 -w)
+//
+// Die bisherige Datennahme schreibt Ereignisse mit nummerierten Zeitbins,
+// getrennt durch "###" (s. fp13Input.cc). Neuere Elektronik liefert
+// stattdessen einen fortlaufenden Strom einzelner Hits, eine Zeile pro
+// Hit:
+//
+// 	Zeitpunkt [ns]	Lage
+// 	   1000000052	   0
+// 	   1000000053	   1
+// 	   1000000061	   2
+// 	   1000002418	   3
+//
+// Die Zeitpunkte sind absolut (ganze ns, bis 2^63 - 1) und muessen in
+// der Reihenfolge der Zeilen steigen; alles nach der zweiten Zahl einer
+// Zeile wird ignoriert. fp13HitStreamInput bildet daraus Ereignisse wie
+// ein Trigger:
+//
+// - ausgeloest wird, sobald alle Lagen aus triggerMask (Standard: die
+//   obersten Lagen 0 und 1, wie fuer ein Myon von oben noetig) innerhalb
+//   von coincidence ns getroffen wurden; das Ereignis beginnt mit dem
+//   ersten dieser Hits
+// - zum Ereignis gehoeren alle Hits bis window ns nach seinem Beginn
+//   (Auslesefenster); Hits zur selben Zeit bilden ein Zeitbin, naeher als
+//   mergeWindow beieinander liegende Zeitbins werden wie beim Lesen der
+//   Textdateien zusammengefasst (s. fp13Input::setMergeWindow)
+// - nach dem Auslesefenster ist der Trigger deadTime ns lang tot; Hits in
+//   dieser Zeit gehen verloren
+//
+// Die Zeiten im Ereignis sind relativ zum Beginn des Ereignisses, das
+// erste Zeitbin hat also die Zeit 0 (und h21 enthaelt nur 0). Die
+// Ereignisse sehen fuer die Analyse sonst genauso aus wie aus einer
+// Textdatei; mit fp13 -k lassen sie sich z.B. als Skim im Binaerformat
+// speichern.
+//
+// Gelesen wird wie bei fp13Input::open: regulaere Dateien werden
+// eingeblendet, mit gzip oder zstd komprimierte Daten beim Lesen
+// entpackt, stdin ("-") und named pipes in einem eigenen Thread gelesen.
+// Gespeichert werden nur die Hits der letzten coincidence ns und des
+// aktuellen Ereignisses.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13HITSTREAM_H
+#define FP13HITSTREAM_H
+
+// C++ headers
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <string>
+
+#include "fp13Input.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+// Parameter der Ereignisbildung
+struct fp13HitStreamConfig
+{
+	// Auslesefenster in ns (so lang wie der Bereich der Histogramme
+	// der Verzoegerungszeiten)
+	static const int defWindow = 50000;
+	// Totzeit nach dem Auslesefenster in ns
+	static const int defDeadTime = 0;
+	// Koinzidenzzeit des Triggers in ns
+	static const int defCoincidence = 60;
+	// Lagen, die fuer den Trigger getroffen sein muessen
+	static const unsigned defTriggerMask = 3;
+
+	int window, deadTime, coincidence;
+	unsigned triggerMask;
+
+	// Standardwerte
+	fp13HitStreamConfig();
+
+	// Lesen aus "window[:deadTime[:coincidence[:triggerMask]]]"; leere
+	// Felder behalten ihren Standardwert, also z.B. "20000::100"
+	// gibt false zurueck, falls spec nicht so aussieht
+	bool parse(const string& spec);
+};
+
+// Eingabe aus einem Hitstrom
+class fp13HitStreamInput : public fp13Input
+{
+public:
+	// Oeffnen des Hitstroms fileName ("-" steht fuer stdin)
+	// gibt 0 zurueck, falls er nicht geoeffnet werden konnte
+	static fp13HitStreamInput* open(const string& fileName,
+			const fp13HitStreamConfig& config);
+	// gibt eine Zusammenfassung aus (s. u.)
+	virtual ~fp13HitStreamInput();
+
+	// Bilden des naechsten Ereignisses
+	virtual int readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter);
+
+	const fp13HitStreamConfig& getConfig() const;
+	// Zaehler: gelesene Hits, davon in der Totzeit verlorene, nicht zu
+	// einem Ereignis gehoerende und wegen fallender Zeit verworfene
+	unsigned long long getNoOfHits() const;
+	unsigned long long getNoOfDeadHits() const;
+	unsigned long long getNoOfUntriggeredHits() const;
+	unsigned long long getNoOfUnorderedHits() const;
+
+protected:
+	// liest aus der eingeblendeten Datei file oder aus stream (die
+	// dabei in den Besitz der Eingabe uebergehen)
+	fp13HitStreamInput(const string& fileName,
+			const fp13HitStreamConfig& config,
+			fp13MappedFile* file, istream* stream);
+
+	// ein Hit
+	struct Hit {
+		long long time;
+		int layer;
+	};
+
+	// naechste Zeile nach [begin, end)
+	// gibt false am Ende der Eingabe zurueck
+	bool nextLine(const char*& begin, const char*& end);
+	// naechster gueltiger Hit mit nicht fallender Zeit
+	// gibt false am Ende der Eingabe zurueck
+	bool nextHit(Hit& hit, unsigned long eventCounter);
+	// Anfuegen des Hits hit an das Ereignis, das zur Zeit start beginnt
+	void addToEvent(const Hit& hit, long long start,
+			vector<int>& hitMask, vector<int>& hitTimes) const;
+
+	fp13HitStreamConfig config;
+	// Quelle: eingeblendete Datei oder Stream
+	fp13MappedFile* file;
+	const char* current;
+	istream* stream;
+	string buf;
+
+	// Hits der letzten coincidence ns vor dem Trigger
+	deque<Hit> recent;
+	// erster Hit nach dem letzten Auslesefenster
+	Hit pending;
+	bool havePending;
+	// Zeit des letzten Hits und Ende der Totzeit
+	long long lastTime, deadUntil;
+
+	unsigned long long nHits, nDeadHits, nUntriggeredHits,
+		nUnorderedHits;
+	unsigned long nEvents;
+
+	// nicht kopierbar
+	fp13HitStreamInput(const fp13HitStreamInput&);
+	fp13HitStreamInput& operator=(const fp13HitStreamInput&);
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,208 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Ereignisindex fuer schnelles Springen in der Eingabedatei
+// (s. fp13Index.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Index.h"
+
+#include <fstream>
+#include <cstring>
+
+// C header files (fuer stat)
+#include <sys/stat.h>
+
+#include "logstream.h"
+
+using namespace logstreams;
+
+// Anhaengen einer Zahl mit 8 Bytes, little endian
+static void putU64(vector<unsigned char>& buf, unsigned long long value)
+{
+	for (unsigned i = 0; i < 8; ++i)
+		buf.push_back(static_cast<unsigned char>(value >> (8 * i)));
+}
+
+// Lesen einer Zahl mit 8 Bytes, little endian
+static bool getU64(const unsigned char*& p, const unsigned char* end,
+		unsigned long long& value)
+{
+	if (end - p < 8)
+		return false;
+	value = 0;
+	for (unsigned i = 0; i < 8; ++i)
+		value |= static_cast<unsigned long long>(p[i]) << (8 * i);
+	p += 8;
+	return true;
+}
+
+const char fp13EventIndex::magic[8] =
+	{ 'F', 'P', '1', '3', 'I', 'D', 'X', '\n' };
+
+fp13EventIndex::fp13EventIndex(const string& name) :
+	dataFileName(name), stride(defStride), nEvents(0)
+{
+	memset(&stamp, 0, sizeof(stamp));
+}
+
+string fp13EventIndex::indexFileName(const string& dataFileName)
+{ return dataFileName + ".idx"; }
+
+unsigned long fp13EventIndex::getNoOfEvents() const
+{ return nEvents; }
+
+// Bestimmen der Kennzeichen der Datendatei
+bool fp13EventIndex::getFileStamp(FileStamp& s) const
+{
+	struct stat st;
+	if (0 != stat(dataFileName.c_str(), &st))
+		return false;
+	s.size = st.st_size;
+	s.mtimeSec = st.st_mtim.tv_sec;
+	s.mtimeNsec = st.st_mtim.tv_nsec;
+	s.inode = st.st_ino;
+	return true;
+}
+
+// Laden der Indexdatei
+bool fp13EventIndex::load()
+{
+	ifstream in(indexFileName(dataFileName).c_str(), ios::binary);
+	if (!in)
+		return false;
+	vector<unsigned char> buf((istreambuf_iterator<char>(in)),
+			istreambuf_iterator<char>());
+	const unsigned char* p = buf.data();
+	const unsigned char* end = p + buf.size();
+	if (buf.size() < sizeof(magic) || 0 != memcmp(p, magic, sizeof(magic)))
+		return false;
+	p += sizeof(magic);
+
+	unsigned long long ver, str, events, nEntries;
+	FileStamp s;
+	if (!getU64(p, end, ver) || version != ver ||
+			!getU64(p, end, str) || 0 == str ||
+			!getU64(p, end, s.size) ||
+			!getU64(p, end, s.mtimeSec) ||
+			!getU64(p, end, s.mtimeNsec) ||
+			!getU64(p, end, s.inode) ||
+			!getU64(p, end, events) ||
+			!getU64(p, end, nEntries) ||
+			nEntries != (events + str - 1) / str ||
+			static_cast<unsigned long long>(end - p) != 8 * nEntries)
+		return false;
+
+	// passt der Index noch zur Datendatei?
+	FileStamp current;
+	if (!getFileStamp(current) || current.size != s.size ||
+			current.mtimeSec != s.mtimeSec ||
+			current.mtimeNsec != s.mtimeNsec ||
+			current.inode != s.inode) {
+		info << "Ereignisindex " << indexFileName(dataFileName) <<
+			" ist veraltet." << endl;
+		return false;
+	}
+
+	offsets.resize(nEntries);
+	for (unsigned long long i = 0; i < nEntries; ++i)
+		getU64(p, end, offsets[i]);
+	stamp = s;
+	stride = str;
+	nEvents = events;
+	return true;
+}
+
+// Aufbauen des Index
+bool fp13EventIndex::build(const fp13Input& input, unsigned str)
+{
+	const fp13MappedFile* file = input.getMappedFile();
+	if (!file || !getFileStamp(stamp))
+		return false;
+	// massgeblich ist der eingeblendete Inhalt; ist die Datei
+	// inzwischen gewachsen, gilt der Index beim naechsten Laden als
+	// veraltet
+	stamp.size = file->size();
+
+	stride = str;
+	nEvents = 0;
+	offsets.clear();
+	size_t offset = input.firstEventOffset();
+	for (;;) {
+		const size_t begin = offset;
+		if (!input.skipEvent(offset))
+			break;
+		if (0 == nEvents % stride)
+			offsets.push_back(begin);
+		++nEvents;
+	}
+	return true;
+}
+
+// Speichern als Indexdatei
+bool fp13EventIndex::save() const
+{
+	vector<unsigned char> buf(magic, magic + sizeof(magic));
+	putU64(buf, version);
+	putU64(buf, stride);
+	putU64(buf, stamp.size);
+	putU64(buf, stamp.mtimeSec);
+	putU64(buf, stamp.mtimeNsec);
+	putU64(buf, stamp.inode);
+	putU64(buf, nEvents);
+	putU64(buf, offsets.size());
+	for (size_t i = 0; i < offsets.size(); ++i)
+		putU64(buf, offsets[i]);
+
+	ofstream out(indexFileName(dataFileName).c_str(),
+			ios::binary | ios::trunc);
+	out.write(reinterpret_cast<const char*>(buf.data()), buf.size());
+	out.close();
+	return !out.fail();
+}
+
+// letztes indiziertes Ereignis vor oder gleich event
+void fp13EventIndex::find(unsigned long event, unsigned long& found,
+		size_t& offset) const
+{
+	if (offsets.empty()) {
+		found = 0;
+		offset = 0;
+		return;
+	}
+	size_t i = event / stride;
+	if (i >= offsets.size())
+		i = offsets.size() - 1;
+	found = i * stride;
+	offset = offsets[i];
+}
+
+// Springen zum Ereignis event
+unsigned long fp13EventIndex::seek(fp13Input& input, unsigned long current,
+		unsigned long event)
+{
+	// Springen lohnt sich erst ab stride Ereignissen
+	if (!input.getMappedFile() || event < current + defStride)
+		return current;
+
+	fp13EventIndex index(input.getFileName());
+	if (!index.load()) {
+		info << "Erstelle Ereignisindex " <<
+			indexFileName(input.getFileName()) << "." << endl;
+		if (!index.build(input))
+			return current;
+		if (!index.save())
+			warn << "Kann Ereignisindex " <<
+				indexFileName(input.getFileName()) <<
+				" nicht schreiben, mache trotzdem weiter." <<
+				endl;
+	}
+
+	unsigned long found;
+	size_t offset;
+	index.find(event, found, offset);
+	if (found <= current || !input.seek(offset))
+		return current;
+	return found;
+}
+
+// Dateiende
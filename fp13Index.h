@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Ereignisindex fuer schnelles Springen in der Eingabedatei
+//
+// Um mit -s tief in einer grossen Datei anzufangen, muessten alle
+// uebersprungenen Ereignisse gelesen und zerlegt werden. Der Index merkt
+// sich stattdessen fuer jedes stride-te Ereignis, an welcher Stelle der
+// Datei es beginnt; gesprungen wird dann zum naechstgelegenen
+// indizierten Ereignis, und nur die wenigen restlichen Ereignisse werden
+// noch gelesen.
+//
+// Der Index wird neben der Datendatei als <Datendatei>.idx gespeichert
+// und beim ersten Sprung in die Datei (oder explizit mit fp13 -x)
+// angelegt. Er enthaelt Groesse, Aenderungszeit und Inode der
+// Datendatei; passen diese nicht mehr zur Datei, wird der Index
+// verworfen und neu aufgebaut.
+//
+// Nur Eingaben aus eingeblendeten Dateien koennen springen (s.
+// fp13Input::getMappedFile); bei stdin oder named pipes werden die
+// Ereignisse wie bisher gelesen.
+//
+// Aufbau der Indexdatei (alle Zahlen little endian, je 8 Bytes):
+// 	Kennung "FP13IDX\n", Version, stride, Groesse, Aenderungszeit
+// 	(Sekunden und Nanosekunden) und Inode der Datendatei, Anzahl der
+// 	Ereignisse, Anzahl n der Eintraege, danach n Positionen (Bytes ab
+// 	Dateianfang) der Ereignisse 0, stride, 2 * stride, ...
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13INDEX_H
+#define FP13INDEX_H
+
+// C++ headers
+#include <vector>
+#include <string>
+
+#include "fp13Input.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13EventIndex
+{
+public:
+	// Abstand der indizierten Ereignisse
+	static const unsigned defStride = 1000;
+
+	// Index zur Datendatei dataFileName (noch leer)
+	fp13EventIndex(const string& dataFileName);
+
+	// Name der Indexdatei zur Datendatei dataFileName
+	static string indexFileName(const string& dataFileName);
+
+	// Laden der Indexdatei
+	// gibt false zurueck, falls sie fehlt, fehlerhaft oder veraltet ist
+	bool load();
+	// Aufbauen des Index durch Ueberfliegen aller Ereignisse in input
+	// gibt false zurueck, falls input nicht springen kann
+	bool build(const fp13Input& input, unsigned stride = defStride);
+	// Speichern als Indexdatei
+	// gibt false zurueck, falls die Datei nicht geschrieben werden kann
+	bool save() const;
+
+	// Springen in input, das als naechstes Ereignis current liefern
+	// wuerde, zum Ereignis event (gezaehlt ab 0) bzw. zum letzten
+	// indizierten Ereignis davor; der Index wird dazu geladen oder, falls
+	// noetig, aufgebaut und gespeichert
+	// gibt die Nummer des Ereignisses zurueck, das input als naechstes
+	// liefert (current, falls nicht gesprungen wurde); die Ereignisse
+	// bis event muessen dann noch gelesen werden
+	static unsigned long seek(fp13Input& input, unsigned long current,
+			unsigned long event);
+
+	// Anzahl der Ereignisse in der Datendatei
+	unsigned long getNoOfEvents() const;
+	// letztes indiziertes Ereignis vor oder gleich event und dessen
+	// Position in der Datei
+	void find(unsigned long event, unsigned long& found,
+			size_t& offset) const;
+
+protected:
+	// Kennzeichen der Datendatei, an denen Aenderungen erkannt werden
+	struct FileStamp {
+		unsigned long long size, mtimeSec, mtimeNsec, inode;
+	};
+	// Bestimmen der Kennzeichen der Datendatei
+	bool getFileStamp(FileStamp& stamp) const;
+
+	// Kennung am Anfang der Indexdatei
+	static const char magic[8];
+	// aktuelle Version des Formats
+	static const unsigned version = 1;
+
+	string dataFileName;
+	FileStamp stamp;
+	unsigned stride;
+	unsigned long nEvents;
+	// Positionen der Ereignisse 0, stride, 2 * stride, ...
+	vector<unsigned long long> offsets;
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,590 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Eingabequellen fuer die Datenanalyse im Rahmen von FP13
+//
+// Format der Daten in dem Textinputfile:
+// Beispiel eines Ereignisses (Zerfall nach unten)
+//
+// Zeitbinnumerierung     Binaeres Detektorhitmuster     Zeitpunkt der Hits [ns]
+//         1                        127                            50
+//         2                        128                          2370
+//        ###
+//
+// Die Zeichenfolge ### markiert das Ende eines Ereignisses
+//
+// Mit eingelesenes carriage return '\r' aus Dateien mit DOS-Zeilen-
+// endkonvention wird beim Lesen der Zahlen wie ein Leerzeichen behandelt
+////////////////////////////////////////////////////////////////////////
+#include "fp13Input.h"
+
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <climits>
+#include <mutex>
+
+// C header files (fuer open, fstat, mmap)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "fp13Binary.h"
+#include "fp13ParallelInput.h"
+#include "fp13AsyncReader.h"
+#include "fp13Compressed.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// Hilfsfunktionen zum Lesen von Zahlen direkt aus dem Puffer
+////////////////////////////////////////////////////////////////////////
+// Leerraum wie bei operator>> (insbesondere auch '\r')
+static inline bool isSpace(char c)
+{
+	return ' ' == c || '\t' == c || '\r' == c || '\n' == c ||
+		'\v' == c || '\f' == c;
+}
+
+static inline bool isDigit(char c)
+{ return '0' <= c && c <= '9'; }
+
+// Lesen einer Dezimalzahl mit optionalem Vorzeichen ab p, fuehrender
+// Leerraum wird uebersprungen; p zeigt danach hinter die Zahl
+// Betraege groesser als maxAbs gelten als Fehler
+// Rueckgabewert: false, falls keine gueltige Zahl gefunden wurde
+static inline bool parseNumber(const char*& p, const char* end,
+		unsigned long long maxAbs, bool& negative,
+		unsigned long long& value)
+{
+	while (p != end && isSpace(*p)) ++p;
+	negative = false;
+	if (p != end && ('-' == *p || '+' == *p)) {
+		negative = ('-' == *p);
+		++p;
+	}
+	if (p == end || !isDigit(*p))
+		return false;
+	value = 0;
+	do {
+		value = 10 * value + (*p - '0');
+		if (value > maxAbs)
+			return false;
+		++p;
+	} while (p != end && isDigit(*p));
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13Input
+////////////////////////////////////////////////////////////////////////
+// Konstruktor
+fp13Input::fp13Input(const string& name) :
+	fileName(name), mergeWindow(defMergeWindow)
+{ }
+
+// Destruktor
+fp13Input::~fp13Input()
+{ }
+
+const string& fp13Input::getFileName() const
+{ return fileName; }
+
+int fp13Input::getMergeWindow() const
+{ return mergeWindow; }
+
+void fp13Input::setMergeWindow(int window)
+{ mergeWindow = window; }
+
+// Streams koennen nicht springen
+const fp13MappedFile* fp13Input::getMappedFile() const
+{ return 0; }
+
+size_t fp13Input::firstEventOffset() const
+{ return 0; }
+
+bool fp13Input::skipEvent(size_t&) const
+{ return false; }
+
+bool fp13Input::seek(size_t)
+{ return false; }
+
+// Kann fp13 mit type komprimierte Daten lesen?
+static bool checkCompression(const string& fileName,
+		fp13Compression::Type type)
+{
+	if (fp13Compression::isSupported(type))
+		return true;
+	error << "Die Eingabedatei " << fileName << " ist mit " <<
+		fp13Compression::getName(type) << " komprimiert, fp13 wurde "
+		"aber ohne Unterstuetzung dafuer uebersetzt." << endl;
+	return false;
+}
+
+// Oeffnen einer Eingabequelle passend zum Dateinamen
+fp13Input* fp13Input::open(const string& fileName, unsigned nThreads)
+{
+	// "-" steht fuer stdin; gelesen wird in einem eigenen Thread (s.
+	// fp13AsyncReader.h)
+	if ("-" == fileName)
+		return openStream(fileName,
+				new fp13IStream(new fp13AsyncReader(0, false)));
+
+	// regulaere Dateien werden in den Speicher eingeblendet
+	struct stat st;
+	if (0 == stat(fileName.c_str(), &st) && S_ISREG(st.st_mode)) {
+		fp13MappedFile* file = new fp13MappedFile(fileName);
+		if (file->isOpen()) {
+			// komprimierte Dateien werden beim Lesen entpackt (s.
+			// fp13Compressed.h)
+			const fp13Compression::Type type =
+				fp13Compression::detect(file->begin(), file->end());
+			if (fp13Compression::None != type) {
+				if (!checkCompression(fileName, type)) {
+					delete file;
+					return 0;
+				}
+				return openStream(fileName, new fp13IStream(
+							fp13Compression::open(type, file,
+								nThreads)));
+			}
+			// Binaerformat anhand der Kennung erkennen
+			if (fp13BinaryFormat::hasMagic(file->begin(),
+						file->end()))
+				return new fp13BinaryInput(fileName, file);
+			if (nThreads > 1)
+				return new fp13ParallelInput(fileName, file,
+						nThreads);
+			return new fp13MappedInput(fileName, file);
+		}
+		// hat nicht geklappt, versuche es unten mit einem istream
+		delete file;
+	}
+
+	// alles andere (named pipes, Geraete, ...) wird wie stdin als
+	// Stream gelesen
+	int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (-1 == fd)
+		return 0;
+	return openStream(fileName,
+			new fp13IStream(new fp13AsyncReader(fd, true)));
+}
+
+// Eingabe aus einem Stream, der dabei in den Besitz der Eingabe uebergeht
+fp13Input* fp13Input::openStream(const string& fileName, istream* stream)
+{
+	// komprimierte Daten werden in einem eigenen Thread entpackt, das
+	// Ergebnis kann wieder Text oder das Binaerformat sein
+	const fp13Compression::Type type =
+		fp13Compression::detect(stream->peek());
+	if (fp13Compression::None != type) {
+		if (!checkCompression(fileName, type)) {
+			delete stream;
+			return 0;
+		}
+		return openStream(fileName,
+				new fp13IStream(fp13Compression::open(type, stream)));
+	}
+
+	// Binaerdaten erkennt man schon am ersten Zeichen
+	if (fp13BinaryFormat::magic[0] == static_cast<char>(stream->peek()))
+		return new fp13BinaryInput(fileName, *stream, true);
+	return new fp13StreamInput(fileName, *stream, true);
+}
+
+// Enthaelt die Zeile [begin, end) die Zeichenfolge "###"?
+bool fp13Input::isEndOfEvent(const char* begin, const char* end)
+{
+	for (const char* p = begin; p != end; ++p) {
+		p = static_cast<const char*>(memchr(p, '#', end - p));
+		if (!p) break;
+		if (end - p >= 3 && '#' == p[1] && '#' == p[2])
+			return true;
+	}
+	return false;
+}
+
+// Ueberspringen eines Ereignisses der Textdatei [begin, end)
+bool fp13Input::skipTextEvent(const char* begin, const char* end,
+		size_t& offset)
+{
+	// wie beim Lesen endet ein Ereignis mit der ersten "###"-Zeile
+	// nach einer gueltigen Zeile mit einem Hit
+	bool haveHit = false;
+	const char* p = begin + offset;
+	while (p != end) {
+		const char* line = p;
+		const char* eol = static_cast<const char*>(
+				memchr(line, '\n', end - line));
+		p = eol ? (eol + 1) : end;
+		unsigned nBin;
+		int mask, time;
+		switch (parseLine(line, eol ? eol : end, nBin, mask, time)) {
+			case LineEndOfEvent:
+				if (haveHit) {
+					offset = p - begin;
+					return true;
+				}
+				break;
+			case LineHit:
+				haveHit = true;
+				break;
+			case LineInvalid:
+				break;
+		}
+	}
+	// Ende der Datei: letztes Ereignis ohne "###" am Ende
+	offset = end - begin;
+	return haveHit;
+}
+
+// Zerlegen einer Zeile in Zeitbinnummer, Hitmuster und Zeitpunkt
+fp13Input::LineType fp13Input::parseLine(const char* begin, const char* end,
+		unsigned& nBin, int& hitMask, int& hitTime)
+{
+	// Die Zeichenfolge "###" irgendwo in der Zeile markiert das Ende
+	// eines Ereignisses
+	if (isEndOfEvent(begin, end))
+		return LineEndOfEvent;
+
+	// drei Zahlen lesen; wie bei operator>> wird alles, was nach der
+	// dritten Zahl kommt, ignoriert
+	const char* p = begin;
+	bool negative;
+	unsigned long long value;
+	// Zeitbinnummer (vorzeichenlos, negative Werte werden wie bei
+	// operator>> modulo 2^32 interpretiert)
+	if (!parseNumber(p, end, UINT_MAX, negative, value))
+		return LineInvalid;
+	nBin = negative ? -static_cast<unsigned>(value) :
+		static_cast<unsigned>(value);
+	// Hitmuster (bis 2^32 - 1, damit alle Lagen eines Detektors mit 32
+	// Lagen hineinpassen; Werte ueber INT_MAX stehen als Bitmuster im
+	// int)
+	if (!parseNumber(p, end, UINT_MAX, negative, value) ||
+			(negative && value > 1ull + INT_MAX))
+		return LineInvalid;
+	hitMask = negative ? static_cast<int>(-static_cast<long long>(value)) :
+		static_cast<int>(static_cast<unsigned>(value));
+	// Zeitpunkt
+	if (!parseNumber(p, end, 1ull + INT_MAX, negative, value) ||
+			(!negative && value > INT_MAX))
+		return LineInvalid;
+	hitTime = negative ? static_cast<int>(-static_cast<long long>(value)) :
+		static_cast<int>(value);
+
+	return LineHit;
+}
+
+// Zerlegen einer Zeile eines Hitstroms in Zeitpunkt und Lage
+fp13Input::LineType fp13Input::parseHitLine(const char* begin,
+		const char* end, long long& time, int& layer)
+{
+	const char* p = begin;
+	bool negative;
+	unsigned long long value;
+	// Zeitpunkt (nicht negativ)
+	if (!parseNumber(p, end, LLONG_MAX, negative, value) || negative)
+		return LineInvalid;
+	time = static_cast<long long>(value);
+	// Lage (0 bis 31)
+	if (!parseNumber(p, end, 31, negative, value) || negative)
+		return LineInvalid;
+	layer = static_cast<int>(value);
+	return LineHit;
+}
+
+// Verarbeiten einer Zeile des aktuellen Ereignisses
+bool fp13Input::processLine(const char* begin, const char* end,
+		vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned& merged, unsigned long eventCounter,
+		vector<Warning>& warnings) const
+{
+	// Variablen zum Zwischenspeichern der ausgelesenen Daten
+	int mask, time;
+	unsigned nBin;
+	switch (parseLine(begin, end, nBin, mask, time)) {
+		case LineEndOfEvent:
+			// Ein einzelnes "###" am Anfang des Ereignisses wird
+			// ueberlesen, da die Datenfiles mit "###" anfangen...
+			return !hitMask.empty();
+		case LineInvalid:
+			addWarning(warnings, Warning::InvalidLine,
+					eventCounter, hitMask.size());
+			return false;
+		case LineHit:
+			break;
+	}
+
+	// Hit anfuegen (und ggf. mit dem vorhergehenden zusammenfassen)
+	addHit(mask, time, hitMask, hitTimes, merged, eventCounter, warnings);
+	// Ueberpruefen, ob konsistent mit der Zaehlung im Datenfile
+	if (nBin != (hitMask.size() + merged)) {
+		// Wenn nicht, ist irgendetwas faul...
+		Warning& w = addWarning(warnings, Warning::BinCountMismatch,
+				eventCounter, hitMask.size());
+		w.nBin = nBin;
+		w.merged = merged;
+	}
+	return false;
+}
+
+// Anfuegen eines Hits an das aktuelle Ereignis
+void fp13Input::addHit(int mask, int time,
+		vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned& merged, unsigned long eventCounter,
+		vector<Warning>& warnings) const
+{
+	// Zeiten und Hitmasken kommen in je einen Vektor
+	hitMask.push_back(mask);
+	hitTimes.push_back(time);
+	// check for increasing times
+	if (hitMask.size() > 1) {
+		int delay = time - hitTimes[hitMask.size() - 2];
+		if (delay <= 0) {
+			Warning& w = addWarning(warnings, Warning::NotMonotonic,
+					eventCounter, hitMask.size());
+			w.delay = delay;
+			w.deltaData = mask ^ hitMask[hitMask.size() - 2];
+		}
+		//Wenn signale 40ns oder naeher zusammenliegen werden sie zusammengefuegt (endl. Zeitaufloesung)
+		if (mergeWindow >= 0 && delay <= mergeWindow) {
+			hitMask[hitMask.size() - 2] |= mask;
+			hitMask.pop_back();
+			hitTimes.pop_back();
+			merged++;
+		}
+	}
+}
+
+// Anfuegen einer Warnung an warnings
+fp13Input::Warning& fp13Input::addWarning(vector<Warning>& warnings,
+		Warning::Type type, unsigned long event, size_t bin)
+{
+	warnings.push_back(Warning());
+	Warning& w = warnings.back();
+	w.type = type;
+	w.event = event;
+	w.bin = bin;
+	w.delay = w.deltaData = 0;
+	w.nBin = w.merged = 0;
+	return w;
+}
+
+// Ausgeben gesammelter Warnungen
+void fp13Input::printWarnings(vector<Warning>::const_iterator begin,
+		vector<Warning>::const_iterator end, unsigned long eventOffset)
+{
+	if (begin == end)
+		return;
+	// mehrere Eingaben koennen in eigenen Threads gelesen werden (s.
+	// fp13RunSet.h), ihre Warnungen sollen sich nicht vermischen
+	static mutex printMutex;
+	lock_guard<mutex> lock(printMutex);
+	for (; begin != end; ++begin) {
+		const Warning& w = *begin;
+		const unsigned long eventCounter = eventOffset + w.event;
+		switch (w.type) {
+			case Warning::InvalidLine:
+				warn << "Ungueltig formatierte Daten in "
+					"Ereignis " << eventCounter <<
+					" Zeitbin " << w.bin <<
+					", mache trotzdem weiter." << endl;
+				break;
+			case Warning::NotMonotonic:
+				warn << "In Ereignis " <<
+					(eventCounter + 1) << ": Zeit steigt"
+					" nicht streng monoton an: Bin " <<
+					w.bin << " delay " <<
+					w.delay << " deltaData " <<
+					w.deltaData << "." << endl;
+				break;
+			case Warning::BinCountMismatch:
+				// EventCounter wird erst erhoeht, wenn das
+				// Ereignis komplett gelesen wurde, daher das
+				// "+ 1" unten
+				warn << "In Ereignis " << (eventCounter + 1) <<
+					": Zeitbinzaehlung unstimmig (Bin " <<
+					w.bin << " in Eingabedaten "
+					"erscheint als " << w.nBin <<
+					" beim Lesen). merged = " <<
+					w.merged << endl;
+				break;
+		}
+	}
+}
+
+// Ausgeben und Loeschen der Warnungen zum gerade gelesenen Ereignis
+void fp13Input::flushWarnings()
+{
+	printWarnings(warnings.begin(), warnings.end(), 0);
+	warnings.clear();
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13StreamInput
+////////////////////////////////////////////////////////////////////////
+fp13StreamInput::fp13StreamInput(const string& name, istream& stream,
+		bool owner) :
+	fp13Input(name), inputStream(stream), ownsStream(owner)
+{ }
+
+fp13StreamInput::~fp13StreamInput()
+{
+	// falls die Daten von cin kommen, darf der Speicher
+	// nicht zurueckgegeben werden
+	if (ownsStream)
+		delete &inputStream;
+}
+
+int fp13StreamInput::readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned long eventCounter)
+{
+	// falls das Ende der Datei erreicht wurde, wird -1 zurueckgegeben
+	if (inputStream.eof())
+		return -1;
+
+	hitMask.clear();
+	hitTimes.clear();
+
+	// Solange kein Fehler auftritt, Zeile fuer Zeile lesen, bis das
+	// Ende des Ereignisses erreicht ist
+	unsigned merged = 0;
+	while (getline(inputStream, buf)) {
+		if (processLine(buf.data(), buf.data() + buf.size(),
+					hitMask, hitTimes, merged,
+					eventCounter, warnings))
+			break;
+	}
+	// OK, Event eingelesen oder Fehler aufgetreten
+	flushWarnings();
+
+	// auf Lesefehler pruefen (nicht Ende der Eingabedatei)
+	if (inputStream.bad()) {
+		error << "Fehler beim Lesen der Eingabedatei " <<
+			fileName << "." << endl;
+		throw;
+	}
+	// falls das Ende der Datei erreicht wurde, wird -1 zurueckgegeben
+	if (inputStream.eof() && hitMask.empty())
+		return -1;
+	// falls nicht Ende der Datei aber trotzdem leeres Event, Fehler-
+	// meldung ausgeben...
+	if (hitMask.empty()) {
+		warn << "leeres Event in der Eingabedatei " <<
+			fileName << "." << endl;
+		throw;
+	}
+
+	// Event erfolgreich gelesen
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13MappedFile
+////////////////////////////////////////////////////////////////////////
+fp13MappedFile::fp13MappedFile(const string& name) :
+	mapBegin(0), mapSize(0), mapped(false)
+{
+	int fd = ::open(name.c_str(), O_RDONLY);
+	if (-1 == fd)
+		return;
+	struct stat st;
+	if (0 != fstat(fd, &st)) {
+		::close(fd);
+		return;
+	}
+	mapSize = st.st_size;
+	// eine leere Datei kann nicht eingeblendet werden, ist aber
+	// trotzdem eine gueltige (leere) Eingabe
+	if (0 == mapSize) {
+		::close(fd);
+		mapped = true;
+		return;
+	}
+	void* addr = mmap(0, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	// die Abbildung bleibt auch nach dem Schliessen der Datei bestehen
+	::close(fd);
+	if (MAP_FAILED == addr)
+		return;
+	// die Datei wird einmal von vorne nach hinten gelesen
+	madvise(addr, mapSize, MADV_SEQUENTIAL);
+
+	mapBegin = static_cast<const char*>(addr);
+	mapped = true;
+}
+
+fp13MappedFile::~fp13MappedFile()
+{
+	if (mapBegin)
+		munmap(const_cast<char*>(mapBegin), mapSize);
+}
+
+bool fp13MappedFile::isOpen() const
+{ return mapped; }
+
+const char* fp13MappedFile::begin() const
+{ return mapBegin; }
+
+const char* fp13MappedFile::end() const
+{ return mapBegin + mapSize; }
+
+size_t fp13MappedFile::size() const
+{ return mapSize; }
+
+////////////////////////////////////////////////////////////////////////
+// fp13MappedInput
+////////////////////////////////////////////////////////////////////////
+fp13MappedInput::fp13MappedInput(const string& name, fp13MappedFile* f) :
+	fp13Input(name), file(f), current(f->begin())
+{ }
+
+fp13MappedInput::~fp13MappedInput()
+{ delete file; }
+
+int fp13MappedInput::readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned long eventCounter)
+{
+	hitMask.clear();
+	hitTimes.clear();
+
+	// Zeile fuer Zeile direkt im eingeblendeten Puffer lesen, bis das
+	// Ende des Ereignisses erreicht ist
+	const char* mapEnd = file->end();
+	unsigned merged = 0;
+	while (current != mapEnd) {
+		const char* line = current;
+		const char* eol = static_cast<const char*>(
+				memchr(line, '\n', mapEnd - line));
+		// die letzte Zeile muss nicht mit '\n' enden
+		current = eol ? (eol + 1) : mapEnd;
+		if (processLine(line, eol ? eol : mapEnd, hitMask, hitTimes,
+					merged, eventCounter, warnings)) {
+			flushWarnings();
+			return 0;
+		}
+	}
+	flushWarnings();
+
+	// Ende der Datei erreicht: letztes Ereignis ohne "###" am Ende
+	// zurueckgeben, sonst -1
+	return hitMask.empty() ? -1 : 0;
+}
+
+const fp13MappedFile* fp13MappedInput::getMappedFile() const
+{ return file; }
+
+bool fp13MappedInput::skipEvent(size_t& offset) const
+{ return skipTextEvent(file->begin(), file->end(), offset); }
+
+bool fp13MappedInput::seek(size_t offset)
+{
+	if (offset > file->size())
+		return false;
+	current = file->begin() + offset;
+	return true;
+}
+
+// Dateiende
@@ -0,0 +1,282 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Eingabequellen fuer die Datenanalyse im Rahmen von FP13
+//
+// Die Klasse fp13Analysis liest ihre Ereignisse ueber ein Objekt vom
+// Typ fp13Input. Je nach Art der Eingabe werden verschiedene
+// Implementierungen verwendet:
+//
+// fp13StreamInput	liest zeilenweise aus einem istream (z.B. stdin,
+// 			wenn als Eingabedatei "-" angegeben wird; das
+// 			eigentliche Lesen passiert in einem eigenen Thread,
+// 			s. fp13AsyncReader.h)
+// fp13MappedInput	blendet eine regulaere Datei mit mmap in den
+// 			Speicher ein und liest die Zahlen direkt aus dem
+// 			eingeblendeten Puffer, ohne Zeilen zu kopieren
+// fp13BinaryInput	liest das kompakte Binaerformat (s. fp13Binary.h),
+// 			das anhand der Kennung am Dateianfang erkannt wird
+// fp13ParallelInput	liest eine eingeblendete Textdatei in Stuecken
+// 			mit mehreren Threads (s. fp13ParallelInput.h)
+// fp13FollowInput	verfolgt eine wachsende Textdatei (s.
+// 			fp13FollowInput.h)
+//
+// Alle teilen sich die Routinen zum Zerlegen einer Zeile und zum
+// Zusammenfuegen der Zeitbins, so dass Ergebnisse und Warnungen
+// unabhaengig von der Eingabequelle identisch sind.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13INPUT_H
+#define FP13INPUT_H
+
+// C++ headers
+#include <iostream>
+#include <vector>
+#include <string>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13MappedFile;
+
+// Basisklasse fuer alle Eingabequellen
+class fp13Input
+{
+public:
+	// Oeffnen einer Eingabequelle
+	// "-" steht fuer stdin, regulaere Dateien werden in den Speicher
+	// eingeblendet, alles andere (z.B. named pipes) wird wie stdin in
+	// einem eigenen Thread gelesen (s. fp13AsyncReader.h);
+	// Binaerdateien werden an ihrer Kennung erkannt, ebenso mit gzip oder
+	// zstd komprimierte Daten, die beim Lesen entpackt werden (s.
+	// fp13Compressed.h)
+	// ist nThreads groesser als 1, werden eingeblendete Textdateien
+	// mit so vielen Threads parallel gelesen
+	// gibt 0 zurueck, falls die Eingabe nicht geoeffnet werden konnte
+	static fp13Input* open(const string& fileName, unsigned nThreads = 1);
+	// Eingabe aus dem Stream stream, der dabei in den Besitz der Eingabe
+	// uebergeht; Binaerdaten und komprimierte Daten werden an ihrer
+	// Kennung erkannt
+	static fp13Input* openStream(const string& fileName, istream* stream);
+
+	virtual ~fp13Input();
+
+	// Einlesen eines Ereignisses in hitMask und hitTimes
+	// eventCounter ist die Zahl der bisher gelesenen Ereignisse und
+	// wird nur fuer Meldungen benutzt
+	// gibt im Erfolgsfall 0 zurueck, -1 am Ende der Eingabe (und 1,
+	// falls beim Verfolgen einer Datei gerade kein Ereignis da ist)
+	virtual int readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter) = 0;
+
+	// Name der Eingabedatei
+	const string& getFileName() const;
+
+	// Zeitbins, deren Zeit hoechstens mergeWindow ns nach dem
+	// vorhergehenden Zeitbin liegt, werden zusammengefasst (endliche
+	// Zeitaufloesung); ein negativer Wert schaltet das ab
+	static const int defMergeWindow = 60;
+	int getMergeWindow() const;
+	void setMergeWindow(int window);
+	// Zusammenfassen der Zeitbins eines mit ausgeschaltetem
+	// Zusammenfassen (mergeWindow -1) gelesenen Ereignisses rawMask/
+	// rawTimes mit dem Zeitfenster window, wie es beim Lesen passiert
+	// waere; das Ergebnis steht danach in hitMask/hitTimes (Mask ist
+	// der Typ der Hitmuster, s. fp13LayerMask in fp13Analysis.h)
+	template <class Mask>
+	static void mergeTimeBins(int window, const vector<Mask>& rawMask,
+			const vector<int>& rawTimes, vector<Mask>& hitMask,
+			vector<int>& hitTimes);
+
+	// Springen in der Eingabedatei (fuer den Ereignisindex, s.
+	// fp13Index.h); Positionen sind Bytes ab Dateianfang
+	// eingeblendete Datei, oder 0, falls die Eingabe nicht springen kann
+	virtual const fp13MappedFile* getMappedFile() const;
+	// Position des ersten Ereignisses
+	virtual size_t firstEventOffset() const;
+	// Ueberspringen des Ereignisses, das bei offset beginnt; offset
+	// zeigt danach auf das naechste Ereignis
+	// gibt false zurueck, falls ab offset kein Ereignis mehr kommt
+	virtual bool skipEvent(size_t& offset) const;
+	// Weiterlesen mit dem Ereignis, das bei offset beginnt
+	// gibt false zurueck, falls die Eingabe nicht springen kann
+	virtual bool seek(size_t offset);
+
+protected:
+	// Konstruktor - nur fuer abgeleitete Klassen
+	fp13Input(const string& fileName);
+
+	// Art einer Zeile in den Eingabedaten
+	typedef enum {
+		LineHit,	// Zeitbinnummer, Hitmuster und Zeit
+		LineEndOfEvent,	// "###" - Ende eines Ereignisses
+		LineInvalid	// ungueltig formatierte Zeile
+	} LineType;
+
+	// Zerlegen der Zeile [begin, end) in Zeitbinnummer, Hitmuster
+	// und Zeitpunkt; die Zeile wird dabei nicht veraendert
+	static LineType parseLine(const char* begin, const char* end,
+			unsigned& nBin, int& hitMask, int& hitTime);
+	// Zerlegen einer Zeile eines Hitstroms [begin, end) in Zeitpunkt und
+	// Lage (s. fp13HitStream.h); liefert LineHit oder LineInvalid
+	static LineType parseHitLine(const char* begin, const char* end,
+			long long& time, int& layer);
+
+	// Warnung zu unstimmigen Eingabedaten
+	// Warnungen werden beim Lesen gesammelt und erst ausgegeben, wenn
+	// das Ereignis abgeliefert wird; so bekommen auch parallel gelesene
+	// Ereignisse (s. fp13ParallelInput.h) die richtige Ereignisnummer
+	struct Warning {
+		typedef enum {
+			InvalidLine,		// ungueltig formatierte Zeile
+			NotMonotonic,		// Zeit steigt nicht an
+			BinCountMismatch	// Zeitbinzaehlung unstimmig
+		} Type;
+		Type type;
+		// Zahl der vor diesem Ereignis gelesenen Ereignisse (relativ
+		// zum eventOffset in printWarnings)
+		unsigned long event;
+		// Zahl der Zeitbins im Ereignis beim Auftreten der Warnung
+		size_t bin;
+		// nur fuer NotMonotonic
+		int delay, deltaData;
+		// nur fuer BinCountMismatch
+		unsigned nBin, merged;
+	};
+
+	// Anfuegen einer neuen Warnung an warnings
+	static Warning& addWarning(vector<Warning>& warnings,
+			Warning::Type type, unsigned long event, size_t bin);
+	// Ausgeben der Warnungen [begin, end) mit der Ereignisnummer
+	// eventOffset + Warning::event
+	static void printWarnings(vector<Warning>::const_iterator begin,
+			vector<Warning>::const_iterator end,
+			unsigned long eventOffset);
+	// Ausgeben und Loeschen der Warnungen in warnings
+	void flushWarnings();
+
+	// Enthaelt die Zeile [begin, end) die Zeichenfolge "###"?
+	static bool isEndOfEvent(const char* begin, const char* end);
+
+	// Ueberspringen eines Ereignisses der Textdatei [begin, end), das
+	// bei begin + offset beginnt, ohne die Hits zu speichern (s. skipEvent)
+	static bool skipTextEvent(const char* begin, const char* end,
+			size_t& offset);
+
+	// Verarbeiten einer Zeile des aktuellen Ereignisses
+	// fuegt den Hit mit addHit an und merkt sich Warnungen zu
+	// ungueltigen Zeilen oder unstimmiger Zeitbinzaehlung in warnings
+	// merged zaehlt die im aktuellen Ereignis zusammengefassten Zeitbins
+	// gibt true zurueck, falls das Ereignis mit dieser Zeile endet
+	bool processLine(const char* begin, const char* end,
+			vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned& merged, unsigned long eventCounter,
+			vector<Warning>& warnings) const;
+
+	// Anfuegen eines Hits an hitMask/hitTimes; fasst zeitlich zu nahe
+	// liegende Zeitbins zusammen (s. mergeWindow) und merkt sich eine
+	// Warnung, falls die Zeit nicht streng monoton steigt
+	void addHit(int mask, int time,
+			vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned& merged, unsigned long eventCounter,
+			vector<Warning>& warnings) const;
+
+	// Name der Eingabedatei
+	string fileName;
+	// Zeitfenster zum Zusammenfassen von Zeitbins in ns
+	int mergeWindow;
+	// Warnungen zum gerade gelesenen Ereignis
+	vector<Warning> warnings;
+};
+
+// Zusammenfassen der Zeitbins eines Ereignisses (wie in addHit)
+template <class Mask>
+void fp13Input::mergeTimeBins(int window, const vector<Mask>& rawMask,
+		const vector<int>& rawTimes, vector<Mask>& hitMask,
+		vector<int>& hitTimes)
+{
+	hitMask.clear();
+	hitTimes.clear();
+	for (size_t i = 0; i < rawMask.size(); ++i) {
+		// verglichen wird wie beim Lesen mit dem letzten
+		// verbliebenen Zeitbin, nicht mit dem vorhergehenden Hit
+		if (!hitMask.empty() && window >= 0 &&
+				rawTimes[i] - hitTimes.back() <= window) {
+			hitMask.back() |= rawMask[i];
+			continue;
+		}
+		hitMask.push_back(rawMask[i]);
+		hitTimes.push_back(rawTimes[i]);
+	}
+}
+
+// Eingabe aus einem istream (stdin, named pipes, ...)
+class fp13StreamInput : public fp13Input
+{
+public:
+	// liest aus stream; falls owner gesetzt ist, wird der Stream im
+	// Destruktor freigegeben
+	fp13StreamInput(const string& fileName, istream& stream,
+			bool owner);
+	virtual ~fp13StreamInput();
+
+	virtual int readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter);
+
+protected:
+	istream& inputStream;
+	bool ownsStream;
+	// Puffer fuer eine Zeile, wird fuer alle Zeilen wiederverwendet
+	string buf;
+};
+
+// eine mit mmap in den Speicher eingeblendete Datei
+class fp13MappedFile
+{
+public:
+	// blendet die Datei fileName ein; isOpen() gibt Auskunft, ob das
+	// geklappt hat
+	fp13MappedFile(const string& fileName);
+	~fp13MappedFile();
+
+	bool isOpen() const;
+	// eingeblendeter Bereich [begin(), end())
+	const char* begin() const;
+	const char* end() const;
+	size_t size() const;
+
+private:
+	const char* mapBegin;
+	size_t mapSize;
+	bool mapped;
+
+	// nicht kopierbar
+	fp13MappedFile(const fp13MappedFile&);
+	fp13MappedFile& operator=(const fp13MappedFile&);
+};
+
+// Eingabe aus einer in den Speicher eingeblendeten Textdatei
+class fp13MappedInput : public fp13Input
+{
+public:
+	// liest aus der eingeblendeten Datei file, die dabei in den Besitz
+	// des fp13MappedInput uebergeht
+	fp13MappedInput(const string& fileName, fp13MappedFile* file);
+	virtual ~fp13MappedInput();
+
+	virtual int readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter);
+
+	virtual const fp13MappedFile* getMappedFile() const;
+	virtual bool skipEvent(size_t& offset) const;
+	virtual bool seek(size_t offset);
+
+protected:
+	fp13MappedFile* file;
+	// aktuelle Leseposition
+	const char* current;
+};
+
+#endif
+
+// Dateiende
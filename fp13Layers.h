@@ -0,0 +1,30 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Anzahl der Detektorlagen fuer die Makros (Lebensdauer.C,
+// Einfangzeiten.C, Asymmetrie.C, Weiteres.C)
+//
+// fp13 schreibt die Anzahl der benutzten Lagen als TParameter<int>
+// "nLayers" in die Ausgabedatei (s. fp13 -l); Dateien ohne diesen
+// Eintrag stammen vom Detektor mit 6 Lagen. maxLayers ist die groesste
+// Anzahl, die fp13 kennt (s. fp13LayerMask in fp13Analysis.h), und
+// damit die Groesse aller Arrays pro Lage in den Makros.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13LAYERS_H
+#define FP13LAYERS_H
+
+#include <TFile.h>
+#include <TParameter.h>
+
+const int maxLayers = 32;
+
+inline int getNoOfLayers(TFile *f)
+{
+	TParameter<int> *p = (TParameter<int>*) f->Get("nLayers");
+	return p ? p->GetVal() : 6;
+}
+
+#endif
+
+// Dateiende
@@ -0,0 +1,310 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Summe der Ergebnisdateien aller Gruppen (s. fp13Merge.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Merge.h"
+
+#include <sstream>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include <TROOT.h>
+#include <TFile.h>
+#include <TNamed.h>
+
+#include "logstream.h"
+
+using namespace logstreams;
+
+const char* const fp13ResultMerger::histogramNames[nHistograms] = {
+	"ho", "hu", "hmo", "hmu"
+};
+
+// Konstruktor
+fp13ResultMerger::fp13ResultMerger()
+{ clear(sum); }
+
+// Destruktor
+fp13ResultMerger::~fp13ResultMerger()
+{ release(sum); }
+
+size_t fp13ResultMerger::getNoOfInputs() const
+{ return inputs.size(); }
+
+void fp13ResultMerger::clear(Sum& s)
+{
+	for (unsigned i = 0; i < nHistograms; ++i)
+		s.histograms[i] = 0;
+	s.origin.clear();
+	s.problem.clear();
+}
+
+void fp13ResultMerger::release(Sum& s)
+{
+	for (unsigned i = 0; i < nHistograms; ++i)
+		delete s.histograms[i];
+	clear(s);
+}
+
+// Addieren zweier Summen
+bool fp13ResultMerger::accumulate(Sum& s, Sum& other)
+{
+	if (!other.histograms[0])
+		return true;
+	if (!s.histograms[0]) {
+		s = other;
+		clear(other);
+		return true;
+	}
+	// erst alle Bins pruefen, damit nichts halb addiert wird
+	for (unsigned i = 0; i < nHistograms; ++i) {
+		const TAxis* a = s.histograms[i]->GetXaxis();
+		const TAxis* b = other.histograms[i]->GetXaxis();
+		if (a->GetNbins() != b->GetNbins() ||
+				a->GetXmin() != b->GetXmin() ||
+				a->GetXmax() != b->GetXmax()) {
+			ostringstream problem;
+			problem << "Das Histogramm " << histogramNames[i] <<
+				" in " << other.origin << " hat andere Bins (" <<
+				b->GetNbins() << " von " << b->GetXmin() <<
+				" bis " << b->GetXmax() << ") als in " <<
+				s.origin << " (" << a->GetNbins() << " von " <<
+				a->GetXmin() << " bis " << a->GetXmax() << ").";
+			s.problem = problem.str();
+			release(other);
+			return false;
+		}
+	}
+	for (unsigned i = 0; i < nHistograms; ++i)
+		s.histograms[i]->Add(other.histograms[i]);
+	release(other);
+	return true;
+}
+
+// Lesen einer Ergebnisdatei in die leere Summe s
+bool fp13ResultMerger::read(Sum& s, const string& fileName)
+{
+	TFile* file = TFile::Open(fileName.c_str(), "READ");
+	if (!file) {
+		s.problem = "Fehler beim Oeffnen der Ergebnisdatei " +
+			fileName + ".";
+		return false;
+	}
+	for (unsigned i = 0; i < nHistograms; ++i) {
+		TH1* h = dynamic_cast<TH1*>(file->Get(histogramNames[i]));
+		if (!h) {
+			s.problem = string("Das Histogramm ") +
+				histogramNames[i] + " fehlt in " + fileName +
+				".";
+			release(s);
+			delete file;
+			return false;
+		}
+		// das Histogramm soll die Datei ueberleben
+		h->SetDirectory(0);
+		s.histograms[i] = h;
+	}
+	s.origin = fileName;
+	delete file;
+	return true;
+}
+
+// Summieren eines Blocks von Dateien
+void fp13ResultMerger::readBlock(Sum* s, const vector<string>* fileNames,
+		size_t begin, size_t end)
+{
+	for (size_t i = begin; i < end; ++i) {
+		Sum other;
+		clear(other);
+		if (!read(other, (*fileNames)[i])) {
+			s->problem = other.problem;
+			return;
+		}
+		if (!accumulate(*s, other))
+			return;
+	}
+}
+
+// Addieren zweier Teilsummen
+void fp13ResultMerger::reduce(Sum* s, Sum* other)
+{ accumulate(*s, *other); }
+
+// Laden einer vorhandenen Summe
+bool fp13ResultMerger::load(const string& fileName)
+{
+	TFile* file = TFile::Open(fileName.c_str(), "READ");
+	if (!file) {
+		error << "Fehler beim Oeffnen der Ergebnisdatei " << fileName <<
+			"." << endl;
+		return false;
+	}
+	Sum loaded;
+	clear(loaded);
+	for (unsigned i = 0; i < nHistograms; ++i) {
+		const string name = string(histogramNames[i]) + "All";
+		TH1* h = dynamic_cast<TH1*>(file->Get(name.c_str()));
+		if (!h) {
+			error << "Das Histogramm " << name << " fehlt in " <<
+				fileName << "." << endl;
+			release(loaded);
+			delete file;
+			return false;
+		}
+		h->SetDirectory(0);
+		loaded.histograms[i] = h;
+	}
+	loaded.origin = fileName;
+
+	// Verzeichnis der summierten Ergebnisdateien
+	vector<string> loadedInputs;
+	for (unsigned i = 0; ; ++i) {
+		ostringstream key;
+		key << "inputs/input" << i;
+		TNamed* entry = dynamic_cast<TNamed*>(file->Get(
+					key.str().c_str()));
+		if (!entry)
+			break;
+		loadedInputs.push_back(entry->GetTitle());
+		delete entry;
+	}
+	delete file;
+
+	if (loadedInputs.empty())
+		warn << fileName << " enthaelt kein Verzeichnis der "
+			"summierten Ergebnisdateien, doppelte Dateien werden "
+			"nicht erkannt." << endl;
+	release(sum);
+	sum = loaded;
+	inputs.swap(loadedInputs);
+	return true;
+}
+
+// Addieren von Ergebnisdateien
+bool fp13ResultMerger::add(const vector<string>& fileNames, unsigned nThreads)
+{
+	// volle Pfade, schon summierte Dateien werden uebersprungen
+	vector<string> newInputs;
+	for (size_t i = 0; i < fileNames.size(); ++i) {
+		char* path = realpath(fileNames[i].c_str(), 0);
+		if (!path) {
+			error << "Fehler beim Oeffnen der Ergebnisdatei " <<
+				fileNames[i] << "." << endl;
+			return false;
+		}
+		const string fullPath(path);
+		free(path);
+		if (find(inputs.begin(), inputs.end(), fullPath) !=
+				inputs.end() ||
+				find(newInputs.begin(), newInputs.end(),
+					fullPath) != newInputs.end()) {
+			warn << fileNames[i] << " ist schon in der Summe, "
+				"ueberspringe die Datei." << endl;
+			continue;
+		}
+		newInputs.push_back(fullPath);
+	}
+	if (newInputs.empty())
+		return true;
+	if (nThreads < 1)
+		nThreads = 1;
+	if (nThreads > newInputs.size())
+		nThreads = newInputs.size();
+
+	// jeder Thread summiert einen Block von Dateien
+	ROOT::EnableThreadSafety();
+	vector<Sum> partial(nThreads);
+	vector<thread> threads;
+	for (unsigned t = 0; t < nThreads; ++t) {
+		clear(partial[t]);
+		threads.push_back(thread(&fp13ResultMerger::readBlock,
+					&partial[t], &newInputs,
+					t * newInputs.size() / nThreads,
+					(t + 1) * newInputs.size() / nThreads));
+	}
+	for (unsigned t = 0; t < nThreads; ++t)
+		threads[t].join();
+
+	// Teilsummen paarweise addieren: 0 += 1, 2 += 3, ..., dann
+	// 0 += 2, 4 += 6, ... bis alles in partial[0] steckt
+	bool ok = true;
+	for (unsigned step = 1; ; step *= 2) {
+		for (unsigned t = 0; t < nThreads; t += step) {
+			if (!partial[t].problem.empty()) {
+				error << partial[t].problem << endl;
+				ok = false;
+			}
+		}
+		if (!ok || step >= nThreads)
+			break;
+		threads.clear();
+		for (unsigned t = 0; t + step < nThreads; t += 2 * step)
+			threads.push_back(thread(&fp13ResultMerger::reduce,
+						&partial[t], &partial[t + step]));
+		for (size_t i = 0; i < threads.size(); ++i)
+			threads[i].join();
+	}
+	if (ok && !accumulate(sum, partial[0])) {
+		error << sum.problem << endl;
+		sum.problem.clear();
+		ok = false;
+	}
+	for (unsigned t = 0; t < nThreads; ++t)
+		release(partial[t]);
+	if (!ok)
+		return false;
+
+	inputs.insert(inputs.end(), newInputs.begin(), newInputs.end());
+	return true;
+}
+
+// Schreiben der Summe
+bool fp13ResultMerger::write(const string& fileName) const
+{
+	if (!sum.histograms[0]) {
+		error << "Keine Ergebnisdateien zum Summieren." << endl;
+		return false;
+	}
+	// erst unter einem temporaeren Namen schreiben, dann umbenennen
+	const string tmpFileName = fileName + ".tmp";
+	TFile* file = new TFile(tmpFileName.c_str(), "RECREATE");
+	if (file->IsZombie()) {
+		error << "Fehler beim Oeffnen der Ausgabedatei " <<
+			tmpFileName << "." << endl;
+		delete file;
+		return false;
+	}
+	file->cd();
+	for (unsigned i = 0; i < nHistograms; ++i) {
+		const string name = string(histogramNames[i]) + "All";
+		TH1* h = static_cast<TH1*>(sum.histograms[i]->Clone(
+					name.c_str()));
+		h->SetDirectory(file);
+	}
+	TDirectory* dir = file->mkdir("inputs", "summierte Ergebnisdateien");
+	vector<TNamed*> entries;
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		ostringstream key;
+		key << "input" << i;
+		TNamed* entry = new TNamed(key.str().c_str(), inputs[i].c_str());
+		dir->WriteObject(entry, key.str().c_str());
+		entries.push_back(entry);
+	}
+	file->Write(0, TObject::kOverwrite);
+	file->Close();
+	delete file;
+	for (size_t i = 0; i < entries.size(); ++i)
+		delete entries[i];
+
+	if (0 != rename(tmpFileName.c_str(), fileName.c_str())) {
+		error << "Kann " << tmpFileName << " nicht in " << fileName <<
+			" umbenennen." << endl;
+		remove(tmpFileName.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Dateiende
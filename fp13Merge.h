@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Summe der Ergebnisdateien aller Gruppen (fp13merge)
+//
+// Jede Gruppe schreibt mit Asymmetrie.C eine Ergebnisdatei Results.root
+// mit den Histogrammen ho, hu, hmo und hmu. AccumulatedAsymmetrie.C
+// braucht deren Summe ueber alle Gruppen in ResultsAll.root, dort heissen
+// die Histogramme hoAll, huAll, hmoAll und hmuAll.
+//
+// fp13ResultMerger bildet diese Summe:
+//
+// - die Ergebnisdateien werden mit mehreren Threads gelesen, jeder Thread
+//   summiert einen zusammenhaengenden Block von Dateien; die Teilsummen
+//   werden danach paarweise (wie ein Baum) addiert, auch das parallel
+// - alle Histogramme mit demselben Namen muessen dieselben Bins haben
+//   (Anzahl, untere und obere Grenze); sonst, oder falls eine Datei
+//   fehlt oder ein Histogramm nicht enthaelt, wird nichts addiert
+// - in der Ausgabedatei steht im Verzeichnis "inputs" fuer jede summierte
+//   Ergebnisdatei ein TNamed "input<i>" mit ihrem vollen Pfad als Titel;
+//   beim Anhaengen (load, dann add) werden nur die neuen Dateien gelesen,
+//   die schon summierten werden uebersprungen
+//
+// 	fp13ResultMerger merger;
+// 	merger.load("ResultsAll.root");
+// 	merger.add(fileNames, 8);
+// 	merger.write("ResultsAll.root");
+//
+// Die Ausgabedatei wird zuerst unter einem temporaeren Namen geschrieben
+// und dann umbenannt, eine vorhandene Summe geht also nicht verloren,
+// falls dabei etwas schiefgeht. Andere Objekte in einer vorhandenen
+// Ausgabedatei werden nicht uebernommen.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13MERGE_H
+#define FP13MERGE_H
+
+// C++ headers
+#include <string>
+#include <vector>
+
+// ROOT headers
+#include <TH1.h>
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13ResultMerger
+{
+public:
+	// Histogramme in den Ergebnisdateien; in der Summe wird "All"
+	// angehaengt
+	static const unsigned nHistograms = 4;
+	static const char* const histogramNames[nHistograms];
+
+	fp13ResultMerger();
+	~fp13ResultMerger();
+
+	// Laden der Summe aus fileName, um weitere Dateien anzuhaengen
+	// gibt false zurueck, falls die Datei nicht geoeffnet werden kann oder
+	// ein Histogramm fehlt
+	bool load(const string& fileName);
+
+	// Addieren der Ergebnisdateien fileNames mit nThreads Threads
+	// Dateien, die schon in der Summe stecken (gleicher Pfad), werden mit
+	// einer Warnung uebersprungen
+	// gibt false zurueck, falls eine Datei nicht gelesen werden kann oder
+	// die Bins nicht passen; die Summe bleibt dann unveraendert
+	bool add(const vector<string>& fileNames, unsigned nThreads);
+
+	// Schreiben der Summe nach fileName
+	// gibt false zurueck, falls das nicht geht oder die Summe leer ist
+	bool write(const string& fileName) const;
+
+	// Anzahl der summierten Ergebnisdateien
+	size_t getNoOfInputs() const;
+
+private:
+	// Summe ueber eine Reihe von Ergebnisdateien
+	struct Sum {
+		TH1* histograms[nHistograms];
+		// Datei, aus der die Bins stammen (fuer Fehlermeldungen)
+		string origin;
+		// Fehlermeldung (die logstreams sind nicht threadsicher, gemeldet
+		// wird deshalb erst im Hauptthread)
+		string problem;
+	};
+
+	// Histogramme auf 0 setzen bzw. freigeben
+	static void clear(Sum& sum);
+	static void release(Sum& sum);
+	// Addieren von other zu sum (other wird dabei freigegeben)
+	// gibt false zurueck, falls die Bins nicht passen
+	static bool accumulate(Sum& sum, Sum& other);
+	// Addieren der Ergebnisdatei fileName zu sum
+	static bool read(Sum& sum, const string& fileName);
+	// Summieren der Dateien [begin, end) in sum (ein Thread)
+	static void readBlock(Sum* sum, const vector<string>* fileNames,
+			size_t begin, size_t end);
+	// Addieren zweier Teilsummen (ein Thread)
+	static void reduce(Sum* sum, Sum* other);
+
+	Sum sum;
+	// volle Pfade der summierten Ergebnisdateien
+	vector<string> inputs;
+
+	// nicht kopierbar
+	fp13ResultMerger(const fp13ResultMerger&);
+	fp13ResultMerger& operator=(const fp13ResultMerger&);
+};
+
+#endif
+
+// Dateiende
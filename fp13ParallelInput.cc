@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Paralleles Einlesen einer Textdatei (s. fp13ParallelInput.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13ParallelInput.h"
+
+#include <cstring>
+#include <algorithm>
+
+fp13ParallelInput::fp13ParallelInput(const string& name, fp13MappedFile* f,
+		unsigned nThreads) :
+	fp13Input(name), file(f), start(f->begin()), chunks(2 * nThreads)
+{
+	startThreads(nThreads);
+}
+
+fp13ParallelInput::~fp13ParallelInput()
+{
+	stopThreads();
+	delete file;
+}
+
+// Starten von nThreads Threads, die ab start zerlegen
+void fp13ParallelInput::startThreads(unsigned nThreads)
+{
+	nChunks = (file->end() - start + chunkSize - 1) / chunkSize;
+	nextToParse = current = currentEvent = currentWarning = 0;
+	stopping = false;
+	for (unsigned i = 0; i < chunks.size(); ++i) {
+		chunks[i].index = static_cast<size_t>(-1);
+		chunks[i].done = false;
+	}
+	for (unsigned i = 0; i < nThreads; ++i)
+		threads.push_back(thread(&fp13ParallelInput::worker, this));
+}
+
+// Anhalten aller Threads
+void fp13ParallelInput::stopThreads()
+{
+	// Threads anhalten und warten, bis alle fertig sind
+	{
+		unique_lock<mutex> guard(chunkMutex);
+		stopping = true;
+	}
+	chunkChanged.notify_all();
+	for (unsigned i = 0; i < threads.size(); ++i)
+		threads[i].join();
+	threads.clear();
+}
+
+const fp13MappedFile* fp13ParallelInput::getMappedFile() const
+{ return file; }
+
+bool fp13ParallelInput::skipEvent(size_t& offset) const
+{ return skipTextEvent(file->begin(), file->end(), offset); }
+
+// Weiterlesen ab offset
+bool fp13ParallelInput::seek(size_t offset)
+{
+	if (offset > file->size())
+		return false;
+	const unsigned nThreads = threads.size();
+	stopThreads();
+	start = file->begin() + offset;
+	startThreads(nThreads);
+	return true;
+}
+
+// Anfang der ersten Zeile hinter der naechsten "###"-Zeile ab p
+const char* fp13ParallelInput::alignToEvent(const char* p) const
+{
+	const char* end = file->end();
+	if (p <= start)
+		return start;
+	if (p >= end)
+		return end;
+	// zum Anfang der naechsten Zeile gehen, falls p mitten in einer
+	// Zeile liegt
+	if ('\n' != p[-1]) {
+		p = static_cast<const char*>(memchr(p, '\n', end - p));
+		if (!p)
+			return end;
+		++p;
+	}
+	// nach einer "###"-Zeile faengt das Lesen immer mit einem leeren
+	// Ereignis an, dort darf also ein neues Stueck beginnen
+	while (p != end) {
+		const char* eol = static_cast<const char*>(
+				memchr(p, '\n', end - p));
+		if (!eol)
+			return end;
+		if (isEndOfEvent(p, eol))
+			return eol + 1;
+		p = eol + 1;
+	}
+	return end;
+}
+
+// Zerlegen des Stuecks index
+void fp13ParallelInput::parseChunk(size_t index, Chunk& chunk) const
+{
+	chunk.hitMask.clear();
+	chunk.hitTimes.clear();
+	chunk.eventEnd.clear();
+	chunk.warnings.clear();
+
+	// das erste Stueck beginnt genau bei start, das ist immer der
+	// Anfang eines Ereignisses
+	const char* p = alignToEvent(start + index * chunkSize);
+	const char* end = (index + 1 == nChunks) ? file->end() :
+		alignToEvent(start + (index + 1) * chunkSize);
+
+	// Zeilen wie in fp13MappedInput::readEvent verarbeiten, die fertigen
+	// Ereignisse werden hinten an den Puffer gehaengt
+	vector<int> hitMask, hitTimes;
+	hitMask.reserve(32);
+	hitTimes.reserve(32);
+	unsigned merged = 0;
+	while (p != end) {
+		const char* line = p;
+		const char* eol = static_cast<const char*>(
+				memchr(line, '\n', end - line));
+		p = eol ? (eol + 1) : end;
+		if (processLine(line, eol ? eol : end, hitMask, hitTimes,
+					merged, chunk.eventEnd.size(),
+					chunk.warnings)) {
+			chunk.hitMask.insert(chunk.hitMask.end(),
+					hitMask.begin(), hitMask.end());
+			chunk.hitTimes.insert(chunk.hitTimes.end(),
+					hitTimes.begin(), hitTimes.end());
+			chunk.eventEnd.push_back(chunk.hitMask.size());
+			hitMask.clear();
+			hitTimes.clear();
+			merged = 0;
+		}
+	}
+	// letztes Ereignis der Datei ohne "###" am Ende
+	if (!hitMask.empty()) {
+		chunk.hitMask.insert(chunk.hitMask.end(),
+				hitMask.begin(), hitMask.end());
+		chunk.hitTimes.insert(chunk.hitTimes.end(),
+				hitTimes.begin(), hitTimes.end());
+		chunk.eventEnd.push_back(chunk.hitMask.size());
+	}
+}
+
+// Hauptschleife der Threads: naechstes freies Stueck holen und zerlegen
+void fp13ParallelInput::worker()
+{
+	unique_lock<mutex> guard(chunkMutex);
+	for (;;) {
+		// warten, bis ein Puffer frei wird
+		while (!stopping && nextToParse < nChunks &&
+				nextToParse >= current + chunks.size())
+			chunkChanged.wait(guard);
+		if (stopping || nextToParse >= nChunks)
+			return;
+		const size_t index = nextToParse++;
+		Chunk& chunk = chunks[index % chunks.size()];
+
+		// das Zerlegen selbst passiert ohne Lock
+		guard.unlock();
+		parseChunk(index, chunk);
+		guard.lock();
+
+		chunk.index = index;
+		chunk.done = true;
+		chunkChanged.notify_all();
+	}
+}
+
+int fp13ParallelInput::readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+		unsigned long eventCounter)
+{
+	for (;;) {
+		if (current >= nChunks)
+			return -1;
+
+		// warten, bis das aktuelle Stueck zerlegt ist
+		Chunk& chunk = chunks[current % chunks.size()];
+		{
+			unique_lock<mutex> guard(chunkMutex);
+			while (!(chunk.done && current == chunk.index))
+				chunkChanged.wait(guard);
+		}
+
+		// Nummer des ersten Ereignisses im Stueck
+		const unsigned long eventOffset = eventCounter - currentEvent;
+		if (currentEvent < chunk.eventEnd.size()) {
+			// Warnungen zu diesem Ereignis ausgeben
+			vector<Warning>::const_iterator
+				w = chunk.warnings.begin() + currentWarning,
+				wend = w;
+			while (wend != chunk.warnings.end() &&
+					wend->event <= currentEvent)
+				++wend;
+			printWarnings(w, wend, eventOffset);
+			currentWarning = wend - chunk.warnings.begin();
+
+			// Ereignis abliefern
+			const size_t begin = currentEvent ?
+				chunk.eventEnd[currentEvent - 1] : 0;
+			const size_t end = chunk.eventEnd[currentEvent];
+			hitMask.assign(chunk.hitMask.begin() + begin,
+					chunk.hitMask.begin() + end);
+			hitTimes.assign(chunk.hitTimes.begin() + begin,
+					chunk.hitTimes.begin() + end);
+			++currentEvent;
+			return 0;
+		}
+
+		// Stueck ist abgearbeitet: restliche Warnungen (zu Zeilen nach
+		// dem letzten Ereignis) ausgeben und Puffer freigeben
+		printWarnings(chunk.warnings.begin() + currentWarning,
+				chunk.warnings.end(), eventOffset);
+		{
+			unique_lock<mutex> guard(chunkMutex);
+			chunk.done = false;
+			++current;
+			currentEvent = currentWarning = 0;
+		}
+		chunkChanged.notify_all();
+	}
+}
+
+// Dateiende
@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Paralleles Einlesen einer Textdatei
+//
+// Die Ereignisse einer Textdatei sind voneinander unabhaengig und durch
+// "###" sauber getrennt. fp13ParallelInput teilt die eingeblendete Datei
+// daher in Stuecke (chunks) von chunkSize Bytes, deren Grenzen jeweils
+// auf das Ende der naechsten "###"-Zeile verschoben werden, und laesst
+// diese Stuecke von mehreren Threads gleichzeitig zerlegen.
+//
+// readEvent liefert die Ereignisse trotzdem in der Reihenfolge der Datei
+// ab. Die Warnungen zu den Eingabedaten werden beim Zerlegen nur
+// gesammelt und erst beim Abliefern des zugehoerigen Ereignisses mit der
+// dann bekannten Ereignisnummer ausgegeben, so dass Histogramme und
+// Meldungen genau denen beim Lesen mit einem Thread entsprechen.
+//
+// Damit der Speicherbedarf begrenzt bleibt, sind hoechstens
+// 2 * nThreads Stuecke gleichzeitig in Arbeit.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13PARALLELINPUT_H
+#define FP13PARALLELINPUT_H
+
+// C++ headers
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "fp13Input.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13ParallelInput : public fp13Input
+{
+public:
+	// liest aus der eingeblendeten Datei file, die dabei in den Besitz
+	// des fp13ParallelInput uebergeht, mit nThreads Threads
+	fp13ParallelInput(const string& fileName, fp13MappedFile* file,
+			unsigned nThreads);
+	virtual ~fp13ParallelInput();
+
+	virtual int readEvent(vector<int>& hitMask, vector<int>& hitTimes,
+			unsigned long eventCounter);
+
+	virtual const fp13MappedFile* getMappedFile() const;
+	virtual bool skipEvent(size_t& offset) const;
+	// haelt die Threads an und laesst sie ab offset neu anfangen
+	virtual bool seek(size_t offset);
+
+	// Groesse der Stuecke, in die die Datei zerlegt wird, in Bytes
+	static const size_t chunkSize = 4 << 20;
+
+protected:
+	// ein zerlegtes Stueck der Datei
+	struct Chunk {
+		// Nummer des Stuecks, das in diesem Puffer liegt
+		size_t index;
+		// fertig zerlegt?
+		bool done;
+		// Hitmuster und Zeiten aller Ereignisse hintereinander
+		vector<int> hitMask, hitTimes;
+		// Ende jedes Ereignisses in hitMask/hitTimes
+		vector<size_t> eventEnd;
+		// Warnungen; Warning::event zaehlt ab dem Anfang des Stuecks
+		vector<Warning> warnings;
+	};
+
+	// Starten von nThreads Threads, die ab start zerlegen
+	void startThreads(unsigned nThreads);
+	// Anhalten aller Threads
+	void stopThreads();
+	// Anfang der ersten Zeile hinter der naechsten "###"-Zeile ab p
+	const char* alignToEvent(const char* p) const;
+	// Zerlegen des Stuecks index in chunk
+	void parseChunk(size_t index, Chunk& chunk) const;
+	// Hauptschleife der Threads
+	void worker();
+
+	fp13MappedFile* file;
+	// Anfang des ersten Stuecks (Dateianfang oder Ziel von seek)
+	const char* start;
+	// Anzahl der Stuecke insgesamt
+	size_t nChunks;
+	// Puffer fuer die Stuecke in Arbeit; Stueck i liegt in
+	// chunks[i % chunks.size()]
+	vector<Chunk> chunks;
+	// naechstes zu zerlegendes Stueck
+	size_t nextToParse;
+	// Stueck, aus dem gerade Ereignisse abgeliefert werden, und
+	// Position darin
+	size_t current;
+	size_t currentEvent;
+	size_t currentWarning;
+	// Threads werden beendet
+	bool stopping;
+
+	vector<thread> threads;
+	mutex chunkMutex;
+	condition_variable chunkChanged;
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,284 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Analyse vieler Laeufe in einem Aufruf (s. fp13RunSet.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13RunSet.h"
+
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <utility>
+#include <climits>
+#include <cstdlib>
+
+// C header files (fuer stat)
+#include <sys/stat.h>
+
+#include <TROOT.h>
+
+#include "fp13Input.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+// Konstruktor
+template <int N>
+fp13BasicRunSet<N>::fp13BasicRunSet(Analysis* analysis,
+		unsigned readThreads) :
+	combined(analysis), nReadThreads(readThreads), next(0)
+{ }
+
+// Destruktor
+template <int N>
+fp13BasicRunSet<N>::~fp13BasicRunSet()
+{
+	for (size_t i = 0; i < runs.size(); ++i) {
+		// die Histogramme landen im Verzeichnis des Laufs und werden
+		// mit der Ausgabedatei im Destruktor von combined geschrieben
+		runs[i].analysis->writeHistograms();
+		delete runs[i].analysis;
+		delete runs[i].log;
+	}
+	delete combined;
+}
+
+// Name des Verzeichnisses fuer eine Eingabedatei
+template <int N>
+string fp13BasicRunSet<N>::runName(const string& fileName)
+{
+	if ("-" == fileName)
+		return "stdin";
+	string name = fileName.substr(fileName.rfind('/') + 1);
+	// Kompressionsendung und Endung abschneiden
+	static const char* const compressed[] = { ".gz", ".zst" };
+	for (unsigned i = 0; i < 2; ++i) {
+		const string suffix(compressed[i]);
+		if (name.size() > suffix.size() && 0 == name.compare(
+					name.size() - suffix.size(),
+					suffix.size(), suffix)) {
+			name.erase(name.size() - suffix.size());
+			break;
+		}
+	}
+	const string::size_type dot = name.rfind('.');
+	if (string::npos != dot && dot > 0)
+		name.erase(dot);
+	return name.empty() ? string("run") : name;
+}
+
+// Hinzufuegen eines Laufs
+template <int N>
+bool fp13BasicRunSet<N>::add(const string& fileName)
+{
+	Run run;
+	run.fileName = fileName;
+	run.size = 0;
+	run.seconds = 0.;
+	run.failed = false;
+	if ("-" != fileName) {
+		struct stat st;
+		if (0 != stat(fileName.c_str(), &st)) {
+			error << "Fehler beim Oeffnen der Eingabedatei " <<
+				fileName << "." << endl;
+			return false;
+		}
+		if (S_ISREG(st.st_mode))
+			run.size = st.st_size;
+	}
+
+	// dieselbe Datei zweimal wuerde doppelt in die Summe eingehen
+	run.path = fileName;
+	if ("-" != fileName) {
+		char* path = realpath(fileName.c_str(), 0);
+		if (path) {
+			run.path = path;
+			free(path);
+		}
+	}
+	for (size_t i = 0; i < runs.size(); ++i) {
+		if (runs[i].path == run.path) {
+			warn << fileName << " ist schon Lauf " << runs[i].name <<
+				", ueberspringe die Datei." << endl;
+			return true;
+		}
+	}
+
+	// gleichnamige Dateien aus verschiedenen Verzeichnissen bekommen
+	// eine laufende Nummer
+	const string base = runName(fileName);
+	run.name = base;
+	for (unsigned n = 2; ; ++n) {
+		bool used = false;
+		for (size_t i = 0; i < runs.size() && !used; ++i)
+			used = (runs[i].name == run.name);
+		if (!used)
+			break;
+		ostringstream name;
+		name << base << '_' << n;
+		run.name = name.str();
+	}
+
+	// Worker-Objekt mit eigenen Histogrammen im Verzeichnis des Laufs
+	run.analysis = combined->createWorker();
+	run.analysis->outputDirectory = combined->outputFile.mkdir(
+			run.name.c_str(), fileName.c_str());
+	run.log = new logbuffer;
+	runs.push_back(run);
+	return true;
+}
+
+template <int N>
+size_t fp13BasicRunSet<N>::getNoOfRuns() const
+{ return runs.size(); }
+
+template <int N>
+unsigned long fp13BasicRunSet<N>::getNoOfEvents() const
+{ return combined->eventCounter; }
+
+template <int N>
+unsigned long fp13BasicRunSet<N>::getNoOfAnalyzedEvents() const
+{ return combined->analyzedCounter; }
+
+// Analysieren aller Laeufe
+template <int N>
+bool fp13BasicRunSet<N>::analyze(unsigned long maxNoOfEvents,
+		unsigned nThreads)
+{
+	if (runs.empty())
+		return true;
+	if (nThreads > runs.size())
+		nThreads = runs.size();
+
+	// grosse Laeufe zuerst, Streams (unbekannte Groesse) ganz vorne;
+	// sortiert wird nach (ULLONG_MAX - Groesse, Index)
+	vector<pair<unsigned long long, size_t> > keys;
+	for (size_t i = 0; i < runs.size(); ++i)
+		keys.push_back(make_pair(runs[i].size ?
+					(ULLONG_MAX - runs[i].size) : 0, i));
+	sort(keys.begin(), keys.end());
+	order.clear();
+	for (size_t i = 0; i < keys.size(); ++i)
+		order.push_back(keys[i].second);
+	next = 0;
+	finished.clear();
+
+	ROOT::EnableThreadSafety();
+	vector<thread> threads;
+	for (unsigned i = 0; i < nThreads; ++i)
+		threads.push_back(thread(&fp13BasicRunSet::workerLoop, this,
+					maxNoOfEvents));
+
+	// fertige Laeufe melden, sobald sie fertig sind, mit den Meldungen
+	// aus ihren Threads (nur aus diesem Thread, die logstreams sind
+	// nicht threadsicher)
+	bool ok = true;
+	for (size_t nReported = 0; nReported < runs.size(); ) {
+		vector<size_t> done;
+		{
+			unique_lock<mutex> lock(runMutex);
+			while (finished.empty())
+				runFinished.wait(lock);
+			done.swap(finished);
+		}
+		for (size_t i = 0; i < done.size(); ++i, ++nReported) {
+			const Run& run = runs[done[i]];
+			run.log->write();
+			if (run.failed) {
+				error << "Fehler beim Oeffnen der Eingabedatei " <<
+					run.fileName << "." << endl;
+				ok = false;
+				continue;
+			}
+			info << "Lauf " << run.name << " (" << (nReported + 1) <<
+				"/" << runs.size() << "): " <<
+				run.analysis->eventCounter << " Ereignisse "
+				"gelesen, davon " <<
+				run.analysis->analyzedCounter << " analysiert, " <<
+				fixed << setprecision(1) << run.seconds << " s." <<
+				endl;
+		}
+	}
+	for (unsigned i = 0; i < nThreads; ++i)
+		threads[i].join();
+
+	// Summe in fester Reihenfolge bilden
+	for (size_t i = 0; i < runs.size(); ++i) {
+		const Analysis& analysis = *runs[i].analysis;
+		combined->mergeHistograms(analysis);
+		combined->eventCounter += analysis.eventCounter;
+		combined->analyzedCounter += analysis.analyzedCounter;
+	}
+	return ok;
+}
+
+// Schleife eines Threads
+template <int N>
+void fp13BasicRunSet<N>::workerLoop(unsigned long maxNoOfEvents)
+{
+	for (;;) {
+		size_t index;
+		{
+			lock_guard<mutex> lock(runMutex);
+			if (next == order.size())
+				return;
+			index = order[next++];
+		}
+		analyzeRun(runs[index], maxNoOfEvents);
+		{
+			lock_guard<mutex> lock(runMutex);
+			finished.push_back(index);
+		}
+		runFinished.notify_one();
+	}
+}
+
+// Lesen und Analysieren eines Laufs
+template <int N>
+void fp13BasicRunSet<N>::analyzeRun(Run& run, unsigned long maxNoOfEvents)
+{
+	const chrono::steady_clock::time_point start =
+		chrono::steady_clock::now();
+	// Meldungen sammeln, analyze gibt sie aus
+	run.log->start();
+	fp13Input* input;
+	{
+		lock_guard<mutex> lock(openMutex);
+		input = fp13Input::open(run.fileName, nReadThreads);
+	}
+	if (!input) {
+		run.failed = true;
+		run.log->stop();
+		return;
+	}
+
+	// wie die Schleife in fp13.cc, nur ohne Statusreport
+	Analysis& analysis = *run.analysis;
+	while (0 == input->readEvent(analysis.inputHitMask,
+				analysis.detectorHitTimes,
+				analysis.eventCounter)) {
+		analysis.currentEvent = analysis.eventCounter++;
+		if (!analysis.setHitMask(analysis.inputHitMask))
+			continue;
+		analysis.analyze();
+		if (analysis.analyzedCounter >= maxNoOfEvents)
+			break;
+	}
+	delete input;
+	run.log->stop();
+	run.seconds = chrono::duration<double>(
+			chrono::steady_clock::now() - start).count();
+}
+
+////////////////////////////////////////////////////////////////////////
+// Instanzen fuer die unterstuetzten Detektorgroessen (fp13 -l)
+////////////////////////////////////////////////////////////////////////
+template class fp13BasicRunSet<6>;
+template class fp13BasicRunSet<8>;
+template class fp13BasicRunSet<12>;
+template class fp13BasicRunSet<16>;
+template class fp13BasicRunSet<32>;
+
+// Dateiende
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Analyse vieler Laeufe in einem Aufruf (fp13 mit mehreren Eingabedateien)
+//
+// Eine Messperiode besteht aus vielen Laeufen, jeder in einer eigenen
+// Eingabedatei. fp13BasicRunSet analysiert sie gleichzeitig mit mehreren
+// Threads, jeden Lauf in einem Thread mit einem eigenen Analyseobjekt,
+// und schreibt alles in eine Ausgabedatei:
+//
+// - die Histogramme jedes Laufs in ein Verzeichnis mit dem Namen der
+//   Eingabedatei ohne Pfad und Endungen (s. runName); der Titel des
+//   Verzeichnisses ist der volle Name der Eingabedatei
+// - die Summe ueber alle Laeufe wie gewohnt direkt in die Datei, so dass
+//   die Makros sie ohne Aenderung auswerten koennen
+//
+// Die Analyseobjekte der Laeufe sind Worker-Objekte des Analyseobjekts
+// fuer die Summe (s. fp13BasicAnalysis::createWorker), abgeleitete
+// Klassen analysieren also auch hier mit ihren eigenen Methoden:
+//
+// 	fp13RunSet runs(new fp13Analysis("season.root"));
+// 	runs.add("run01.txt");
+// 	runs.add("run02.txt.gz");
+// 	runs.analyze(maxNoOfEvents, 8);
+//
+// Damit lange und kurze Laeufe sich gut auf die Threads verteilen, werden
+// die Laeufe nach der Groesse ihrer Eingabedatei absteigend abgearbeitet;
+// jeder Thread holt sich den naechsten, sobald er fertig ist. Die Summe
+// wird am Ende in der Reihenfolge von add gebildet, sie ist also (wie die
+// Histogramme der Laeufe) unabhaengig von der Anzahl der Threads.
+//
+// Die logstreams sind nicht threadsicher: was beim Lesen und Analysieren
+// eines Laufs gemeldet wird (Fehler beim Oeffnen, Warnungen zu einzelnen
+// Ereignissen), sammelt der Thread des Laufs in einem logbuffer, und der
+// Thread, der analyze aufgerufen hat, gibt es mit der Meldung ueber den
+// fertigen Lauf aus.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13RUNSET_H
+#define FP13RUNSET_H
+
+// C++ headers
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "fp13Analysis.h"
+#include "logstream.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+template <int N>
+class fp13BasicRunSet
+{
+public:
+	typedef fp13BasicAnalysis<N> Analysis;
+
+	// combined ist das Analyseobjekt fuer die Summe ueber alle Laeufe,
+	// ohne eigene Eingabe (s. fp13BasicAnalysis(outputFileName)); es
+	// geht in den Besitz von fp13BasicRunSet ueber
+	// die Eingabedateien werden mit nReadThreads Threads gelesen (s.
+	// fp13ParallelInput.h)
+	explicit fp13BasicRunSet(Analysis* combined, unsigned nReadThreads = 1);
+	// schreibt die Histogramme aller Laeufe und die Ausgabedatei
+	~fp13BasicRunSet();
+
+	// Hinzufuegen eines Laufs mit der Eingabedatei fileName
+	// gibt false zurueck, falls es die Datei nicht gibt; eine Datei, die
+	// (unter welchem Namen auch immer) schon ein Lauf ist, wird mit einer
+	// Warnung uebersprungen
+	bool add(const string& fileName);
+
+	// Analysieren von hoechstens maxNoOfEvents Ereignissen jedes Laufs
+	// mit nThreads Threads
+	// gibt false zurueck, falls eine Eingabedatei nicht geoeffnet werden
+	// konnte (die anderen Laeufe werden trotzdem analysiert)
+	bool analyze(unsigned long maxNoOfEvents, unsigned nThreads);
+
+	size_t getNoOfRuns() const;
+	// Summen ueber alle Laeufe
+	unsigned long getNoOfEvents() const;
+	unsigned long getNoOfAnalyzedEvents() const;
+
+	// Name des Verzeichnisses fuer die Eingabedatei fileName: ohne Pfad,
+	// Kompressionsendung (.gz, .zst) und Endung, also z.B. "run01" fuer
+	// "daten/run01.txt.gz" ("stdin" fuer "-")
+	static string runName(const string& fileName);
+
+private:
+	// ein Lauf
+	struct Run {
+		string fileName, name;
+		// voller Pfad der Eingabedatei ("-" fuer stdin)
+		string path;
+		// Analyseobjekt des Laufs mit Histogrammen im Verzeichnis name
+		Analysis* analysis;
+		// Groesse der Eingabedatei in Bytes (0 fuer Streams)
+		unsigned long long size;
+		// Dauer der Analyse in s; failed, falls die Eingabedatei nicht
+		// geoeffnet werden konnte
+		double seconds;
+		bool failed;
+		// Meldungen beim Lesen und Analysieren des Laufs
+		logstreams::logbuffer* log;
+	};
+
+	// Lesen und Analysieren eines Laufs
+	void analyzeRun(Run& run, unsigned long maxNoOfEvents);
+	// Schleife eines Threads: analysiert Laeufe, bis keiner mehr da ist
+	void workerLoop(unsigned long maxNoOfEvents);
+
+	Analysis* combined;
+	unsigned nReadThreads;
+	vector<Run> runs;
+	// Reihenfolge der Laeufe (Index in runs), der naechste zu
+	// analysierende und die fertigen, die noch nicht gemeldet sind
+	vector<size_t> order;
+	size_t next;
+	vector<size_t> finished;
+	mutex runMutex;
+	condition_variable runFinished;
+	// die Eingabedateien werden nacheinander geoeffnet, damit sich die
+	// Fehlermeldungen dabei nicht vermischen
+	mutex openMutex;
+
+	// nicht kopierbar
+	fp13BasicRunSet(const fp13BasicRunSet&);
+	fp13BasicRunSet& operator=(const fp13BasicRunSet&);
+};
+
+// Laeufe fuer den Detektor im Praktikum
+typedef fp13BasicRunSet<6> fp13RunSet;
+
+#endif
+
+// Dateiende
@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Analyse mehrerer Konfigurationen in einem Durchgang (s. fp13Scan.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Scan.h"
+
+#include <sstream>
+#include <typeinfo>
+
+#include <TParameter.h>
+
+#include "fp13Input.h"
+#include "logstream.h"
+
+using namespace logstreams;
+
+////////////////////////////////////////////////////////////////////////
+// fp13ScanConfig
+////////////////////////////////////////////////////////////////////////
+fp13ScanConfig::fp13ScanConfig() :
+	minDelay(fp13Analysis::defMinDelay),
+	mergeWindow(fp13Input::defMergeWindow),
+	variant("default")
+{ }
+
+bool fp13ScanConfig::parse(const string& spec)
+{
+	// Felder zwischen den Doppelpunkten
+	vector<string> fields;
+	string::size_type begin = 0, end;
+	do {
+		end = spec.find(':', begin);
+		fields.push_back(spec.substr(begin, (string::npos == end) ?
+					string::npos : (end - begin)));
+		begin = end + 1;
+	} while (string::npos != end);
+	if (fields.size() > 4 || fields[0].empty())
+		return false;
+
+	name = fields[0];
+	int* const numbers[] = { &minDelay, &mergeWindow };
+	for (size_t i = 1; i < fields.size() && i < 3; ++i) {
+		if (fields[i].empty())
+			continue;
+		istringstream stream(fields[i]);
+		if (!(stream >> *numbers[i - 1]) || !stream.eof())
+			return false;
+	}
+	if (fields.size() > 3 && !fields[3].empty())
+		variant = fields[3];
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////
+// fp13BasicScan
+////////////////////////////////////////////////////////////////////////
+// Konstruktor
+template <int N>
+fp13BasicScan<N>::fp13BasicScan(const string& inputFileName,
+		const string& outputFileName, unsigned nReadThreads) :
+	Base(inputFileName, outputFileName, nReadThreads, false)
+{
+	// die Eingabe liest die Zeitbins so, wie sie in der Datei stehen;
+	// zusammengefasst wird erst in analyze fuer jede Konfiguration
+	mergeWindow = this->inputFile->getMergeWindow();
+	this->inputFile->setMergeWindow(-1);
+}
+
+// Konstruktor fuer Worker-Objekte
+template <int N>
+fp13BasicScan<N>::fp13BasicScan(const fp13BasicScan& master) :
+	Base(master), mergeWindow(master.mergeWindow), names(master.names),
+	mergeWindows(master.mergeWindows)
+{
+	for (size_t i = 0; i < master.configs.size(); ++i)
+		configs.push_back(master.configs[i]->createWorker());
+}
+
+// Destruktor
+template <int N>
+fp13BasicScan<N>::~fp13BasicScan()
+{
+	for (size_t i = 0; i < configs.size(); ++i) {
+		// die Histogramme landen im Verzeichnis der Konfiguration und
+		// werden mit der Ausgabedatei im Destruktor von
+		// fp13BasicAnalysis geschrieben
+		if (!this->isWorker)
+			configs[i]->writeHistograms();
+		delete configs[i];
+	}
+}
+
+// Hinzufuegen einer Konfiguration
+template <int N>
+bool fp13BasicScan<N>::addConfiguration(const fp13ScanConfig& config)
+{
+	for (size_t i = 0; i < names.size(); ++i) {
+		if (names[i] == config.name) {
+			error << "Die Konfiguration " << config.name <<
+				" gibt es schon." << endl;
+			return false;
+		}
+	}
+	Base* analysis = createVariant(config.variant);
+	if (!analysis) {
+		error << "Unbekannte Variante " << config.variant <<
+			" fuer Konfiguration " << config.name << "." << endl;
+		return false;
+	}
+	analysis->setMinDelay(config.minDelay);
+	// Kandidaten (s. writeCandidates) schreibt nur die Standardanalyse
+	delete analysis->candidates;
+	analysis->candidates = 0;
+	analysis->candidateWriter = 0;
+
+	// eigenes Verzeichnis mit den Parametern der Konfiguration
+	TDirectory* directory = this->outputFile.mkdir(config.name.c_str());
+	directory->Append(new TParameter<int>("minDelay", config.minDelay));
+	directory->Append(new TParameter<int>("mergeWindow",
+				config.mergeWindow));
+	analysis->outputDirectory = directory;
+
+	names.push_back(config.name);
+	configs.push_back(analysis);
+	mergeWindows.push_back(config.mergeWindow);
+	info << "Konfiguration " << config.name << ": minDelay " <<
+		config.minDelay << " ns, mergeWindow " <<
+		config.mergeWindow << " ns, Variante " << config.variant <<
+		endl;
+	return true;
+}
+
+// Analyse des aktuellen Ereignisses
+template <int N>
+void fp13BasicScan<N>::analyze()
+{
+	// das gelesene Ereignis beiseite legen...
+	rawHitMask.swap(this->detectorHitMask);
+	rawHitTimes.swap(this->detectorHitTimes);
+	// ... fuer jede Konfiguration zusammenfassen und analysieren ...
+	for (size_t i = 0; i < configs.size(); ++i) {
+		Base& config = *configs[i];
+		config.currentEvent = this->currentEvent;
+		fp13Input::mergeTimeBins(mergeWindows[i], rawHitMask,
+				rawHitTimes, config.detectorHitMask,
+				config.detectorHitTimes);
+		config.analyze();
+	}
+	// ... und zuletzt wie in der normalen Analyse
+	fp13Input::mergeTimeBins(mergeWindow, rawHitMask, rawHitTimes,
+			this->detectorHitMask, this->detectorHitTimes);
+	Base::analyze();
+}
+
+// Analyse eines Pakets
+template <int N>
+void fp13BasicScan<N>::analyzeBatch(const Batch& batch)
+{
+	// die Pakete enthalten nicht zusammengefasste Zeitbins, daher
+	// kann nicht das ganze Paket auf einmal klassifiziert werden
+	this->analyzeEachEvent(batch);
+}
+
+// Erzeugen eines Worker-Objekts
+template <int N>
+typename fp13BasicScan<N>::Base* fp13BasicScan<N>::createWorker() const
+{ return new fp13BasicScan(*this); }
+
+template <int N>
+bool fp13BasicScan<N>::hasOwnFinders() const
+{ return typeid(*this) != typeid(fp13BasicScan); }
+
+// Addieren der Histogramme eines Worker-Objekts
+template <int N>
+void fp13BasicScan<N>::mergeHistograms(const Base& worker)
+{
+	Base::mergeHistograms(worker);
+	const fp13BasicScan& scanWorker =
+		static_cast<const fp13BasicScan&>(worker);
+	for (size_t i = 0; i < configs.size(); ++i)
+		configs[i]->mergeHistograms(*scanWorker.configs[i]);
+}
+
+// Erzeugen des Analyseobjekts einer Konfiguration
+template <int N>
+typename fp13BasicScan<N>::Base* fp13BasicScan<N>::createVariant(
+		const string& variant) const
+{
+	// ein Worker-Objekt hat eigene Histogramme und liest nicht selbst
+	if ("default" == variant)
+		return Base::createWorker();
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////
+// Instanzen fuer die unterstuetzten Detektorgroessen (fp13 -l)
+////////////////////////////////////////////////////////////////////////
+template class fp13BasicScan<6>;
+template class fp13BasicScan<8>;
+template class fp13BasicScan<12>;
+template class fp13BasicScan<16>;
+template class fp13BasicScan<32>;
+
+// Dateiende
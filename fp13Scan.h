@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Analyse mehrerer Konfigurationen in einem Durchgang (fp13 -S)
+//
+// Fuer systematische Studien wird dieselbe Messung mit verschiedenen
+// Schnitten analysiert: minimale Verzoegerung (minDelay), Zeitfenster
+// zum Zusammenfassen von Zeitbins beim Lesen (s. fp13Input::
+// setMergeWindow) und Variante der Methoden zum Finden von Zerfaellen
+// und Nachpulsen. Statt die Eingabedatei fuer jede Konfiguration neu zu
+// lesen, liest fp13BasicScan jedes Ereignis einmal mit ausgeschaltetem
+// Zusammenfassen und gibt es an ein Analyseobjekt pro Konfiguration
+// weiter, nachdem es die Zeitbins mit dem Zeitfenster der Konfiguration
+// zusammengefasst hat (fp13Input::mergeTimeBins, liefert dasselbe wie
+// beim Lesen).
+//
+// Die Histogramme der Standardanalyse stehen wie immer direkt in der
+// Ausgabedatei, die jeder Konfiguration in einem Verzeichnis mit ihrem
+// Namen, zusammen mit den TParameter<int> "minDelay" und "mergeWindow".
+//
+// Warnungen zu nicht streng monoton steigenden Zeiten beziehen sich im
+// Scan auf die nicht zusammengefassten Zeitbins und koennen daher von
+// denen einer normalen Analyse abweichen; an den Histogrammen aendert
+// das nichts.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13SCAN_H
+#define FP13SCAN_H
+
+// C++ headers
+#include <string>
+#include <vector>
+
+#include "fp13Analysis.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+// eine Konfiguration des Scans
+struct fp13ScanConfig
+{
+	// Name des Verzeichnisses in der Ausgabedatei
+	string name;
+	// minimale Verzoegerung in ns (s. fp13BasicAnalysis::minDelay)
+	int minDelay;
+	// Zeitfenster zum Zusammenfassen in ns, -1 schaltet es ab
+	int mergeWindow;
+	// Variante der Methoden zum Finden (s. fp13BasicScan::createVariant)
+	string variant;
+
+	// Standardwerte wie in der normalen Analyse
+	fp13ScanConfig();
+
+	// Lesen aus "name:minDelay:mergeWindow[:variant]"; leere Felder
+	// behalten ihren Standardwert, also z.B. "d45:45" oder "m40::40"
+	// gibt false zurueck, falls spec nicht so aussieht
+	bool parse(const string& spec);
+};
+
+template <int N>
+class fp13BasicScan : public fp13BasicAnalysis<N>
+{
+public:
+	typedef fp13BasicAnalysis<N> Base;
+	typedef typename Base::Batch Batch;
+
+	// wie fp13BasicAnalysis (ohne Verfolgen der Eingabedatei)
+	fp13BasicScan(const string& inputFileName,
+			const string& outputFileName,
+			unsigned nReadThreads = 1);
+	// schreibt die Histogramme aller Konfigurationen
+	virtual ~fp13BasicScan();
+
+	// Hinzufuegen einer Konfiguration
+	// gibt false zurueck, falls der Name schon vergeben oder die
+	// Variante unbekannt ist
+	bool addConfiguration(const fp13ScanConfig& config);
+
+	// Analyse des aktuellen Ereignisses mit allen Konfigurationen und
+	// der Standardanalyse
+	virtual void analyze();
+	// Analyse eines Pakets, Ereignis fuer Ereignis
+	virtual void analyzeBatch(const Batch& batch);
+
+protected:
+	// Konstruktor fuer Worker-Objekte: jede Konfiguration bekommt
+	// ebenfalls ein Worker-Objekt
+	fp13BasicScan(const fp13BasicScan& master);
+	virtual Base* createWorker() const;
+
+	// die Standardanalyse benutzt die Methoden von fp13BasicAnalysis
+	virtual bool hasOwnFinders() const;
+
+	// Addieren der Histogramme eines Worker-Objekts, auch fuer alle
+	// Konfigurationen
+	virtual void mergeHistograms(const Base& worker);
+
+	// Erzeugen des Analyseobjekts fuer eine Konfiguration mit der
+	// Variante variant, 0 falls es die Variante nicht gibt
+	// Eingebaut ist nur "default" (die Methoden von fp13BasicAnalysis).
+	// Eigene Varianten bekommt man, indem man ableitet und diese
+	// Methode ueberschreibt, z.B. mit
+	//
+	// 	if ("mine" == variant) return new MyAnalysis(*this);
+	//
+	// wobei MyAnalysis einen Konstruktor fuer Worker-Objekte (s.
+	// fp13BasicAnalysis) haben muss.
+	virtual Base* createVariant(const string& variant) const;
+
+	// Zeitfenster zum Zusammenfassen fuer die Standardanalyse
+	int mergeWindow;
+	// Namen, Analyseobjekte und Zeitfenster der Konfigurationen
+	vector<string> names;
+	vector<Base*> configs;
+	vector<int> mergeWindows;
+	// das gelesene Ereignis, nicht zusammengefasst
+	vector<typename Base::Mask> rawHitMask;
+	vector<int> rawHitTimes;
+
+private:
+	// nicht zuweisbar
+	fp13BasicScan& operator=(const fp13BasicScan&);
+};
+
+// Scan fuer den Detektor im Praktikum
+typedef fp13BasicScan<6> fp13Scan;
+
+#endif
+
+// Dateiende
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Skim der analysierbaren Ereignisse (s. fp13Skim.h)
+////////////////////////////////////////////////////////////////////////
+#include "fp13Skim.h"
+
+#include "logstream.h"
+
+using namespace logstreams;
+
+fp13SkimOutput::fp13SkimOutput(const string& name, unsigned maskBytes,
+		const string& input, int window) :
+	fileName(name), inputFileName(input), mergeWindow(window),
+	out(name.c_str(), ios::out | ios::binary | ios::trunc),
+	output(out, maskBytes),
+	firstEvent(0), nEvents(0), nSelected(0)
+{
+	if (out)
+		output.writeHeader();
+}
+
+fp13SkimOutput::~fp13SkimOutput()
+{
+	if (!out.is_open())
+		return;
+	out.flush();
+	if (!out)
+		error << "Fehler beim Schreiben von " << fileName << "." << endl;
+
+	const string sumFileName = summaryFileName(fileName);
+	ofstream sum(sumFileName.c_str(), ios::trunc);
+	sum << "FP13SKIM 1" << endl <<
+		"input " << inputFileName << endl <<
+		"mergeWindow " << mergeWindow << endl <<
+		"firstEvent " << firstEvent << endl <<
+		"events " << nEvents << endl <<
+		"selected " << nSelected << endl;
+	sum.close();
+	if (sum.fail())
+		error << "Fehler beim Schreiben von " << sumFileName << "." <<
+			endl;
+}
+
+bool fp13SkimOutput::isOpen() const
+{ return out.is_open() && out.good(); }
+
+const string& fp13SkimOutput::getFileName() const
+{ return fileName; }
+
+string fp13SkimOutput::summaryFileName(const string& fileName)
+{ return fileName + ".sum"; }
+
+void fp13SkimOutput::countEvent(unsigned long event)
+{
+	if (!nEvents)
+		firstEvent = event;
+	++nEvents;
+}
+
+bool fp13SkimOutput::writeEvent(const vector<int>& hitMask,
+		const vector<int>& hitTimes)
+{
+	if (!output.writeEvent(hitMask, hitTimes))
+		return false;
+	++nSelected;
+	return true;
+}
+
+unsigned long fp13SkimOutput::getNoOfEvents() const
+{ return nEvents; }
+
+unsigned long fp13SkimOutput::getNoOfSelectedEvents() const
+{ return nSelected; }
+
+// Dateiende
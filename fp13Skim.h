@@ -0,0 +1,92 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Skim: Datei mit den Ereignissen, die fuer Zerfaelle und Nachpulse in
+// Frage kommen (fp13 -k)
+//
+// Zerfaelle und Nachpulse sucht die Analyse nur in Ereignissen, in deren
+// erstem Zeitbin ein Myon von oben durch mindestens zwei Lagen gelaufen
+// ist (lastMuonLayer != -1) und die mindestens zwei Zeitbins haben. Das
+// ist nur ein kleiner Teil aller Ereignisse. Mit fp13 -k schreibt die
+// Analyse genau diese Ereignisse im Binaerformat (s. fp13Binary.h) in
+// eine eigene Datei; spaetere Durchgaenge (mit anderen Methoden zum
+// Finden, anderem minDelay oder fp13 -c) koennen dann mit fp13 -i auf dem
+// Skim laufen und sind entsprechend schneller fertig.
+//
+// Die Zeitbins stehen so im Skim, wie die Analyse sie sieht, also schon
+// zusammengefasst (s. fp13Input::setMergeWindow). Da zusammengefasste
+// Zeitbins weiter als mergeWindow auseinander liegen, aendert das
+// nochmalige Zusammenfassen beim Lesen des Skims mit demselben
+// Zeitfenster nichts; mit kleinerem Zeitfenster laesst sich der Skim
+// aber nicht sinnvoll analysieren.
+//
+// Die Histogramme, die auch fuer nicht ausgewaehlte Ereignisse gefuellt
+// werden (h1, h6, h8 und h21), enthalten bei der Analyse des Skims
+// natuerlich nur noch die ausgewaehlten Ereignisse; alle anderen sind
+// dieselben wie bei der Analyse der ganzen Messung. Die Ereignisnummern
+// zaehlen im Skim neu ab 0. Wie viele Ereignisse urspruenglich gelesen
+// wurden, steht daher in der Zusammenfassung <Skim>.sum (Text):
+//
+// 	FP13SKIM 1
+// 	input <Eingabedatei>
+// 	mergeWindow <Zeitfenster in ns>
+// 	firstEvent <Nummer des ersten gelesenen Ereignisses>
+// 	events <Anzahl der gelesenen Ereignisse>
+// 	selected <Anzahl der Ereignisse im Skim>
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13SKIM_H
+#define FP13SKIM_H
+
+// C++ headers
+#include <fstream>
+#include <vector>
+#include <string>
+
+#include "fp13Binary.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+class fp13SkimOutput
+{
+public:
+	// legt den Skim fileName an, Hitmuster werden mit maskBytes Bytes
+	// gespeichert; isOpen() gibt Auskunft, ob das geklappt hat
+	// inputFileName und mergeWindow stehen in der Zusammenfassung
+	fp13SkimOutput(const string& fileName, unsigned maskBytes,
+			const string& inputFileName, int mergeWindow);
+	// schreibt die Zusammenfassung
+	~fp13SkimOutput();
+
+	bool isOpen() const;
+	const string& getFileName() const;
+	// Name der Zusammenfassung zum Skim fileName
+	static string summaryFileName(const string& fileName);
+
+	// Mitzaehlen des gelesenen Ereignisses event (ab 0)
+	void countEvent(unsigned long event);
+	// Schreiben eines ausgewaehlten Ereignisses
+	// gibt false zurueck, falls ein Hitmuster nicht in maskBytes passt
+	bool writeEvent(const vector<int>& hitMask,
+			const vector<int>& hitTimes);
+
+	unsigned long getNoOfEvents() const;
+	unsigned long getNoOfSelectedEvents() const;
+
+private:
+	string fileName, inputFileName;
+	int mergeWindow;
+	ofstream out;
+	fp13BinaryOutput output;
+	// Nummer des ersten gelesenen Ereignisses und Zaehler
+	unsigned long firstEvent, nEvents, nSelected;
+
+	// nicht kopierbar
+	fp13SkimOutput(const fp13SkimOutput&);
+	fp13SkimOutput& operator=(const fp13SkimOutput&);
+};
+
+#endif
+
+// Dateiende
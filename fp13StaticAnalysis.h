@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Analyse mit eigenen Methoden zum Finden von Zerfaellen und Nachpulsen
+// ohne virtuelle Aufrufe
+//
+// Wer findDecayDownward usw. in einer von fp13Analysis abgeleiteten
+// Klasse ueberschreibt, bekommt pro Zeitbin mehrere virtuelle Aufrufe,
+// die der Compiler weder inlinen noch an die Schleifen in analyze
+// anpassen kann. Leitet man stattdessen von fp13StaticAnalysis ab und
+// gibt die eigene Klasse als Template-Parameter an ("curiously
+// recurring template pattern"), steht beim Uebersetzen fest, welche
+// Methoden aufgerufen werden:
+//
+// 	class MyAnalysis : public fp13StaticAnalysis<MyAnalysis>
+// 	{
+// 	public:
+// 		MyAnalysis(const string& in, const string& out) :
+// 			fp13StaticAnalysis<MyAnalysis>(in, out)
+// 		{ }
+// 	protected:
+// 		friend class fp13StaticAnalysis<MyAnalysis>;
+// 		int findDecayDownward(int timeBin);
+// 	};
+//
+// Die Methoden heissen und funktionieren genau wie in fp13Analysis; was
+// MyAnalysis nicht selbst definiert, kommt von dort. Damit
+// fp13StaticAnalysis die eigenen Methoden aufrufen darf, muessen sie
+// public sein oder fp13StaticAnalysis<MyAnalysis> als friend
+// deklariert werden (wie oben). Fuer einen Detektor mit mehr Lagen gibt
+// man die Anzahl als zweiten Parameter an, z.B.
+// fp13StaticAnalysis<MyAnalysis, 12>.
+//
+// Fuer analyzeParallel erzeugt fp13StaticAnalysis die Worker-Objekte
+// selbst mit dem Kopierkonstruktor von MyAnalysis; createWorker muss
+// also nicht ueberschrieben werden, solange MyAnalysis kopierbar ist.
+//
+// Die bisherige Art, von fp13Analysis abzuleiten und die virtuellen
+// Methoden zu ueberschreiben, funktioniert weiterhin.
+////////////////////////////////////////////////////////////////////////
+
+#ifndef FP13STATICANALYSIS_H
+#define FP13STATICANALYSIS_H
+
+// C++ headers
+#include <string>
+
+#include "fp13Analysis.h"
+
+// Namen aus dem Namensraum std verfuegbar machen
+using namespace std;
+
+template <class Derived, int N = 6>
+class fp13StaticAnalysis : public fp13BasicAnalysis<N>
+{
+public:
+	typedef fp13BasicAnalysis<N> Base;
+	typedef typename Base::Batch Batch;
+
+	fp13StaticAnalysis(const string& inputFileName,
+			const string& outputFileName,
+			unsigned nReadThreads = 1, bool follow = false) :
+		Base(inputFileName, outputFileName, nReadThreads, follow)
+	{ }
+
+	// ohne eigene Eingabe (s. fp13EventStream.h)
+	explicit fp13StaticAnalysis(const string& outputFileName) :
+		Base(outputFileName)
+	{ }
+
+	// Analyse des aktuellen Ereignisses mit den Methoden von Derived
+	virtual void analyze()
+	{
+		Finders finders(derived());
+		this->analyzeEvent(finders);
+		this->indexEvent();
+	}
+
+	// Analyse aller Ereignisse eines Pakets, ohne fuer jedes Ereignis
+	// analyze virtuell aufzurufen
+	virtual void analyzeBatch(const Batch& batch)
+	{
+		Finders finders(derived());
+		for (size_t i = 0; i < batch.size(); ++i) {
+			batch.getEvent(i, this->detectorHitMask,
+					this->detectorHitTimes);
+			this->currentEvent = batch.getFirstEvent() + i;
+			this->analyzeEvent(finders);
+			this->indexEvent();
+		}
+	}
+
+protected:
+	// Konstruktor fuer Worker-Objekte (s. fp13BasicAnalysis)
+	fp13StaticAnalysis(const fp13StaticAnalysis& master) : Base(master)
+	{ }
+
+	// Worker-Objekte sind Kopien von Derived
+	virtual Base* createWorker() const
+	{ return new Derived(static_cast<const Derived&>(*this)); }
+
+private:
+	Derived& derived()
+	{ return static_cast<Derived&>(*this); }
+
+	// ruft die Methoden von Derived auf; durch den qualifizierten Namen
+	// (Derived::...) ist der Aufruf nicht virtuell, auch wenn die
+	// Methode in fp13BasicAnalysis virtuell ist
+	class Finders
+	{
+	public:
+		Finders(Derived& analysis) : d(analysis)
+		{ }
+
+		int determineLastLayerHitByIncomingMuon()
+		{ return d.Derived::determineLastLayerHitByIncomingMuon(); }
+		int findDecayUpward(int timeBin)
+		{ return d.Derived::findDecayUpward(timeBin); }
+		int findDecayDownward(int timeBin)
+		{ return d.Derived::findDecayDownward(timeBin); }
+		int findAfterpulsesUsingThroughGoingMuons(int timeBin,
+				int startLayer)
+		{
+			return d.Derived::findAfterpulsesUsingThroughGoingMuons(
+					timeBin, startLayer);
+		}
+		int findAfterpulsesImproved(int timeBin, int startLayer)
+		{
+			return d.Derived::findAfterpulsesImproved(timeBin,
+					startLayer);
+		}
+
+	private:
+		Derived& d;
+	};
+};
+
+#endif
+
+// Dateiende
@@ -0,0 +1,591 @@
+///////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Messen der Geschwindigkeit der verschiedenen Analysewege
+//
+// usage: fp13bench [-i inputDataFile] [-g nEvents[:seed]]
+// 		[-w window[:deadTime[:coincidence[:triggerMask]]]]
+// 		[-o rootOutputFile] [-r nRepeat] [-q] [-v]
+//
+// liest alle Ereignisse der Eingabedatei in den Speicher (in Paketen,
+// s. fp13EventQueue.h) oder erzeugt mit -g nEvents zufaellige Ereignisse
+// (s. generateAll) und analysiert sie nRepeat mal auf drei Arten:
+//
+//  generic	analyze mit den virtuellen Methoden findDecayUpward usw.
+//		(so analysieren abgeleitete Klassen)
+//  tables	analyze mit den vorab berechneten Tabellen (s.
+//		fp13Classify.h)
+//  batch	analyzeBatch, also Tabellen und Vektorbefehle fuer ein
+//		ganzes Paket
+//
+// Danach wird mit eigenen Methoden zum Finden von Zerfaellen nach unten
+// und Nachpulsen (wie sie die Studenten schreiben) verglichen, wie diese
+// aufgerufen werden:
+//
+//  virtual	von fp13Analysis abgeleitet, die Methoden sind virtuell
+//  static	von fp13StaticAnalysis abgeleitet, die Methoden werden
+//		direkt aufgerufen (s. fp13StaticAnalysis.h)
+//
+// Mit -w ist die Eingabedatei ein Hitstrom, aus dem die Ereignisse wie
+// mit fp13 -w gebildet werden (s. fp13HitStream.h). Das Lesen wird
+// einmal gemessen, die Analyse nRepeat mal; mit derselben Messung einmal
+// als Textdatei und einmal als Hitstrom zeigt fp13bench also auch, was
+// die Ereignisbildung kostet. Am Ende wird geprueft,
+// dass die ersten drei Arten und die letzten beiden jeweils genau
+// dieselben Histogramme fuellen. Die Zusammenfassung jeder Analyse am
+// Ende zaehlt nur den letzten Durchlauf.
+////////////////////////////////////////////////////////////////////////
+
+// C++ header files
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+// C header files (fuer getopt)
+#include <unistd.h>
+
+// C++ header fuer logstream, die Programmeldungen netter machen
+#include "logstream.h"
+// C++ header files fuer die Analyse
+#include "fp13Analysis.h"
+#include "fp13StaticAnalysis.h"
+#include "fp13EventQueue.h"
+#include "fp13Classify.h"
+#include "fp13HitStream.h"
+
+using namespace std;
+using namespace logstreams;
+
+// Standardwerte der Eingabeparameter
+static const char *defInputDataFileName = "fp13.txt";
+static const char *defRootOutputFileName = "fp13bench.root";
+static const unsigned defNoOfRepeats = 5;
+static const unsigned defSeed = 1;
+
+// Messen und Vergleichen fuer eine beliebige Analyseklasse
+template <class Analysis>
+class fp13Bench : public Analysis
+{
+public:
+	fp13Bench(const string& inputFileName, const string& outputFileName) :
+		Analysis(inputFileName, outputFileName)
+	{ }
+
+	// mit schon geoeffneter Eingabe (z.B. einem Hitstrom)
+	fp13Bench(fp13Input* input, const string& outputFileName) :
+		Analysis(input, outputFileName)
+	{ }
+
+	// ohne Eingabe, die Ereignisse kommen von aussen
+	explicit fp13Bench(const string& outputFileName) :
+		Analysis(outputFileName)
+	{ }
+
+	// Einlesen aller Ereignisse in Pakete
+	void readAll(vector<fp13EventBatch*>& batches)
+	{
+		static const size_t batchSize = 4096;
+		while (this->readEvent() == 0) {
+			if (batches.empty() || batches.back()->size() >= batchSize)
+				batches.push_back(new fp13EventBatch);
+			if (!batches.back()->append(this->detectorHitMask,
+						this->detectorHitTimes))
+				warn << "Ereignis " << this->eventCounter <<
+					" passt nicht in ein Paket und wird "
+					"ausgelassen." << endl;
+		}
+	}
+
+	// Erzeugen von nEvents zufaelligen Ereignissen in Pakete, mit dem
+	// Zufallsgenerator ab seed (gleicher seed, gleiche Ereignisse)
+	//
+	// Jedes Myon trifft ab 50 bis 150 ns die Lagen von oben bis zu der,
+	// in der es stoppt (gleichverteilt, ein Viertel laeuft durch alle
+	// Lagen). Ein gestopptes Myon zerfaellt in der Haelfte der Faelle
+	// nach einer exponentiell verteilten Zeit (2197 ns) in der eigenen
+	// oder einer Nachbarlage, ein Fuenftel der Ereignisse hat 1 bis 8 us
+	// spaeter einen Nachpuls in einer der getroffenen Lagen, jedes
+	// zwanzigste einen Rauschhit in den 20 us danach. Wie beim Lesen
+	// werden Zeitbins innerhalb von fp13Input::defMergeWindow
+	// zusammengefasst.
+	void generateAll(unsigned long nEvents, unsigned seed,
+			vector<fp13EventBatch*>& batches)
+	{
+		static const size_t batchSize = 4096;
+		typedef typename Analysis::Mask Mask;
+		const int nLayers = this->nLayers;
+		mt19937 random(seed);
+		uniform_real_distribution<double> uniform(0., 1.);
+		uniform_int_distribution<int> anyLayer(0, nLayers - 1);
+		exponential_distribution<double> decayTime(1. / 2197.);
+
+		// Zeitbins (Zeit, Hitmuster) vor dem Zusammenfassen
+		vector<pair<int, Mask> > bins;
+		vector<Mask> rawMask, hitMask;
+		vector<int> rawTimes, hitTimes;
+		for (unsigned long event = 0; event < nEvents; ++event) {
+			bins.clear();
+			const int t0 = 50 + int(100. * uniform(random));
+			const int stop = (uniform(random) < 0.25) ?
+				(nLayers - 1) : anyLayer(random);
+			bins.push_back(make_pair(t0, Mask((2u << stop) - 1)));
+			if (stop < nLayers - 1 && uniform(random) < 0.5) {
+				const int layer = max(0, stop - 1 +
+						int(3. * uniform(random)));
+				bins.push_back(make_pair(t0 +
+						int(decayTime(random)),
+						Mask(1u << layer)));
+			}
+			if (uniform(random) < 0.2) {
+				const int layer = int((stop + 1) *
+						uniform(random));
+				bins.push_back(make_pair(t0 + 1000 +
+						int(7000. * uniform(random)),
+						Mask(1u << layer)));
+			}
+			if (uniform(random) < 0.05)
+				bins.push_back(make_pair(t0 +
+						int(20000. * uniform(random)),
+						Mask(1u << anyLayer(random))));
+			sort(bins.begin(), bins.end());
+
+			rawMask.clear();
+			rawTimes.clear();
+			for (size_t i = 0; i < bins.size(); ++i) {
+				rawTimes.push_back(bins[i].first);
+				rawMask.push_back(bins[i].second);
+			}
+			fp13Input::mergeTimeBins(fp13Input::defMergeWindow,
+					rawMask, rawTimes, hitMask, hitTimes);
+			if (batches.empty() ||
+					batches.back()->size() >= batchSize)
+				batches.push_back(new fp13EventBatch);
+			batches.back()->append(hitMask, hitTimes);
+		}
+	}
+
+	// Analysieren aller Pakete, paketweise mit analyzeBatch oder
+	// Ereignis fuer Ereignis mit analyze; gibt die benoetigte Zeit in s
+	// zurueck
+	double run(bool batchwise, const vector<fp13EventBatch*>& batches)
+	{
+		const chrono::steady_clock::time_point start =
+			chrono::steady_clock::now();
+		for (size_t b = 0; b < batches.size(); ++b) {
+			const fp13EventBatch& batch = *batches[b];
+			if (batchwise) {
+				this->analyzeBatch(batch);
+				continue;
+			}
+			for (size_t i = 0; i < batch.size(); ++i) {
+				batch.getEvent(i, this->detectorHitMask,
+						this->detectorHitTimes);
+				this->analyze();
+			}
+		}
+		return chrono::duration<double>(
+				chrono::steady_clock::now() - start).count();
+	}
+
+	// Bininhalte und Eintraege aller Histogramme
+	void snapshot(vector<unsigned long>& contents) const
+	{
+		vector<fp13Histogram*> histograms;
+		this->getHistograms(histograms);
+		contents.clear();
+		for (size_t i = 0; i < histograms.size(); ++i) {
+			contents.push_back(histograms[i]->getEntries());
+			for (int bin = 0; bin <= histograms[i]->getNbins() + 1;
+					++bin)
+				contents.push_back(
+					histograms[i]->getBinContent(bin));
+		}
+	}
+
+	// Leeren aller Histogramme vor einem Durchlauf ueber nEvents
+	// Ereignisse; auch die Zaehler fangen neu an, damit die
+	// Zusammenfassung im Destruktor nur einen Durchlauf zaehlt
+	void reset(unsigned long nEvents)
+	{
+		vector<fp13Histogram*> histograms;
+		this->getHistograms(histograms);
+		for (size_t i = 0; i < histograms.size(); ++i)
+			histograms[i]->reset();
+		this->eventCounter = nEvents;
+		this->analyzedCounter = 0;
+	}
+};
+
+// Analyse, die zwischen den ersten drei Arten umschalten kann
+class fp13BenchModes : public fp13Analysis
+{
+public:
+	enum Mode { Generic, Tables, Batch };
+
+	fp13BenchModes(const string& inputFileName,
+			const string& outputFileName) :
+		fp13Analysis(inputFileName, outputFileName), mode(Generic)
+	{ }
+
+	fp13BenchModes(fp13Input* input, const string& outputFileName) :
+		fp13Analysis(input, outputFileName), mode(Generic)
+	{ }
+
+	explicit fp13BenchModes(const string& outputFileName) :
+		fp13Analysis(outputFileName), mode(Generic)
+	{ }
+
+	void setMode(Mode m)
+	{ mode = m; }
+
+protected:
+	// fuer Generic wird so getan, als haette die Klasse eigene
+	// Methoden; sie ueberschreibt aber keine, die anderen Arten
+	// liefern also dasselbe
+	virtual bool hasOwnFinders() const
+	{ return Generic == mode; }
+
+	Mode mode;
+};
+
+// eigene Methoden fuer den Vergleich virtueller und statischer Aufrufe,
+// von beiden Klassen unten gleich benutzt
+//
+// Zerfall nach unten: die Lage unter der letzten Lage des Myons ist
+// getroffen, die letzte Lage selbst nicht
+static inline int benchDecayDownward(int hitMask, int lastMuonLayer,
+		int nLayers)
+{
+	if (-1 == lastMuonLayer || nLayers - 1 == lastMuonLayer)
+		return -1;
+	if ((hitMask & (1 << (lastMuonLayer + 1))) &&
+			!(hitMask & (1 << lastMuonLayer)))
+		return lastMuonLayer + 1;
+	return -1;
+}
+
+// Nachpulse auch aus stoppenden Myonen: alle getroffenen Lagen ueber der
+// letzten Lage des Myons (dort und darunter koennten Zerfaelle sein)
+static inline int benchAfterpulses(int hitMask, int lastMuonLayer,
+		int startLayer)
+{
+	if (-1 == lastMuonLayer)
+		return -1;
+	if (-1 == startLayer)
+		startLayer = lastMuonLayer;
+	for (int iLayer = startLayer - 1; iLayer >= 0; --iLayer)
+		if (hitMask & (1 << iLayer))
+			return iLayer;
+	return -1;
+}
+
+// mit virtuellen Methoden
+class fp13BenchVirtual : public fp13Analysis
+{
+public:
+	explicit fp13BenchVirtual(const string& outputFileName) :
+		fp13Analysis(outputFileName)
+	{ }
+
+protected:
+	virtual int findDecayDownward(int timeBin)
+	{
+		return benchDecayDownward(detectorHitMask[timeBin],
+				lastMuonLayer, nLayers);
+	}
+
+	virtual int findAfterpulsesImproved(int timeBin, int startLayer)
+	{
+		return benchAfterpulses(detectorHitMask[timeBin],
+				lastMuonLayer, startLayer);
+	}
+};
+
+// dieselben Methoden, direkt aufgerufen
+class fp13BenchStatic : public fp13StaticAnalysis<fp13BenchStatic>
+{
+public:
+	explicit fp13BenchStatic(const string& outputFileName) :
+		fp13StaticAnalysis<fp13BenchStatic>(outputFileName)
+	{ }
+
+protected:
+	friend class fp13StaticAnalysis<fp13BenchStatic>;
+
+	int findDecayDownward(int timeBin)
+	{
+		return benchDecayDownward(detectorHitMask[timeBin],
+				lastMuonLayer, nLayers);
+	}
+
+	int findAfterpulsesImproved(int timeBin, int startLayer)
+	{
+		return benchAfterpulses(detectorHitMask[timeBin],
+				lastMuonLayer, startLayer);
+	}
+};
+
+// nRepeats Durchlaeufe von analysis ueber alle Pakete, die schnellste
+// Zeit zaehlt; contents enthaelt danach die Histogramme
+template <class Analysis>
+static double measure(fp13Bench<Analysis>& analysis, bool batchwise,
+		const vector<fp13EventBatch*>& batches, unsigned nRepeats,
+		vector<unsigned long>& contents)
+{
+	unsigned long nEvents = 0;
+	for (size_t b = 0; b < batches.size(); ++b)
+		nEvents += batches[b]->size();
+	double best = 0.;
+	for (unsigned r = 0; r < nRepeats; ++r) {
+		analysis.reset(nEvents);
+		const double t = analysis.run(batchwise, batches);
+		if (!r || t < best)
+			best = t;
+	}
+	analysis.snapshot(contents);
+	return best;
+}
+
+// Ausgabe einer Zeile mit Zeit, Ereignissen pro Sekunde und dem Faktor
+// gegenueber der Zeit reference
+static void report(const char* name, double best, double reference,
+		unsigned long nEvents)
+{
+	info << setw(8) << name << ": " << fixed << setprecision(4) <<
+		best << " s, " << setprecision(1) <<
+		(best > 0. ? 1e-6 * nEvents / best : 0.) <<
+		" Mio. Ereignisse/s, Faktor " << setprecision(2) <<
+		(best > 0. ? reference / best : 0.) << endl;
+}
+
+// kleine Prozedur zum Ausgeben eines Hilfetextes
+void help(char *myname)
+{
+	cout << endl << "usage:\t" << myname << " [-i inputDataFileName] " <<
+		"[-g nEvents[:seed]]" << endl <<
+		"\t\t[-w window[:deadTime[:coincidence[:triggerMask]]]] " <<
+		"[-o rootOutputFileName]" << endl <<
+		"\t\t[-r nRepeat] [-q] [-v]" << endl <<
+		endl <<
+		"\tMeasures the speed of the different ways to analyze "
+		"events:" << endl <<
+		"\tper event with the virtual finder methods (generic), " <<
+		endl <<
+		"\tper event with precomputed tables (tables) and per " <<
+		"batch" << endl <<
+		"\twith tables and SIMD instructions (batch), and then " <<
+		"custom finder" << endl <<
+		"\tmethods called virtually (virtual) or statically " <<
+		"(static)." << endl <<
+		"\tAll events of the input file are read into memory and " <<
+		"analyzed" << endl <<
+		"\tnRepeat times (default " << defNoOfRepeats << ") each. "
+		"If not specified on the command line," << endl <<
+		"\tinput is read from " << defInputDataFileName <<
+		", and the histograms are written" << endl <<
+		"\tto " << defRootOutputFileName << "." << endl <<
+		"\tWith -g, nEvents random events (muons, decays, " <<
+		"afterpulses and noise)" << endl <<
+		"\tare generated from seed (default " << defSeed <<
+		") instead of reading the input file." << endl <<
+		"\tWith -w, the input file is a hit stream, from which " <<
+		"events are built" << endl <<
+		"\tas with fp13 -w. Reading is timed once, so the same " <<
+		"measurement as" << endl <<
+		"\ttext file and as hit stream shows the cost of " <<
+		"building events." << endl <<
+		"\tThe options -q and -v make " << myname << " more quiet"
+		" or more verbose and may" << endl <<
+		"\tbe given more than once." << endl;
+}
+
+int main(int argc, char *argv[])
+{
+	string inputDataFileName = defInputDataFileName;
+	string rootOutputFileName = defRootOutputFileName;
+	unsigned nRepeats = defNoOfRepeats;
+	// Anzahl zufaelliger Ereignisse (0: Eingabedatei lesen)
+	unsigned long nGenerated = 0;
+	unsigned seed = defSeed;
+	// Eingabedatei ist ein Hitstrom
+	bool hitStream = false;
+	fp13HitStreamConfig hitStreamConfig;
+
+	// Lese Programmoptionen aus
+	int c;
+	while ((c = getopt(argc, argv, "hqvi:o:r:g:w:")) != -1) {
+		switch (c) {
+			case 'i':// Name der Eingabedatei
+				inputDataFileName = optarg;
+				break;
+			case 'o':// Name der Ausgabedatei
+				rootOutputFileName = optarg;
+				break;
+			case 'r':// Anzahl der Wiederholungen
+				{
+				  istringstream stream(optarg);
+				  stream >> nRepeats; // Lesen
+				}
+				if (nRepeats < 1)
+					nRepeats = 1;
+				break;
+			case 'g':// zufaellige Ereignisse
+				{
+				  istringstream stream(optarg);
+				  char colon = ':';
+				  stream >> nGenerated; // Lesen
+				  if (stream && !stream.eof())
+					  stream >> colon >> seed;
+				  if (!stream || !stream.eof() ||
+						  ':' != colon || !nGenerated) {
+					  error << "Ungueltige Angabe " <<
+						  optarg << " fuer -g " <<
+						  "(erwartet: " <<
+						  "nEvents[:seed])." << endl;
+					  return -1;
+				  }
+				}
+				break;
+			case 'w':// Hitstrom
+				if (!hitStreamConfig.parse(optarg)) {
+					error << "Ungueltige Parameter " <<
+						optarg << " fuer die "
+						"Ereignisbildung." << endl;
+					return -1;
+				}
+				hitStream = true;
+				break;
+			case '?':// Unbekannter Optionsbuchstabe
+			case 'h':// Hilfe
+				help(argv[0]);
+				return -1;
+			case 'q':// Ausgabe weniger ausfuerhlich
+			case 'v':// Ausgabe ausfuehrlich
+				logstream::setLogLevel(logstream::logLevel()
+					+ (('q' == c) ? (1) : (-1)));
+				break;
+			default:
+				cerr << argv[0] <<
+					": Unhandled option character \"-" <<
+					c << "\"." << endl;
+				return -1;
+		}
+	}
+
+	if (hitStream && nGenerated) {
+		error << "-g und -w koennen nicht zusammen benutzt werden." <<
+			endl;
+		return -1;
+	}
+
+	// Benutzer informieren, was getan wird
+	info << endl << string(72, '*') << endl;
+	if (nGenerated)
+		info << "Zufallsereignisse\t" << nGenerated << ", Seed " <<
+			seed << endl;
+	else
+		info << "Eingabedatei:\t\t" << inputDataFileName << endl;
+	if (hitStream)
+		info << "Hitstrom\t\tFenster " << hitStreamConfig.window <<
+			" ns, Totzeit " << hitStreamConfig.deadTime <<
+			" ns, Koinzidenz " << hitStreamConfig.coincidence <<
+			" ns, Trigger " << hitStreamConfig.triggerMask << endl;
+	info << "Ausgabedatei:\t\t" << rootOutputFileName << endl <<
+		"Wiederholungen\t\t" << nRepeats << endl <<
+		"Vektorbefehle\t\t" << fp13Classifier::getKernelName() <<
+		endl << string(72, '*') << endl << endl;
+
+	fp13Bench<fp13BenchModes>* analysis;
+	vector<fp13EventBatch*> batches;
+	const chrono::steady_clock::time_point start =
+		chrono::steady_clock::now();
+	if (nGenerated) {
+		analysis = new fp13Bench<fp13BenchModes>(rootOutputFileName);
+		analysis->generateAll(nGenerated, seed, batches);
+	} else if (hitStream) {
+		fp13HitStreamInput* input = fp13HitStreamInput::open(
+				inputDataFileName, hitStreamConfig);
+		if (!input) {
+			error << "Fehler beim Oeffnen der Eingabedatei " <<
+				inputDataFileName << "." << endl;
+			return -1;
+		}
+		analysis = new fp13Bench<fp13BenchModes>(input,
+				rootOutputFileName);
+		analysis->readAll(batches);
+	} else {
+		analysis = new fp13Bench<fp13BenchModes>(inputDataFileName,
+				rootOutputFileName);
+		analysis->readAll(batches);
+	}
+	const double readTime = chrono::duration<double>(
+			chrono::steady_clock::now() - start).count();
+	unsigned long nEvents = 0;
+	for (size_t b = 0; b < batches.size(); ++b)
+		nEvents += batches[b]->size();
+	info << nEvents << " Ereignisse in " << batches.size() <<
+		" Paketen " << (nGenerated ? "erzeugt" : "gelesen") <<
+		" in " << fixed << setprecision(3) << readTime << " s (" <<
+		setprecision(2) << (readTime > 0. ?
+				1e-6 * nEvents / readTime : 0.) <<
+		" Mio. Ereignisse/s)." << endl;
+
+	// Tabellen und Vektorbefehle gegenueber generic
+	static const char* names[] = { "generic", "tables", "batch" };
+	vector<unsigned long> reference, contents;
+	double generic = 0.;
+	int retVal = 0;
+	for (int m = fp13BenchModes::Generic; m <= fp13BenchModes::Batch;
+			++m) {
+		analysis->setMode(static_cast<fp13BenchModes::Mode>(m));
+		const double best = measure(*analysis,
+				fp13BenchModes::Batch == m, batches, nRepeats,
+				contents);
+		if (fp13BenchModes::Generic == m)
+			generic = best;
+		report(names[m], best, generic, nEvents);
+
+		// alle Arten muessen dasselbe liefern
+		if (reference.empty()) {
+			reference = contents;
+		} else if (contents != reference) {
+			error << names[m] << " liefert andere Histogramme "
+				"als " << names[0] << "." << endl;
+			retVal = -1;
+		}
+	}
+	// jede Analyse schreibt beim Loeschen die Ausgabedatei, am Ende
+	// stehen dort die Histogramme der letzten
+	delete analysis;
+
+	// virtuelle gegenueber direkt aufgerufenen eigenen Methoden
+	fp13Bench<fp13BenchVirtual>* virtualAnalysis =
+		new fp13Bench<fp13BenchVirtual>(rootOutputFileName);
+	const double virtualTime = measure(*virtualAnalysis, false, batches,
+			nRepeats, reference);
+	report("virtual", virtualTime, virtualTime, nEvents);
+	delete virtualAnalysis;
+
+	fp13Bench<fp13BenchStatic>* staticAnalysis =
+		new fp13Bench<fp13BenchStatic>(rootOutputFileName);
+	const double staticTime = measure(*staticAnalysis, false, batches,
+			nRepeats, contents);
+	report("static", staticTime, virtualTime, nEvents);
+	if (contents != reference) {
+		error << "static liefert andere Histogramme als virtual." <<
+			endl;
+		retVal = -1;
+	}
+	delete staticAnalysis;
+
+	for (size_t b = 0; b < batches.size(); ++b)
+		delete batches[b];
+
+	return retVal;
+}
+
+// Dateiende
@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Umwandeln von Textdateien in das kompakte Binaerformat (s. fp13Binary.h)
+//
+// usage: fp13convert [-i inputDataFile] [-o binaryOutputFile]
+// 		[-b maskBytes] [-q] [-v]
+//
+// werden Eingabe- oder Ausgabefile auf der Kommandozeile nicht
+// angegeben, so verwendet das Programm "fp13.txt" standardmaessig als
+// Eingabefile und "fp13.bin" als Ausgabefile
+//
+// fp13 erkennt Binaerdateien automatisch, man ruft dann einfach
+// fp13 -i fp13.bin auf
+//
+// die Hitmuster werden mit maskBytes Bytes gespeichert (1, 2 oder 4);
+// fuer Detektoren mit mehr als 8 Lagen (fp13 -l) braucht man 2 bzw. 4
+////////////////////////////////////////////////////////////////////////
+
+// C++ header files
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iomanip>
+// C header files (fuer getopt)
+#include <unistd.h>
+
+// C++ header fuer logstream, die Programmeldungen netter machen
+#include "logstream.h"
+// C++ header files fuer Ein- und Ausgabe der Ereignisse
+#include "fp13Input.h"
+#include "fp13Binary.h"
+
+using namespace std;
+using namespace logstreams;
+
+// Standardwerte der Eingabeparameter
+static const char *defInputDataFileName = "fp13.txt";
+static const char *defBinaryOutputFileName = "fp13.bin";
+static const unsigned defMaskBytes = 1;
+
+// kleine Prozedur zum Ausgeben eines Hilfetextes
+void help(char *myname)
+{
+	cout << endl << "usage:\t" << myname << " [-i inputDataFileName] " <<
+		"[-o binaryOutputFileName] [-b maskBytes] [-q] [-v]" <<
+		endl << endl <<
+		"\tConverts fp13 text data into the compact binary format." <<
+		endl <<
+		"\tIf not specified on the command line, input is read "
+		"from " << defInputDataFileName << "," << endl <<
+		"\tand output is written to " << defBinaryOutputFileName <<
+		"." << endl <<
+		"\tIf \"-\" is given as name of the input or output file, " <<
+		"data" << endl << "\tis read from stdin or written to stdout." <<
+		endl <<
+		"\tHit masks are stored with maskBytes bytes (1, 2 or 4, "
+		"default: " << defMaskBytes << ");" << endl <<
+		"\tdetectors with more than 8 layers need 2 or 4." << endl <<
+		"\tThe options -q and -v make " << myname << " more quiet"
+		" or more verbose and may" << endl <<
+		"\tbe given more than once." << endl;
+}
+
+int main(int argc, char *argv[])
+{
+	string inputDataFileName = defInputDataFileName;
+	string binaryOutputFileName = defBinaryOutputFileName;
+	unsigned maskBytes = defMaskBytes;
+
+	// Lese Programmoptionen aus
+	int c;
+	while ((c = getopt(argc, argv, "hqvi:o:b:")) != -1) {
+		switch (c) {
+			case 'i':// Name der Eingabedatei
+				inputDataFileName = optarg;
+				break;
+			case 'o':// Name der Ausgabedatei
+				binaryOutputFileName = optarg;
+				break;
+			case 'b':// Breite der Hitmuster
+				{
+				  istringstream stream(optarg);
+				  stream >> maskBytes; // Lesen
+				}
+				if (1 != maskBytes && 2 != maskBytes &&
+						4 != maskBytes) {
+					help(argv[0]);
+					return -1;
+				}
+				break;
+			case '?':// Unbekannter Optionsbuchstabe
+			case 'h':// Hilfe
+				help(argv[0]);
+				return -1;
+			case 'q':// Ausgabe weniger ausfuerhlich
+			case 'v':// Ausgabe ausfuehrlich
+				logstream::setLogLevel(logstream::logLevel()
+					+ (('q' == c) ? (1) : (-1)));
+				break;
+			default:
+				cerr << argv[0] <<
+					": Unhandled option character \"-" <<
+					c << "\"." << endl;
+				return -1;
+		}
+	}
+
+	// Benutzer informieren, was getan wird
+	info << endl << string(72, '*') << endl <<
+		"Eingabedatei:\t\t" << inputDataFileName << endl <<
+		"Ausgabedatei:\t\t" << binaryOutputFileName << endl <<
+		string(72, '*') << endl << endl;
+
+	fp13Input* input = fp13Input::open(inputDataFileName);
+	if (!input) {
+		error << "Fehler beim Oeffnen der Eingabedatei " <<
+			inputDataFileName << "." << endl;
+		return -1;
+	}
+	// die Zeitbins werden so gespeichert, wie sie in der Eingabe
+	// stehen; das Zusammenfassen passiert erst beim Lesen der
+	// Binaerdatei
+	input->setMergeWindow(-1);
+
+	ofstream* outputFile = 0;
+	if ("-" != binaryOutputFileName) {
+		outputFile = new ofstream(binaryOutputFileName.c_str(),
+				ios::out | ios::binary | ios::trunc);
+		if (outputFile->fail()) {
+			error << "Fehler beim Oeffnen der Ausgabedatei " <<
+				binaryOutputFileName << "." << endl;
+			delete outputFile;
+			delete input;
+			return -1;
+		}
+	}
+	ostream& out = outputFile ? *outputFile : cout;
+	fp13BinaryOutput output(out, maskBytes);
+	output.writeHeader();
+
+	// Ereignisse lesen und binaer wieder schreiben
+	vector<int> hitMask, hitTimes;
+	unsigned long eventCounter = 0;
+	int retVal = 0;
+	while (0 == input->readEvent(hitMask, hitTimes, eventCounter)) {
+		++eventCounter;
+		if (!output.writeEvent(hitMask, hitTimes)) {
+			error << "Hitmuster in Ereignis " << eventCounter <<
+				" passt nicht in das Binaerformat." << endl;
+			retVal = -1;
+			break;
+		}
+		// Statusreport alle 100000 Ereignisse
+		if (0 == (eventCounter % 100000))
+			info << "Ereignis " << setw(8) << eventCounter <<
+				" umgewandelt." << endl;
+	}
+	out.flush();
+	if (out.fail()) {
+		error << "Fehler beim Schreiben der Ausgabedatei " <<
+			binaryOutputFileName << "." << endl;
+		retVal = -1;
+	}
+
+	info << string(72, '*') << endl <<
+		setw(8) << eventCounter << " Ereignisse umgewandelt." <<
+		endl << string(72, '*') << endl << endl;
+
+	delete outputFile;
+	delete input;
+
+	return retVal;
+}
+
+// Dateiende
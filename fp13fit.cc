@@ -0,0 +1,548 @@
+///////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Fit der Lebensdauer an die Histogramme einer Ausgabedatei von fp13
+// (s. fp13Fit.h)
+//
+// usage: fp13fit [-i rootFile] [-r xmin:xmax] [-L] [-q] [-v]
+// 		[histogram...]
+//        fp13fit -c candidateFile [-r xmin:xmax] [-C] [-R ratio]
+// 		[-j nThreads] [-q] [-v] [histogram...]
+//        fp13fit -s scanFile [-i rootFile] [-r xmin:xmax] [-L]
+// 		[-x first:last:n] [-X first:last:n] [-j nThreads] [-q] [-v]
+// 		[histogram...]
+//
+// wird die Datei auf der Kommandozeile nicht angegeben, so verwendet das
+// Programm "fp13.root", der Fitbereich ist wie in Lebensdauer.C 300 ns
+// bis 20000 ns
+//
+// gefittet wird fitFuncF aus Lebensdauer.C an die angegebenen Histogramme
+// (Standard: ho hu hL), mit -L mit der Poisson-Likelihood statt chi^2;
+// fehlen ho, hu oder hL in der Datei, so werden sie wie in Lebensdauer.C
+// aus den Zerfaellen nach oben (a1 bis a<nLayers-2>) und unten (b2 bis
+// b<nLayers-2>) gebildet, allerdings ohne Abzug der Nachpulse, z.B.
+//
+// 	fp13fit -i run.root -r 500:20000
+// 	fp13fit -i Results.root ho hmo
+//
+// mit -c wird statt an die Histogramme ungebinnt an die Verzoegerungen aus
+// der Tabelle der Kandidaten (fp13 -c) gefittet (fp13UnbinnedFit); ho, hu
+// und hL stehen dann fuer die Zerfaelle nach oben, nach unten und beide,
+// aus denselben Lagen wie oben. Die Tabelle wird mit nThreads Threads
+// gelesen, die ebenso viele Threads fuer die Likelihood benutzen. Mit -C
+// wird wie in Einfangzeiten.C mit dem Einfang negativer Myonen gefittet,
+// das Verhaeltnis r von mu+ zu mu- ist dabei fest 1.275 oder mit -R
+// ratio fest ratio; mit -R 0 wird es mitgefittet, z.B.
+//
+// 	fp13fit -c run.cand -j 4 -r 1000:20000
+// 	fp13fit -c run.cand -C -R 0 hu
+//
+// mit -s wird statt eines Fits der Fitbereich gescannt (s. fp13FitScan.h):
+// fuer jedes Histogramm wird fuer n Werte von xmin (-x, Standard
+// 300:2300:6, also in Schritten von einer Binbreite) und n Werte von
+// xmax (-X, Standard 10000:40000:16) gefittet, fuer alle Histogramme
+// zusammen mit nThreads Threads (hoechstens einer pro Histogramm und
+// Wert von xmin, mit den Standardwerten also 18 fuer ho, hu und hL); die
+// Karten tau(xmin, xmax) und die Zusammenfassung mit dem Fitbereich von
+// -r als Bezug landen in scanFile in einem Verzeichnis mit dem Namen des
+// Histogramms, z.B.
+//
+// 	fp13fit -i run.root -s scan.root -j 4 -x 100:1700:5 hL
+////////////////////////////////////////////////////////////////////////
+
+// C++ header files
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cmath>
+#include <algorithm>
+// C header files (fuer getopt)
+#include <unistd.h>
+
+// ROOT header files
+#include <TFile.h>
+#include <TH1.h>
+#include <TParameter.h>
+
+// C++ header fuer logstream, die Programmeldungen netter machen
+#include "logstream.h"
+// C++ header file fuer den Fit
+#include "fp13Fit.h"
+// C++ header file fuer den Scan des Fitbereichs
+#include "fp13FitScan.h"
+// C++ header file fuer die Tabelle der Kandidaten
+#include "fp13Candidates.h"
+
+using namespace std;
+using namespace logstreams;
+
+// Standardwerte der Eingabeparameter
+static const char *defRootFileName = "fp13.root";
+static const double defXmin = 300.;
+static const double defXmax = 20000.;
+static const double defRatio = 1.275;
+static const unsigned defNoOfThreads = 1;
+static const char *defXminGrid = "300:2300:6";
+static const char *defXmaxGrid = "10000:40000:16";
+
+// kleine Prozedur zum Ausgeben eines Hilfetextes
+void help(char *myname)
+{
+	cout << endl << "usage:\t" << myname << " [-i rootFileName] " <<
+		"[-r xmin:xmax] [-L] [-q] [-v] [histogram...]" << endl <<
+		"\t" << myname << " -c candidateFileName [-r xmin:xmax] [-C] " <<
+		"[-R ratio] [-j nThreads]" << endl << "\t\t[-q] [-v] " <<
+		"[histogram...]" << endl <<
+		"\t" << myname << " -s scanFileName [-i rootFileName] " <<
+		"[-r xmin:xmax] [-L]" << endl << "\t\t[-x first:last:n] " <<
+		"[-X first:last:n] [-j nThreads] [-q] [-v]" << endl <<
+		"\t\t[histogram...]" << endl << endl <<
+		"\tFits the muon lifetime (fitFuncF from Lebensdauer.C) to "
+		"the given" << endl << "\thistograms (default: ho hu hL) "
+		"and prints the results. If ho, hu" << endl << "\tor hL "
+		"are missing, they are built from the decay histograms "
+		"like" << endl << "\tLebensdauer.C does, but without "
+		"subtracting afterpulses." << endl <<
+		"\tIf not specified on the command line, histograms are "
+		"read from" << endl << "\t" << defRootFileName <<
+		" and fitted from " << defXmin << " ns to " << defXmax <<
+		" ns." << endl <<
+		"\tWith -L, a Poisson likelihood fit is done instead of a "
+		"chi^2 fit." << endl <<
+		"\tWith -c, an unbinned likelihood fit to the delays in the "
+		"candidate" << endl << "\tfile written by fp13 -c is done "
+		"instead; ho, hu and hL then" << endl << "\tselect decays "
+		"up, down or both. The candidate file is read and the" <<
+		endl << "\tlikelihood is computed by nThreads threads "
+		"(default: " << defNoOfThreads << ")." << endl <<
+		"\tWith -C, muon capture is included in the fit like in "
+		"Einfangzeiten.C," << endl << "\twith the ratio of mu+ to "
+		"mu- fixed to ratio (default: " << defRatio << ");" <<
+		endl << "\t-R 0 fits the ratio as well." << endl <<
+		"\tWith -s, the fit range is scanned instead: every "
+		"histogram is fitted" << endl << "\tfor n values of xmin "
+		"(-x, default: " << defXminGrid << ") and n values of" <<
+		endl << "\txmax (-X, default: " << defXmaxGrid << "), "
+		"using nThreads threads. The maps" << endl << "\ttau(xmin, "
+		"xmax) and a summary of the stability relative to the fit" <<
+		endl << "\trange given by -r are written to scanFileName." <<
+		endl <<
+		"\tThe options -q and -v make " << myname << " more quiet"
+		" or more verbose and may" << endl <<
+		"\tbe given more than once." << endl;
+}
+
+// Summe der Histogramme prefix<first> bis prefix<last>
+static TH1* sumOfLayers(TFile& file, const char* prefix, int first, int last,
+		const char* name, const char* title)
+{
+	TH1* sum = 0;
+	for (int i = first; i <= last; ++i) {
+		ostringstream layerName;
+		layerName << prefix << i;
+		TH1* h = dynamic_cast<TH1*>(file.Get(layerName.str().c_str()));
+		if (!h) {
+			error << "Das Histogramm " << layerName.str() <<
+				" fehlt in " << file.GetName() << "." << endl;
+			delete sum;
+			return 0;
+		}
+		if (!sum) {
+			sum = static_cast<TH1*>(h->Clone(name));
+			sum->SetDirectory(0);
+			sum->SetTitle(title);
+		} else {
+			sum->Add(h);
+		}
+	}
+	return sum;
+}
+
+// Histogramm name aus der Datei, ho, hu und hL notfalls wie in
+// Lebensdauer.C gebildet
+static TH1* getHistogram(TFile& file, const string& name)
+{
+	TH1* h = dynamic_cast<TH1*>(file.Get(name.c_str()));
+	if (h)
+		return h;
+	if ("ho" != name && "hu" != name && "hL" != name) {
+		error << "Das Histogramm " << name << " fehlt in " <<
+			file.GetName() << "." << endl;
+		return 0;
+	}
+	// Dateien ohne nLayers stammen vom Detektor mit 6 Lagen
+	TParameter<int>* p = dynamic_cast<TParameter<int>*>(
+			file.Get("nLayers"));
+	const int nLayers = p ? p->GetVal() : 6;
+	if ("ho" == name)
+		return sumOfLayers(file, "a", 1, nLayers - 2, "ho",
+				"Zerfall nach oben");
+	if ("hu" == name)
+		return sumOfLayers(file, "b", 2, nLayers - 2, "hu",
+				"Zerfall nach unten");
+	TH1* hL = sumOfLayers(file, "a", 1, nLayers - 2, "hL", "Lebensdauer");
+	TH1* hu = sumOfLayers(file, "b", 2, nLayers - 2, "hu",
+			"Zerfall nach unten");
+	if (!hL || !hu) {
+		delete hL;
+		delete hu;
+		return 0;
+	}
+	hL->Add(hu);
+	delete hu;
+	return hL;
+}
+
+// Scan des Fitbereichs fuer die Histogramme names
+static int scanRanges(TFile& file, const vector<string>& names,
+		const string& scanFileName, double xmin, double xmax,
+		fp13LifetimeFit::Method method, const fp13ScanGrid& xminGrid,
+		const fp13ScanGrid& xmaxGrid, unsigned nThreads)
+{
+	TFile* scanFile = new TFile(scanFileName.c_str(), "RECREATE");
+	if (scanFile->IsZombie()) {
+		error << "Fehler beim Oeffnen der Ausgabedatei " <<
+			scanFileName << "." << endl;
+		delete scanFile;
+		return -1;
+	}
+	int ret = 0;
+	// jedes Histogramm bekommt ein Verzeichnis, also nur einmal scannen
+	vector<string> unique;
+	for (size_t i = 0; i < names.size(); ++i) {
+		if (find(unique.begin(), unique.end(), names[i]) == unique.end())
+			unique.push_back(names[i]);
+		else
+			warn << names[i] << " ist mehrfach angegeben, scanne es "
+				"nur einmal." << endl;
+	}
+	// alle Histogramme zusammen scannen, damit alle Threads zu tun haben
+	vector<string> found;
+	vector<const TH1*> histograms;
+	vector<fp13FitRangeScan*> scans;
+	for (size_t i = 0; i < unique.size(); ++i) {
+		TH1* h = getHistogram(file, unique[i]);
+		if (!h) {
+			ret = -1;
+			continue;
+		}
+		found.push_back(unique[i]);
+		histograms.push_back(h);
+		scans.push_back(new fp13FitRangeScan(method, xminGrid,
+					xmaxGrid));
+	}
+	fp13FitRangeScan::scan(scans, histograms, nThreads);
+
+	for (size_t i = 0; i < scans.size(); ++i) {
+		const TH1* h = histograms[i];
+		const fp13FitRangeScan::Summary summary =
+			scans[i]->summarize(xmin, xmax);
+		cout << endl << found[i] << ": " << h->GetTitle() << ", ";
+		scans[i]->print(cout, summary);
+		TDirectory* dir = scanFile->mkdir(found[i].c_str(),
+				h->GetTitle());
+		if (dir) {
+			scans[i]->write(dir, summary);
+		} else {
+			error << "Fehler beim Anlegen des Verzeichnisses " <<
+				found[i] << " in " << scanFileName << "." <<
+				endl;
+			ret = -1;
+		}
+		if (summary.nFailed > 0) {
+			warn << "Fuer " << summary.nFailed << " Fitbereiche von " <<
+				found[i] << " gibt es kein Ergebnis." << endl;
+		}
+		delete scans[i];
+		// selbst gebildete Histogramme gehoeren nicht der Datei
+		if (h->GetDirectory() != &file)
+			delete h;
+	}
+	scanFile->Write();
+	scanFile->Close();
+	delete scanFile;
+	return ret;
+}
+
+// Anzahl der Zerfaelle pro ns Verzoegerung aus einem Teil der Tabelle
+struct DelayCounts {
+	// ab der Verzoegerung first, nach oben und nach unten
+	int first;
+	vector<double> up, down;
+	bool ok;
+};
+
+// Zaehlen der Zerfaelle in den Bloecken k, k + n, k + 2n, ... (ein Thread)
+static void countDelays(const fp13CandidateReader* reader, size_t k,
+		size_t n, DelayCounts* counts)
+{
+	const int nLayers = reader->getNoOfLayers();
+	const int size = counts->up.size();
+	fp13CandidateBlock block;
+	for (size_t i = k; i < reader->getNoOfBlocks(); i += n) {
+		if (!reader->readBlock(i, block)) {
+			counts->ok = false;
+			return;
+		}
+		const uint8_t* layers = block.getLayers();
+		const int32_t* delays = block.getDelays();
+		const uint8_t* types = block.getTypes();
+		for (size_t j = 0; j < block.size(); ++j) {
+			const int bin = delays[j] - counts->first;
+			if (bin < 0 || bin >= size || layers[j] > nLayers - 2)
+				continue;
+			// Lagen wie a<i> und b<i> in Lebensdauer.C
+			if (fp13CandidateFormat::DecayUp == types[j] &&
+					layers[j] >= 1)
+				counts->up[bin] += 1.;
+			else if (fp13CandidateFormat::DecayDown == types[j] &&
+					layers[j] >= 2)
+				counts->down[bin] += 1.;
+		}
+	}
+}
+
+// ungebinnter Fit an die Kandidaten aus candidateFileName
+static int fitCandidates(const string& candidateFileName,
+		const vector<string>& names, double xmin, double xmax,
+		fp13UnbinnedFit::Model model, double ratio, unsigned nThreads)
+{
+	for (size_t i = 0; i < names.size(); ++i) {
+		if ("ho" != names[i] && "hu" != names[i] && "hL" != names[i]) {
+			error << "Ungebinnt gibt es nur ho, hu und hL, nicht " <<
+				names[i] << "." << endl;
+			return -1;
+		}
+	}
+	fp13CandidateReader reader(candidateFileName);
+	if (!reader.isOpen())
+		return -1;
+
+	// die Verzoegerungen sind ganze ns; Zerfaelle mit gleicher
+	// Verzoegerung werden zu einem Gewicht zusammengefasst
+	const int first = int(ceil(xmin)), last = int(floor(xmax));
+	if (first > last) {
+		error << "Im Fitbereich liegt keine ganze Verzoegerung." << endl;
+		return -1;
+	}
+	vector<DelayCounts> counts(nThreads);
+	vector<thread> threads;
+	for (unsigned k = 0; k < nThreads; ++k) {
+		counts[k].first = first;
+		counts[k].up.assign(last - first + 1, 0.);
+		counts[k].down.assign(last - first + 1, 0.);
+		counts[k].ok = true;
+		threads.push_back(thread(countDelays, &reader, k,
+					size_t(nThreads), &counts[k]));
+	}
+	for (unsigned k = 0; k < nThreads; ++k)
+		threads[k].join();
+	for (unsigned k = 0; k < nThreads; ++k) {
+		if (!counts[k].ok) {
+			error << "Fehlerhafter Block in " << candidateFileName <<
+				"." << endl;
+			return -1;
+		}
+		if (k == 0)
+			continue;
+		for (size_t j = 0; j < counts[0].up.size(); ++j) {
+			counts[0].up[j] += counts[k].up[j];
+			counts[0].down[j] += counts[k].down[j];
+		}
+	}
+	info << reader.getNoOfCandidates() << " Kandidaten aus " <<
+		candidateFileName << " gelesen." << endl;
+
+	int ret = 0;
+	for (size_t i = 0; i < names.size(); ++i) {
+		const bool up = ("hu" != names[i]), down = ("ho" != names[i]);
+		fp13UnbinnedFit fit(model, xmin, xmax, nThreads);
+		if (fp13UnbinnedFit::CaptureModel == model) {
+			if (ratio > 0.)
+				fit.fixParameter(fp13UnbinnedFit::Ratio, ratio);
+			else
+				fit.releaseParameter(fp13UnbinnedFit::Ratio);
+		}
+		for (size_t j = 0; j < counts[0].up.size(); ++j) {
+			const double n = (up ? counts[0].up[j] : 0.) +
+				(down ? counts[0].down[j] : 0.);
+			if (n > 0.)
+				fit.add(first + int(j), n);
+		}
+		if (!(fit.getNoOfDecays() > fp13UnbinnedFit::nParameters)) {
+			error << "Zu wenige Zerfaelle fuer " << names[i] <<
+				" im Fitbereich." << endl;
+			ret = -1;
+			continue;
+		}
+		if (!fit.fit()) {
+			warn << "Der Fit an " << names[i] << " ist nicht "
+				"konvergiert." << endl;
+			ret = -1;
+		}
+		cout << endl << names[i] << ": " << (!down ?
+				"Zerfall nach oben" : (!up ?
+					"Zerfall nach unten" : "Lebensdauer")) <<
+			", ungebinnt, " << xmin << " ns bis " << xmax << " ns" <<
+			endl;
+		fit.print(cout);
+	}
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	string rootFileName = defRootFileName;
+	double xmin = defXmin, xmax = defXmax;
+	fp13LifetimeFit::Method method = fp13LifetimeFit::Chi2;
+	// ungebinnter Fit an die Kandidaten
+	string candidateFileName;
+	fp13UnbinnedFit::Model model = fp13UnbinnedFit::LifetimeModel;
+	double ratio = defRatio;
+	unsigned nThreads = defNoOfThreads;
+	// Scan des Fitbereichs
+	string scanFileName;
+	fp13ScanGrid xminGrid, xmaxGrid;
+	xminGrid.parse(defXminGrid);
+	xmaxGrid.parse(defXmaxGrid);
+
+	// Lese Programmoptionen aus
+	int c;
+	while ((c = getopt(argc, argv, "hqvLCi:r:c:R:j:s:x:X:")) != -1) {
+		switch (c) {
+			case 'i':// Name der Datei
+				rootFileName = optarg;
+				break;
+			case 'r':// Fitbereich
+				{
+				  istringstream stream(optarg);
+				  char colon = 0;
+				  if (!(stream >> xmin >> colon >> xmax) ||
+						  ':' != colon || !stream.eof() ||
+						  !(xmin < xmax)) {
+					  error << "Ungueltiger Fitbereich " <<
+						  optarg << "." << endl;
+					  return -1;
+				  }
+				}
+				break;
+			case 'L':// Poisson-Likelihood
+				method = fp13LifetimeFit::Poisson;
+				break;
+			case 'c':// Tabelle der Kandidaten
+				candidateFileName = optarg;
+				break;
+			case 'C':// mit Einfang
+				model = fp13UnbinnedFit::CaptureModel;
+				break;
+			case 'R':// Verhaeltnis mu+/mu-
+				{
+				  istringstream stream(optarg);
+				  if (!(stream >> ratio) || !stream.eof() ||
+						  ratio < 0.) {
+					  error << "Ungueltiges Verhaeltnis " <<
+						  optarg << "." << endl;
+					  return -1;
+				  }
+				}
+				break;
+			case 's':// Scan des Fitbereichs
+				scanFileName = optarg;
+				break;
+			case 'x':// Gitter fuer xmin bzw. xmax
+			case 'X':
+				if (!(('x' == c) ? xminGrid : xmaxGrid).parse(
+							optarg)) {
+					error << "Ungueltiges Gitter " << optarg <<
+						"." << endl;
+					return -1;
+				}
+				break;
+			case 'j':// Anzahl der Threads
+				{
+				  istringstream stream(optarg);
+				  stream >> nThreads; // Lesen
+				}
+				if (nThreads < 1)
+					nThreads = 1;
+				break;
+			case '?':// Unbekannter Optionsbuchstabe
+			case 'h':// Hilfe
+				help(argv[0]);
+				return -1;
+			case 'q':// Ausgabe weniger ausfuerhlich
+			case 'v':// Ausgabe ausfuehrlich
+				logstream::setLogLevel(logstream::logLevel()
+					+ (('q' == c) ? (1) : (-1)));
+				break;
+			default:
+				cerr << argv[0] <<
+					": Unhandled option character \"-" <<
+					c << "\"." << endl;
+				return -1;
+		}
+	}
+	vector<string> names(argv + optind, argv + argc);
+	if (names.empty()) {
+		names.push_back("ho");
+		names.push_back("hu");
+		names.push_back("hL");
+	}
+	if (!candidateFileName.empty() && !scanFileName.empty()) {
+		error << "Gescannt wird nur gebinnt (ohne -c)." << endl;
+		return -1;
+	}
+	if (!candidateFileName.empty())
+		return fitCandidates(candidateFileName, names, xmin, xmax,
+				model, ratio, nThreads);
+	if (fp13UnbinnedFit::CaptureModel == model) {
+		error << "Mit Einfang wird nur ungebinnt (-c) gefittet." << endl;
+		return -1;
+	}
+
+	TFile* file = TFile::Open(rootFileName.c_str(), "READ");
+	if (!file) {
+		error << "Fehler beim Oeffnen der Datei " << rootFileName <<
+			"." << endl;
+		return -1;
+	}
+	if (!scanFileName.empty()) {
+		const int ret = scanRanges(*file, names, scanFileName, xmin,
+				xmax, method, xminGrid, xmaxGrid, nThreads);
+		delete file;
+		return ret;
+	}
+	int ret = 0;
+	for (size_t i = 0; i < names.size(); ++i) {
+		TH1* h = getHistogram(*file, names[i]);
+		if (!h) {
+			ret = -1;
+			continue;
+		}
+		fp13LifetimeFit fit(method);
+		if (fit.setData(*h, xmin, xmax) > fp13LifetimeFit::nParameters) {
+			if (!fit.fit()) {
+				warn << "Der Fit an " << names[i] << " ist nicht "
+					"konvergiert." << endl;
+				ret = -1;
+			}
+			cout << endl << names[i] << ": " << h->GetTitle() <<
+				", " << xmin << " ns bis " << xmax << " ns" <<
+				endl;
+			fit.print(cout);
+		} else {
+			error << "Zu wenige Bins mit Eintraegen in " <<
+				names[i] << " im Fitbereich." << endl;
+			ret = -1;
+		}
+		// selbst gebildete Histogramme gehoeren nicht der Datei
+		if (h->GetDirectory() != file)
+			delete h;
+	}
+	delete file;
+	return ret;
+}
+
+// Dateiende
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Summieren der Ergebnisdateien aller Gruppen fuer
+// AccumulatedAsymmetrie.C (s. fp13Merge.h)
+//
+// usage: fp13merge [-o outputFile] [-a] [-j nThreads] [-q] [-v]
+// 		resultFile...
+//
+// wird die Ausgabedatei auf der Kommandozeile nicht angegeben, so
+// verwendet das Programm "ResultsAll.root"
+//
+// die Histogramme ho, hu, hmo und hmu aller Ergebnisdateien (Results.root
+// aus Asymmetrie.C) werden mit nThreads Threads gelesen und summiert und
+// als hoAll, huAll, hmoAll und hmuAll in die Ausgabedatei geschrieben, z.B.
+//
+// 	fp13merge -o ResultsAll.root gruppe*/Results.root
+//
+// mit -a werden die Ergebnisdateien zu der Summe in der Ausgabedatei
+// addiert; es werden dann nur die neuen Dateien gelesen, schon summierte
+// (mit demselben Pfad) werden uebersprungen:
+//
+// 	fp13merge -a -o ResultsAll.root gruppe42/Results.root
+////////////////////////////////////////////////////////////////////////
+
+// C++ header files
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+// C header files (fuer getopt, access)
+#include <unistd.h>
+
+// C++ header fuer logstream, die Programmeldungen netter machen
+#include "logstream.h"
+// C++ header file fuer die Summe der Ergebnisdateien
+#include "fp13Merge.h"
+
+using namespace std;
+using namespace logstreams;
+
+// Standardwerte der Eingabeparameter
+static const char *defOutputFileName = "ResultsAll.root";
+static const unsigned defNoOfThreads = 4;
+
+// kleine Prozedur zum Ausgeben eines Hilfetextes
+void help(char *myname)
+{
+	cout << endl << "usage:\t" << myname << " [-o outputFileName] [-a] " <<
+		"[-j nThreads] [-q] [-v] resultFileName..." << endl << endl <<
+		"\tSums the histograms ho, hu, hmo and hmu of the result "
+		"files written" << endl << "\tby Asymmetrie.C and writes "
+		"them as hoAll, huAll, hmoAll and hmuAll," << endl <<
+		"\tas needed by AccumulatedAsymmetrie.C. All histograms "
+		"with the same" << endl << "\tname must have the same bins." <<
+		endl <<
+		"\tIf not specified on the command line, output is written "
+		"to" << endl << "\t" << defOutputFileName << "." << endl <<
+		"\tWith -a, the result files are added to the sums already "
+		"in the output" << endl << "\tfile; files which were summed "
+		"before are skipped." << endl <<
+		"\tWith -j, result files are read by nThreads threads "
+		"(default: " << defNoOfThreads << ")." << endl <<
+		"\tThe options -q and -v make " << myname << " more quiet"
+		" or more verbose and may" << endl <<
+		"\tbe given more than once." << endl;
+}
+
+int main(int argc, char *argv[])
+{
+	string outputFileName = defOutputFileName;
+	// zu einer vorhandenen Summe addieren
+	bool append = false;
+	unsigned nThreads = defNoOfThreads;
+
+	// Lese Programmoptionen aus
+	int c;
+	while ((c = getopt(argc, argv, "hqvao:j:")) != -1) {
+		switch (c) {
+			case 'o':// Name der Ausgabedatei
+				outputFileName = optarg;
+				break;
+			case 'a':// anhaengen
+				append = true;
+				break;
+			case 'j':// Anzahl der Threads zum Lesen
+				{
+				  istringstream stream(optarg);
+				  stream >> nThreads; // Lesen
+				}
+				if (nThreads < 1)
+					nThreads = 1;
+				break;
+			case '?':// Unbekannter Optionsbuchstabe
+			case 'h':// Hilfe
+				help(argv[0]);
+				return -1;
+			case 'q':// Ausgabe weniger ausfuerhlich
+			case 'v':// Ausgabe ausfuehrlich
+				logstream::setLogLevel(logstream::logLevel()
+					+ (('q' == c) ? (1) : (-1)));
+				break;
+			default:
+				cerr << argv[0] <<
+					": Unhandled option character \"-" <<
+					c << "\"." << endl;
+				return -1;
+		}
+	}
+	if (optind == argc) {
+		help(argv[0]);
+		return -1;
+	}
+	const vector<string> fileNames(argv + optind, argv + argc);
+
+	fp13ResultMerger merger;
+	if (append) {
+		// ohne Ausgabedatei wird eben neu angefangen
+		if (0 == access(outputFileName.c_str(), F_OK)) {
+			if (!merger.load(outputFileName))
+				return -1;
+			info << "Summe von " << merger.getNoOfInputs() <<
+				" Ergebnisdateien aus " << outputFileName <<
+				" geladen." << endl;
+		} else {
+			warn << outputFileName << " gibt es noch nicht, "
+				"fange eine neue Summe an." << endl;
+		}
+	}
+	const size_t nOld = merger.getNoOfInputs();
+	if (!merger.add(fileNames, nThreads))
+		return -1;
+	if (append && merger.getNoOfInputs() == nOld) {
+		info << "Keine neuen Ergebnisdateien, " << outputFileName <<
+			" bleibt unveraendert." << endl;
+		return 0;
+	}
+	if (!merger.write(outputFileName))
+		return -1;
+	info << (merger.getNoOfInputs() - nOld) << " Ergebnisdateien "
+		"addiert, Summe von " << merger.getNoOfInputs() <<
+		" Ergebnisdateien nach " << outputFileName <<
+		" geschrieben." << endl;
+	return 0;
+}
+
+// Dateiende
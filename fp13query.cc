@@ -0,0 +1,289 @@
+///////////////////////////////////////////////////////////////////////
+// FP13 -- Lebensdauer von Myonen
+//
+// Auswahl von Ereignissen mit dem Flag-Index (s. fp13FlagIndex.h)
+//
+// usage: fp13query [-b flagIndexFile] [-i inputDataFile] [-c] [-O] [-x]
+// 		[-q] [-v] [expression]
+//
+// wird der Flag-Index oder die Eingabedatei auf der Kommandozeile nicht
+// angegeben, so verwendet das Programm "fp13.flags" bzw. "fp13.txt"
+//
+// ausgegeben werden die Nummern (ab 0) aller analysierten Ereignisse, auf
+// die expression zutrifft, z.B.
+//
+// 	fp13 -i run.txt -b run.flags
+// 	fp13query -b run.flags 'decayUp & layer3 & afterpulseImproved'
+//
+// mit -c nur deren Anzahl, mit -O zusaetzlich die Position (Bytes ab
+// Dateianfang) jedes Ereignisses in der Eingabedatei, mit -x die
+// Ereignisse selbst im Format der Textdateien, so wie sie in der
+// Eingabedatei stehen (also mit nicht zusammengefassten Zeitbins); die
+// Ausgabe von -x kann wieder mit fp13 analysiert werden
+//
+// bei eingeblendeten Eingabedateien wird mit dem Ereignisindex (s.
+// fp13Index.h) zu den ausgewaehlten Ereignissen gesprungen, die
+// Ereignisse dazwischen werden nur ueberflogen
+//
+// ohne expression werden die Bitmaps im Flag-Index mit der Anzahl ihrer
+// Ereignisse aufgelistet
+////////////////////////////////////////////////////////////////////////
+
+// C++ header files
+#include <iostream>
+#include <string>
+#include <vector>
+#include <iomanip>
+// C header files (fuer getopt)
+#include <unistd.h>
+
+// C++ header fuer logstream, die Programmeldungen netter machen
+#include "logstream.h"
+// C++ header files fuer Flag-Index, Eingabe und Ereignisindex
+#include "fp13FlagIndex.h"
+#include "fp13Input.h"
+#include "fp13Index.h"
+
+using namespace std;
+using namespace logstreams;
+
+// Standardwerte der Eingabeparameter
+static const char *defFlagIndexFileName = "fp13.flags";
+static const char *defInputDataFileName = "fp13.txt";
+
+// kleine Prozedur zum Ausgeben eines Hilfetextes
+void help(char *myname)
+{
+	cout << endl << "usage:\t" << myname << " [-b flagIndexFileName] " <<
+		"[-i inputDataFileName] [-c] [-O] [-x] [-q] [-v] " <<
+		"[expression]" << endl << endl <<
+		"\tPrints the numbers of the analyzed events (counted from "
+		"0) which match" << endl << "\texpression, using the "
+		"flag index written by fp13 -b. Expressions" << endl <<
+		"\tcombine the bitmap names with ! (not), & (and), | (or) "
+		"and" << endl << "\tparentheses, e.g. " <<
+		"'decayUp & layer3 & afterpulseImproved'." << endl <<
+		"\t\"decay\" and \"afterpulse\" match both kinds. Without "
+		"expression, all" << endl << "\tbitmaps are listed." <<
+		endl <<
+		"\tIf not specified on the command line, the flag index is "
+		"read from" << endl << "\t" << defFlagIndexFileName <<
+		", and events are taken from " << defInputDataFileName <<
+		"." << endl <<
+		"\tWith -c, only the number of matching events is printed." <<
+		endl << "\tWith -O, the byte offset of each event in the "
+		"input file is printed, too." << endl <<
+		"\tWith -x, the events are printed in the text format "
+		"instead." << endl <<
+		"\tThe options -q and -v make " << myname << " more quiet"
+		" or more verbose and may" << endl <<
+		"\tbe given more than once." << endl;
+}
+
+// Auflisten der Bitmaps
+static void listBitmaps(const fp13FlagIndex& index)
+{
+	cout << "# " << index.getNoOfEvents() << " Ereignisse, " <<
+		index.getNoOfLayers() << " Lagen" << endl;
+	for (unsigned b = 0; b < index.getNoOfBitmaps(); ++b)
+		cout << setw(20) << left << fp13FlagIndexFormat::getName(b) <<
+			right << setw(12) << index.getCount(b) << endl;
+}
+
+// Ausgeben der Zeitbins eines Ereignisses im Format der Textdateien
+static void printEvent(const vector<int>& hitMask,
+		const vector<int>& hitTimes)
+{
+	for (unsigned i = 0; i < hitMask.size(); ++i)
+		cout << setw(10) << (i + 1) << setw(10) << hitMask[i] <<
+			setw(10) << hitTimes[i] << '\n';
+	cout << "###\n";
+}
+
+// Ausgeben der ausgewaehlten Ereignisse selected (oder mit offsets ihrer
+// Positionen) aus der Eingabedatei inputDataFileName
+static int printEvents(const string& inputDataFileName,
+		const vector<unsigned long>& selected, bool offsets)
+{
+	fp13Input* input = fp13Input::open(inputDataFileName);
+	if (!input) {
+		error << "Fehler beim Oeffnen der Eingabedatei " <<
+			inputDataFileName << "." << endl;
+		return -1;
+	}
+	// die Ereignisse so, wie sie in der Datei stehen
+	input->setMergeWindow(-1);
+	vector<int> hitMask, hitTimes;
+	unsigned long current = 0;
+
+	if (!input->getMappedFile()) {
+		// ohne eingeblendete Datei bleibt nur das Lesen aller
+		// Ereignisse
+		if (offsets) {
+			error << "Positionen gibt es nur fuer eingeblendete "
+				"Dateien." << endl;
+			delete input;
+			return -1;
+		}
+		size_t i = 0;
+		for (; i < selected.size(); ++current) {
+			if (input->readEvent(hitMask, hitTimes, current) != 0)
+				break;
+			if (current == selected[i]) {
+				printEvent(hitMask, hitTimes);
+				++i;
+			}
+		}
+		if (i < selected.size()) {
+			error << "Ereignis " << selected[i] << " nicht "
+				"gefunden, " << inputDataFileName <<
+				" enthaelt nur " << current << " Ereignisse." <<
+				endl;
+			delete input;
+			return -1;
+		}
+	} else {
+		// Ereignisindex laden oder aufbauen, falls es sich lohnt
+		fp13EventIndex index(inputDataFileName);
+		bool haveIndex = false;
+		if (!selected.empty() &&
+				selected.back() >= fp13EventIndex::defStride) {
+			haveIndex = index.load();
+			if (!haveIndex) {
+				info << "Erstelle Ereignisindex " <<
+					fp13EventIndex::indexFileName(
+						inputDataFileName) << "." << endl;
+				haveIndex = index.build(*input);
+				if (haveIndex && !index.save())
+					warn << "Kann Ereignisindex nicht "
+						"schreiben, mache trotzdem "
+						"weiter." << endl;
+			}
+		}
+		size_t offset = input->firstEventOffset();
+		for (size_t i = 0; i < selected.size(); ++i) {
+			const unsigned long event = selected[i];
+			// moeglichst weit springen...
+			if (haveIndex &&
+					event >= current + fp13EventIndex::defStride) {
+				unsigned long found;
+				size_t foundOffset;
+				index.find(event, found, foundOffset);
+				if (found > current) {
+					current = found;
+					offset = foundOffset;
+				}
+			}
+			// ... und den Rest ueberfliegen
+			for (; current < event; ++current)
+				if (!input->skipEvent(offset))
+					break;
+			if (current < event)
+				break;
+			if (offsets) {
+				cout << event << ' ' << offset << '\n';
+				continue;
+			}
+			if (!input->seek(offset) ||
+					input->readEvent(hitMask, hitTimes,
+						current) != 0)
+				break;
+			printEvent(hitMask, hitTimes);
+		}
+		if (!selected.empty() && current < selected.back()) {
+			error << "Ereignis " << selected.back() << " nicht "
+				"gefunden, " << inputDataFileName <<
+				" enthaelt nur " << current << " Ereignisse." <<
+				endl;
+			delete input;
+			return -1;
+		}
+	}
+	cout.flush();
+	delete input;
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	string flagIndexFileName = defFlagIndexFileName;
+	string inputDataFileName = defInputDataFileName;
+	// nur zaehlen, Positionen oder Ereignisse ausgeben
+	bool onlyCount = false, printOffsets = false, extract = false;
+
+	// Lese Programmoptionen aus
+	int c;
+	while ((c = getopt(argc, argv, "hqvcOxb:i:")) != -1) {
+		switch (c) {
+			case 'b':// Name des Flag-Index
+				flagIndexFileName = optarg;
+				break;
+			case 'i':// Name der Eingabedatei
+				inputDataFileName = optarg;
+				break;
+			case 'c':// nur zaehlen
+				onlyCount = true;
+				break;
+			case 'O':// Positionen ausgeben
+				printOffsets = true;
+				break;
+			case 'x':// Ereignisse ausgeben
+				extract = true;
+				break;
+			case '?':// Unbekannter Optionsbuchstabe
+			case 'h':// Hilfe
+				help(argv[0]);
+				return -1;
+			case 'q':// Ausgabe weniger ausfuerhlich
+			case 'v':// Ausgabe ausfuehrlich
+				logstream::setLogLevel(logstream::logLevel()
+					+ (('q' == c) ? (1) : (-1)));
+				break;
+			default:
+				cerr << argv[0] <<
+					": Unhandled option character \"-" <<
+					c << "\"." << endl;
+				return -1;
+		}
+	}
+	if (optind + 1 < argc || (onlyCount + printOffsets + extract) > 1) {
+		help(argv[0]);
+		return -1;
+	}
+
+	fp13FlagIndex index(flagIndexFileName);
+	if (!index.isOpen())
+		return -1;
+	if (optind == argc) {
+		listBitmaps(index);
+		return 0;
+	}
+
+	vector<uint64_t> words;
+	if (!index.select(argv[optind], words))
+		return -1;
+	vector<unsigned long> selected;
+	for (size_t w = 0; w < words.size(); ++w)
+		for (uint64_t bits = words[w]; bits; bits &= bits - 1) {
+			unsigned bit = 0;
+			while (!((bits >> bit) & 1))
+				++bit;
+			selected.push_back(64 * w + bit);
+		}
+	info << selected.size() << " von " <<
+		index.getCount(fp13FlagIndexFormat::Analyzed) <<
+		" analysierten Ereignissen ausgewaehlt." << endl;
+
+	if (onlyCount) {
+		cout << selected.size() << endl;
+		return 0;
+	}
+	if (printOffsets || extract)
+		return printEvents(inputDataFileName, selected, printOffsets);
+	for (size_t i = 0; i < selected.size(); ++i)
+		cout << selected[i] << '\n';
+	cout.flush();
+	return 0;
+}
+
+// Dateiende
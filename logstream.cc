@@ -167,44 +167,46 @@ namespace logstreams {
     {
 	if (bufdirty) {
 	    // a dirty buffer needs to be written to the underlying stream
-	    if (!buffer.str().empty()) {
-		// need to append my name after each newline
-		std::string str = buffer.str();
-		std::string::size_type start = 0;
-		std::string::size_type end = str.find("\n", start);
-		while (str.size() > start) {
-		    if (std::string::npos != end) ++end;
-		    *stream << str.substr(start, end - start);
-		    if (str.size() <= end) break;
-		    *stream << myname.substr(0,
-			    std::min(namewidth, unsigned(myname.size())));
-		    if (myname.size() < namewidth)
-			*stream << std::string(namewidth - myname.size(),
-				stream->fill());
-		    start = end;
-		    end = str.find("\n", start);
-		}
-	    }
+	    if (!buffer.str().empty())
+		writeLines(*stream, buffer.str());
 	    // flush the stream if neccessary
 	    if (flushStream) stream->flush();
 	    if (namewidth > 0) {
 		buffer.str("");
 		// refill the buffer with the start of a line for this
 		// logstream
-		buffer << myname.substr(0,
-			std::min(namewidth, unsigned(myname.size())));
-		// if neccessary, pad with the underlying stream's default
-		// fill character to the right so our name field is namewidth
-		// characters long
-		if (myname.size() < namewidth)
-		    buffer << std::string(namewidth - myname.size(),
-			    stream->fill());
+		writeName(buffer);
 	    }
 	    // buffer is clean again
 	    bufdirty = false;
 	}
     }
 
+    void logstream::writeName(std::ostream& os) const
+    {
+	os << myname.substr(0, std::min(namewidth, unsigned(myname.size())));
+	// if neccessary, pad with the underlying stream's default fill
+	// character to the right so our name field is namewidth characters
+	// long
+	if (myname.size() < namewidth)
+	    os << std::string(namewidth - myname.size(), stream->fill());
+    }
+
+    void logstream::writeLines(std::ostream& os, const std::string& str) const
+    {
+	// need to append my name after each newline
+	std::string::size_type start = 0;
+	std::string::size_type end = str.find("\n", start);
+	while (str.size() > start) {
+	    if (std::string::npos != end) ++end;
+	    os << str.substr(start, end - start);
+	    if (str.size() <= end) break;
+	    writeName(os);
+	    start = end;
+	    end = str.find("\n", start);
+	}
+    }
+
     ////////////////////////////////////////////////////////////////////////
     // getters for logstream properties
     ////////////////////////////////////////////////////////////////////////
@@ -233,12 +235,75 @@ namespace logstreams {
 	for_each(tmp.begin(), tmp.end(), deleter<StreamMapKey,logstream>());
     }
 
+    ////////////////////////////////////////////////////////////////////////
+    // logbuffer
+    ////////////////////////////////////////////////////////////////////////
+    logbuffer::logbuffer() { }
+
+    logbuffer::~logbuffer()
+    {
+	if (this == current)
+	    stop();
+	for (LineMap::iterator it = pending.begin(); pending.end() != it; ++it)
+	    delete it->second;
+    }
+
+    void logbuffer::start() { current = this; }
+
+    void logbuffer::stop()
+    {
+	// end unfinished lines
+	while (!pending.empty()) {
+	    const logstream& log = *pending.begin()->first;
+	    *pending.begin()->second << std::endl;
+	    endLine(log);
+	}
+	if (this == current)
+	    current = 0;
+    }
+
+    void logbuffer::write()
+    {
+	for (std::vector<line>::const_iterator it = lines.begin();
+		lines.end() != it; ++it)
+	    *it->stream << it->text;
+	lines.clear();
+    }
+
+    bool logbuffer::empty() const { return lines.empty(); }
+
+    std::ostream& logbuffer::lineStream(const logstream& log)
+    {
+	std::ostringstream*& s = pending[&log];
+	if (!s) {
+	    // a new line starts with the name field, as in the logstream
+	    s = new std::ostringstream;
+	    if (logstream::namewidth > 0)
+		log.writeName(*s);
+	}
+	return *s;
+    }
+
+    void logbuffer::endLine(const logstream& log)
+    {
+	LineMap::iterator it = pending.find(&log);
+	if (pending.end() == it)
+	    return;
+	std::ostringstream text;
+	log.writeLines(text, it->second->str());
+	line l = { log.stream, text.str() };
+	lines.push_back(l);
+	delete it->second;
+	pending.erase(it);
+    }
+
     ////////////////////////////////////////////////////////////////////////
     // initialize class variables
     ////////////////////////////////////////////////////////////////////////
     unsigned logstream::namewidth = 8;
     int logstream::globalLogLevel = 1;
     logstream::StreamMap logstream::streams = logstream::StreamMap();
+    thread_local logbuffer* logbuffer::current = 0;
 
     ////////////////////////////////////////////////////////////////////////
     // initialize standard streams and make them permanent
@@ -16,16 +16,20 @@
 // Oct 02 2008		M. Schiller
 // 			fixed type conversion bug, handle newline in
 // 			printed strings better
+// 			logbuffer to collect the output of worker threads
 ////////////////////////////////////////////////////////////////////////
 #ifndef _LOGSTREAM_H
 #define _LOGSTREAM_H
 
 #include <map>
 #include <string>
+#include <vector>
 #include <ostream>
 #include <sstream>
 
 namespace logstreams {
+    class logbuffer;
+
     class logstream {
 	public:
 	    ////////////////////////////////////////////////////////////////
@@ -204,6 +208,12 @@ namespace logstreams {
 	    static void registerStream(logstream* log);
 	    static void unregisterStream(logstream* log, bool doDelete);
 
+	    // write the name field which starts a line to os
+	    void writeName(std::ostream& os) const;
+	    // write str to os, starting a new name field after each newline
+	    // except a final one
+	    void writeLines(std::ostream& os, const std::string& str) const;
+
 	    // deleter for map-style iterators containing pointers...
 	    template<typename K, typename T>
 	    struct deleter :
@@ -211,6 +221,69 @@ namespace logstreams {
 		void operator()(const std::pair<K,T*>& ptr)
 		{ delete ptr.second; }
 	    };
+
+	    friend class logbuffer;
+    };
+
+    ////////////////////////////////////////////////////////////////////
+    // logbuffer
+    ////////////////////////////////////////////////////////////////////
+    // the logstreams share their buffers between all threads, so only
+    // one thread may use them at a time; a worker thread can collect its
+    // output in a logbuffer instead, and another thread writes it later:
+    //
+    // 		logbuffer log;
+    // 		// in the worker thread
+    // 		log.start();
+    // 		warn << "odd event " << n << std::endl;
+    // 		log.stop();
+    // 		// later, in the thread that owns the logstreams
+    // 		log.write();
+    //
+    // while a thread collects, the output of all logstreams written by
+    // it goes to its logbuffer (filtered by log level and with the name
+    // field as usual), line by line in the order it was logged
+    class logbuffer {
+	public:
+	    logbuffer();
+	    // stops collecting; collected lines that were not written are
+	    // lost
+	    ~logbuffer();
+
+	    // collect the output of the calling thread from now on
+	    void start();
+	    // stop collecting in the calling thread; an unfinished line is
+	    // ended with a newline
+	    void stop();
+	    // write the collected lines to the underlying streams of their
+	    // logstreams and forget them
+	    void write();
+	    // true if there are no collected lines
+	    bool empty() const;
+
+	private:
+	    // a finished line and the stream it goes to
+	    struct line {
+		std::ostream* stream;
+		std::string text;
+	    };
+	    std::vector<line> lines;
+	    // unfinished line of each logstream
+	    typedef std::map<const logstream*, std::ostringstream*> LineMap;
+	    LineMap pending;
+
+	    // logbuffer of the calling thread (0 if it does not collect)
+	    static thread_local logbuffer* current;
+
+	    // stream for the unfinished line of log
+	    std::ostream& lineStream(const logstream& log);
+	    // move the unfinished line of log to lines
+	    void endLine(const logstream& log);
+
+	    logbuffer(const logbuffer&);
+	    logbuffer& operator=(const logbuffer&);
+
+	    friend class logstream;
     };
 
     ////////////////////////////////////////////////////////////////////
@@ -235,6 +308,11 @@ namespace logstreams {
     template<typename T> inline logstream& logstream::operator<< (const T& par)
     {
 	if (myLogLevel >= globalLogLevel) {
+	    // a collecting thread writes to its logbuffer
+	    if (logbuffer::current) {
+		logbuffer::current->lineStream(*this) << par;
+		return *this;
+	    }
 	    // writing to the stream makes the buffer dirty
 	    bufdirty = true;
 	    buffer << par;
@@ -245,12 +323,19 @@ namespace logstreams {
     inline logstream& logstream::operator<<(std::ostream&(*par)(std::ostream&))
     {
 	if (myLogLevel >= globalLogLevel) {
-	    // writing to the stream makes the buffer dirty
-	    bufdirty = true;
-	    par(buffer);
 	    // get pointer to endl so we can flush buffers to the underlying
 	    // stream if par was endl
 	    std::ostream& (*endl)(std::ostream&) = std::endl;
+	    // a collecting thread writes to its logbuffer
+	    if (logbuffer::current) {
+		par(logbuffer::current->lineStream(*this));
+		if (endl == par)
+		    logbuffer::current->endLine(*this);
+		return *this;
+	    }
+	    // writing to the stream makes the buffer dirty
+	    bufdirty = true;
+	    par(buffer);
 	    if (endl == par)
 		flush();
 	}